@@ -299,7 +299,11 @@ asset_handle asset_package_find_record(const struct asset_package* p_package, as
 }
 
 asset_handle asset_package_new_record(struct asset_package* p_package, uint8_t type) {
-    const asset_id new_asset_id = ASSET_ID(type, rand_idn());
+    return asset_package_new_record_with_id(p_package, ASSET_ID(type, rand_idn()));
+}
+
+asset_handle asset_package_new_record_with_id(struct asset_package* p_package, asset_id new_asset_id) {
+    const uint8_t type = GET_ASSET_TYPE(new_asset_id);
 
     struct hashtable* p_records = hashtable_find(&p_package->_asset_type_record_tables, &type, sizeof(type));
 
@@ -61,6 +61,7 @@ void asset_package_save(struct asset_package* p_package);
 void asset_package_save_as(struct asset_package* p_package, const char* s_filename);
 asset_handle asset_package_find_record(const struct asset_package* p_package, asset_id id);
 asset_handle asset_package_new_record(struct asset_package* p_package, uint8_t type);
+asset_handle asset_package_new_record_with_id(struct asset_package* p_package, asset_id id);
 void asset_package_delete_record(struct asset_package* p_package, asset_id id);
 
 void                   asset_directory_register_package(const struct asset_package* p_package);
@@ -0,0 +1,883 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "convex_decomposition.h"
+#include "darr.h"
+#include "logging.h"
+#include "mesh.h"
+#include "parallel.h"
+#include "physics.h"
+#include "quickhull.h"
+#include "serialization.h"
+#include "static_mesh.h"
+#include "vector.h"
+
+#define CX_LOG_CAT_CD "convex-decomposition"
+
+// Number of evenly spaced split planes tried along each axis of a part
+#define CD_SPLIT_CANDIDATES 8
+
+enum cd_voxel {
+    CD_VOXEL_unknown,  // interior unless the exterior flood fill reaches it
+    CD_VOXEL_surface,
+    CD_VOXEL_exterior
+};
+
+struct cd_grid {
+    uint32_t  dims[3];
+    float     origin[3];
+    float     voxel_size;
+    uint8_t*  p_voxels; // enum cd_voxel, x fastest
+    uint32_t* p_sums;   // summed volume table of solid voxels, (dims + 1) per axis
+};
+
+// Axis-aligned box of voxels; the part is every solid voxel inside it. Volumes are measured in voxels.
+struct cd_part {
+    uint32_t lo[3];
+    uint32_t hi[3];
+    uint32_t depth;
+    float    concavity;
+};
+
+struct cd_split {
+    const struct cd_grid* p_grid;
+    uint32_t              part;
+    uint32_t              axis;
+    uint32_t              plane;
+    float                 concavity[2];
+};
+
+struct cd_split_job {
+    struct darr* p_parts;
+    struct darr* p_splits;
+};
+
+struct cd_hull_job {
+    const struct cd_grid* p_grid;
+    struct darr*          p_parts;
+    struct cd_hull*       p_hulls;
+};
+
+struct cd_hull {
+    struct he_compact_mesh mesh; // in voxel coordinates until the final conversion
+    float                  volume;
+    float                  min[3];
+    float                  max[3];
+    int                    b_alive;
+};
+
+struct cd_merge {
+    struct cd_hull* p_hulls;
+    uint32_t        num_hulls;
+    float*          p_costs; // num_hulls * num_hulls, upper triangle used
+    uint32_t*       p_pairs; // pairs (a, b) to evaluate in the current pass
+};
+
+static void     cd_collect_triangles(const struct static_mesh* p_static_mesh, struct darr* p_triangles);
+static void     cd_voxelise(struct cd_grid* p_grid, const struct darr* p_triangles, uint32_t resolution);
+static void     cd_flood_fill_exterior(struct cd_grid* p_grid);
+static void     cd_build_sums(struct cd_grid* p_grid);
+static uint32_t cd_count_solid(const struct cd_grid* p_grid, const uint32_t* p_lo, const uint32_t* p_hi);
+static int      cd_is_solid(const struct cd_grid* p_grid, uint32_t x, uint32_t y, uint32_t z);
+static int      cd_part_tighten(const struct cd_grid* p_grid, struct cd_part* p_part);
+static float    cd_part_hull(const struct cd_grid* p_grid, const uint32_t* p_lo, const uint32_t* p_hi, struct he_compact_mesh* p_hull);
+static float    cd_quickhull(float* p_points, size_t num_points, struct he_compact_mesh* p_hull);
+static float    cd_hull_volume(const struct he_compact_mesh* p_hull);
+static void     cd_evaluate_split(size_t index, void* p_user_data);
+static void     cd_hull_part(size_t index, void* p_user_data);
+static void     cd_evaluate_merge(size_t index, void* p_user_data);
+static int      cd_triangle_box_overlap(const float* p_center, float half_size, const float* p_v0, const float* p_v1, const float* p_v2);
+
+void convex_decomposition_params_default(struct convex_decomposition_params* p_params) {
+    *p_params = (struct convex_decomposition_params) {
+        .resolution = 64,
+        .max_hulls = 16,
+        .max_depth = 8,
+        .max_concavity = 0.01f
+    };
+}
+
+int convex_decomposition_generate(const struct static_mesh* p_static_mesh, const struct convex_decomposition_params* p_params, struct convex_decomposition* p_result) {
+    *p_result = (struct convex_decomposition) {
+        .params = *p_params
+    };
+
+    struct darr triangles;
+    darr_init(&triangles, sizeof(float) * 9);
+    cd_collect_triangles(p_static_mesh, &triangles);
+
+    if (!triangles._length) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_CD, "Cannot decompose mesh: it has no triangles\n");
+        darr_free(&triangles);
+        return 0;
+    }
+
+    struct cd_grid grid;
+    cd_voxelise(&grid, &triangles, p_params->resolution < 2 ? 2 : p_params->resolution);
+    darr_free(&triangles);
+
+    cd_flood_fill_exterior(&grid);
+    cd_build_sums(&grid);
+
+    const uint32_t zero[3] = { 0, 0, 0 };
+    const uint32_t total_solid = cd_count_solid(&grid, zero, grid.dims);
+
+    cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_CD, "Voxelised mesh: %dx%dx%d, %d solid voxels\n", grid.dims[0], grid.dims[1], grid.dims[2], total_solid);
+
+    // Split parts level by level. Every candidate plane of every part on the level is evaluated in one parallel pass.
+
+    struct darr parts;
+    struct darr splits;
+    darr_init(&parts, sizeof(struct cd_part));
+    darr_init(&splits, sizeof(struct cd_split));
+
+    struct cd_part* p_root = darr_push(&parts);
+    *p_root = (struct cd_part) {
+        .hi = { grid.dims[0], grid.dims[1], grid.dims[2] }
+    };
+
+    if (cd_part_tighten(&grid, p_root)) {
+        struct he_compact_mesh hull;
+        p_root->concavity = cd_part_hull(&grid, p_root->lo, p_root->hi, &hull) - (float)total_solid;
+        half_edge_compact_free(&hull);
+    } else {
+        darr_set_length(&parts, 0);
+    }
+
+    const float max_concavity = p_params->max_concavity * (float)total_solid;
+
+    for (uint32_t depth = 0; depth < p_params->max_depth; ++depth) {
+        darr_set_length(&splits, 0);
+
+        for (uint32_t p = 0; p < parts._length; ++p) {
+            const struct cd_part* p_part = darr_get(&parts, p);
+
+            if (p_part->concavity <= max_concavity) {
+                continue;
+            }
+
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                const uint32_t extent = p_part->hi[axis] - p_part->lo[axis];
+                const uint32_t num_planes = extent - 1 < CD_SPLIT_CANDIDATES ? extent - 1 : CD_SPLIT_CANDIDATES;
+
+                for (uint32_t k = 0; k < num_planes; ++k) {
+                    *(struct cd_split*)darr_push(&splits) = (struct cd_split) {
+                        .p_grid = &grid,
+                        .part = p,
+                        .axis = axis,
+                        .plane = p_part->lo[axis] + (k + 1) * extent / (num_planes + 1)
+                    };
+                }
+            }
+        }
+
+        if (!splits._length) {
+            break;
+        }
+
+        struct cd_split_job split_job = { &parts, &splits };
+
+        parallel_for(splits._length, cd_evaluate_split, &split_job);
+
+        // Splits are grouped by part; apply the cheapest of each group
+        const uint32_t num_parts = (uint32_t)parts._length;
+        size_t s = 0;
+        while (s < splits._length) {
+            const struct cd_split* p_best = darr_get(&splits, s);
+            const uint32_t part = p_best->part;
+
+            for (; s < splits._length; ++s) {
+                const struct cd_split* p_split = darr_get(&splits, s);
+                if (p_split->part != part) {
+                    break;
+                }
+                if (p_split->concavity[0] + p_split->concavity[1] < p_best->concavity[0] + p_best->concavity[1]) {
+                    p_best = p_split;
+                }
+            }
+
+            struct cd_part* p_part = darr_get(&parts, part);
+            struct cd_part halves[2] = { *p_part, *p_part };
+            halves[0].hi[p_best->axis] = p_best->plane;
+            halves[1].lo[p_best->axis] = p_best->plane;
+
+            for (int h = 0; h < 2; ++h) {
+                halves[h].depth = depth + 1;
+                halves[h].concavity = p_best->concavity[h];
+            }
+
+            // The first half takes the parent's slot so the remaining groups' part indices stay valid
+            const int b_has_first = cd_part_tighten(&grid, &halves[0]);
+            const int b_has_second = cd_part_tighten(&grid, &halves[1]);
+
+            if (b_has_first) {
+                *p_part = halves[0];
+                if (b_has_second) {
+                    *(struct cd_part*)darr_push(&parts) = halves[1];
+                }
+            } else {
+                *p_part = halves[1];
+            }
+        }
+
+        cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_CD, "Split level %d: %d parts -> %d parts (%d candidate planes)\n", depth, num_parts, (int)parts._length, (int)splits._length);
+    }
+
+    darr_free(&splits);
+
+    // Hull every part, then greedily merge the pair that adds the least volume until few enough hulls remain
+
+    struct cd_merge merge = {
+        .num_hulls = (uint32_t)parts._length,
+        .p_hulls = calloc(parts._length ? parts._length : 1, sizeof(struct cd_hull))
+    };
+
+    struct cd_hull_job hull_job = { &grid, &parts, merge.p_hulls };
+
+    parallel_for(parts._length, cd_hull_part, &hull_job);
+
+    darr_free(&parts);
+    free(grid.p_voxels);
+    free(grid.p_sums);
+
+    uint32_t num_alive = merge.num_hulls;
+
+    if (num_alive > p_params->max_hulls) {
+        merge.p_costs = malloc(sizeof(float) * merge.num_hulls * merge.num_hulls);
+        merge.p_pairs = malloc(sizeof(uint32_t) * 2 * merge.num_hulls * merge.num_hulls);
+
+        size_t num_pairs = 0;
+        for (uint32_t a = 0; a < merge.num_hulls; ++a) {
+            for (uint32_t b = a + 1; b < merge.num_hulls; ++b) {
+                merge.p_pairs[num_pairs * 2] = a;
+                merge.p_pairs[num_pairs * 2 + 1] = b;
+                ++num_pairs;
+            }
+        }
+
+        parallel_for(num_pairs, cd_evaluate_merge, &merge);
+
+        while (num_alive > p_params->max_hulls && num_alive > 1) {
+            uint32_t best_a = 0;
+            uint32_t best_b = 0;
+            float best_cost = INFINITY;
+
+            for (uint32_t a = 0; a < merge.num_hulls; ++a) {
+                for (uint32_t b = a + 1; b < merge.num_hulls; ++b) {
+                    if (merge.p_hulls[a].b_alive && merge.p_hulls[b].b_alive && merge.p_costs[a * merge.num_hulls + b] < best_cost) {
+                        best_cost = merge.p_costs[a * merge.num_hulls + b];
+                        best_a = a;
+                        best_b = b;
+                    }
+                }
+            }
+
+            if (isinf(best_cost)) {
+                cx_log_fmt(CX_LOG_WARNING, CX_LOG_CAT_CD, "No adjacent hulls left to merge; keeping %d hulls\n", num_alive);
+                break;
+            }
+
+            struct cd_hull* p_a = &merge.p_hulls[best_a];
+            struct cd_hull* p_b = &merge.p_hulls[best_b];
+
+            const size_t num_points = p_a->mesh.num_vertices + p_b->mesh.num_vertices;
+            float* p_points = malloc(sizeof(float) * 3 * num_points);
+            memcpy(p_points, p_a->mesh.p_positions, sizeof(float) * 3 * p_a->mesh.num_vertices);
+            memcpy(&p_points[p_a->mesh.num_vertices * 3], p_b->mesh.p_positions, sizeof(float) * 3 * p_b->mesh.num_vertices);
+
+            half_edge_compact_free(&p_a->mesh);
+            p_a->volume = cd_quickhull(p_points, num_points, &p_a->mesh);
+            free(p_points);
+
+            for (int i = 0; i < 3; ++i) {
+                p_a->min[i] = fminf(p_a->min[i], p_b->min[i]);
+                p_a->max[i] = fmaxf(p_a->max[i], p_b->max[i]);
+            }
+
+            half_edge_compact_free(&p_b->mesh);
+            p_b->b_alive = 0;
+            --num_alive;
+
+            num_pairs = 0;
+            for (uint32_t other = 0; other < merge.num_hulls; ++other) {
+                if (other != best_a && merge.p_hulls[other].b_alive) {
+                    merge.p_pairs[num_pairs * 2] = other < best_a ? other : best_a;
+                    merge.p_pairs[num_pairs * 2 + 1] = other < best_a ? best_a : other;
+                    ++num_pairs;
+                }
+            }
+
+            parallel_for(num_pairs, cd_evaluate_merge, &merge);
+        }
+
+        free(merge.p_costs);
+        free(merge.p_pairs);
+    }
+
+    // Move the surviving hulls from voxel coordinates into mesh space
+
+    p_result->p_hulls = malloc(sizeof(struct he_compact_mesh) * (num_alive ? num_alive : 1));
+
+    for (uint32_t i = 0; i < merge.num_hulls; ++i) {
+        struct cd_hull* p_hull = &merge.p_hulls[i];
+
+        if (!p_hull->b_alive) {
+            continue;
+        }
+
+        for (uint32_t v = 0; v < p_hull->mesh.num_vertices; ++v) {
+            float* p_position = &p_hull->mesh.p_positions[v * 3];
+            vec3_mul_s(p_position, grid.voxel_size, p_position);
+            vec3_add(p_position, grid.origin, p_position);
+        }
+
+        p_result->p_hulls[p_result->num_hulls++] = p_hull->mesh;
+    }
+
+    free(merge.p_hulls);
+
+    cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_CD, "Decomposed mesh into %d convex hulls\n", p_result->num_hulls);
+
+    return p_result->num_hulls > 0;
+}
+
+void convex_decomposition_make_collider(const struct convex_decomposition* p_decomposition, struct physics_collider* p_collider) {
+    physics_collider_init(p_collider, PHYSICS_COLLIDER_TYPE_compound);
+
+    for (uint32_t i = 0; i < p_decomposition->num_hulls; ++i) {
+        const struct he_compact_mesh* p_hull = &p_decomposition->p_hulls[i];
+        physics_compound_add_hull(p_collider, p_hull->p_positions, p_hull->num_vertices);
+    }
+
+    physics_compound_build_tree(p_collider);
+}
+
+asset_handle convex_decomposition_find_or_generate(struct asset_package* p_package, asset_handle static_mesh_handle, const struct convex_decomposition_params* p_params) {
+    // The decomposition shares the source mesh's IDN, so it can be found again without an index
+    const asset_id id = ASSET_ID(ASSET_TYPE_CONVEX_DECOMPOSITION, GET_ASSET_IDN(static_mesh_handle->_asset._id));
+
+    asset_handle handle = asset_package_find_record(p_package, id);
+
+    if (handle) {
+        if (!handle->_asset._p_data) {
+            asset_load(handle);
+        }
+
+        const struct convex_decomposition* p_cached = handle->_asset._p_data;
+        if (p_cached && !memcmp(&p_cached->params, p_params, sizeof(*p_params))) {
+            return handle;
+        }
+
+        cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_CD, "Cached decomposition of '%s' is stale; regenerating\n", static_mesh_handle->_asset.s_name);
+        asset_free(handle);
+    }
+
+    if (!static_mesh_handle->_asset._p_data && !asset_load(static_mesh_handle)) {
+        cx_log_fmt(CX_LOG_ERROR, CX_LOG_CAT_CD, "Cannot decompose '%s': failed to load the static mesh\n", static_mesh_handle->_asset.s_name);
+        return 0;
+    }
+
+    struct convex_decomposition* p_decomposition = calloc(1, sizeof(struct convex_decomposition));
+
+    if (!convex_decomposition_generate(static_mesh_handle->_asset._p_data, p_params, p_decomposition)) {
+        convex_decomposition_free(p_decomposition);
+        free(p_decomposition);
+        return 0;
+    }
+
+    if (!handle) {
+        handle = asset_package_new_record_with_id(p_package, id);
+        snprintf(handle->_asset.s_name, ASSET_NAME_MAX_LEN, "%.*s hulls", ASSET_NAME_MAX_LEN - 7, static_mesh_handle->_asset.s_name);
+    }
+
+    handle->_asset._p_data = p_decomposition;
+
+    return handle;
+}
+
+int convex_decomposition_serialize(FILE* p_file, const void* p_convex_decomposition) {
+    const struct convex_decomposition* p_decomposition = p_convex_decomposition;
+
+    serialize_uint32(p_file, p_decomposition->params.resolution);
+    serialize_uint32(p_file, p_decomposition->params.max_hulls);
+    serialize_uint32(p_file, p_decomposition->params.max_depth);
+    serialize_bytes(p_file, &p_decomposition->params.max_concavity, sizeof(float));
+    serialize_uint32(p_file, p_decomposition->num_hulls);
+
+    for (uint32_t i = 0; i < p_decomposition->num_hulls; ++i) {
+        if (!half_edge_compact_serialize(p_file, &p_decomposition->p_hulls[i])) {
+            return 0;
+        }
+    }
+
+    return !ferror(p_file);
+}
+
+int convex_decomposition_deserialize(FILE* p_file, void* p_convex_decomposition) {
+    struct convex_decomposition* p_decomposition = p_convex_decomposition;
+    *p_decomposition = (struct convex_decomposition){0};
+
+    deserialize_uint32(p_file, &p_decomposition->params.resolution);
+    deserialize_uint32(p_file, &p_decomposition->params.max_hulls);
+    deserialize_uint32(p_file, &p_decomposition->params.max_depth);
+    deserialize_bytes(p_file, &p_decomposition->params.max_concavity, sizeof(float));
+
+    uint32_t num_hulls = 0;
+    deserialize_uint32(p_file, &num_hulls);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_CD, "Failed to deserialize convex decomposition: unexpected end of file\n");
+        return 0;
+    }
+
+    p_decomposition->p_hulls = calloc(num_hulls ? num_hulls : 1, sizeof(struct he_compact_mesh));
+
+    for (uint32_t i = 0; i < num_hulls; ++i) {
+        if (!half_edge_compact_deserialize(p_file, &p_decomposition->p_hulls[i])) {
+            convex_decomposition_free(p_decomposition);
+            return 0;
+        }
+        ++p_decomposition->num_hulls;
+    }
+
+    return 1;
+}
+
+void convex_decomposition_free(void* p_convex_decomposition) {
+    struct convex_decomposition* p_decomposition = p_convex_decomposition;
+
+    for (uint32_t i = 0; i < p_decomposition->num_hulls; ++i) {
+        half_edge_compact_free(&p_decomposition->p_hulls[i]);
+    }
+
+    free(p_decomposition->p_hulls);
+    *p_decomposition = (struct convex_decomposition){0};
+}
+
+void cd_collect_triangles(const struct static_mesh* p_static_mesh, struct darr* p_triangles) {
+    for (size_t i = 0; i < p_static_mesh->num_primitives; ++i) {
+        const struct mesh_primitive* p_primitive = &p_static_mesh->p_primitives[i];
+
+        if (p_primitive->draw_mode != MESH_PRIMITIVE_DRAW_MODE_triangles) {
+            cx_log_fmt(CX_LOG_WARNING, CX_LOG_CAT_CD, "Skipping primitive %d: only triangle lists are supported\n", (int)i);
+            continue;
+        }
+
+        const struct vertex_attribute* p_position_attribute = 0;
+
+        for (size_t a = 0; a < p_primitive->num_attributes; ++a) {
+            if (p_primitive->p_attributes[a].index == 0) {
+                p_position_attribute = &p_primitive->p_attributes[a];
+                break;
+            }
+        }
+
+        if (!p_position_attribute) {
+            continue;
+        }
+
+        const struct vertex_buffer* p_position_buffer = &p_primitive->p_vertex_buffers[p_position_attribute->vertex_buffer_index];
+        const struct vertex_index_buffer* p_index_buffer = &p_primitive->index_buffer;
+        const size_t num_indices = p_index_buffer->p_bytes ? p_index_buffer->count : p_primitive->vertex_count;
+
+        for (size_t t = 0; t + 2 < num_indices; t += 3) {
+            float* p_triangle = darr_push(p_triangles);
+
+            for (size_t v = 0; v < 3; ++v) {
+                size_t index = t + v;
+
+                if (p_index_buffer->p_bytes) {
+                    switch (p_index_buffer->type) {
+                        case VERTEX_INDEX_TYPE_u8:  index = ((const uint8_t*)p_index_buffer->p_bytes)[t + v];  break;
+                        case VERTEX_INDEX_TYPE_u16: index = ((const uint16_t*)p_index_buffer->p_bytes)[t + v]; break;
+                        case VERTEX_INDEX_TYPE_u32: index = ((const uint32_t*)p_index_buffer->p_bytes)[t + v]; break;
+                    }
+                }
+
+                const float* p_v = (float*)((char*)p_position_buffer->p_bytes + p_position_attribute->layout.offset + (p_position_attribute->layout.stride * index));
+                vec3_set(p_v, &p_triangle[v * 3]);
+            }
+        }
+    }
+}
+
+void cd_voxelise(struct cd_grid* p_grid, const struct darr* p_triangles, uint32_t resolution) {
+    float bounds_min[3] = {  INFINITY,  INFINITY,  INFINITY };
+    float bounds_max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+    for (size_t t = 0; t < p_triangles->_length; ++t) {
+        const float* p_triangle = darr_get(p_triangles, t);
+        for (int v = 0; v < 9; ++v) {
+            bounds_min[v % 3] = fminf(bounds_min[v % 3], p_triangle[v]);
+            bounds_max[v % 3] = fmaxf(bounds_max[v % 3], p_triangle[v]);
+        }
+    }
+
+    float extent[3];
+    vec3_sub(bounds_max, bounds_min, extent);
+    const float longest = fmaxf(extent[0], fmaxf(extent[1], extent[2]));
+
+    *p_grid = (struct cd_grid) {
+        .voxel_size = longest > 0 ? longest / (float)resolution : 1
+    };
+
+    // One layer of padding on each side keeps the exterior connected for the flood fill
+    for (int i = 0; i < 3; ++i) {
+        p_grid->dims[i] = (uint32_t)ceilf(extent[i] / p_grid->voxel_size) + 2;
+        if (p_grid->dims[i] < 3) {
+            p_grid->dims[i] = 3;
+        }
+        p_grid->origin[i] = bounds_min[i] - p_grid->voxel_size;
+    }
+
+    const size_t num_voxels = (size_t)p_grid->dims[0] * p_grid->dims[1] * p_grid->dims[2];
+    p_grid->p_voxels = calloc(num_voxels, sizeof(uint8_t));
+
+    const float half_size = p_grid->voxel_size * 0.5f;
+
+    for (size_t t = 0; t < p_triangles->_length; ++t) {
+        const float* p_triangle = darr_get(p_triangles, t);
+
+        uint32_t lo[3];
+        uint32_t hi[3];
+        for (int i = 0; i < 3; ++i) {
+            const float t_min = fminf(p_triangle[i], fminf(p_triangle[3 + i], p_triangle[6 + i]));
+            const float t_max = fmaxf(p_triangle[i], fmaxf(p_triangle[3 + i], p_triangle[6 + i]));
+            lo[i] = (uint32_t)((t_min - p_grid->origin[i]) / p_grid->voxel_size);
+            hi[i] = (uint32_t)((t_max - p_grid->origin[i]) / p_grid->voxel_size);
+            if (hi[i] >= p_grid->dims[i]) {
+                hi[i] = p_grid->dims[i] - 1;
+            }
+        }
+
+        for (uint32_t z = lo[2]; z <= hi[2]; ++z) {
+            for (uint32_t y = lo[1]; y <= hi[1]; ++y) {
+                for (uint32_t x = lo[0]; x <= hi[0]; ++x) {
+                    const float center[3] = {
+                        p_grid->origin[0] + ((float)x + 0.5f) * p_grid->voxel_size,
+                        p_grid->origin[1] + ((float)y + 0.5f) * p_grid->voxel_size,
+                        p_grid->origin[2] + ((float)z + 0.5f) * p_grid->voxel_size
+                    };
+
+                    if (cd_triangle_box_overlap(center, half_size, p_triangle, &p_triangle[3], &p_triangle[6])) {
+                        p_grid->p_voxels[((size_t)z * p_grid->dims[1] + y) * p_grid->dims[0] + x] = CD_VOXEL_surface;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void cd_flood_fill_exterior(struct cd_grid* p_grid) {
+    const uint32_t* p_dims = p_grid->dims;
+
+    struct darr stack;
+    darr_init(&stack, sizeof(uint32_t) * 3);
+
+    uint32_t* p_start = darr_push(&stack);
+    p_start[0] = p_start[1] = p_start[2] = 0;
+    p_grid->p_voxels[0] = CD_VOXEL_exterior;
+
+    while (stack._length) {
+        uint32_t voxel[3];
+        memcpy(voxel, darr_get(&stack, stack._length - 1), sizeof(voxel));
+        darr_set_length(&stack, stack._length - 1);
+
+        for (int n = 0; n < 6; ++n) {
+            uint32_t neighbour[3] = { voxel[0], voxel[1], voxel[2] };
+            const int axis = n >> 1;
+
+            if (n & 1) {
+                if (neighbour[axis] + 1 >= p_dims[axis]) {
+                    continue;
+                }
+                ++neighbour[axis];
+            } else {
+                if (neighbour[axis] == 0) {
+                    continue;
+                }
+                --neighbour[axis];
+            }
+
+            uint8_t* p_voxel = &p_grid->p_voxels[((size_t)neighbour[2] * p_dims[1] + neighbour[1]) * p_dims[0] + neighbour[0]];
+
+            if (*p_voxel == CD_VOXEL_unknown) {
+                *p_voxel = CD_VOXEL_exterior;
+                memcpy(darr_push(&stack), neighbour, sizeof(neighbour));
+            }
+        }
+    }
+
+    darr_free(&stack);
+}
+
+void cd_build_sums(struct cd_grid* p_grid) {
+    const size_t sx = p_grid->dims[0] + 1;
+    const size_t sy = p_grid->dims[1] + 1;
+    const size_t sz = p_grid->dims[2] + 1;
+
+    p_grid->p_sums = calloc(sx * sy * sz, sizeof(uint32_t));
+
+    uint32_t* p_sums = p_grid->p_sums;
+
+    for (size_t z = 1; z < sz; ++z) {
+        for (size_t y = 1; y < sy; ++y) {
+            for (size_t x = 1; x < sx; ++x) {
+                p_sums[(z * sy + y) * sx + x] = (uint32_t)cd_is_solid(p_grid, (uint32_t)x - 1, (uint32_t)y - 1, (uint32_t)z - 1)
+                    + p_sums[((z - 1) * sy + y) * sx + x]
+                    + p_sums[(z * sy + (y - 1)) * sx + x]
+                    + p_sums[(z * sy + y) * sx + (x - 1)]
+                    - p_sums[((z - 1) * sy + (y - 1)) * sx + x]
+                    - p_sums[((z - 1) * sy + y) * sx + (x - 1)]
+                    - p_sums[(z * sy + (y - 1)) * sx + (x - 1)]
+                    + p_sums[((z - 1) * sy + (y - 1)) * sx + (x - 1)];
+            }
+        }
+    }
+}
+
+uint32_t cd_count_solid(const struct cd_grid* p_grid, const uint32_t* p_lo, const uint32_t* p_hi) {
+    const size_t sx = p_grid->dims[0] + 1;
+    const size_t sy = p_grid->dims[1] + 1;
+    const uint32_t* p_sums = p_grid->p_sums;
+
+#define CD_SUM(X, Y, Z) p_sums[((size_t)(Z) * sy + (Y)) * sx + (X)]
+    return CD_SUM(p_hi[0], p_hi[1], p_hi[2])
+        - CD_SUM(p_lo[0], p_hi[1], p_hi[2])
+        - CD_SUM(p_hi[0], p_lo[1], p_hi[2])
+        - CD_SUM(p_hi[0], p_hi[1], p_lo[2])
+        + CD_SUM(p_lo[0], p_lo[1], p_hi[2])
+        + CD_SUM(p_lo[0], p_hi[1], p_lo[2])
+        + CD_SUM(p_hi[0], p_lo[1], p_lo[2])
+        - CD_SUM(p_lo[0], p_lo[1], p_lo[2]);
+#undef CD_SUM
+}
+
+int cd_is_solid(const struct cd_grid* p_grid, uint32_t x, uint32_t y, uint32_t z) {
+    return p_grid->p_voxels[((size_t)z * p_grid->dims[1] + y) * p_grid->dims[0] + x] != CD_VOXEL_exterior;
+}
+
+int cd_part_tighten(const struct cd_grid* p_grid, struct cd_part* p_part) {
+    // Shrink the box to the bounds of its solid voxels. Returns 0 when the box holds none.
+
+    if (!cd_count_solid(p_grid, p_part->lo, p_part->hi)) {
+        return 0;
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        uint32_t slab_lo[3];
+        uint32_t slab_hi[3];
+
+        for (;;) {
+            memcpy(slab_lo, p_part->lo, sizeof(slab_lo));
+            memcpy(slab_hi, p_part->hi, sizeof(slab_hi));
+            slab_hi[axis] = slab_lo[axis] + 1;
+            if (cd_count_solid(p_grid, slab_lo, slab_hi)) {
+                break;
+            }
+            ++p_part->lo[axis];
+        }
+
+        for (;;) {
+            memcpy(slab_lo, p_part->lo, sizeof(slab_lo));
+            memcpy(slab_hi, p_part->hi, sizeof(slab_hi));
+            slab_lo[axis] = slab_hi[axis] - 1;
+            if (cd_count_solid(p_grid, slab_lo, slab_hi)) {
+                break;
+            }
+            --p_part->hi[axis];
+        }
+    }
+
+    return 1;
+}
+
+float cd_part_hull(const struct cd_grid* p_grid, const uint32_t* p_lo, const uint32_t* p_hi, struct he_compact_mesh* p_hull) {
+    // Every solid voxel of a row lies between the row's first and last solid voxels, so the outer faces of those two
+    // voxels span the same hull as the whole part
+
+    const size_t num_rows = (size_t)(p_hi[1] - p_lo[1]) * (p_hi[2] - p_lo[2]);
+    float* p_points = malloc(sizeof(float) * 3 * 8 * num_rows);
+    size_t num_points = 0;
+
+    for (uint32_t z = p_lo[2]; z < p_hi[2]; ++z) {
+        for (uint32_t y = p_lo[1]; y < p_hi[1]; ++y) {
+            uint32_t first = p_hi[0];
+            uint32_t last = p_lo[0];
+
+            for (uint32_t x = p_lo[0]; x < p_hi[0]; ++x) {
+                if (cd_is_solid(p_grid, x, y, z)) {
+                    first = x < first ? x : first;
+                    last = x;
+                }
+            }
+
+            if (first == p_hi[0]) {
+                continue;
+            }
+
+            for (int c = 0; c < 4; ++c) {
+                const float cy = (float)(y + (c & 1));
+                const float cz = (float)(z + (c >> 1));
+
+                float* p_point = &p_points[num_points++ * 3];
+                p_point[0] = (float)first;
+                p_point[1] = cy;
+                p_point[2] = cz;
+
+                p_point = &p_points[num_points++ * 3];
+                p_point[0] = (float)(last + 1);
+                p_point[1] = cy;
+                p_point[2] = cz;
+            }
+        }
+    }
+
+    const float volume = cd_quickhull(p_points, num_points, p_hull);
+
+    free(p_points);
+
+    return volume;
+}
+
+float cd_quickhull(float* p_points, size_t num_points, struct he_compact_mesh* p_hull) {
+    struct he_mesh hull;
+    quickhull(p_points, num_points, &hull);
+    half_edge_compact(&hull, p_hull);
+    quickhull_free(&hull);
+
+    return cd_hull_volume(p_hull);
+}
+
+float cd_hull_volume(const struct he_compact_mesh* p_hull) {
+    // Sum of the signed volumes of the tetrahedra formed by the origin and a fan triangulation of each face
+
+    float volume = 0;
+    float cross[3];
+
+    for (uint32_t f = 0; f < p_hull->num_faces; ++f) {
+        const uint32_t e0 = p_hull->p_face_edges[f];
+        const float* p_v0 = &p_hull->p_positions[p_hull->p_edge_tails[e0] * 3];
+
+        for (uint32_t e = p_hull->p_edge_nexts[e0]; p_hull->p_edge_nexts[e] != e0; e = p_hull->p_edge_nexts[e]) {
+            const float* p_v1 = &p_hull->p_positions[p_hull->p_edge_tails[e] * 3];
+            const float* p_v2 = &p_hull->p_positions[p_hull->p_edge_tails[p_hull->p_edge_nexts[e]] * 3];
+            vec3_cross(p_v1, p_v2, cross);
+            volume += vec3_dot(p_v0, cross);
+        }
+    }
+
+    return fabsf(volume) / 6.0f;
+}
+
+void cd_evaluate_split(size_t index, void* p_user_data) {
+    struct cd_split_job* p_job = p_user_data;
+
+    struct cd_split* p_split = darr_get(p_job->p_splits, index);
+    const struct cd_part* p_part = darr_get(p_job->p_parts, p_split->part);
+
+    struct cd_part halves[2] = { *p_part, *p_part };
+    halves[0].hi[p_split->axis] = p_split->plane;
+    halves[1].lo[p_split->axis] = p_split->plane;
+
+    for (int h = 0; h < 2; ++h) {
+        p_split->concavity[h] = 0;
+
+        if (!cd_part_tighten(p_split->p_grid, &halves[h])) {
+            continue;
+        }
+
+        struct he_compact_mesh hull;
+        const float hull_volume = cd_part_hull(p_split->p_grid, halves[h].lo, halves[h].hi, &hull);
+        half_edge_compact_free(&hull);
+
+        p_split->concavity[h] = fmaxf(0, hull_volume - (float)cd_count_solid(p_split->p_grid, halves[h].lo, halves[h].hi));
+    }
+}
+
+void cd_hull_part(size_t index, void* p_user_data) {
+    struct cd_hull_job* p_job = p_user_data;
+
+    const struct cd_part* p_part = darr_get(p_job->p_parts, index);
+    struct cd_hull* p_hull = &p_job->p_hulls[index];
+
+    p_hull->volume = cd_part_hull(p_job->p_grid, p_part->lo, p_part->hi, &p_hull->mesh);
+    p_hull->b_alive = 1;
+
+    for (int i = 0; i < 3; ++i) {
+        p_hull->min[i] = (float)p_part->lo[i];
+        p_hull->max[i] = (float)p_part->hi[i];
+    }
+}
+
+void cd_evaluate_merge(size_t index, void* p_user_data) {
+    struct cd_merge* p_merge = p_user_data;
+
+    const uint32_t a = p_merge->p_pairs[index * 2];
+    const uint32_t b = p_merge->p_pairs[index * 2 + 1];
+    const struct cd_hull* p_a = &p_merge->p_hulls[a];
+    const struct cd_hull* p_b = &p_merge->p_hulls[b];
+
+    float* p_cost = &p_merge->p_costs[a * p_merge->num_hulls + b];
+
+    // Only hulls whose boxes touch are merge candidates; merging distant parts would fill the space between them
+    for (int i = 0; i < 3; ++i) {
+        if (p_a->min[i] > p_b->max[i] || p_b->min[i] > p_a->max[i]) {
+            *p_cost = INFINITY;
+            return;
+        }
+    }
+
+    const size_t num_points = p_a->mesh.num_vertices + p_b->mesh.num_vertices;
+    float* p_points = malloc(sizeof(float) * 3 * num_points);
+    memcpy(p_points, p_a->mesh.p_positions, sizeof(float) * 3 * p_a->mesh.num_vertices);
+    memcpy(&p_points[p_a->mesh.num_vertices * 3], p_b->mesh.p_positions, sizeof(float) * 3 * p_b->mesh.num_vertices);
+
+    struct he_compact_mesh merged;
+    *p_cost = cd_quickhull(p_points, num_points, &merged) - p_a->volume - p_b->volume;
+    half_edge_compact_free(&merged);
+
+    free(p_points);
+}
+
+int cd_triangle_box_overlap(const float* p_center, float half_size, const float* p_v0, const float* p_v1, const float* p_v2) {
+    // Separating axis test between a triangle and a cube (Akenine-Moller). The caller only visits voxels inside the
+    // triangle's bounds, so the three box face normals don't need testing.
+
+    float v[3][3];
+    vec3_sub(p_v0, p_center, v[0]);
+    vec3_sub(p_v1, p_center, v[1]);
+    vec3_sub(p_v2, p_center, v[2]);
+
+    float e[3][3];
+    vec3_sub(v[1], v[0], e[0]);
+    vec3_sub(v[2], v[1], e[1]);
+    vec3_sub(v[0], v[2], e[2]);
+
+    // Cross products of the box axes with the triangle edges
+    for (int i = 0; i < 3; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            float a[3] = { 0, 0, 0 };
+            const int j = (axis + 1) % 3;
+            const int k = (axis + 2) % 3;
+            a[j] = -e[i][k];
+            a[k] =  e[i][j];
+
+            const float p0 = vec3_dot(v[0], a);
+            const float p1 = vec3_dot(v[1], a);
+            const float p2 = vec3_dot(v[2], a);
+            const float r = half_size * (fabsf(a[0]) + fabsf(a[1]) + fabsf(a[2]));
+
+            if (fminf(p0, fminf(p1, p2)) > r || fmaxf(p0, fmaxf(p1, p2)) < -r) {
+                return 0;
+            }
+        }
+    }
+
+    // Triangle plane
+    float normal[3];
+    vec3_cross(e[0], e[1], normal);
+    const float r = half_size * (fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]));
+    return fabsf(vec3_dot(normal, v[0])) <= r;
+}
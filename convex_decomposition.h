@@ -0,0 +1,35 @@
+#ifndef _H__CONVEX_DECOMPOSITION
+#define _H__CONVEX_DECOMPOSITION
+
+#include <stdint.h>
+
+#include "asset.h"
+#include "half_edge.h"
+
+#define ASSET_TYPE_CONVEX_DECOMPOSITION 7
+
+struct physics_collider;
+struct static_mesh;
+
+struct convex_decomposition_params {
+    uint32_t resolution;    // voxels along the longest axis of the mesh bounds
+    uint32_t max_hulls;     // parts are merged back together until at most this many remain
+    uint32_t max_depth;     // maximum number of times a part can be split
+    float    max_concavity; // parts whose hull exceeds their volume by less than this fraction of the mesh volume aren't split
+};
+
+/* Approximate convex decomposition of a static mesh (V-HACD style): the mesh is voxelised, the solid voxels are split
+ * recursively along axis-aligned planes that minimise concavity, and the resulting parts are hulled and merged. Hull
+ * positions are in the mesh's local space. */
+ASSET_STRUCT(convex_decomposition) {
+    struct convex_decomposition_params params;
+    struct he_compact_mesh*            p_hulls;
+    uint32_t                           num_hulls;
+};
+
+void         convex_decomposition_params_default(struct convex_decomposition_params* p_params);
+int          convex_decomposition_generate(const struct static_mesh* p_static_mesh, const struct convex_decomposition_params* p_params, struct convex_decomposition* p_result);
+void         convex_decomposition_make_collider(const struct convex_decomposition* p_decomposition, struct physics_collider* p_collider);
+asset_handle convex_decomposition_find_or_generate(struct asset_package* p_package, asset_handle static_mesh_handle, const struct convex_decomposition_params* p_params);
+
+#endif
@@ -0,0 +1,680 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cooked_texture.h"
+#include "image.h"
+#include "logging.h"
+#include "parallel.h"
+#include "platform.h"
+#include "serialization.h"
+
+#ifdef PLATFORM_LINUX
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COOKED_TEXTURE_SSE 1
+#include <emmintrin.h>
+#else
+#define COOKED_TEXTURE_SSE 0
+#endif
+
+#define LOG_CAT_COOKED_TEXTURE "cooked_texture"
+
+#define COOKED_TEXTURE_MAGIC   0x54435843u // "CXCT"
+#define COOKED_TEXTURE_VERSION 2           // bumped whenever cooking changes, so stale cache files are cooked again
+
+struct cooked_texture_cook_job {
+    const asset_handle*                 p_image_handles;
+    const struct cooked_texture_params* p_params;
+    const char*                         s_cache_directory;
+    struct cooked_texture**             pp_results;
+    int*                                p_b_from_cache;
+};
+
+static uint64_t cooked_texture_hash(uint64_t hash, const void* p_bytes, size_t size);
+static uint64_t cooked_texture_hash_image(const struct image* p_image, const struct cooked_texture_params* p_params);
+static size_t   cooked_texture_level_size(uint32_t format, uint32_t width, uint32_t height);
+static void     cooked_texture_sum_rows(const uint8_t* p_row0, const uint8_t* p_row1, size_t size, uint16_t* p_sums);
+static void     cooked_texture_downsample(const uint8_t* p_src, uint32_t src_width, uint32_t src_height, uint32_t num_channels, uint8_t* p_dst, uint16_t* p_row_sums);
+static void     cooked_texture_encode_level(uint32_t format, const uint8_t* p_pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint8_t* p_dst);
+static void     cooked_texture_fetch_block(const uint8_t* p_pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint32_t x, uint32_t y, uint8_t* p_block);
+static void     cooked_texture_encode_bc1(const uint8_t* p_block, uint8_t* p_dst);
+static void     cooked_texture_encode_bc4(const uint8_t* p_block, size_t channel, uint8_t* p_dst);
+static uint16_t cooked_texture_pack_565(const int* p_color);
+static void     cooked_texture_unpack_565(uint16_t packed, int* p_color);
+static void     cooked_texture_make_path(const char* s_directory, uint64_t hash, char* s_path);
+static int      cooked_texture_load_cached(const char* s_path, uint64_t hash, const struct cooked_texture_params* p_params, struct cooked_texture* p_result);
+static void     cooked_texture_save_cached(const char* s_path, const struct cooked_texture* p_texture);
+static void     cooked_texture_cook_image(size_t index, void* p_user_data);
+
+void cooked_texture_params_default(struct cooked_texture_params* p_params) {
+    *p_params = (struct cooked_texture_params) {
+        .b_mipmaps = 1,
+        .b_compress = 1,
+        .b_s3tc = 0
+    };
+}
+
+int cooked_texture_cook(const struct image* p_image, const struct cooked_texture_params* p_params, struct cooked_texture* p_result) {
+    *p_result = (struct cooked_texture) {
+        .params = *p_params,
+        .source_hash = cooked_texture_hash_image(p_image, p_params)
+    };
+
+    const uint32_t num_channels = p_image->num_channels;
+
+    if (!p_image->p_pixel_data || p_image->width == 0 || p_image->height == 0 || num_channels < 1 || num_channels > 4) {
+        return 0;
+    }
+
+    static const uint32_t formats[2][4] = {
+        { COOKED_TEXTURE_FORMAT_r8,  COOKED_TEXTURE_FORMAT_rg8, COOKED_TEXTURE_FORMAT_rgb8, COOKED_TEXTURE_FORMAT_rgba8 },
+        { COOKED_TEXTURE_FORMAT_bc4, COOKED_TEXTURE_FORMAT_bc5, COOKED_TEXTURE_FORMAT_bc1,  COOKED_TEXTURE_FORMAT_bc3 }
+    };
+
+    // BC4 and BC5 are core (RGTC), but without S3TC, 3 and 4 channel images are left uncompressed
+    const int b_compress = p_params->b_compress && (num_channels < 3 || p_params->b_s3tc);
+    p_result->format = formats[b_compress ? 1 : 0][num_channels - 1];
+
+    uint32_t width = p_image->width;
+    uint32_t height = p_image->height;
+    size_t data_size = 0;
+
+    while (p_result->num_levels < COOKED_TEXTURE_MAX_LEVELS) {
+        const size_t level_size = cooked_texture_level_size(p_result->format, width, height);
+
+        if (data_size + level_size > UINT32_MAX) {
+            return 0;
+        }
+
+        p_result->levels[p_result->num_levels++] = (struct cooked_texture_level) {
+            .width = width,
+            .height = height,
+            .offset = (uint32_t)data_size,
+            .size = (uint32_t)level_size
+        };
+
+        data_size += level_size;
+
+        if (!p_params->b_mipmaps || (width == 1 && height == 1)) {
+            break;
+        }
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    p_result->data_size = (uint32_t)data_size;
+    p_result->p_data = malloc(data_size);
+
+    // Each level is filtered down from the uncompressed one above it, never from its compressed blocks
+    const size_t row_size = (size_t)p_image->width * num_channels;
+    uint8_t* p_levels[2] = { 0 };
+    uint16_t* p_row_sums = 0;
+
+    if (p_result->num_levels > 1) {
+        p_levels[0] = malloc(((size_t)p_image->width / 2 + 1) * ((size_t)p_image->height / 2 + 1) * num_channels);
+        p_levels[1] = malloc(((size_t)p_image->width / 4 + 1) * ((size_t)p_image->height / 4 + 1) * num_channels);
+        p_row_sums = malloc(row_size * sizeof(uint16_t));
+    }
+
+    const uint8_t* p_pixels = p_image->p_pixel_data;
+
+    for (uint32_t i = 0; i < p_result->num_levels; ++i) {
+        const struct cooked_texture_level* p_level = &p_result->levels[i];
+        uint8_t* p_dst = (uint8_t*)p_result->p_data + p_level->offset;
+
+        if (cooked_texture_is_compressed(p_result->format)) {
+            cooked_texture_encode_level(p_result->format, p_pixels, p_level->width, p_level->height, num_channels, p_dst);
+        } else {
+            memcpy(p_dst, p_pixels, p_level->size);
+        }
+
+        if (i + 1 < p_result->num_levels) {
+            uint8_t* p_next = p_levels[i % 2];
+            cooked_texture_downsample(p_pixels, p_level->width, p_level->height, num_channels, p_next, p_row_sums);
+            p_pixels = p_next;
+        }
+    }
+
+    free(p_levels[0]);
+    free(p_levels[1]);
+    free(p_row_sums);
+
+    return 1;
+}
+
+uint32_t cooked_texture_num_channels(uint32_t format) {
+    switch (format) {
+        case COOKED_TEXTURE_FORMAT_r8:
+        case COOKED_TEXTURE_FORMAT_bc4:   return 1;
+        case COOKED_TEXTURE_FORMAT_rg8:
+        case COOKED_TEXTURE_FORMAT_bc5:   return 2;
+        case COOKED_TEXTURE_FORMAT_rgb8:
+        case COOKED_TEXTURE_FORMAT_bc1:   return 3;
+        case COOKED_TEXTURE_FORMAT_rgba8:
+        case COOKED_TEXTURE_FORMAT_bc3:   return 4;
+    }
+    return 0;
+}
+
+int cooked_texture_is_compressed(uint32_t format) {
+    return format >= COOKED_TEXTURE_FORMAT_bc1;
+}
+
+void cooked_texture_cook_images(struct asset_package* p_package, const asset_handle* p_image_handles, size_t num_images, const struct cooked_texture_params* p_params, const char* s_cache_directory, asset_handle* p_results) {
+    if (s_cache_directory) {
+#ifdef PLATFORM_WINDOWS
+        CreateDirectoryA(s_cache_directory, NULL);
+#elif defined(PLATFORM_LINUX)
+        mkdir(s_cache_directory, 0755);
+#endif
+    }
+
+    struct cooked_texture_cook_job job = {
+        .p_image_handles = p_image_handles,
+        .p_params = p_params,
+        .s_cache_directory = s_cache_directory,
+        .pp_results = calloc(num_images, sizeof(struct cooked_texture*)),
+        .p_b_from_cache = calloc(num_images, sizeof(int))
+    };
+
+    parallel_for(num_images, cooked_texture_cook_image, &job);
+
+    unsigned num_cooked = 0;
+    unsigned num_from_cache = 0;
+
+    for (size_t i = 0; i < num_images; ++i) {
+        p_results[i] = 0;
+
+        if (!job.pp_results[i]) {
+            continue;
+        }
+
+        const asset_handle image_handle = p_image_handles[i];
+        const asset_id id = ASSET_ID(ASSET_TYPE_COOKED_TEXTURE, GET_ASSET_IDN(image_handle->_asset._id));
+
+        asset_handle handle = asset_package_find_record(p_package, id);
+
+        if (handle) {
+            asset_free(handle);
+        } else {
+            handle = asset_package_new_record_with_id(p_package, id);
+            snprintf(handle->_asset.s_name, ASSET_NAME_MAX_LEN, "%.*s cooked", ASSET_NAME_MAX_LEN - 8, image_handle->_asset.s_name);
+        }
+
+        handle->_asset._p_data = job.pp_results[i];
+        p_results[i] = handle;
+
+        if (job.p_b_from_cache[i]) {
+            ++num_from_cache;
+        } else {
+            ++num_cooked;
+        }
+    }
+
+    cx_log_fmt(CX_LOG_INFO, LOG_CAT_COOKED_TEXTURE, "%u textures cooked, %u loaded from the cache\n", num_cooked, num_from_cache);
+
+    free(job.pp_results);
+    free(job.p_b_from_cache);
+}
+
+int cooked_texture_serialize(FILE* p_file, const void* p_cooked_texture) {
+    const struct cooked_texture* p_texture = p_cooked_texture;
+
+    serialize_int32(p_file, p_texture->params.b_mipmaps);
+    serialize_int32(p_file, p_texture->params.b_compress);
+    serialize_int32(p_file, p_texture->params.b_s3tc);
+    serialize_bytes(p_file, &p_texture->source_hash, sizeof(p_texture->source_hash));
+    serialize_uint32(p_file, p_texture->format);
+    serialize_uint32(p_file, p_texture->num_levels);
+
+    for (uint32_t i = 0; i < p_texture->num_levels; ++i) {
+        serialize_uint32(p_file, p_texture->levels[i].width);
+        serialize_uint32(p_file, p_texture->levels[i].height);
+        serialize_uint32(p_file, p_texture->levels[i].offset);
+        serialize_uint32(p_file, p_texture->levels[i].size);
+    }
+
+    serialize_uint32(p_file, p_texture->data_size);
+    serialize_bytes(p_file, p_texture->p_data, p_texture->data_size);
+
+    return !ferror(p_file);
+}
+
+int cooked_texture_deserialize(FILE* p_file, void* p_cooked_texture) {
+    struct cooked_texture* p_texture = p_cooked_texture;
+    *p_texture = (struct cooked_texture){0};
+
+    int32_t b_mipmaps = 0;
+    int32_t b_compress = 0;
+    int32_t b_s3tc = 0;
+    deserialize_int32(p_file, &b_mipmaps);
+    deserialize_int32(p_file, &b_compress);
+    deserialize_int32(p_file, &b_s3tc);
+    p_texture->params = (struct cooked_texture_params) {
+        .b_mipmaps = b_mipmaps,
+        .b_compress = b_compress,
+        .b_s3tc = b_s3tc
+    };
+
+    deserialize_bytes(p_file, &p_texture->source_hash, sizeof(p_texture->source_hash));
+    deserialize_uint32(p_file, &p_texture->format);
+    deserialize_uint32(p_file, &p_texture->num_levels);
+
+    if (ferror(p_file) || feof(p_file) || p_texture->format > COOKED_TEXTURE_FORMAT_bc5 || p_texture->num_levels == 0 || p_texture->num_levels > COOKED_TEXTURE_MAX_LEVELS) {
+        cx_log(CX_LOG_ERROR, LOG_CAT_COOKED_TEXTURE, "Failed to deserialize cooked texture: invalid header\n");
+        *p_texture = (struct cooked_texture){0};
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < p_texture->num_levels; ++i) {
+        deserialize_uint32(p_file, &p_texture->levels[i].width);
+        deserialize_uint32(p_file, &p_texture->levels[i].height);
+        deserialize_uint32(p_file, &p_texture->levels[i].offset);
+        deserialize_uint32(p_file, &p_texture->levels[i].size);
+    }
+
+    deserialize_uint32(p_file, &p_texture->data_size);
+
+    for (uint32_t i = 0; i < p_texture->num_levels; ++i) {
+        const struct cooked_texture_level* p_level = &p_texture->levels[i];
+
+        if ((uint64_t)p_level->offset + p_level->size > p_texture->data_size || p_level->size != cooked_texture_level_size(p_texture->format, p_level->width, p_level->height)) {
+            cx_log(CX_LOG_ERROR, LOG_CAT_COOKED_TEXTURE, "Failed to deserialize cooked texture: invalid levels\n");
+            *p_texture = (struct cooked_texture){0};
+            return 0;
+        }
+    }
+
+    // All the levels in one read, to be uploaded from as they are
+    p_texture->p_data = malloc(p_texture->data_size);
+    deserialize_bytes(p_file, p_texture->p_data, p_texture->data_size);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, LOG_CAT_COOKED_TEXTURE, "Failed to deserialize cooked texture: unexpected end of file\n");
+        cooked_texture_free(p_texture);
+        return 0;
+    }
+
+    return 1;
+}
+
+void cooked_texture_free(void* p_cooked_texture) {
+    struct cooked_texture* p_texture = p_cooked_texture;
+    free(p_texture->p_data);
+    *p_texture = (struct cooked_texture){0};
+}
+
+uint64_t cooked_texture_hash(uint64_t hash, const void* p_bytes, size_t size) {
+    // FNV-1a
+    const uint8_t* p = p_bytes;
+
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211u;
+    }
+
+    return hash;
+}
+
+uint64_t cooked_texture_hash_image(const struct image* p_image, const struct cooked_texture_params* p_params) {
+    const uint32_t header[7] = {
+        COOKED_TEXTURE_VERSION,
+        p_image->width,
+        p_image->height,
+        p_image->num_channels,
+        (uint32_t)p_params->b_mipmaps,
+        (uint32_t)p_params->b_compress,
+        (uint32_t)p_params->b_s3tc
+    };
+
+    uint64_t hash = cooked_texture_hash(14695981039346656037u, header, sizeof(header));
+
+    if (p_image->p_pixel_data) {
+        hash = cooked_texture_hash(hash, p_image->p_pixel_data, (size_t)p_image->width * p_image->height * p_image->num_channels);
+    }
+
+    return hash;
+}
+
+size_t cooked_texture_level_size(uint32_t format, uint32_t width, uint32_t height) {
+    const size_t num_blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+
+    switch (format) {
+        case COOKED_TEXTURE_FORMAT_bc1:
+        case COOKED_TEXTURE_FORMAT_bc4: return num_blocks * 8;
+        case COOKED_TEXTURE_FORMAT_bc3:
+        case COOKED_TEXTURE_FORMAT_bc5: return num_blocks * 16;
+    }
+
+    return (size_t)width * height * cooked_texture_num_channels(format);
+}
+
+void cooked_texture_sum_rows(const uint8_t* p_row0, const uint8_t* p_row1, size_t size, uint16_t* p_sums) {
+    size_t i = 0;
+
+#if COOKED_TEXTURE_SSE
+    // Adding rows doesn't care which channel a byte is, so it's done 16 bytes at a time
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i*)&p_row0[i]);
+        const __m128i b = _mm_loadu_si128((const __m128i*)&p_row1[i]);
+        _mm_storeu_si128((__m128i*)&p_sums[i], _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+        _mm_storeu_si128((__m128i*)&p_sums[i + 8], _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        p_sums[i] = (uint16_t)(p_row0[i] + p_row1[i]);
+    }
+}
+
+void cooked_texture_downsample(const uint8_t* p_src, uint32_t src_width, uint32_t src_height, uint32_t num_channels, uint8_t* p_dst, uint16_t* p_row_sums) {
+    // 2x2 box filter. Odd sizes drop their last row or column, as glGenerateMipmap usually does, and a side of 1 stays 1.
+    const uint32_t dst_width = src_width > 1 ? src_width / 2 : 1;
+    const uint32_t dst_height = src_height > 1 ? src_height / 2 : 1;
+    const size_t src_row_size = (size_t)src_width * num_channels;
+
+    for (uint32_t y = 0; y < dst_height; ++y) {
+        const uint32_t y1 = 2 * y + 1 < src_height ? 2 * y + 1 : src_height - 1;
+        cooked_texture_sum_rows(&p_src[(size_t)(2 * y) * src_row_size], &p_src[(size_t)y1 * src_row_size], src_row_size, p_row_sums);
+
+        uint8_t* p_dst_row = &p_dst[(size_t)y * dst_width * num_channels];
+
+        for (uint32_t x = 0; x < dst_width; ++x) {
+            const size_t x0 = (size_t)(2 * x) * num_channels;
+            const size_t x1 = (size_t)(2 * x + 1 < src_width ? 2 * x + 1 : src_width - 1) * num_channels;
+
+            for (uint32_t c = 0; c < num_channels; ++c) {
+                p_dst_row[x * num_channels + c] = (uint8_t)((p_row_sums[x0 + c] + p_row_sums[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void cooked_texture_encode_level(uint32_t format, const uint8_t* p_pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint8_t* p_dst) {
+    uint8_t block[16 * 4];
+
+    for (uint32_t y = 0; y < height; y += 4) {
+        for (uint32_t x = 0; x < width; x += 4) {
+            cooked_texture_fetch_block(p_pixels, width, height, num_channels, x, y, block);
+
+            switch (format) {
+                case COOKED_TEXTURE_FORMAT_bc1:
+                    cooked_texture_encode_bc1(block, p_dst);
+                    p_dst += 8;
+                    break;
+                case COOKED_TEXTURE_FORMAT_bc3:
+                    cooked_texture_encode_bc4(block, 3, p_dst);
+                    cooked_texture_encode_bc1(block, p_dst + 8);
+                    p_dst += 16;
+                    break;
+                case COOKED_TEXTURE_FORMAT_bc4:
+                    cooked_texture_encode_bc4(block, 0, p_dst);
+                    p_dst += 8;
+                    break;
+                case COOKED_TEXTURE_FORMAT_bc5:
+                    cooked_texture_encode_bc4(block, 0, p_dst);
+                    cooked_texture_encode_bc4(block, 1, p_dst + 8);
+                    p_dst += 16;
+                    break;
+            }
+        }
+    }
+}
+
+void cooked_texture_fetch_block(const uint8_t* p_pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint32_t x, uint32_t y, uint8_t* p_block) {
+    // Blocks hanging over the edge repeat the edge pixels, which keeps them out of the way of the endpoints
+    for (uint32_t by = 0; by < 4; ++by) {
+        const uint32_t py = y + by < height ? y + by : height - 1;
+
+        for (uint32_t bx = 0; bx < 4; ++bx) {
+            const uint32_t px = x + bx < width ? x + bx : width - 1;
+            const uint8_t* p_pixel = &p_pixels[((size_t)py * width + px) * num_channels];
+            uint8_t* p_texel = &p_block[(by * 4 + bx) * 4];
+
+            p_texel[0] = p_texel[1] = p_texel[2] = 0;
+            p_texel[3] = 0xFF;
+
+            for (uint32_t c = 0; c < num_channels; ++c) {
+                p_texel[c] = p_pixel[c];
+            }
+        }
+    }
+}
+
+void cooked_texture_encode_bc1(const uint8_t* p_block, uint8_t* p_dst) {
+    int min[3] = { 255, 255, 255 };
+    int max[3] = { 0, 0, 0 };
+    int sum[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const int v = p_block[i * 4 + c];
+            min[c] = v < min[c] ? v : min[c];
+            max[c] = v > max[c] ? v : max[c];
+            sum[c] += v;
+        }
+    }
+
+    /* Endpoints are the corners of the colors' bounding box, inset a little since the extremes are rarely worth
+     * reproducing exactly. The box's main diagonal only fits colors that rise together, so a channel that falls as
+     * the widest one rises swaps its ends. */
+    int widest = 0;
+
+    for (int c = 1; c < 3; ++c) {
+        widest = max[c] - min[c] > max[widest] - min[widest] ? c : widest;
+    }
+
+    int covariance[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; ++i) {
+        const int d_widest = p_block[i * 4 + widest] * 16 - sum[widest];
+
+        for (int c = 0; c < 3; ++c) {
+            covariance[c] += (p_block[i * 4 + c] * 16 - sum[c]) * d_widest / 16;
+        }
+    }
+
+    int endpoints[2][3];
+
+    for (int c = 0; c < 3; ++c) {
+        const int hi = covariance[c] < 0 ? min[c] : max[c];
+        const int lo = covariance[c] < 0 ? max[c] : min[c];
+        const int inset = (hi - lo) / 16;
+
+        endpoints[0][c] = hi - inset;
+        endpoints[1][c] = lo + inset;
+    }
+
+    uint16_t packed[2] = {
+        cooked_texture_pack_565(endpoints[0]),
+        cooked_texture_pack_565(endpoints[1])
+    };
+
+    // The first endpoint has to be the larger one for the block to have 4 colors rather than 3 and transparent black
+    if (packed[0] < packed[1]) {
+        const uint16_t t = packed[0];
+        packed[0] = packed[1];
+        packed[1] = t;
+    }
+
+    int palette[4][3];
+    cooked_texture_unpack_565(packed[0], palette[0]);
+    cooked_texture_unpack_565(packed[1], palette[1]);
+
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+
+    if (packed[0] != packed[1]) {
+        for (int i = 0; i < 16; ++i) {
+            int best = 0;
+            int best_distance = 0x7FFFFFFF;
+
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+
+                for (int c = 0; c < 3; ++c) {
+                    const int d = p_block[i * 4 + c] - palette[p][c];
+                    distance += d * d;
+                }
+
+                if (distance < best_distance) {
+                    best = p;
+                    best_distance = distance;
+                }
+            }
+
+            indices |= (uint32_t)best << (i * 2);
+        }
+    }
+
+    p_dst[0] = (uint8_t)packed[0];
+    p_dst[1] = (uint8_t)(packed[0] >> 8);
+    p_dst[2] = (uint8_t)packed[1];
+    p_dst[3] = (uint8_t)(packed[1] >> 8);
+
+    for (int i = 0; i < 4; ++i) {
+        p_dst[4 + i] = (uint8_t)(indices >> (i * 8));
+    }
+}
+
+void cooked_texture_encode_bc4(const uint8_t* p_block, size_t channel, uint8_t* p_dst) {
+    int min = 255;
+    int max = 0;
+
+    for (int i = 0; i < 16; ++i) {
+        const int v = p_block[i * 4 + channel];
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+    }
+
+    // max first selects the mode with 6 values between the endpoints: index 0 is max, 1 is min and 2 to 7 step down
+    p_dst[0] = (uint8_t)max;
+    p_dst[1] = (uint8_t)min;
+
+    uint64_t indices = 0;
+
+    if (max > min) {
+        const int range = max - min;
+
+        for (int i = 0; i < 16; ++i) {
+            const int step = (14 * (p_block[i * 4 + channel] - min) + range) / (2 * range); // 0 at min to 7 at max
+            const int index = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+            indices |= (uint64_t)index << (i * 3);
+        }
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        p_dst[2 + i] = (uint8_t)(indices >> (i * 8));
+    }
+}
+
+uint16_t cooked_texture_pack_565(const int* p_color) {
+    const int r = (p_color[0] * 31 + 127) / 255;
+    const int g = (p_color[1] * 63 + 127) / 255;
+    const int b = (p_color[2] * 31 + 127) / 255;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+void cooked_texture_unpack_565(uint16_t packed, int* p_color) {
+    const int r = (packed >> 11) & 0x1F;
+    const int g = (packed >> 5) & 0x3F;
+    const int b = packed & 0x1F;
+    p_color[0] = (r << 3) | (r >> 2);
+    p_color[1] = (g << 2) | (g >> 4);
+    p_color[2] = (b << 3) | (b >> 2);
+}
+
+void cooked_texture_make_path(const char* s_directory, uint64_t hash, char* s_path) {
+    snprintf(s_path, COOKED_TEXTURE_PATH_LEN, "%s/%08x%08x.cxt", s_directory, (unsigned)(hash >> 32), (unsigned)hash);
+}
+
+int cooked_texture_load_cached(const char* s_path, uint64_t hash, const struct cooked_texture_params* p_params, struct cooked_texture* p_result) {
+    FILE* p_file = fopen(s_path, "rb");
+
+    if (!p_file) {
+        return 0;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    deserialize_uint32(p_file, &magic);
+    deserialize_uint32(p_file, &version);
+
+    int b_result = magic == COOKED_TEXTURE_MAGIC && version == COOKED_TEXTURE_VERSION && cooked_texture_deserialize(p_file, p_result);
+
+    fclose(p_file);
+
+    // The hash names the file, but it's the contents that have to match
+    if (b_result && (p_result->source_hash != hash || memcmp(&p_result->params, p_params, sizeof(*p_params)))) {
+        cooked_texture_free(p_result);
+        b_result = 0;
+    }
+
+    return b_result;
+}
+
+void cooked_texture_save_cached(const char* s_path, const struct cooked_texture* p_texture) {
+    FILE* p_file = fopen(s_path, "wb");
+
+    if (!p_file) {
+        cx_log_fmt(CX_LOG_WARNING, LOG_CAT_COOKED_TEXTURE, "Couldn't write cooked texture '%s'\n", s_path);
+        return;
+    }
+
+    serialize_uint32(p_file, COOKED_TEXTURE_MAGIC);
+    serialize_uint32(p_file, COOKED_TEXTURE_VERSION);
+    const int b_result = cooked_texture_serialize(p_file, p_texture);
+
+    fclose(p_file);
+
+    if (!b_result) {
+        remove(s_path);
+    }
+}
+
+void cooked_texture_cook_image(size_t index, void* p_user_data) {
+    const struct cooked_texture_cook_job* p_job = p_user_data;
+    const asset_handle image_handle = p_job->p_image_handles[index];
+    const struct image* p_image = image_handle->_asset._p_data;
+
+    if (!p_image) {
+        return;
+    }
+
+    struct cooked_texture* p_texture = calloc(1, sizeof(struct cooked_texture));
+    char s_path[COOKED_TEXTURE_PATH_LEN];
+
+    if (p_job->s_cache_directory) {
+        const uint64_t hash = cooked_texture_hash_image(p_image, p_job->p_params);
+        cooked_texture_make_path(p_job->s_cache_directory, hash, s_path);
+
+        if (cooked_texture_load_cached(s_path, hash, p_job->p_params, p_texture)) {
+            p_job->pp_results[index] = p_texture;
+            p_job->p_b_from_cache[index] = 1;
+            return;
+        }
+    }
+
+    if (!cooked_texture_cook(p_image, p_job->p_params, p_texture)) {
+        cx_log_fmt(CX_LOG_ERROR, LOG_CAT_COOKED_TEXTURE, "Couldn't cook image '%s'\n", image_handle->_asset.s_name);
+        cooked_texture_free(p_texture);
+        free(p_texture);
+        return;
+    }
+
+    if (p_job->s_cache_directory) {
+        cooked_texture_save_cached(s_path, p_texture);
+    }
+
+    p_job->pp_results[index] = p_texture;
+}
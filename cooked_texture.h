@@ -0,0 +1,63 @@
+#ifndef _H__COOKED_TEXTURE
+#define _H__COOKED_TEXTURE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "asset.h"
+
+#define ASSET_TYPE_COOKED_TEXTURE 9
+
+#define COOKED_TEXTURE_MAX_LEVELS 16
+#define COOKED_TEXTURE_PATH_LEN   260
+
+struct image;
+
+enum cooked_texture_format {
+    COOKED_TEXTURE_FORMAT_r8,
+    COOKED_TEXTURE_FORMAT_rg8,
+    COOKED_TEXTURE_FORMAT_rgb8,
+    COOKED_TEXTURE_FORMAT_rgba8,
+    COOKED_TEXTURE_FORMAT_bc1, // RGB, 8 bytes per 4x4 block
+    COOKED_TEXTURE_FORMAT_bc3, // RGBA, 16 bytes per block
+    COOKED_TEXTURE_FORMAT_bc4, // R, 8 bytes per block
+    COOKED_TEXTURE_FORMAT_bc5  // RG, 16 bytes per block
+};
+
+struct cooked_texture_params {
+    int b_mipmaps;
+    int b_compress; // 1, 2, 3 and 4 channel images become BC4, BC5, BC1 and BC3
+    int b_s3tc;     // whether BC1 and BC3 may be used, which GL 3.3 only has through EXT_texture_compression_s3tc
+};
+
+struct cooked_texture_level {
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset; // bytes into p_data
+    uint32_t size;
+};
+
+/* An image prepared offline for uploading as it is: its whole mip chain, box filtered on the CPU, and optionally block
+ * compressed. The levels are stored back to back in one allocation, largest first, so a device texture is created
+ * straight from p_data without touching the pixels. */
+ASSET_STRUCT(cooked_texture) {
+    struct cooked_texture_params params;
+    uint64_t                     source_hash; // of the image and params it was cooked from
+    uint32_t                     format;      // enum cooked_texture_format
+    uint32_t                     num_levels;
+    struct cooked_texture_level  levels[COOKED_TEXTURE_MAX_LEVELS];
+    uint32_t                     data_size;
+    void*                        p_data;
+};
+
+void     cooked_texture_params_default(struct cooked_texture_params* p_params);
+int      cooked_texture_cook(const struct image* p_image, const struct cooked_texture_params* p_params, struct cooked_texture* p_result);
+uint32_t cooked_texture_num_channels(uint32_t format);
+int      cooked_texture_is_compressed(uint32_t format);
+
+/* The import step: cooks every image in parallel and adds the results to p_package, sharing each source image's IDN.
+ * Cooked textures are also saved to s_cache_directory (unless that's 0), keyed by a hash of the image and params, and
+ * loaded from there on later runs instead of being cooked again. An image that couldn't be cooked gets a 0 handle. */
+void cooked_texture_cook_images(struct asset_package* p_package, const asset_handle* p_image_handles, size_t num_images, const struct cooked_texture_params* p_params, const char* s_cache_directory, asset_handle* p_results);
+
+#endif
@@ -1,11 +1,17 @@
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "asset.h"
+#include "convex_decomposition.h"
 #include "dev.h"
+#include "dev_draw.h"
 #include "gl_mesh.h"
 #include "gl_program.h"
+#include "gl_program_cache.h"
 #include "gltf.h"
 #include "half_edge.h"
+#include "hashtable.h"
 #include "import_gltf.h"
 #include "input.h"
 #include "logging.h"
@@ -20,6 +26,7 @@
 #include "scene.h"
 #include "static_mesh.h"
 #include "transform.h"
+#include "triangle_bvh.h"
 #include "vector.h"
 
 #define DEV_MESH_ID_CAPTURER_ID_GIZMO_T_X      1
@@ -66,10 +73,6 @@ static struct dev_state {
     int                           b_is_dragging;
 
     struct gl_program             gl_program_flat;
-    GLuint                        gl_program_flat_u_projection_matrix;
-    GLuint                        gl_program_flat_u_view_matrix;
-    GLuint                        gl_program_flat_u_model_matrix;
-    GLuint                        gl_program_flat_u_color;
     
     struct asset_package          asset_package;
 
@@ -78,10 +81,11 @@ static struct dev_state {
     float                         camera_position[3];
 
     struct physics_world*         p_physics_world;
-    struct gl_mesh                gl_physics_collider_meshes[4];
+    struct gl_mesh                gl_physics_collider_meshes[6];
     int                           b_draw_physics;
     float*                        p_hull_points;
     size_t                        num_hull_points;
+    struct hashtable              physics_compound_edges; // struct physics_compound* -> struct darr of hull edges
 
     struct gizmos_state {
         enum gizmo_type      active_type;
@@ -117,8 +121,14 @@ static void on_mouse_button(const void* p_event_data, void* p_user_ptr);
 static void on_mouse_move(const void* p_event_data, void* p_user_ptr);
 
 static void set_selected_entity(struct scene_entity* p_entity);
+static const struct static_mesh* get_entity_mesh(const struct scene_entity* p_entity);
+static struct physics_object* get_entity_physics_object(const struct scene_entity* p_entity);
 
 static void draw_physics(void);
+static void draw_physics_compound(const struct physics_compound* p_compound, const float* p_transform);
+static const struct darr* get_physics_compound_edges(const struct physics_compound* p_compound);
+static void clear_physics_compound_edges(void);
+static void draw_physics_mesh(const struct physics_mesh* p_mesh, const float* p_transform);
 
 static void compute_physics_collider_transform_matrix(const struct physics_collider* p_collider, const struct transform* p_transform, float* p_collider_transform_matrix);
 
@@ -137,59 +147,50 @@ static void  gizmo_drag_scale_axis(const float* p_control_axis, const float* p_c
 static void  gizmo_drag_scale_plane(const float* p_control_plane_normal, const float* p_cursor_ray_origin, const float* p_cursor_ray);
 static void  gizmo_drag_scale_uniformly(const float* p_control_plane_normal, const float* p_cursor_ray_origin, const float* p_cursor_ray);
 
-static void mesh_selector_render_pass(size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix);
+static void mesh_selector_render_pass_submit_scene(void);
 static void mesh_selector_render_pass_submit_gizmo_control(const struct gizmo_control* p_control);
 
 static void draw_hull_DEBUGDEBUGDEBUG(void);
 
-void dev_init(const struct platform_window* p_platform_window, struct scene* p_scene, struct physics_world* p_physics_world) {
+void dev_init(const struct platform_window* p_platform_window, struct scene* p_scene, struct physics_world* p_physics_world, struct gl_program_cache* p_gl_program_cache) {
     g_dev.p_platform_window = p_platform_window;
 
     g_dev.p_scene = p_scene;
 
     g_dev.p_physics_world = p_physics_world;
 
-    mesh_id_capturer_init(&g_dev.mesh_id_capturer);
+    mesh_id_capturer_init(&g_dev.mesh_id_capturer, p_gl_program_cache);
+    hashtable_init(&g_dev.physics_compound_edges, sizeof(struct darr));
+    dev_draw_init(p_gl_program_cache);
 
     input_event_subscribe(INPUT_EVENT_key, on_key, 0);
     input_event_subscribe(INPUT_EVENT_mouse_button, on_mouse_button, 0);
     input_event_subscribe(INPUT_EVENT_mouse_move, on_mouse_move, 0);
 
-    struct gl_shader gl_vertex_shader;
-    struct gl_shader gl_fragment_shader;
-
-    gl_shader_create(&gl_vertex_shader, GL_VERTEX_SHADER);
-    gl_shader_compile(&gl_vertex_shader,
-        "#version 330 core\n"
-        "uniform mat4 u_projection_matrix;"
-        "uniform mat4 u_view_matrix;"
-        "uniform mat4 u_model_matrix;"
-        "layout (location=0) in vec3 a_pos;"
-        "void main() {"
-            "gl_Position = u_projection_matrix * u_view_matrix * u_model_matrix * vec4(a_pos, 1.0);"
-        "}");
-
-    gl_shader_create(&gl_fragment_shader, GL_FRAGMENT_SHADER);
-    gl_shader_compile(&gl_fragment_shader,
-        "#version 330 core\n"
-        "uniform vec3 u_color;"
-        "out vec4 f_color;"
-        "void main() {"
-            "f_color = vec4(u_color, 1.0);"
-        "}");
-
-    gl_program_create(&g_dev.gl_program_flat);
-    gl_program_attach_shader(&g_dev.gl_program_flat, &gl_vertex_shader);
-    gl_program_attach_shader(&g_dev.gl_program_flat, &gl_fragment_shader);
-    gl_program_link(&g_dev.gl_program_flat);
-
-    gl_shader_destroy(&gl_vertex_shader);
-    gl_shader_destroy(&gl_fragment_shader);
-
-    g_dev.gl_program_flat_u_projection_matrix = glGetUniformLocation(g_dev.gl_program_flat.gl_handle, "u_projection_matrix");
-    g_dev.gl_program_flat_u_view_matrix = glGetUniformLocation(g_dev.gl_program_flat.gl_handle, "u_view_matrix");
-    g_dev.gl_program_flat_u_model_matrix = glGetUniformLocation(g_dev.gl_program_flat.gl_handle, "u_model_matrix");
-    g_dev.gl_program_flat_u_color = glGetUniformLocation(g_dev.gl_program_flat.gl_handle, "u_color");
+    const struct gl_program_source program_flat_sources[] = {
+        {
+            GL_VERTEX_SHADER,
+            "#version 330 core\n"
+            "uniform mat4 u_projection_matrix;"
+            "uniform mat4 u_view_matrix;"
+            "uniform mat4 u_model_matrix;"
+            "layout (location=0) in vec3 a_pos;"
+            "void main() {"
+                "gl_Position = u_projection_matrix * u_view_matrix * u_model_matrix * vec4(a_pos, 1.0);"
+            "}"
+        },
+        {
+            GL_FRAGMENT_SHADER,
+            "#version 330 core\n"
+            "uniform vec3 u_color;"
+            "out vec4 f_color;"
+            "void main() {"
+                "f_color = vec4(u_color, 1.0);"
+            "}"
+        }
+    };
+
+    gl_program_cache_load(p_gl_program_cache, program_flat_sources, 2, 0, &g_dev.gl_program_flat);
 
     asset_package_init(&g_dev.asset_package);
 
@@ -214,15 +215,18 @@ void dev_init(const struct platform_window* p_platform_window, struct scene* p_s
         .num_primitives = 1
     };
     struct he_mesh static_mesh_hull;
+    struct he_compact_mesh static_mesh_hull_compact;
 
     quickhull_static_mesh(&static_mesh, &static_mesh_hull);
+    half_edge_compact(&static_mesh_hull, &static_mesh_hull_compact);
+    quickhull_free(&static_mesh_hull);
 
-    half_edge_get_vertices(&static_mesh_hull, 0, &g_dev.num_hull_points);
+    half_edge_get_vertices(&static_mesh_hull_compact, 0, &g_dev.num_hull_points);
 
     g_dev.p_hull_points = malloc(sizeof(float) * 3 * g_dev.num_hull_points);
-    half_edge_get_vertices(&static_mesh_hull, g_dev.p_hull_points, &g_dev.num_hull_points);
+    half_edge_get_vertices(&static_mesh_hull_compact, g_dev.p_hull_points, &g_dev.num_hull_points);
 
-    quickhull_free(&static_mesh_hull);
+    half_edge_compact_free(&static_mesh_hull_compact);
 
     mesh_factory_free_primitive(&mesh_primitive);
     
@@ -231,6 +235,8 @@ void dev_init(const struct platform_window* p_platform_window, struct scene* p_s
     gl_mesh_create(&g_dev.gl_physics_collider_meshes[PHYSICS_COLLIDER_TYPE_plane], &mesh_primitive);
     mesh_factory_free_primitive(&mesh_primitive);
 
+    // Compounds and triangle meshes have no mesh of their own, being drawn in lines by draw_physics
+
     // load gizmos
     
     g_dev.gizmos.active_type = GIZMO_TYPE_translate;
@@ -319,6 +325,10 @@ void dev_init(const struct platform_window* p_platform_window, struct scene* p_s
 
 void dev_shutdown(void) {
     mesh_id_capturer_destroy(&g_dev.mesh_id_capturer);
+    dev_draw_shutdown();
+
+    clear_physics_compound_edges();
+    hashtable_free(&g_dev.physics_compound_edges);
 
     input_event_unsubscribe(INPUT_EVENT_key, on_key);
     input_event_unsubscribe(INPUT_EVENT_mouse_button, on_mouse_button);
@@ -348,21 +358,19 @@ void dev_shutdown(void) {
     asset_package_free(&g_dev.asset_package);
 }
 
-void dev_draw(GLuint gl_framebuffer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix) {
+void dev_draw(const float* p_projection_matrix, const float* p_view_matrix, float delta_seconds) {
     matrix_multiply(p_projection_matrix, p_view_matrix, g_dev.perspective_view_matrix);
     
     g_dev.perspective_scale = 2 / p_projection_matrix[5];
 
     float view_matrix_inverse[16];
-    matrix_inverse(4, p_view_matrix, view_matrix_inverse);
+    matrix_inverse_affine(p_view_matrix, view_matrix_inverse);
     vec3_set(&view_matrix_inverse[12], g_dev.camera_position);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, gl_framebuffer);
-
     glUseProgram(g_dev.gl_program_flat.gl_handle);
                 
-    glUniformMatrix4fv(g_dev.gl_program_flat_u_projection_matrix, 1, GL_FALSE, p_projection_matrix);
-    glUniformMatrix4fv(g_dev.gl_program_flat_u_view_matrix, 1, GL_FALSE, p_view_matrix);
+    glUniformMatrix4fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_projection_matrix], 1, GL_FALSE, p_projection_matrix);
+    glUniformMatrix4fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_view_matrix], 1, GL_FALSE, p_view_matrix);
 
     draw_hull_DEBUGDEBUGDEBUG();
 
@@ -373,83 +381,24 @@ void dev_draw(GLuint gl_framebuffer, size_t framebuffer_width, size_t framebuffe
     if (g_dev.gizmos.p_target_transform) {
         draw_gizmo();
 
-        if (g_dev.p_selected_entity->p_mesh) {
+        const struct static_mesh* p_mesh = get_entity_mesh(g_dev.p_selected_entity);
+
+        // Device meshes are only loaded once an entity has been visible
+        if (p_mesh && p_mesh->b_loaded_device_meshes) {
             float bounds_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
             float bounds_max[3] = { FLT_MIN, FLT_MIN, FLT_MIN };
 
-            const struct static_mesh* p_mesh = g_dev.p_selected_entity->p_mesh->_asset._p_data;
-
             for (size_t i = 0; i < p_mesh->num_primitives; ++i) {
                 const struct gl_mesh* p_gl_mesh = &p_mesh->p_gl_meshes[i];
                 vec3_min(bounds_min, p_gl_mesh->_bounds_min, bounds_min);
                 vec3_max(bounds_max, p_gl_mesh->_bounds_max, bounds_max);
             }
 
-            float mesh_bounds_box_vertices[] = {
-                bounds_min[0], bounds_min[1], bounds_min[2],
-                bounds_max[0], bounds_min[1], bounds_min[2],
-                bounds_min[0], bounds_min[1], bounds_max[2],
-                bounds_max[0], bounds_min[1], bounds_max[2],
-                bounds_min[0], bounds_min[1], bounds_min[2],
-                bounds_min[0], bounds_min[1], bounds_max[2],
-                bounds_max[0], bounds_min[1], bounds_min[2],
-                bounds_max[0], bounds_min[1], bounds_max[2],
-                bounds_min[0], bounds_max[1], bounds_min[2],
-                bounds_max[0], bounds_max[1], bounds_min[2],
-                bounds_min[0], bounds_max[1], bounds_max[2],
-                bounds_max[0], bounds_max[1], bounds_max[2],
-                bounds_min[0], bounds_max[1], bounds_min[2],
-                bounds_min[0], bounds_max[1], bounds_max[2],
-                bounds_max[0], bounds_max[1], bounds_min[2],
-                bounds_max[0], bounds_max[1], bounds_max[2],
-                bounds_min[0], bounds_min[1], bounds_min[2],
-                bounds_min[0], bounds_max[1], bounds_min[2],
-                bounds_max[0], bounds_min[1], bounds_min[2],
-                bounds_max[0], bounds_max[1], bounds_min[2],
-                bounds_min[0], bounds_min[1], bounds_max[2],
-                bounds_min[0], bounds_max[1], bounds_max[2],
-                bounds_max[0], bounds_min[1], bounds_max[2],
-                bounds_max[0], bounds_max[1], bounds_max[2]
-            };
-
-            struct vertex_buffer mesh_bounds_box_vertex_buffer = {
-                .p_bytes = mesh_bounds_box_vertices,
-                .size = sizeof(mesh_bounds_box_vertices)
-            };
-
-            struct vertex_attribute mesh_bounds_box_vertex_attribute = {
-                .index = 0,
-                .vertex_buffer_index = 0,
-                .layout = {
-                    .component_count = 3,
-                    .component_type = VERTEX_ATTRIBUTE_TYPE_f32
-                }
-            };
-
-            struct mesh_primitive mesh_bounds_box_mesh = {
-                .p_vertex_buffers = &mesh_bounds_box_vertex_buffer,
-                .num_vertex_buffers = 1,
-                .p_attributes = &mesh_bounds_box_vertex_attribute,
-                .num_attributes = 1,
-                .vertex_count = 24,
-                .draw_mode = MESH_PRIMITIVE_DRAW_MODE_lines
-            };
-
-            struct gl_mesh gl_mesh_bounds_box_mesh;
-            gl_mesh_create(&gl_mesh_bounds_box_mesh, &mesh_bounds_box_mesh);
-            
-            glUniformMatrix4fv(g_dev.gl_program_flat_u_model_matrix, 1, GL_FALSE, g_dev.p_selected_entity->transform.world_trs_matrix);
-            
-            float mesh_bounds_box_color[] = { 0.75, 0.6, 0 };
-            glUniform3fv(g_dev.gl_program_flat_u_color, 1, mesh_bounds_box_color);
-
-            gl_mesh_draw(&gl_mesh_bounds_box_mesh);
-
-            gl_mesh_destroy(&gl_mesh_bounds_box_mesh);
+            dev_draw_box_transformed(bounds_min, bounds_max, g_dev.p_selected_entity->transform.world_trs_matrix, CX_U32_R8G8B8A8(191, 153, 0, 255), CX_COLOR_NONE, 0);
         }
     }
 
-    mesh_selector_render_pass(framebuffer_width, framebuffer_height, p_projection_matrix, p_view_matrix);
+    dev_draw_flush(p_projection_matrix, p_view_matrix, delta_seconds);
 }
 
 void on_key(const void* p_event_data, void* p_user_ptr) {
@@ -462,6 +411,7 @@ void on_key(const void* p_event_data, void* p_user_ptr) {
     switch (p_e->key) {
         case KEY_1: {
             g_dev.b_draw_physics = !g_dev.b_draw_physics;
+            mesh_id_capturer_invalidate(&g_dev.mesh_id_capturer);
             break;
         }
         
@@ -505,38 +455,65 @@ void on_key(const void* p_event_data, void* p_user_ptr) {
 
         // Cycle between static physics object, rigidboy physics object, and no physics object
         case KEY_o: {
-            if (!g_dev.p_selected_entity->p_physics_object) {
-                g_dev.p_selected_entity->p_physics_object = physics_world_new_object(g_dev.p_physics_world, &g_dev.p_selected_entity->transform, 0);
-                physics_world_new_object_collider(g_dev.p_physics_world, g_dev.p_selected_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
-            } else if (!g_dev.p_selected_entity->p_physics_object->_b_is_rigidbody) {
+            struct physics_object* p_physics_object = get_entity_physics_object(g_dev.p_selected_entity);
+
+            if (!p_physics_object) {
+                p_physics_object = physics_world_new_object(g_dev.p_physics_world, &g_dev.p_selected_entity->transform, 0);
+                physics_world_new_object_collider(g_dev.p_physics_world, p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
+                *(struct physics_object**)scene_add_component(g_dev.p_scene, g_dev.p_selected_entity->_id, SCENE_COMPONENT_physics_object) = p_physics_object;
+            } else if (!p_physics_object->_b_is_rigidbody) {
                 // todo replace static object with rigidbody with SAME collider
             } else {
-                physics_world_destroy_object(g_dev.p_physics_world, g_dev.p_selected_entity->p_physics_object);
-                g_dev.p_selected_entity->p_physics_object = 0;
+                physics_world_destroy_object(g_dev.p_physics_world, p_physics_object);
+                scene_remove_component(g_dev.p_scene, g_dev.p_selected_entity->_id, SCENE_COMPONENT_physics_object);
+                clear_physics_compound_edges();
             }
             break;
         }
 
         // Cycle physics body collider type
         case KEY_i: {
-            if (!g_dev.p_selected_entity->p_physics_object) {
+            struct physics_object* p_physics_object = get_entity_physics_object(g_dev.p_selected_entity);
+
+            if (!p_physics_object) {
                 break;
             }
 
-            if (!g_dev.p_selected_entity->p_physics_object->_p_collider) {
-                physics_world_new_object_collider(g_dev.p_physics_world, g_dev.p_selected_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
-            } else if (g_dev.p_selected_entity->p_physics_object->_p_collider->type != PHYSICS_COLLIDER_TYPE_plane) {
-                physics_collider_init(g_dev.p_selected_entity->p_physics_object->_p_collider, g_dev.p_selected_entity->p_physics_object->_p_collider->type + 1);
+            if (!p_physics_object->_p_collider) {
+                physics_world_new_object_collider(g_dev.p_physics_world, p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
+            } else if (p_physics_object->_p_collider->type < PHYSICS_COLLIDER_TYPE_mesh) {
+                physics_collider_free(p_physics_object->_p_collider);
+                physics_collider_init(p_physics_object->_p_collider, p_physics_object->_p_collider->type + 1);
+                clear_physics_compound_edges();
 
-                if (g_dev.p_selected_entity->p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_hull) {
-                    darr_set_length(&g_dev.p_selected_entity->p_physics_object->_p_collider->as_hull.verts, g_dev.num_hull_points);
+                const asset_handle* pp_mesh = scene_get_component(g_dev.p_scene, g_dev.p_selected_entity->_id, SCENE_COMPONENT_mesh);
+
+                if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_hull) {
+                    darr_set_length(&p_physics_object->_p_collider->as_hull.verts, g_dev.num_hull_points);
                     for (size_t i = 0; i < g_dev.num_hull_points; ++i) {
-                        float* p_v = darr_get(&g_dev.p_selected_entity->p_physics_object->_p_collider->as_hull.verts, i);
+                        float* p_v = darr_get(&p_physics_object->_p_collider->as_hull.verts, i);
                         vec3_set(&g_dev.p_hull_points[i * 3], p_v);
                     }
+                } else if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_compound && pp_mesh) {
+                    // Decomposing takes a while the first time; the hulls are kept for the next entity with this mesh
+                    struct convex_decomposition_params params;
+                    convex_decomposition_params_default(&params);
+
+                    const asset_handle decomposition_handle = convex_decomposition_find_or_generate(&g_dev.asset_package, *pp_mesh, &params);
+
+                    if (decomposition_handle) {
+                        convex_decomposition_make_collider(decomposition_handle->_asset._p_data, p_physics_object->_p_collider);
+                    }
+                } else if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_mesh && pp_mesh) {
+                    const asset_handle bvh_handle = triangle_bvh_find_or_build(&g_dev.asset_package, *pp_mesh);
+
+                    if (bvh_handle) {
+                        p_physics_object->_p_collider->as_mesh.p_bvh = bvh_handle->_asset._p_data;
+                    }
                 }
             } else {
-                physics_world_destroy_object_collider(g_dev.p_physics_world, g_dev.p_selected_entity->p_physics_object);
+                physics_world_destroy_object_collider(g_dev.p_physics_world, p_physics_object);
+                clear_physics_compound_edges();
             }
 
             break;
@@ -552,21 +529,32 @@ void on_key(const void* p_event_data, void* p_user_ptr) {
             
             transform_copy(&g_dev.p_selected_entity->transform, &p_new_scene_entity->transform);
             
-            p_new_scene_entity->p_mesh = g_dev.p_selected_entity->p_mesh;
+            const asset_handle* pp_mesh = scene_get_component(g_dev.p_scene, g_dev.p_selected_entity->_id, SCENE_COMPONENT_mesh);
+
+            if (pp_mesh) {
+                scene_set_entity_mesh(g_dev.p_scene, p_new_scene_entity->_id, *pp_mesh);
+            }
+
+            const struct physics_object* p_physics_object = get_entity_physics_object(g_dev.p_selected_entity);
 
-            if (g_dev.p_selected_entity->p_physics_object) {
-                p_new_scene_entity->p_physics_object = physics_world_new_object(g_dev.p_selected_entity->p_physics_object->_p_world, 0, g_dev.p_selected_entity->p_physics_object->_b_is_rigidbody);
+            if (p_physics_object) {
+                struct physics_object* p_new_physics_object = physics_world_new_object(p_physics_object->_p_world, &p_new_scene_entity->transform, p_physics_object->_b_is_rigidbody);
 
-                if (p_new_scene_entity->p_physics_object->_b_is_rigidbody) {
-                    const struct physics_rigidbody* p_rigidbody = (const struct physics_rigidbody*)g_dev.p_selected_entity->p_physics_object;
-                    struct physics_rigidbody* p_new_rigidbody = (struct physics_rigidbody*)p_new_scene_entity->p_physics_object;
+                if (p_new_physics_object->_b_is_rigidbody) {
+                    const struct physics_rigidbody* p_rigidbody = (const struct physics_rigidbody*)p_physics_object;
+                    struct physics_rigidbody* p_new_rigidbody = (struct physics_rigidbody*)p_new_physics_object;
                     *p_new_rigidbody = *p_rigidbody;
                     p_new_rigidbody->base._p_transform = &p_new_scene_entity->transform;
+                    p_new_rigidbody->base._p_collider = 0;
                 }
 
-                if (g_dev.p_selected_entity->p_physics_object->_p_collider) {
-                    *p_new_scene_entity->p_physics_object->_p_collider = *g_dev.p_selected_entity->p_physics_object->_p_collider;
+                if (p_physics_object->_p_collider) {
+                    // Deep copy so the two objects don't share (and both free) a compound's hulls
+                    physics_world_new_object_collider(p_new_physics_object->_p_world, p_new_physics_object, p_physics_object->_p_collider->type);
+                    physics_collider_copy(p_physics_object->_p_collider, p_new_physics_object->_p_collider);
                 }
+
+                *(struct physics_object**)scene_add_component(g_dev.p_scene, p_new_scene_entity->_id, SCENE_COMPONENT_physics_object) = p_new_physics_object;
             }
 
             set_selected_entity(p_new_scene_entity);
@@ -577,8 +565,10 @@ void on_key(const void* p_event_data, void* p_user_ptr) {
         }
 
         case KEY_delete: {
-            physics_world_destroy_object(g_dev.p_physics_world, g_dev.p_selected_entity->p_physics_object);
+            physics_world_destroy_object(g_dev.p_physics_world, get_entity_physics_object(g_dev.p_selected_entity));
             scene_destroy_entity(g_dev.p_scene, g_dev.p_selected_entity);
+            clear_physics_compound_edges();
+            set_selected_entity(0);
             break;
         }
 
@@ -592,10 +582,10 @@ void on_mouse_button(const void* p_event_data, void*) {
     if (p_e->button == MOUSE_BUTTON_middle) {
         if (!g_dev.b_is_dragging && !p_e->b_is_down) {
             if (g_dev.target_mesh_id > DEV_MESH_ID_CAPTURER_RESERVED_IDS) {
-                size_t entity_id = g_dev.target_mesh_id - DEV_MESH_ID_CAPTURER_RESERVED_IDS;
+                const scene_entity_id entity_id = g_dev.target_mesh_id - DEV_MESH_ID_CAPTURER_RESERVED_IDS;
                 struct scene_entity* p_entity = scene_get_entity(g_dev.p_scene, entity_id);
 
-                if (transform_set_local_transform(&g_dev.p_selected_entity->transform, p_entity == g_dev.p_selected_entity ? 0 : &p_entity->transform, 1)) {
+                if (p_entity && g_dev.p_selected_entity && transform_set_local_transform(&g_dev.p_selected_entity->transform, p_entity == g_dev.p_selected_entity ? 0 : &p_entity->transform, 1)) {
                     set_selected_entity(p_entity);
                 }
             }
@@ -605,7 +595,7 @@ void on_mouse_button(const void* p_event_data, void*) {
     if (p_e->button == MOUSE_BUTTON_left) {
         if (!g_dev.b_is_dragging && !p_e->b_is_down) {
             if (g_dev.target_mesh_id > DEV_MESH_ID_CAPTURER_RESERVED_IDS) {
-                size_t entity_id = g_dev.target_mesh_id - DEV_MESH_ID_CAPTURER_RESERVED_IDS;
+                const scene_entity_id entity_id = g_dev.target_mesh_id - DEV_MESH_ID_CAPTURER_RESERVED_IDS;
                 struct scene_entity* p_entity = scene_get_entity(g_dev.p_scene, entity_id);
                 set_selected_entity(p_entity == g_dev.p_selected_entity ? 0 : p_entity);
             } else if (g_dev.target_mesh_id == 0) {
@@ -759,31 +749,147 @@ void on_mouse_move(const void* p_event_data, void*) {
 void set_selected_entity(struct scene_entity* p_entity) {
     g_dev.p_selected_entity = p_entity;
     g_dev.gizmos.p_target_transform = p_entity ? &p_entity->transform : 0;
+
+    // The gizmo has moved or gone without the cursor or camera moving
+    mesh_id_capturer_invalidate(&g_dev.mesh_id_capturer);
+}
+
+const struct static_mesh* get_entity_mesh(const struct scene_entity* p_entity) {
+    const asset_handle* pp_mesh = scene_get_component(g_dev.p_scene, p_entity->_id, SCENE_COMPONENT_mesh);
+    return pp_mesh ? (*pp_mesh)->_asset._p_data : 0;
+}
+
+struct physics_object* get_entity_physics_object(const struct scene_entity* p_entity) {
+    struct physics_object** pp_physics_object = scene_get_component(g_dev.p_scene, p_entity->_id, SCENE_COMPONENT_physics_object);
+    return pp_physics_object ? *pp_physics_object : 0;
 }
 
 void draw_physics(void) {
     srand(117);
 
-    for (size_t i = 0; i < g_dev.p_scene->_entities._length; ++i) {
-        struct scene_entity* p_entity = *(struct scene_entity**)darr_get(&g_dev.p_scene->_entities, i);
+    struct scene_query query;
+    scene_query_init(&query, g_dev.p_scene, SCENE_COMPONENT_BIT(SCENE_COMPONENT_physics_object));
+
+    while (scene_query_next(&query)) {
+        const struct physics_object* p_physics_object = *(struct physics_object**)scene_query_get(&query, SCENE_COMPONENT_physics_object);
 
-        if (!p_entity->p_physics_object || !p_entity->p_physics_object->_p_collider) {
+        if (!p_physics_object->_p_collider) {
             continue;
         }
 
-        if (p_entity->p_physics_object->_b_is_rigidbody) {
+        if (p_physics_object->_b_is_rigidbody) {
             float color[] = { randf(), randf(), randf() };
-            glUniform3fv(g_dev.gl_program_flat_u_color, 1, color);
+            glUniform3fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, color);
         } else {
             float color[] = { randf(), randf(), randf() };
-            glUniform3fv(g_dev.gl_program_flat_u_color, 1, color);
+            glUniform3fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, color);
         }
 
         float physics_collider_trs_matrix[16];
-        compute_physics_collider_transform_matrix(p_entity->p_physics_object->_p_collider, p_entity->p_physics_object->_p_transform, physics_collider_trs_matrix);
+        compute_physics_collider_transform_matrix(p_physics_object->_p_collider, p_physics_object->_p_transform, physics_collider_trs_matrix);
+
+        if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_compound) {
+            draw_physics_compound(&p_physics_object->_p_collider->as_compound, physics_collider_trs_matrix);
+            continue;
+        }
+
+        if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_mesh) {
+            draw_physics_mesh(&p_physics_object->_p_collider->as_mesh, physics_collider_trs_matrix);
+            continue;
+        }
 
-        glUniformMatrix4fv(g_dev.gl_program_flat_u_model_matrix, 1, GL_FALSE, physics_collider_trs_matrix);
-        gl_mesh_draw(&g_dev.gl_physics_collider_meshes[p_entity->p_physics_object->_p_collider->type]);
+        glUniformMatrix4fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, physics_collider_trs_matrix);
+        gl_mesh_draw(&g_dev.gl_physics_collider_meshes[p_physics_object->_p_collider->type]);
+    }
+}
+
+void draw_physics_compound(const struct physics_compound* p_compound, const float* p_transform) {
+    const struct darr* p_edges = get_physics_compound_edges(p_compound);
+
+    for (size_t i = 0; i < p_edges->_length; ++i) {
+        float edge[6];
+        matrix_transform_points(p_transform, darr_get(p_edges, i), 0, edge, 2);
+        dev_draw_line(&edge[0], &edge[3], CX_U32_R8G8B8A8(0, 191, 191, 255), 0);
+    }
+}
+
+const struct darr* get_physics_compound_edges(const struct physics_compound* p_compound) {
+    struct darr* p_edges = hashtable_find(&g_dev.physics_compound_edges, &p_compound, sizeof(p_compound));
+
+    if (p_edges) {
+        return p_edges;
+    }
+
+    // Child hulls only keep their vertices, so each is hulled again for its faces. That's too slow (and, in debug
+    // builds, too chatty) to redo every frame, so the edges are kept until dev next frees a collider.
+    p_edges = hashtable_add(&g_dev.physics_compound_edges, &p_compound, sizeof(p_compound));
+    darr_init(p_edges, sizeof(float) * 6);
+
+    struct darr points;
+    darr_init(&points, sizeof(float) * 3);
+
+    for (size_t i = 0; i < p_compound->hulls._length; ++i) {
+        const struct physics_hull* p_hull = darr_get(&p_compound->hulls, i);
+
+        if (p_hull->verts._length < 4) {
+            continue;
+        }
+
+        // quickhull reorders its input
+        darr_set_length(&points, p_hull->verts._length);
+        memcpy(points._p_buffer, p_hull->verts._p_buffer, sizeof(float) * 3 * p_hull->verts._length);
+
+        struct he_mesh hull;
+        quickhull(points._p_buffer, points._length, &hull);
+
+        for (const struct he_face* p_face = hull.p_faces; p_face; p_face = p_face->p_next) {
+            const struct he_edge* p_edge = p_face->p_edges;
+            do {
+                // Each edge is shared with its twin's face; keep one of the pair
+                if ((uintptr_t)p_edge < (uintptr_t)p_edge->p_twin) {
+                    float* p_edge_points = darr_push(p_edges);
+                    vec3_set(p_edge->p_tail->position, &p_edge_points[0]);
+                    vec3_set(p_edge->p_next->p_tail->position, &p_edge_points[3]);
+                }
+                p_edge = p_edge->p_next;
+            } while (p_edge != p_face->p_edges);
+        }
+
+        quickhull_free(&hull);
+    }
+
+    darr_free(&points);
+
+    return p_edges;
+}
+
+void clear_physics_compound_edges(void) {
+    struct hashtable_itr itr;
+    hashtable_itr(&g_dev.physics_compound_edges, &itr);
+
+    while (hashtable_itr_is_valid(&itr)) {
+        darr_free(itr.p_value);
+        hashtable_itr_next(&itr);
+    }
+
+    hashtable_free(&g_dev.physics_compound_edges);
+    hashtable_init(&g_dev.physics_compound_edges, sizeof(struct darr));
+}
+
+void draw_physics_mesh(const struct physics_mesh* p_mesh, const float* p_transform) {
+    if (!p_mesh->p_bvh) {
+        return;
+    }
+
+    // Shared edges are drawn once per triangle, which is fine for a debug view
+    for (uint32_t i = 0; i < p_mesh->p_bvh->num_triangles; ++i) {
+        float triangle[9];
+        triangle_bvh_get_triangle(p_mesh->p_bvh, i, &triangle[0], &triangle[3], &triangle[6]);
+        matrix_transform_points(p_transform, triangle, 0, triangle, 3);
+
+        dev_draw_line(&triangle[0], &triangle[3], CX_U32_R8G8B8A8(0, 191, 63, 255), 0);
+        dev_draw_line(&triangle[3], &triangle[6], CX_U32_R8G8B8A8(0, 191, 63, 255), 0);
+        dev_draw_line(&triangle[6], &triangle[0], CX_U32_R8G8B8A8(0, 191, 63, 255), 0);
     }
 }
 
@@ -812,7 +918,9 @@ void compute_physics_collider_transform_matrix(const struct physics_collider* p_
             break;
         }
 
-        case PHYSICS_COLLIDER_TYPE_hull: {
+        case PHYSICS_COLLIDER_TYPE_hull:
+        case PHYSICS_COLLIDER_TYPE_compound:
+        case PHYSICS_COLLIDER_TYPE_mesh: {
             matrix_copy(p_transform->world_trs_matrix, p_collider_transform_matrix);
             break;
         }
@@ -849,7 +957,7 @@ void draw_gizmo(void) {
     matrix_make_translation(g_dev.gizmos.p_target_transform->world_position[0], g_dev.gizmos.p_target_transform->world_position[1], g_dev.gizmos.p_target_transform->world_position[2], translation);
     matrix_multiply(translation, g_dev.gizmos.gizmo_transform, g_dev.gizmos.gizmo_transform);
     
-    glUniformMatrix4fv(g_dev.gl_program_flat_u_model_matrix, 1, GL_FALSE, g_dev.gizmos.gizmo_transform);
+    glUniformMatrix4fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, g_dev.gizmos.gizmo_transform);
 
     switch (g_dev.gizmos.active_type) {
         case GIZMO_TYPE_translate: {
@@ -886,7 +994,7 @@ void draw_gizmo(void) {
 
 void draw_gizmo_control(const struct gizmo_control* p_control) {
     const int b_highlight = (g_dev.pressed_mesh_id == 0 && g_dev.target_mesh_id == p_control->mesh_id_capturer_id) || (g_dev.pressed_mesh_id == p_control->mesh_id_capturer_id);
-    glUniform3fv(g_dev.gl_program_flat_u_color, 1, b_highlight ? g_dev.gizmos.hovered_control_color : p_control->color);
+    glUniform3fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, b_highlight ? g_dev.gizmos.hovered_control_color : p_control->color);
     gl_mesh_draw(&p_control->gl_mesh);
 }
 
@@ -1054,31 +1162,61 @@ void gizmo_drag_scale_uniformly(const float* p_control_plane_normal, const float
     transform_set_world_scale(g_dev.gizmos.p_target_transform, new_world_scale);
 }
 
-void mesh_selector_render_pass(size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix) {
-    mesh_id_capturer_begin(&g_dev.mesh_id_capturer, framebuffer_width, framebuffer_height, p_projection_matrix, p_view_matrix);
+void dev_capture_target_mesh(size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix) {
+    int mouse_client_coords[2];
+    platform_window_get_mouse_client_coords(g_dev.p_platform_window, &mouse_client_coords[0], &mouse_client_coords[1]);
+
+    float mouse_position_normalized[2];
+    platform_window_normalize_client_coords(g_dev.p_platform_window, mouse_client_coords[0], mouse_client_coords[1], &mouse_position_normalized[0], &mouse_position_normalized[1]);
+
+    if (mesh_id_capturer_begin(&g_dev.mesh_id_capturer, framebuffer_width, framebuffer_height, p_projection_matrix, p_view_matrix, mouse_position_normalized[0], mouse_position_normalized[1])) {
+        mesh_selector_render_pass_submit_scene();
+        mesh_id_capturer_end(&g_dev.mesh_id_capturer);
+    }
 
-    for (size_t i = 0; i < g_dev.p_scene->_entities._length; ++i) {
-        struct scene_entity* p_entity = *(struct scene_entity**)darr_get(&g_dev.p_scene->_entities, i);
+    g_dev.target_mesh_id = mesh_id_capturer_query(&g_dev.mesh_id_capturer);
+}
 
-        const unsigned int mesh_id_capturer_entity_id = DEV_MESH_ID_CAPTURER_RESERVED_IDS + p_entity->_id;
+void mesh_selector_render_pass_submit_scene(void) {
+    struct scene_query query;
+    scene_query_init(&query, g_dev.p_scene, SCENE_COMPONENT_BIT(SCENE_COMPONENT_mesh));
 
-        if (p_entity->p_mesh) {
-            const struct static_mesh* p_mesh = p_entity->p_mesh->_asset._p_data;
+    while (scene_query_next(&query)) {
+        const unsigned int mesh_id_capturer_entity_id = DEV_MESH_ID_CAPTURER_RESERVED_IDS + query.entity_id;
+        const struct static_mesh* p_mesh = (*(asset_handle*)scene_query_get(&query, SCENE_COMPONENT_mesh))->_asset._p_data;
 
-            for (size_t j = 0; j < p_mesh->num_primitives; ++j) {
-                const struct gl_mesh* p_gl_mesh = &p_mesh->p_gl_meshes[j];
-                mesh_id_capturer_submit(&g_dev.mesh_id_capturer, p_gl_mesh, p_entity->transform.world_trs_matrix, mesh_id_capturer_entity_id);
-            }
+        // Never visible yet, so nothing has been loaded to draw, and it can't be under the cursor anyway
+        if (!p_mesh->b_loaded_device_meshes) {
+            continue;
         }
 
-        if (!g_dev.b_draw_physics || !p_entity->p_physics_object || !p_entity->p_physics_object->_p_collider) {
-            continue;
+        for (size_t j = 0; j < p_mesh->num_primitives; ++j) {
+            const struct gl_mesh* p_gl_mesh = &p_mesh->p_gl_meshes[j];
+            mesh_id_capturer_submit(&g_dev.mesh_id_capturer, p_gl_mesh, query.p_entity->transform.world_trs_matrix, mesh_id_capturer_entity_id);
         }
+    }
 
-        float physics_collider_trs_matrix[16];
-        compute_physics_collider_transform_matrix(p_entity->p_physics_object->_p_collider, p_entity->p_physics_object->_p_transform, physics_collider_trs_matrix);
+    if (g_dev.b_draw_physics) {
+        scene_query_init(&query, g_dev.p_scene, SCENE_COMPONENT_BIT(SCENE_COMPONENT_physics_object));
+
+        while (scene_query_next(&query)) {
+            const unsigned int mesh_id_capturer_entity_id = DEV_MESH_ID_CAPTURER_RESERVED_IDS + query.entity_id;
+            const struct physics_object* p_physics_object = *(struct physics_object**)scene_query_get(&query, SCENE_COMPONENT_physics_object);
+
+            if (!p_physics_object->_p_collider) {
+                continue;
+            }
 
-        mesh_id_capturer_submit(&g_dev.mesh_id_capturer, &g_dev.gl_physics_collider_meshes[p_entity->p_physics_object->_p_collider->type], physics_collider_trs_matrix, mesh_id_capturer_entity_id);
+            // Compounds and triangle meshes are drawn in lines, so have nothing here to pick
+            if (p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_compound || p_physics_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_mesh) {
+                continue;
+            }
+
+            float physics_collider_trs_matrix[16];
+            compute_physics_collider_transform_matrix(p_physics_object->_p_collider, p_physics_object->_p_transform, physics_collider_trs_matrix);
+
+            mesh_id_capturer_submit(&g_dev.mesh_id_capturer, &g_dev.gl_physics_collider_meshes[p_physics_object->_p_collider->type], physics_collider_trs_matrix, mesh_id_capturer_entity_id);
+        }
     }
     
     if (g_dev.gizmos.p_target_transform) {
@@ -1116,14 +1254,6 @@ void mesh_selector_render_pass(size_t framebuffer_width, size_t framebuffer_heig
             }
         }
     }
-    
-    int mouse_client_coords[2];
-    platform_window_get_mouse_client_coords(g_dev.p_platform_window, &mouse_client_coords[0], &mouse_client_coords[1]);
-
-    float mouse_position_normalized[2];
-    platform_window_normalize_client_coords(g_dev.p_platform_window, mouse_client_coords[0], mouse_client_coords[1], &mouse_position_normalized[0], &mouse_position_normalized[1]);
-
-    g_dev.target_mesh_id = mesh_id_capturer_query(&g_dev.mesh_id_capturer, mouse_position_normalized[0], mouse_position_normalized[1]);
 }
 
 void mesh_selector_render_pass_submit_gizmo_control(const struct gizmo_control* p_control) {
@@ -1131,11 +1261,13 @@ void mesh_selector_render_pass_submit_gizmo_control(const struct gizmo_control*
 } 
 
 void draw_hull_DEBUGDEBUGDEBUG(void) {
-    if (!g_dev.p_selected_entity || !g_dev.p_selected_entity->p_mesh) {
+    const struct static_mesh* p_selected_mesh = g_dev.p_selected_entity ? get_entity_mesh(g_dev.p_selected_entity) : 0;
+
+    if (!p_selected_mesh) {
         return;
     }
 
-    static struct he_mesh he_mesh;
+    static struct he_compact_mesh he_mesh;
     
     static struct mesh_primitive mesh_primitive;
     static struct mesh_primitive mesh_primitive_outline;
@@ -1148,14 +1280,18 @@ void draw_hull_DEBUGDEBUGDEBUG(void) {
     if (g_dev.p_selected_entity != p_old_selected_entity) {
         p_old_selected_entity = g_dev.p_selected_entity;
 
-        if (he_mesh.p_buffer) {
-            quickhull_free(&he_mesh);
+        if (he_mesh._p_buffer) {
+            half_edge_compact_free(&he_mesh);
             mesh_factory_free_primitive(&mesh_primitive);
+            mesh_factory_free_primitive(&mesh_primitive_outline);
             gl_mesh_destroy(&gl_mesh);
             gl_mesh_destroy(&gl_mesh_outline);
         }
 
-        quickhull_static_mesh((const struct static_mesh*)g_dev.p_selected_entity->p_mesh->_asset._p_data, &he_mesh);
+        struct he_mesh he_mesh_hull;
+        quickhull_static_mesh(p_selected_mesh, &he_mesh_hull);
+        half_edge_compact(&he_mesh_hull, &he_mesh);
+        quickhull_free(&he_mesh_hull);
         
         mesh_factory_make_from_halfedge_mesh(&he_mesh, &mesh_primitive, 0);
         gl_mesh_create(&gl_mesh, &mesh_primitive);
@@ -1166,13 +1302,13 @@ void draw_hull_DEBUGDEBUGDEBUG(void) {
 
     float matrix[16];
     matrix_make_identity(matrix);
-    glUniformMatrix4fv(g_dev.gl_program_flat_u_model_matrix, 1, GL_FALSE, matrix);
+    glUniformMatrix4fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, matrix);
     
     float color[] = { 1, 1, 1 };
-    glUniform3fv(g_dev.gl_program_flat_u_color, 1, color);
+    glUniform3fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, color);
     gl_mesh_draw(&gl_mesh);
     
     float color_wf[] = { 1, 0, 0 };
-    glUniform3fv(g_dev.gl_program_flat_u_color, 1, color_wf);
+    glUniform3fv(g_dev.gl_program_flat.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, color_wf);
     gl_mesh_draw(&gl_mesh_outline);
 }
\ No newline at end of file
@@ -8,9 +8,14 @@
 struct platform_window;
 struct scene;
 struct physics_world;
+struct gl_program_cache;
 
-void dev_init(const struct platform_window* p_platform_window, struct scene* p_scene, struct physics_world* p_physics_world);
+void dev_init(const struct platform_window* p_platform_window, struct scene* p_scene, struct physics_world* p_physics_world, struct gl_program_cache* p_gl_program_cache);
 void dev_shutdown(void);
-void dev_draw(GLuint gl_framebuffer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix);
+// Draws the dev overlays into whatever framebuffer is bound
+void dev_draw(const float* p_projection_matrix, const float* p_view_matrix, float delta_seconds);
+
+// Renders the mesh IDs under the cursor into a framebuffer of its own, for picking what's under it a frame or two later
+void dev_capture_target_mesh(size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix);
 
 #endif
\ No newline at end of file
@@ -1,21 +1,499 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "darr.h"
 #include "dev_draw.h"
+#include "gl.h"
+#include "gl_program.h"
+#include "gl_program_cache.h"
+#include "matrix.h"
+#include "vector.h"
+
+#define DEV_DRAW_PI 3.14159265f
+
+struct dev_draw_vertex {
+    float   position[3];
+    uint8_t color[4];
+};
+
+// Vertices are pushed in the order shapes are requested, so each shape's are the next num_*_vertices of each array
+struct dev_draw_shape {
+    float    time_left;
+    uint32_t num_line_vertices;
+    uint32_t num_fill_vertices;
+};
+
+static struct {
+    int               b_is_initialized;
+    struct darr       line_vertices; // struct dev_draw_vertex
+    struct darr       fill_vertices; // struct dev_draw_vertex
+    struct darr       shapes;        // struct dev_draw_shape
+    struct gl_program gl_program;
+    GLuint            gl_vao;
+    GLuint            gl_vbo;
+    GLsizeiptr        vbo_size;
+} g_dev_draw;
+
+static int  dev_draw_begin_shape(size_t* p_first_line_vertex, size_t* p_first_fill_vertex);
+static void dev_draw_end_shape(size_t first_line_vertex, size_t first_fill_vertex, float duration);
+static void dev_draw_push_vertex(struct darr* p_vertices, const float* p_position, u32_r8g8b8a8 color);
+static void dev_draw_push_line(const float* p_p0, const float* p_p1, u32_r8g8b8a8 color);
+static void dev_draw_push_triangle(const float* p_p0, const float* p_p1, const float* p_p2, u32_r8g8b8a8 color);
+static void dev_draw_push_quad(const float* p_p0, const float* p_p1, const float* p_p2, const float* p_p3, u32_r8g8b8a8 color);
+static void dev_draw_push_arc(const float* p_center, const float* p_x, const float* p_y, float radius, float angle0, float angle1, size_t num_segments, u32_r8g8b8a8 color);
+static void dev_draw_push_capsule_fill(const float* p_p0, const float* p_p1, const float* p_axis, const float* p_u, const float* p_v, float radius, u32_r8g8b8a8 color);
+static void dev_draw_make_basis(const float* p_axis, float* p_u, float* p_v);
+static void dev_draw_render(const float* p_projection_matrix, const float* p_view_matrix);
+static void dev_draw_expire(float delta_seconds);
+
+void dev_draw_init(struct gl_program_cache* p_gl_program_cache) {
+    darr_init(&g_dev_draw.line_vertices, sizeof(struct dev_draw_vertex));
+    darr_init(&g_dev_draw.fill_vertices, sizeof(struct dev_draw_vertex));
+    darr_init(&g_dev_draw.shapes, sizeof(struct dev_draw_shape));
+
+    const struct gl_program_source sources[] = {
+        {
+            GL_VERTEX_SHADER,
+            "#version 330 core\n"
+            "uniform mat4 u_projection_matrix;"
+            "uniform mat4 u_view_matrix;"
+            "layout (location=0) in vec3 a_pos;"
+            "layout (location=1) in vec4 a_color;"
+            "out vec4 v_color;"
+            "void main() {"
+                "v_color = a_color;"
+                "gl_Position = u_projection_matrix * u_view_matrix * vec4(a_pos, 1.0);"
+            "}"
+        },
+        {
+            GL_FRAGMENT_SHADER,
+            "#version 330 core\n"
+            "in vec4 v_color;"
+            "out vec4 f_color;"
+            "void main() {"
+                "f_color = v_color;"
+            "}"
+        }
+    };
+
+    gl_program_cache_load(p_gl_program_cache, sources, 2, 0, &g_dev_draw.gl_program);
+
+    glGenVertexArrays(1, &g_dev_draw.gl_vao);
+    glGenBuffers(1, &g_dev_draw.gl_vbo);
+
+    glBindVertexArray(g_dev_draw.gl_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, g_dev_draw.gl_vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(struct dev_draw_vertex), (void*)offsetof(struct dev_draw_vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(struct dev_draw_vertex), (void*)offsetof(struct dev_draw_vertex, color));
+    glBindVertexArray(0);
+
+    g_dev_draw.b_is_initialized = 1;
+}
+
+void dev_draw_shutdown(void) {
+    darr_free(&g_dev_draw.line_vertices);
+    darr_free(&g_dev_draw.fill_vertices);
+    darr_free(&g_dev_draw.shapes);
+    gl_program_destroy(&g_dev_draw.gl_program);
+    glDeleteVertexArrays(1, &g_dev_draw.gl_vao);
+    glDeleteBuffers(1, &g_dev_draw.gl_vbo);
+
+    g_dev_draw.b_is_initialized = 0;
+}
+
+void dev_draw_flush(const float* p_projection_matrix, const float* p_view_matrix, float delta_seconds) {
+    if (!g_dev_draw.b_is_initialized) {
+        return;
+    }
+
+    if (g_dev_draw.fill_vertices._length + g_dev_draw.line_vertices._length) {
+        dev_draw_render(p_projection_matrix, p_view_matrix);
+    }
+
+    dev_draw_expire(delta_seconds);
+}
 
 void dev_draw_line(const float* p_p0, const float* p_p1, u32_r8g8b8a8 p_color, float duration) {
+    size_t first_line_vertex, first_fill_vertex;
+
+    if (!dev_draw_begin_shape(&first_line_vertex, &first_fill_vertex)) {
+        return;
+    }
 
+    if (CX_U32_R8G8B8A8_A(p_color)) {
+        dev_draw_push_line(p_p0, p_p1, p_color);
+    }
+
+    dev_draw_end_shape(first_line_vertex, first_fill_vertex, duration);
 }
 
 void dev_draw_sphere(const float* p_center, float radius, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration) {
+    size_t first_line_vertex, first_fill_vertex;
+
+    if (!dev_draw_begin_shape(&first_line_vertex, &first_fill_vertex)) {
+        return;
+    }
+
+    const float x[] = { 1, 0, 0 };
+    const float y[] = { 0, 1, 0 };
+    const float z[] = { 0, 0, 1 };
 
+    if (CX_U32_R8G8B8A8_A(p_line_color)) {
+        dev_draw_push_arc(p_center, x, y, radius, 0, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS, p_line_color);
+        dev_draw_push_arc(p_center, y, z, radius, 0, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS, p_line_color);
+        dev_draw_push_arc(p_center, z, x, radius, 0, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS, p_line_color);
+    }
+
+    if (CX_U32_R8G8B8A8_A(p_fill_color)) {
+        dev_draw_push_capsule_fill(p_center, p_center, y, z, x, radius, p_fill_color);
+    }
+
+    dev_draw_end_shape(first_line_vertex, first_fill_vertex, duration);
 }
 
 void dev_draw_capsule(const float* p_p0, const float* p_p1, float radius, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration) {
+    size_t first_line_vertex, first_fill_vertex;
+
+    if (!dev_draw_begin_shape(&first_line_vertex, &first_fill_vertex)) {
+        return;
+    }
 
+    float axis[3];
+    vec3_sub(p_p1, p_p0, axis);
+
+    if (vec3_len_sq(axis) > 0) {
+        vec3_norm(axis, axis);
+    } else {
+        vec3_set_ijk(0, 1, 0, axis);
+    }
+
+    float u[3];
+    float v[3];
+    dev_draw_make_basis(axis, u, v);
+
+    if (CX_U32_R8G8B8A8_A(p_line_color)) {
+        dev_draw_push_arc(p_p0, u, v, radius, 0, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS, p_line_color);
+        dev_draw_push_arc(p_p1, u, v, radius, 0, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS, p_line_color);
+        dev_draw_push_arc(p_p1, u, axis, radius, 0, DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS / 2, p_line_color);
+        dev_draw_push_arc(p_p1, v, axis, radius, 0, DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS / 2, p_line_color);
+        dev_draw_push_arc(p_p0, u, axis, radius, DEV_DRAW_PI, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS / 2, p_line_color);
+        dev_draw_push_arc(p_p0, v, axis, radius, DEV_DRAW_PI, 2 * DEV_DRAW_PI, DEV_DRAW_CIRCLE_SEGMENTS / 2, p_line_color);
+
+        for (size_t i = 0; i < 4; ++i) {
+            float side[3];
+            vec3_mul_s(i & 1 ? v : u, i & 2 ? -radius : radius, side);
+
+            float side_p0[3];
+            float side_p1[3];
+            vec3_add(p_p0, side, side_p0);
+            vec3_add(p_p1, side, side_p1);
+            dev_draw_push_line(side_p0, side_p1, p_line_color);
+        }
+    }
+
+    if (CX_U32_R8G8B8A8_A(p_fill_color)) {
+        dev_draw_push_capsule_fill(p_p0, p_p1, axis, u, v, radius, p_fill_color);
+    }
+
+    dev_draw_end_shape(first_line_vertex, first_fill_vertex, duration);
 }
 
 void dev_draw_box(const float* p_min, const float* p_max, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration) {
+    dev_draw_box_transformed(p_min, p_max, 0, p_line_color, p_fill_color, duration);
+}
+
+void dev_draw_box_transformed(const float* p_min, const float* p_max, const float* p_transform, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration) {
+    size_t first_line_vertex, first_fill_vertex;
+
+    if (!dev_draw_begin_shape(&first_line_vertex, &first_fill_vertex)) {
+        return;
+    }
+
+    // Corner i takes x, y and z from p_max where bits 0, 1 and 2 of i are set
+    float corners[8][3];
+
+    for (size_t i = 0; i < 8; ++i) {
+        const float corner[] = {
+            i & 1 ? p_max[0] : p_min[0],
+            i & 2 ? p_max[1] : p_min[1],
+            i & 4 ? p_max[2] : p_min[2]
+        };
+
+        if (p_transform) {
+            matrix_multiply_vec3(p_transform, corner, corners[i]);
+        } else {
+            vec3_set(corner, corners[i]);
+        }
+    }
 
+    if (CX_U32_R8G8B8A8_A(p_line_color)) {
+        for (size_t i = 0; i < 8; ++i) {
+            for (size_t bit = 1; bit < 8; bit <<= 1) {
+                if (!(i & bit)) {
+                    dev_draw_push_line(corners[i], corners[i | bit], p_line_color);
+                }
+            }
+        }
+    }
+
+    if (CX_U32_R8G8B8A8_A(p_fill_color)) {
+        for (size_t bit = 1; bit < 8; bit <<= 1) {
+            const size_t bit_u = bit == 4 ? 1 : bit << 1;
+            const size_t bit_v = bit_u == 4 ? 1 : bit_u << 1;
+
+            for (size_t side = 0; side < 2; ++side) {
+                const size_t base = side ? bit : 0;
+                dev_draw_push_quad(corners[base], corners[base | bit_u], corners[base | bit_u | bit_v], corners[base | bit_v], p_fill_color);
+            }
+        }
+    }
+
+    dev_draw_end_shape(first_line_vertex, first_fill_vertex, duration);
 }
 
 void dev_draw_plane(const float* p_normal, float distance, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration) {
+    size_t first_line_vertex, first_fill_vertex;
+
+    if (!dev_draw_begin_shape(&first_line_vertex, &first_fill_vertex)) {
+        return;
+    }
+
+    float normal[3];
+    vec3_norm(p_normal, normal);
+
+    float u[3];
+    float v[3];
+    dev_draw_make_basis(normal, u, v);
+    vec3_mul_s(u, DEV_DRAW_PLANE_EXTENT, u);
+    vec3_mul_s(v, DEV_DRAW_PLANE_EXTENT, v);
+
+    float center[3];
+    vec3_mul_s(normal, distance, center);
+
+    float corners[4][3];
+
+    for (size_t i = 0; i < 4; ++i) {
+        const float s_u = i == 0 || i == 3 ? -1.0f : 1.0f;
+        const float s_v = i < 2 ? -1.0f : 1.0f;
+
+        for (size_t j = 0; j < 3; ++j) {
+            corners[i][j] = center[j] + s_u * u[j] + s_v * v[j];
+        }
+    }
+
+    if (CX_U32_R8G8B8A8_A(p_line_color)) {
+        for (size_t i = 0; i < 4; ++i) {
+            dev_draw_push_line(corners[i], corners[(i + 1) % 4], p_line_color);
+        }
+
+        float normal_tip[3];
+        vec3_add(center, normal, normal_tip);
+        dev_draw_push_line(center, normal_tip, p_line_color);
+    }
+
+    if (CX_U32_R8G8B8A8_A(p_fill_color)) {
+        dev_draw_push_quad(corners[0], corners[1], corners[2], corners[3], p_fill_color);
+    }
 
-}
\ No newline at end of file
+    dev_draw_end_shape(first_line_vertex, first_fill_vertex, duration);
+}
+
+int dev_draw_begin_shape(size_t* p_first_line_vertex, size_t* p_first_fill_vertex) {
+    *p_first_line_vertex = g_dev_draw.line_vertices._length;
+    *p_first_fill_vertex = g_dev_draw.fill_vertices._length;
+    return g_dev_draw.b_is_initialized;
+}
+
+void dev_draw_end_shape(size_t first_line_vertex, size_t first_fill_vertex, float duration) {
+    struct dev_draw_shape* p_shape = darr_push(&g_dev_draw.shapes);
+    *p_shape = (struct dev_draw_shape) {
+        .time_left = duration,
+        .num_line_vertices = (uint32_t)(g_dev_draw.line_vertices._length - first_line_vertex),
+        .num_fill_vertices = (uint32_t)(g_dev_draw.fill_vertices._length - first_fill_vertex)
+    };
+}
+
+void dev_draw_push_vertex(struct darr* p_vertices, const float* p_position, u32_r8g8b8a8 color) {
+    struct dev_draw_vertex* p_vertex = darr_push(p_vertices);
+    *p_vertex = (struct dev_draw_vertex) {
+        .position = { p_position[0], p_position[1], p_position[2] },
+        .color = { CX_U32_R8G8B8A8_R(color), CX_U32_R8G8B8A8_G(color), CX_U32_R8G8B8A8_B(color), CX_U32_R8G8B8A8_A(color) }
+    };
+}
+
+void dev_draw_push_line(const float* p_p0, const float* p_p1, u32_r8g8b8a8 color) {
+    dev_draw_push_vertex(&g_dev_draw.line_vertices, p_p0, color);
+    dev_draw_push_vertex(&g_dev_draw.line_vertices, p_p1, color);
+}
+
+void dev_draw_push_triangle(const float* p_p0, const float* p_p1, const float* p_p2, u32_r8g8b8a8 color) {
+    dev_draw_push_vertex(&g_dev_draw.fill_vertices, p_p0, color);
+    dev_draw_push_vertex(&g_dev_draw.fill_vertices, p_p1, color);
+    dev_draw_push_vertex(&g_dev_draw.fill_vertices, p_p2, color);
+}
+
+void dev_draw_push_quad(const float* p_p0, const float* p_p1, const float* p_p2, const float* p_p3, u32_r8g8b8a8 color) {
+    dev_draw_push_triangle(p_p0, p_p1, p_p2, color);
+    dev_draw_push_triangle(p_p0, p_p2, p_p3, color);
+}
+
+void dev_draw_push_arc(const float* p_center, const float* p_x, const float* p_y, float radius, float angle0, float angle1, size_t num_segments, u32_r8g8b8a8 color) {
+    const float step = (angle1 - angle0) / num_segments;
+    float p0[3];
+
+    for (size_t i = 0; i <= num_segments; ++i) {
+        const float c = cosf(angle0 + step * i) * radius;
+        const float s = sinf(angle0 + step * i) * radius;
+
+        float p1[3];
+        for (size_t j = 0; j < 3; ++j) {
+            p1[j] = p_center[j] + c * p_x[j] + s * p_y[j];
+        }
+
+        if (i > 0) {
+            dev_draw_push_line(p0, p1, color);
+        }
+
+        vec3_set(p1, p0);
+    }
+}
+
+void dev_draw_push_capsule_fill(const float* p_p0, const float* p_p1, const float* p_axis, const float* p_u, const float* p_v, float radius, u32_r8g8b8a8 color) {
+    const int b_is_sphere = vec3_dist_sq(p_p0, p_p1) <= 0.0f;
+
+    // Latitude rings from the bottom pole around p_p0 to the top pole around p_p1, the equator once for each end
+    float rings[DEV_DRAW_SPHERE_RINGS + 2][DEV_DRAW_CIRCLE_SEGMENTS][3];
+
+    for (size_t i = 0; i < DEV_DRAW_SPHERE_RINGS + 2; ++i) {
+        const size_t latitude_index = i <= DEV_DRAW_SPHERE_RINGS / 2 ? i : i - 1;
+        const float latitude = -0.5f * DEV_DRAW_PI + DEV_DRAW_PI * latitude_index / DEV_DRAW_SPHERE_RINGS;
+        const float* p_center = i <= DEV_DRAW_SPHERE_RINGS / 2 ? p_p0 : p_p1;
+
+        for (size_t j = 0; j < DEV_DRAW_CIRCLE_SEGMENTS; ++j) {
+            const float longitude = 2 * DEV_DRAW_PI * j / DEV_DRAW_CIRCLE_SEGMENTS;
+            const float c = cosf(latitude) * cosf(longitude) * radius;
+            const float s = cosf(latitude) * sinf(longitude) * radius;
+            const float a = sinf(latitude) * radius;
+
+            for (size_t k = 0; k < 3; ++k) {
+                rings[i][j][k] = p_center[k] + c * p_u[k] + s * p_v[k] + a * p_axis[k];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < DEV_DRAW_SPHERE_RINGS + 1; ++i) {
+        // A sphere's two equators are the same ring, with nothing between them
+        if (b_is_sphere && i == DEV_DRAW_SPHERE_RINGS / 2) {
+            continue;
+        }
+
+        for (size_t j = 0; j < DEV_DRAW_CIRCLE_SEGMENTS; ++j) {
+            const size_t next = (j + 1) % DEV_DRAW_CIRCLE_SEGMENTS;
+            dev_draw_push_quad(rings[i][j], rings[i][next], rings[i + 1][next], rings[i + 1][j], color);
+        }
+    }
+}
+
+void dev_draw_make_basis(const float* p_axis, float* p_u, float* p_v) {
+    // Crossing with the world axis least aligned with p_axis keeps the result well away from zero length
+    const float ax = fabsf(p_axis[0]);
+    const float ay = fabsf(p_axis[1]);
+    const float az = fabsf(p_axis[2]);
+
+    float t[3] = { 0, 0, 0 };
+    t[ax <= ay && ax <= az ? 0 : (ay <= az ? 1 : 2)] = 1;
+
+    vec3_cross(p_axis, t, p_u);
+    vec3_norm(p_u, p_u);
+    vec3_cross(p_axis, p_u, p_v);
+}
+
+void dev_draw_render(const float* p_projection_matrix, const float* p_view_matrix) {
+    const size_t num_fill_vertices = g_dev_draw.fill_vertices._length;
+    const size_t num_line_vertices = g_dev_draw.line_vertices._length;
+
+    const GLsizeiptr fill_size = (GLsizeiptr)(num_fill_vertices * sizeof(struct dev_draw_vertex));
+    const GLsizeiptr line_size = (GLsizeiptr)(num_line_vertices * sizeof(struct dev_draw_vertex));
+
+    if (fill_size + line_size > g_dev_draw.vbo_size) {
+        g_dev_draw.vbo_size = fill_size + line_size > g_dev_draw.vbo_size * 2 ? fill_size + line_size : g_dev_draw.vbo_size * 2;
+    }
+
+    // Orphaning the old storage lets the driver hand out fresh memory instead of waiting for last frame's draws to finish reading it
+    glBindBuffer(GL_ARRAY_BUFFER, g_dev_draw.gl_vbo);
+    glBufferData(GL_ARRAY_BUFFER, g_dev_draw.vbo_size, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, fill_size, g_dev_draw.fill_vertices._p_buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, fill_size, line_size, g_dev_draw.line_vertices._p_buffer);
+
+    glUseProgram(g_dev_draw.gl_program.gl_handle);
+    glUniformMatrix4fv(g_dev_draw.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_projection_matrix], 1, GL_FALSE, p_projection_matrix);
+    glUniformMatrix4fv(g_dev_draw.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_view_matrix], 1, GL_FALSE, p_view_matrix);
+    glBindVertexArray(g_dev_draw.gl_vao);
+
+    if (num_fill_vertices) {
+        const GLboolean b_cull_face = glIsEnabled(GL_CULL_FACE);
+
+        // Fills are see-through and seen from both sides, and shouldn't hide the lines behind them
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)num_fill_vertices);
+
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+
+        if (b_cull_face) {
+            glEnable(GL_CULL_FACE);
+        }
+    }
+
+    if (num_line_vertices) {
+        glDrawArrays(GL_LINES, (GLint)num_fill_vertices, (GLsizei)num_line_vertices);
+    }
+
+    glBindVertexArray(0);
+}
+
+void dev_draw_expire(float delta_seconds) {
+    // Compacts survivors toward the front in place, so expiring costs no allocation however many shapes there are
+    struct dev_draw_shape* p_shapes = g_dev_draw.shapes._p_buffer;
+    struct dev_draw_vertex* p_line_vertices = g_dev_draw.line_vertices._p_buffer;
+    struct dev_draw_vertex* p_fill_vertices = g_dev_draw.fill_vertices._p_buffer;
+
+    size_t num_shapes = 0;
+    size_t src_line_vertex = 0;
+    size_t src_fill_vertex = 0;
+    size_t dst_line_vertex = 0;
+    size_t dst_fill_vertex = 0;
+
+    for (size_t i = 0; i < g_dev_draw.shapes._length; ++i) {
+        struct dev_draw_shape shape = p_shapes[i];
+        shape.time_left -= delta_seconds;
+
+        if (shape.time_left > 0) {
+            if (dst_line_vertex != src_line_vertex) {
+                memmove(&p_line_vertices[dst_line_vertex], &p_line_vertices[src_line_vertex], sizeof(*p_line_vertices) * shape.num_line_vertices);
+            }
+
+            if (dst_fill_vertex != src_fill_vertex) {
+                memmove(&p_fill_vertices[dst_fill_vertex], &p_fill_vertices[src_fill_vertex], sizeof(*p_fill_vertices) * shape.num_fill_vertices);
+            }
+
+            dst_line_vertex += shape.num_line_vertices;
+            dst_fill_vertex += shape.num_fill_vertices;
+            p_shapes[num_shapes++] = shape;
+        }
+
+        src_line_vertex += shape.num_line_vertices;
+        src_fill_vertex += shape.num_fill_vertices;
+    }
+
+    g_dev_draw.shapes._length = num_shapes;
+    g_dev_draw.line_vertices._length = dst_line_vertex;
+    g_dev_draw.fill_vertices._length = dst_fill_vertex;
+}
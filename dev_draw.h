@@ -3,10 +3,24 @@
 
 #include "cx_color.h"
 
+#define DEV_DRAW_CIRCLE_SEGMENTS 32
+#define DEV_DRAW_SPHERE_RINGS    12 // latitude bands of filled spheres and capsules, even so each hemisphere gets half
+#define DEV_DRAW_PLANE_EXTENT    5.0f
+
+struct gl_program_cache;
+
+/* Debug shapes are accumulated into CPU vertex arrays as they're requested, from anywhere and at any time after init,
+ * and drawn by dev_draw_flush in at most two draw calls. Each one is drawn for its duration in seconds, or for the
+ * next flush only if that's 0. A color with no alpha skips the lines or the fill it's for. */
+void dev_draw_init(struct gl_program_cache* p_gl_program_cache);
+void dev_draw_shutdown(void);
+void dev_draw_flush(const float* p_projection_matrix, const float* p_view_matrix, float delta_seconds);
+
 void dev_draw_line(const float* p_p0, const float* p_p1, u32_r8g8b8a8 p_color, float duration);
 void dev_draw_sphere(const float* p_center, float radius, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration);
 void dev_draw_capsule(const float* p_p0, const float* p_p1, float radius, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration);
 void dev_draw_box(const float* p_min, const float* p_max, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration);
+void dev_draw_box_transformed(const float* p_min, const float* p_max, const float* p_transform, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration);
 void dev_draw_plane(const float* p_normal, float distance, u32_r8g8b8a8 p_line_color, u32_r8g8b8a8 p_fill_color, float duration);
 
-#endif
\ No newline at end of file
+#endif
@@ -17,6 +17,13 @@ enum error {
     ERROR_WIN32_REGISTER_CLASS,
     ERROR_WIN32_CREATE_WINDOW,
 
+    ERROR_EGL_NO_DISPLAY,
+    ERROR_EGL_INITIALIZE,
+    ERROR_EGL_NO_SUITABLE_CONFIG,
+    ERROR_EGL_CREATE_SURFACE,
+    ERROR_EGL_CREATE_CONTEXT,
+    ERROR_EGL_MAKE_CURRENT,
+
     ERROR_OPENGL,
 
     ERROR_INVALID_VALUE,
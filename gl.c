@@ -62,6 +62,13 @@ static void* GalogenGetProcAddress(const char *name)
 	return lib ? dlsym(lib, name) : NULL;
 }
 
+#elif defined(__linux__)
+
+/* gl_context creates EGL contexts on Linux, and Mesa's eglGetProcAddress also returns core functions */
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#define GalogenGetProcAddress(name) eglGetProcAddress(name)
+
 #else
 
 #include <GL/glx.h>
@@ -2132,4 +2139,22 @@ static void  GL_APIENTRY _impl_glCullFace (GLenum mode) {
 	_glptr_glCullFace = (PFN_glCullFace)GalogenGetProcAddress("glCullFace");
 	 _glptr_glCullFace(mode);
 }
-PFN_glCullFace _glptr_glCullFace = _impl_glCullFace;
\ No newline at end of file
+PFN_glCullFace _glptr_glCullFace = _impl_glCullFace;
+
+static void  GL_APIENTRY _impl_glGetProgramBinary (GLuint program, GLsizei bufSize, GLsizei * length, GLenum * binaryFormat, void * binary) {
+	_glptr_glGetProgramBinary = (PFN_glGetProgramBinary)GalogenGetProcAddress("glGetProgramBinary");
+	 _glptr_glGetProgramBinary(program, bufSize, length, binaryFormat, binary);
+}
+PFN_glGetProgramBinary _glptr_glGetProgramBinary = _impl_glGetProgramBinary;
+
+static void  GL_APIENTRY _impl_glProgramBinary (GLuint program, GLenum binaryFormat, const void * binary, GLsizei length) {
+	_glptr_glProgramBinary = (PFN_glProgramBinary)GalogenGetProcAddress("glProgramBinary");
+	 _glptr_glProgramBinary(program, binaryFormat, binary, length);
+}
+PFN_glProgramBinary _glptr_glProgramBinary = _impl_glProgramBinary;
+
+static void  GL_APIENTRY _impl_glProgramParameteri (GLuint program, GLenum pname, GLint value) {
+	_glptr_glProgramParameteri = (PFN_glProgramParameteri)GalogenGetProcAddress("glProgramParameteri");
+	 _glptr_glProgramParameteri(program, pname, value);
+}
+PFN_glProgramParameteri _glptr_glProgramParameteri = _impl_glProgramParameteri;
\ No newline at end of file
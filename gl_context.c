@@ -1,6 +1,7 @@
 #include "gl_context.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "gl.h"
 #include "logging.h"
@@ -8,7 +9,7 @@
 
 #define CX_LOG_CAT_OPENGL "opengl"
 
-#if PLATFORM_WINDOWS
+#ifdef PLATFORM_WINDOWS
 
 typedef const char* APIENTRY wglGetExtensionsStringARB_fn(HDC);
 wglGetExtensionsStringARB_fn* wglGetExtensionsStringARB;
@@ -347,4 +348,143 @@ void gl_debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum sev
 }
 #endif
 
-#endif
\ No newline at end of file
+#elif defined(PLATFORM_LINUX)
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef EGLDisplay eglGetPlatformDisplayEXT_fn(EGLenum, void*, const EGLint*);
+
+enum error gl_context_create(const struct platform_window* p_platform_window, int gl_version_major, int gl_version_minor, struct gl_context* p_gl_context) {
+	*p_gl_context = (struct gl_context){0};
+
+	// A surfaceless display needs neither X nor a GPU. Without the extension, whatever the default display is will do.
+	EGLDisplay display = EGL_NO_DISPLAY;
+	eglGetPlatformDisplayEXT_fn* eglGetPlatformDisplayEXT = (eglGetPlatformDisplayEXT_fn*)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (eglGetPlatformDisplayEXT) {
+		display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+
+	if (display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	if (display == EGL_NO_DISPLAY) {
+		return ERROR_EGL_NO_DISPLAY;
+	}
+
+	EGLint egl_version_major;
+	EGLint egl_version_minor;
+	if (!eglInitialize(display, &egl_version_major, &egl_version_minor) || !eglBindAPI(EGL_OPENGL_API)) {
+		return ERROR_EGL_INITIALIZE;
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE,        8,
+		EGL_GREEN_SIZE,      8,
+		EGL_BLUE_SIZE,       8,
+		EGL_ALPHA_SIZE,      8,
+		EGL_DEPTH_SIZE,      24,
+		EGL_STENCIL_SIZE,    8,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(display, config_attribs, &config, 1, &num_configs) || num_configs == 0) {
+		eglTerminate(display);
+		return ERROR_EGL_NO_SUITABLE_CONFIG;
+	}
+
+	unsigned int width;
+	unsigned int height;
+	platform_window_size(p_platform_window, &width, &height);
+
+	const EGLint surface_attribs[] = {
+		EGL_WIDTH,  (EGLint)width,
+		EGL_HEIGHT, (EGLint)height,
+		EGL_NONE
+	};
+
+	EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attribs);
+	if (surface == EGL_NO_SURFACE) {
+		eglTerminate(display);
+		return ERROR_EGL_CREATE_SURFACE;
+	}
+
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION,             gl_version_major,
+		EGL_CONTEXT_MINOR_VERSION,             gl_version_minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK,       EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+#ifndef NDEBUG
+		EGL_CONTEXT_OPENGL_DEBUG,              EGL_TRUE,
+#endif
+		EGL_NONE
+	};
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+	if (context == EGL_NO_CONTEXT) {
+		eglTerminate(display);
+		return ERROR_EGL_CREATE_CONTEXT;
+	}
+
+	if (!eglMakeCurrent(display, surface, surface, context)) {
+		eglTerminate(display);
+		return ERROR_EGL_MAKE_CURRENT;
+	}
+
+	p_gl_context->_display = display;
+	p_gl_context->_surface = surface;
+	p_gl_context->_context = context;
+
+	GLint context_flags;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &context_flags);
+	cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_OPENGL, "OpenGL %scontext created (v%s, GLSL v%s, EGL v%d.%d, %ux%u pbuffer)\n", context_flags & 0x2 ? "Debug " : "", glGetString(GL_VERSION), glGetString(GL_SHADING_LANGUAGE_VERSION), egl_version_major, egl_version_minor, width, height);
+	cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_OPENGL, "Graphics platform: %s, %s\n", glGetString(GL_VENDOR), glGetString(GL_RENDERER));
+
+	return ERROR_OK;
+}
+
+void gl_context_destroy(struct gl_context* p_gl_context) {
+	eglMakeCurrent(p_gl_context->_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(p_gl_context->_display, p_gl_context->_context);
+	eglDestroySurface(p_gl_context->_display, p_gl_context->_surface);
+	eglTerminate(p_gl_context->_display);
+	*p_gl_context = (struct gl_context){0};
+}
+
+enum error gl_context_make_current(const struct gl_context* p_gl_context) {
+	if (eglMakeCurrent(p_gl_context->_display, p_gl_context->_surface, p_gl_context->_surface, p_gl_context->_context)) {
+		return ERROR_OK;
+	}
+	return ERROR_EGL_MAKE_CURRENT;
+}
+
+enum error gl_context_swap_buffers(struct gl_context* p_gl_context) {
+	// Nothing to present from a pbuffer, but the call still marks the end of the frame for the driver
+	if (eglSwapBuffers(p_gl_context->_display, p_gl_context->_surface)) {
+		return ERROR_OK;
+	}
+
+	return ERROR_OPENGL;
+}
+
+#endif
+
+int gl_context_has_extension(const char* s_extension) {
+	GLint num_extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions);
+
+	for (GLint i = 0; i < num_extensions; ++i) {
+		if (!strcmp((const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i), s_extension)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
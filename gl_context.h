@@ -4,12 +4,24 @@
 #include "errors.h"
 #include "platform.h"
 
+#ifdef PLATFORM_LINUX
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#endif
+
 struct platform_window;
 
+/* On Windows, a WGL context drawing to the window. On Linux, where there's no window, an EGL context drawing to a
+ * pbuffer the window's size, on a surfaceless display where Mesa has one, so it runs without a display server or GPU
+ * (llvmpipe). The pbuffer stands in for the default framebuffer, and swapping it does nothing. */
 struct gl_context {
 #ifdef PLATFORM_WINDOWS
     HDC   _hdc;
     HGLRC _hrc;
+#elif defined(PLATFORM_LINUX)
+    EGLDisplay _display;
+    EGLSurface _surface;
+    EGLContext _context;
 #endif
 };
 
@@ -18,4 +30,7 @@ void       gl_context_destroy(struct gl_context* p_gl_context);
 enum error gl_context_make_current(const struct gl_context* p_gl_context);
 enum error gl_context_swap_buffers(struct gl_context* p_gl_context);
 
+// Whether the current context supports a GL extension, such as "GL_EXT_texture_compression_s3tc". Not a cheap call.
+int        gl_context_has_extension(const char* s_extension);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,523 @@
+#include <string.h>
+
+#include "gl_frame_graph.h"
+#include "logging.h"
+#include "platform_time.h"
+
+struct gl_frame_graph_format_info {
+    GLint  gl_internal_format;
+    GLenum gl_format;
+    GLenum gl_type;
+};
+
+static const struct gl_frame_graph_format_info g_format_infos[] = {
+    [GL_FRAME_GRAPH_FORMAT_rgb8]             = { GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE },
+    [GL_FRAME_GRAPH_FORMAT_rgba8]            = { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+    [GL_FRAME_GRAPH_FORMAT_r32ui]            = { GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT },
+    [GL_FRAME_GRAPH_FORMAT_depth24_stencil8] = { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 }
+};
+
+static void   gl_frame_graph_cull(struct gl_frame_graph* p_graph);
+static void   gl_frame_graph_allocate(struct gl_frame_graph* p_graph);
+static size_t gl_frame_graph_acquire_physical_texture(struct gl_frame_graph* p_graph, const struct gl_frame_graph_texture* p_texture);
+static void   gl_frame_graph_bind(struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass);
+static GLuint gl_frame_graph_get_framebuffer(struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass);
+static void   gl_frame_graph_clear(const struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass);
+static void   gl_frame_graph_collect_garbage(struct gl_frame_graph* p_graph);
+static struct gl_frame_graph_timing* gl_frame_graph_get_timing(struct gl_frame_graph* p_graph, const char* s_name);
+
+void gl_frame_graph_create(struct gl_frame_graph* p_graph) {
+    *p_graph = (struct gl_frame_graph){0};
+
+    darr_init(&p_graph->_textures, sizeof(struct gl_frame_graph_texture));
+    darr_init(&p_graph->_passes, sizeof(struct gl_frame_graph_pass));
+    darr_init(&p_graph->_physical_textures, sizeof(struct gl_frame_graph_physical_texture));
+    darr_init(&p_graph->_framebuffers, sizeof(struct gl_frame_graph_framebuffer));
+    darr_init(&p_graph->_timings, sizeof(struct gl_frame_graph_timing));
+}
+
+void gl_frame_graph_destroy(struct gl_frame_graph* p_graph) {
+    const struct gl_frame_graph_physical_texture* p_physical_textures = p_graph->_physical_textures._p_buffer;
+    const struct gl_frame_graph_framebuffer* p_framebuffers = p_graph->_framebuffers._p_buffer;
+    const struct gl_frame_graph_timing* p_timings = p_graph->_timings._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_physical_textures._length; ++i) {
+        glDeleteTextures(1, &p_physical_textures[i].gl_handle);
+    }
+
+    for (size_t i = 0; i < p_graph->_framebuffers._length; ++i) {
+        glDeleteFramebuffers(1, &p_framebuffers[i].gl_handle);
+    }
+
+    for (size_t i = 0; i < p_graph->_timings._length; ++i) {
+        glDeleteQueries(GL_FRAME_GRAPH_NUM_TIMER_QUERIES, p_timings[i].gl_queries);
+    }
+
+    darr_free(&p_graph->_textures);
+    darr_free(&p_graph->_passes);
+    darr_free(&p_graph->_physical_textures);
+    darr_free(&p_graph->_framebuffers);
+    darr_free(&p_graph->_timings);
+    *p_graph = (struct gl_frame_graph){0};
+}
+
+void gl_frame_graph_begin(struct gl_frame_graph* p_graph, GLsizei backbuffer_width, GLsizei backbuffer_height) {
+    p_graph->_textures._length = 0;
+    p_graph->_passes._length = 0;
+
+    // Whatever ran between frames may have bound anything
+    p_graph->_b_is_state_known = 0;
+
+    // Color placeholders for GL_FRAME_GRAPH_NONE and GL_FRAME_GRAPH_BACKBUFFER, so resources index textures directly
+    for (size_t i = 0; i < 2; ++i) {
+        *(struct gl_frame_graph_texture*)darr_push(&p_graph->_textures) = (struct gl_frame_graph_texture) {
+            .width = backbuffer_width,
+            .height = backbuffer_height,
+            .physical = SIZE_MAX
+        };
+    }
+}
+
+gl_frame_graph_resource gl_frame_graph_create_texture(struct gl_frame_graph* p_graph, GLsizei width, GLsizei height, enum gl_frame_graph_format format) {
+    *(struct gl_frame_graph_texture*)darr_push(&p_graph->_textures) = (struct gl_frame_graph_texture) {
+        .width = width,
+        .height = height,
+        .format = format,
+        .physical = SIZE_MAX
+    };
+
+    return (gl_frame_graph_resource)(p_graph->_textures._length - 1);
+}
+
+size_t gl_frame_graph_add_pass(struct gl_frame_graph* p_graph, const char* s_name, gl_frame_graph_pass_fn fn, void* p_user_data) {
+    *(struct gl_frame_graph_pass*)darr_push(&p_graph->_passes) = (struct gl_frame_graph_pass) {
+        .s_name = s_name,
+        .fn = fn,
+        .p_user_data = p_user_data
+    };
+
+    return p_graph->_passes._length - 1;
+}
+
+void gl_frame_graph_read(struct gl_frame_graph* p_graph, size_t pass, gl_frame_graph_resource resource) {
+    struct gl_frame_graph_pass* p_pass = darr_get(&p_graph->_passes, pass);
+
+    if (p_pass->num_reads == GL_FRAME_GRAPH_MAX_READS) {
+        cx_log_fmt(CX_LOG_ERROR, "frame_graph", "Pass '%s' reads more than %u textures\n", p_pass->s_name, (unsigned int)GL_FRAME_GRAPH_MAX_READS);
+        return;
+    }
+
+    p_pass->reads[p_pass->num_reads++] = resource;
+}
+
+void gl_frame_graph_write(struct gl_frame_graph* p_graph, size_t pass, gl_frame_graph_resource resource, enum gl_frame_graph_load load, const float* p_clear_value) {
+    struct gl_frame_graph_pass* p_pass = darr_get(&p_graph->_passes, pass);
+
+    if (p_pass->num_attachments == GL_FRAME_GRAPH_MAX_ATTACHMENTS) {
+        cx_log_fmt(CX_LOG_ERROR, "frame_graph", "Pass '%s' writes more than %u attachments\n", p_pass->s_name, (unsigned int)GL_FRAME_GRAPH_MAX_ATTACHMENTS);
+        return;
+    }
+
+    const int b_is_backbuffer = resource == GL_FRAME_GRAPH_BACKBUFFER;
+    const int b_has_backbuffer = p_pass->num_attachments && p_pass->attachments[0].resource == GL_FRAME_GRAPH_BACKBUFFER;
+
+    if (p_pass->num_attachments && b_is_backbuffer != b_has_backbuffer) {
+        cx_log_fmt(CX_LOG_ERROR, "frame_graph", "Pass '%s' writes the backbuffer alongside textures\n", p_pass->s_name);
+        return;
+    }
+
+    struct gl_frame_graph_attachment* p_attachment = &p_pass->attachments[p_pass->num_attachments++];
+    *p_attachment = (struct gl_frame_graph_attachment) {
+        .resource = resource,
+        .load = load
+    };
+
+    if (load == GL_FRAME_GRAPH_LOAD_clear && p_clear_value) {
+        const struct gl_frame_graph_texture* p_texture = darr_get(&p_graph->_textures, resource);
+        const size_t num_values = p_texture->format == GL_FRAME_GRAPH_FORMAT_depth24_stencil8 ? 2 : 4;
+        memcpy(p_attachment->clear_value, p_clear_value, sizeof(float) * num_values);
+    }
+}
+
+void gl_frame_graph_execute(struct gl_frame_graph* p_graph) {
+    gl_frame_graph_cull(p_graph);
+    gl_frame_graph_allocate(p_graph);
+
+    const size_t query = p_graph->_frame % GL_FRAME_GRAPH_NUM_TIMER_QUERIES;
+
+    for (size_t i = 0; i < p_graph->_passes._length; ++i) {
+        const struct gl_frame_graph_pass* p_pass = darr_get(&p_graph->_passes, i);
+
+        if (p_pass->b_is_culled) {
+            continue;
+        }
+
+        struct gl_frame_graph_timing* p_timing = gl_frame_graph_get_timing(p_graph, p_pass->s_name);
+
+        /* The query is a few frames old by now. If the GPU still hasn't got to it, this run goes untimed rather than
+         * waiting, or beginning the query again and losing the result it's owed. */
+        if (p_timing->b_is_query_pending[query]) {
+            GLint b_is_available = 0;
+            glGetQueryObjectiv(p_timing->gl_queries[query], GL_QUERY_RESULT_AVAILABLE, &b_is_available);
+
+            if (b_is_available) {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(p_timing->gl_queries[query], GL_QUERY_RESULT, &nanoseconds);
+
+                // No pass takes longer than the time since it began, though llvmpipe can report so for a first query
+                const double gpu_seconds = (double)nanoseconds * 1e-9;
+
+                if (gpu_seconds <= platform_time_seconds() - p_timing->query_start_seconds[query]) {
+                    p_timing->gpu_seconds += gpu_seconds;
+                    ++p_timing->num_gpu_samples;
+                }
+
+                p_timing->b_is_query_pending[query] = 0;
+            }
+        }
+
+        const int b_is_timed_on_gpu = !p_timing->b_is_query_pending[query];
+        const double cpu_start = platform_time_seconds();
+
+        if (b_is_timed_on_gpu) {
+            glBeginQuery(GL_TIME_ELAPSED, p_timing->gl_queries[query]);
+            p_timing->query_start_seconds[query] = cpu_start;
+        }
+
+        gl_frame_graph_bind(p_graph, p_pass);
+        gl_frame_graph_clear(p_graph, p_pass);
+        p_pass->fn(p_graph, p_pass->p_user_data);
+
+        if (b_is_timed_on_gpu) {
+            glEndQuery(GL_TIME_ELAPSED);
+            p_timing->b_is_query_pending[query] = 1;
+        }
+
+        p_timing->cpu_seconds += platform_time_seconds() - cpu_start;
+        ++p_timing->num_cpu_samples;
+
+        // A pass without attachments binds its own framebuffer
+        if (p_pass->num_attachments == 0) {
+            p_graph->_b_is_state_known = 0;
+        }
+    }
+
+    gl_frame_graph_collect_garbage(p_graph);
+    ++p_graph->_frame;
+}
+
+GLuint gl_frame_graph_get_texture(const struct gl_frame_graph* p_graph, gl_frame_graph_resource resource) {
+    const struct gl_frame_graph_texture* p_texture = darr_get(&p_graph->_textures, resource);
+
+    if (p_texture->physical == SIZE_MAX) {
+        return 0;
+    }
+
+    return ((const struct gl_frame_graph_physical_texture*)darr_get(&p_graph->_physical_textures, p_texture->physical))->gl_handle;
+}
+
+void gl_frame_graph_log_timings(struct gl_frame_graph* p_graph, int log_level) {
+    struct gl_frame_graph_timing* p_timings = p_graph->_timings._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_timings._length; ++i) {
+        struct gl_frame_graph_timing* p_timing = &p_timings[i];
+
+        if (p_timing->num_cpu_samples == 0) {
+            continue;
+        }
+
+        const double cpu_ms = p_timing->cpu_seconds / p_timing->num_cpu_samples * 1000.0;
+        const double gpu_ms = p_timing->num_gpu_samples ? p_timing->gpu_seconds / p_timing->num_gpu_samples * 1000.0 : 0.0;
+
+        cx_log_fmt(log_level, "frame_graph", "Pass '%s': CPU %.3f ms, GPU %.3f ms (%u runs)\n", p_timing->s_name, cpu_ms, gpu_ms, (unsigned int)p_timing->num_cpu_samples);
+
+        p_timing->cpu_seconds = 0;
+        p_timing->num_cpu_samples = 0;
+        p_timing->gpu_seconds = 0;
+        p_timing->num_gpu_samples = 0;
+    }
+}
+
+void gl_frame_graph_cull(struct gl_frame_graph* p_graph) {
+    struct gl_frame_graph_texture* p_textures = p_graph->_textures._p_buffer;
+    struct gl_frame_graph_pass* p_passes = p_graph->_passes._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_textures._length; ++i) {
+        p_textures[i].b_is_wanted = i == GL_FRAME_GRAPH_BACKBUFFER;
+    }
+
+    /* Walking backwards, a texture is wanted while a pass that runs later reads it or keeps what's in it. Writing it
+     * any other way makes what earlier passes wrote unwanted again. */
+    for (size_t i = p_graph->_passes._length; i-- > 0;) {
+        struct gl_frame_graph_pass* p_pass = &p_passes[i];
+        int b_is_wanted = p_pass->num_attachments == 0;
+
+        for (size_t j = 0; j < p_pass->num_attachments; ++j) {
+            b_is_wanted |= p_textures[p_pass->attachments[j].resource].b_is_wanted;
+        }
+
+        p_pass->b_is_culled = !b_is_wanted;
+
+        if (p_pass->b_is_culled) {
+            continue;
+        }
+
+        for (size_t j = 0; j < p_pass->num_attachments; ++j) {
+            p_textures[p_pass->attachments[j].resource].b_is_wanted = p_pass->attachments[j].load == GL_FRAME_GRAPH_LOAD_keep;
+        }
+
+        for (size_t j = 0; j < p_pass->num_reads; ++j) {
+            p_textures[p_pass->reads[j]].b_is_wanted = 1;
+        }
+    }
+}
+
+void gl_frame_graph_allocate(struct gl_frame_graph* p_graph) {
+    struct gl_frame_graph_texture* p_textures = p_graph->_textures._p_buffer;
+    const struct gl_frame_graph_pass* p_passes = p_graph->_passes._p_buffer;
+    struct gl_frame_graph_physical_texture* p_physical_textures = p_graph->_physical_textures._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_physical_textures._length; ++i) {
+        p_physical_textures[i].b_is_used = 0;
+    }
+
+    for (size_t i = 0; i < p_graph->_textures._length; ++i) {
+        p_textures[i].first_pass = SIZE_MAX;
+        p_textures[i].last_pass = 0;
+    }
+
+    // Each texture lives from the first pass that runs and uses it to the last
+    for (size_t i = 0; i < p_graph->_passes._length; ++i) {
+        const struct gl_frame_graph_pass* p_pass = &p_passes[i];
+
+        if (p_pass->b_is_culled) {
+            continue;
+        }
+
+        for (size_t j = 0; j < p_pass->num_reads + p_pass->num_attachments; ++j) {
+            const gl_frame_graph_resource resource = j < p_pass->num_reads ? p_pass->reads[j] : p_pass->attachments[j - p_pass->num_reads].resource;
+            struct gl_frame_graph_texture* p_texture = &p_textures[resource];
+
+            p_texture->first_pass = p_texture->first_pass < i ? p_texture->first_pass : i;
+            p_texture->last_pass = i;
+        }
+    }
+
+    // In order of first use, so a texture can take over one whose last use was before its first
+    for (size_t i = 0; i < p_graph->_passes._length; ++i) {
+        const struct gl_frame_graph_pass* p_pass = &p_passes[i];
+
+        if (p_pass->b_is_culled) {
+            continue;
+        }
+
+        for (size_t j = 0; j < p_pass->num_reads + p_pass->num_attachments; ++j) {
+            const gl_frame_graph_resource resource = j < p_pass->num_reads ? p_pass->reads[j] : p_pass->attachments[j - p_pass->num_reads].resource;
+            struct gl_frame_graph_texture* p_texture = &p_textures[resource];
+
+            if (resource > GL_FRAME_GRAPH_BACKBUFFER && p_texture->first_pass == i && p_texture->physical == SIZE_MAX) {
+                p_texture->physical = gl_frame_graph_acquire_physical_texture(p_graph, p_texture);
+            }
+        }
+    }
+}
+
+size_t gl_frame_graph_acquire_physical_texture(struct gl_frame_graph* p_graph, const struct gl_frame_graph_texture* p_texture) {
+    struct gl_frame_graph_physical_texture* p_physical_textures = p_graph->_physical_textures._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_physical_textures._length; ++i) {
+        struct gl_frame_graph_physical_texture* p_physical_texture = &p_physical_textures[i];
+
+        const int b_is_free = !p_physical_texture->b_is_used || p_physical_texture->last_pass < p_texture->first_pass;
+
+        if (b_is_free && p_physical_texture->width == p_texture->width && p_physical_texture->height == p_texture->height && p_physical_texture->format == p_texture->format) {
+            p_physical_texture->last_pass = p_texture->last_pass;
+            p_physical_texture->b_is_used = 1;
+            p_physical_texture->unused_frames = 0;
+            return i;
+        }
+    }
+
+    const struct gl_frame_graph_format_info* p_format_info = &g_format_infos[p_texture->format];
+
+    struct gl_frame_graph_physical_texture* p_physical_texture = darr_push(&p_graph->_physical_textures);
+    *p_physical_texture = (struct gl_frame_graph_physical_texture) {
+        .width = p_texture->width,
+        .height = p_texture->height,
+        .format = p_texture->format,
+        .last_pass = p_texture->last_pass,
+        .b_is_used = 1
+    };
+
+    glGenTextures(1, &p_physical_texture->gl_handle);
+    glBindTexture(GL_TEXTURE_2D, p_physical_texture->gl_handle);
+    glTexImage2D(GL_TEXTURE_2D, 0, p_format_info->gl_internal_format, p_texture->width, p_texture->height, 0, p_format_info->gl_format, p_format_info->gl_type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return p_graph->_physical_textures._length - 1;
+}
+
+void gl_frame_graph_bind(struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass) {
+    if (p_pass->num_attachments == 0) {
+        return;
+    }
+
+    const struct gl_frame_graph_texture* p_texture = darr_get(&p_graph->_textures, p_pass->attachments[0].resource);
+    const GLuint gl_framebuffer = p_pass->attachments[0].resource == GL_FRAME_GRAPH_BACKBUFFER ? 0 : gl_frame_graph_get_framebuffer(p_graph, p_pass);
+
+    if (!p_graph->_b_is_state_known || p_graph->_gl_bound_framebuffer != gl_framebuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, gl_framebuffer);
+        p_graph->_gl_bound_framebuffer = gl_framebuffer;
+    }
+
+    if (!p_graph->_b_is_state_known || p_graph->_viewport_size[0] != p_texture->width || p_graph->_viewport_size[1] != p_texture->height) {
+        glViewport(0, 0, p_texture->width, p_texture->height);
+        p_graph->_viewport_size[0] = p_texture->width;
+        p_graph->_viewport_size[1] = p_texture->height;
+    }
+
+    p_graph->_b_is_state_known = 1;
+}
+
+GLuint gl_frame_graph_get_framebuffer(struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass) {
+    GLuint gl_attachments[GL_FRAME_GRAPH_MAX_ATTACHMENTS] = {0};
+
+    for (size_t i = 0; i < p_pass->num_attachments; ++i) {
+        gl_attachments[i] = gl_frame_graph_get_texture(p_graph, p_pass->attachments[i].resource);
+    }
+
+    struct gl_frame_graph_framebuffer* p_framebuffers = p_graph->_framebuffers._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_framebuffers._length; ++i) {
+        if (memcmp(p_framebuffers[i].gl_attachments, gl_attachments, sizeof(gl_attachments)) == 0) {
+            p_framebuffers[i].unused_frames = 0;
+            return p_framebuffers[i].gl_handle;
+        }
+    }
+
+    struct gl_frame_graph_framebuffer* p_framebuffer = darr_push(&p_graph->_framebuffers);
+    *p_framebuffer = (struct gl_frame_graph_framebuffer){0};
+    memcpy(p_framebuffer->gl_attachments, gl_attachments, sizeof(gl_attachments));
+
+    glGenFramebuffers(1, &p_framebuffer->gl_handle);
+    glBindFramebuffer(GL_FRAMEBUFFER, p_framebuffer->gl_handle);
+
+    GLenum gl_draw_buffers[GL_FRAME_GRAPH_MAX_ATTACHMENTS];
+    GLsizei num_draw_buffers = 0;
+
+    for (size_t i = 0; i < p_pass->num_attachments; ++i) {
+        const struct gl_frame_graph_texture* p_texture = darr_get(&p_graph->_textures, p_pass->attachments[i].resource);
+
+        if (p_texture->format == GL_FRAME_GRAPH_FORMAT_depth24_stencil8) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gl_attachments[i], 0);
+        } else {
+            gl_draw_buffers[num_draw_buffers] = GL_COLOR_ATTACHMENT0 + num_draw_buffers;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, gl_draw_buffers[num_draw_buffers], GL_TEXTURE_2D, gl_attachments[i], 0);
+            ++num_draw_buffers;
+        }
+    }
+
+    if (num_draw_buffers) {
+        glDrawBuffers(num_draw_buffers, gl_draw_buffers);
+    } else {
+        glDrawBuffer(GL_NONE);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cx_log_fmt(CX_LOG_ERROR, "frame_graph", "Framebuffer of pass '%s' is incomplete\n", p_pass->s_name);
+    }
+
+    // Bound already, though not yet recorded as such
+    p_graph->_b_is_state_known = 0;
+
+    return p_framebuffer->gl_handle;
+}
+
+void gl_frame_graph_clear(const struct gl_frame_graph* p_graph, const struct gl_frame_graph_pass* p_pass) {
+    GLint draw_buffer = 0;
+
+    for (size_t i = 0; i < p_pass->num_attachments; ++i) {
+        const struct gl_frame_graph_attachment* p_attachment = &p_pass->attachments[i];
+        const uint32_t format = ((const struct gl_frame_graph_texture*)darr_get(&p_graph->_textures, p_attachment->resource))->format;
+
+        if (format == GL_FRAME_GRAPH_FORMAT_depth24_stencil8) {
+            if (p_attachment->load == GL_FRAME_GRAPH_LOAD_clear) {
+                glClearBufferfi(GL_DEPTH_STENCIL, 0, p_attachment->clear_value[0], (GLint)p_attachment->clear_value[1]);
+            }
+            continue;
+        }
+
+        if (p_attachment->load == GL_FRAME_GRAPH_LOAD_clear) {
+            if (format == GL_FRAME_GRAPH_FORMAT_r32ui) {
+                const GLuint values[4] = { (GLuint)p_attachment->clear_value[0], (GLuint)p_attachment->clear_value[1], (GLuint)p_attachment->clear_value[2], (GLuint)p_attachment->clear_value[3] };
+                glClearBufferuiv(GL_COLOR, draw_buffer, values);
+            } else {
+                glClearBufferfv(GL_COLOR, draw_buffer, p_attachment->clear_value);
+            }
+        }
+
+        ++draw_buffer;
+    }
+}
+
+void gl_frame_graph_collect_garbage(struct gl_frame_graph* p_graph) {
+    // Backwards, as removing swaps the last element in
+    for (size_t i = p_graph->_physical_textures._length; i-- > 0;) {
+        struct gl_frame_graph_physical_texture* p_physical_texture = darr_get(&p_graph->_physical_textures, i);
+
+        if (p_physical_texture->b_is_used || ++p_physical_texture->unused_frames <= GL_FRAME_GRAPH_MAX_UNUSED_FRAMES) {
+            continue;
+        }
+
+        // Framebuffers are keyed by GL names, which a new texture could be given again
+        for (size_t j = 0; j < p_graph->_framebuffers._length; ++j) {
+            struct gl_frame_graph_framebuffer* p_framebuffer = darr_get(&p_graph->_framebuffers, j);
+
+            for (size_t k = 0; k < GL_FRAME_GRAPH_MAX_ATTACHMENTS; ++k) {
+                if (p_framebuffer->gl_attachments[k] == p_physical_texture->gl_handle) {
+                    p_framebuffer->unused_frames = SIZE_MAX - 1; // so it's deleted below
+                }
+            }
+        }
+
+        glDeleteTextures(1, &p_physical_texture->gl_handle);
+        darr_remove(&p_graph->_physical_textures, i);
+    }
+
+    for (size_t i = p_graph->_framebuffers._length; i-- > 0;) {
+        struct gl_frame_graph_framebuffer* p_framebuffer = darr_get(&p_graph->_framebuffers, i);
+
+        if (++p_framebuffer->unused_frames <= GL_FRAME_GRAPH_MAX_UNUSED_FRAMES) {
+            continue;
+        }
+
+        if (p_graph->_gl_bound_framebuffer == p_framebuffer->gl_handle) {
+            p_graph->_b_is_state_known = 0;
+        }
+
+        glDeleteFramebuffers(1, &p_framebuffer->gl_handle);
+        darr_remove(&p_graph->_framebuffers, i);
+    }
+}
+
+struct gl_frame_graph_timing* gl_frame_graph_get_timing(struct gl_frame_graph* p_graph, const char* s_name) {
+    struct gl_frame_graph_timing* p_timings = p_graph->_timings._p_buffer;
+
+    for (size_t i = 0; i < p_graph->_timings._length; ++i) {
+        if (p_timings[i].s_name == s_name || strcmp(p_timings[i].s_name, s_name) == 0) {
+            return &p_timings[i];
+        }
+    }
+
+    struct gl_frame_graph_timing* p_timing = darr_push(&p_graph->_timings);
+    *p_timing = (struct gl_frame_graph_timing) {
+        .s_name = s_name
+    };
+
+    glGenQueries(GL_FRAME_GRAPH_NUM_TIMER_QUERIES, p_timing->gl_queries);
+
+    return p_timing;
+}
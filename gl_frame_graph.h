@@ -0,0 +1,142 @@
+#ifndef _H__GL_FRAME_GRAPH
+#define _H__GL_FRAME_GRAPH
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "darr.h"
+#include "gl.h"
+
+#define GL_FRAME_GRAPH_MAX_READS          4
+#define GL_FRAME_GRAPH_MAX_ATTACHMENTS    4 // of which one may be a depth stencil attachment
+#define GL_FRAME_GRAPH_NUM_TIMER_QUERIES  3 // per pass, so a pass's GPU time is read a couple of frames later
+#define GL_FRAME_GRAPH_MAX_UNUSED_FRAMES  8 // before an unused texture or framebuffer is deleted
+
+#define GL_FRAME_GRAPH_NONE       0
+#define GL_FRAME_GRAPH_BACKBUFFER 1 // the default framebuffer's color, which is always wanted
+
+struct gl_frame_graph;
+
+// A texture of the frame, or one of the two above, which take its first two indices
+typedef uint32_t gl_frame_graph_resource;
+
+typedef void (*gl_frame_graph_pass_fn)(struct gl_frame_graph* p_graph, void* p_user_data);
+
+enum gl_frame_graph_format {
+    GL_FRAME_GRAPH_FORMAT_rgb8,
+    GL_FRAME_GRAPH_FORMAT_rgba8,
+    GL_FRAME_GRAPH_FORMAT_r32ui,
+    GL_FRAME_GRAPH_FORMAT_depth24_stencil8
+};
+
+// What a pass wants in an attachment before it draws
+enum gl_frame_graph_load {
+    GL_FRAME_GRAPH_LOAD_keep,     // what the previous pass to write it left
+    GL_FRAME_GRAPH_LOAD_clear,
+    GL_FRAME_GRAPH_LOAD_dont_care // the pass covers every pixel itself
+};
+
+struct gl_frame_graph_texture {
+    GLsizei  width;
+    GLsizei  height;
+    uint32_t format;   // enum gl_frame_graph_format
+    size_t   first_pass;
+    size_t   last_pass;
+    size_t   physical; // index into _physical_textures, SIZE_MAX if no pass that runs uses the texture
+    int      b_is_wanted;
+};
+
+struct gl_frame_graph_physical_texture {
+    GLuint   gl_handle;
+    GLsizei  width;
+    GLsizei  height;
+    uint32_t format;
+    size_t   last_pass;     // of the frame's textures using it
+    int      b_is_used;     // this frame
+    size_t   unused_frames;
+};
+
+struct gl_frame_graph_framebuffer {
+    GLuint gl_handle;
+    GLuint gl_attachments[GL_FRAME_GRAPH_MAX_ATTACHMENTS]; // the textures' GL names, what the framebuffer is keyed by
+    size_t unused_frames;
+};
+
+struct gl_frame_graph_attachment {
+    gl_frame_graph_resource resource;
+    uint32_t                load;           // enum gl_frame_graph_load
+    float                   clear_value[4]; // color, or depth then stencil
+};
+
+struct gl_frame_graph_pass {
+    const char*                      s_name;
+    gl_frame_graph_pass_fn           fn;
+    void*                            p_user_data;
+    gl_frame_graph_resource          reads[GL_FRAME_GRAPH_MAX_READS];
+    size_t                           num_reads;
+    struct gl_frame_graph_attachment attachments[GL_FRAME_GRAPH_MAX_ATTACHMENTS];
+    size_t                           num_attachments;
+    int                              b_is_culled;
+};
+
+// The CPU and GPU time of one named pass, summed since timings were last logged
+struct gl_frame_graph_timing {
+    const char* s_name;
+    GLuint      gl_queries[GL_FRAME_GRAPH_NUM_TIMER_QUERIES];
+    int         b_is_query_pending[GL_FRAME_GRAPH_NUM_TIMER_QUERIES];
+    double      query_start_seconds[GL_FRAME_GRAPH_NUM_TIMER_QUERIES];
+    double      cpu_seconds;
+    size_t      num_cpu_samples;
+    double      gpu_seconds;
+    size_t      num_gpu_samples;
+};
+
+/* Runs a frame's render passes from what each declares it reads and writes, rather than from state each pass sets up
+ * for itself. Every frame the passes are declared again, in order, and on execute:
+ * - passes whose writes nothing wanted reads are culled, though passes with no attachments always run, being
+ *   assumed to draw somewhere of their own
+ * - the frame's textures are created only as they're needed, and textures whose lifetimes don't overlap share one
+ * - each pass gets a framebuffer of its attachments bound, its viewport set and its clears made, each skipped
+ *   where the previous pass left things as they already are
+ * - each pass's CPU and GPU time is measured
+ * Clears obey the scissor test and write masks, so passes should leave them off and on. */
+struct gl_frame_graph {
+    struct darr _textures;           // struct gl_frame_graph_texture, of the frame, indexed by resource
+    struct darr _passes;             // struct gl_frame_graph_pass, of the frame
+    struct darr _physical_textures;  // struct gl_frame_graph_physical_texture
+    struct darr _framebuffers;       // struct gl_frame_graph_framebuffer
+    struct darr _timings;            // struct gl_frame_graph_timing
+    GLuint      _gl_bound_framebuffer;
+    GLsizei     _viewport_size[2];
+    int         _b_is_state_known;   // whether the bound framebuffer and viewport are as recorded
+    size_t      _frame;
+};
+
+void gl_frame_graph_create(struct gl_frame_graph* p_graph);
+void gl_frame_graph_destroy(struct gl_frame_graph* p_graph);
+
+// Starts declaring a frame, forgetting the last one's passes and textures
+void gl_frame_graph_begin(struct gl_frame_graph* p_graph, GLsizei backbuffer_width, GLsizei backbuffer_height);
+
+gl_frame_graph_resource gl_frame_graph_create_texture(struct gl_frame_graph* p_graph, GLsizei width, GLsizei height, enum gl_frame_graph_format format);
+
+// Passes run in the order they're added. s_name must outlive the graph, as it keys the pass's timings.
+size_t gl_frame_graph_add_pass(struct gl_frame_graph* p_graph, const char* s_name, gl_frame_graph_pass_fn fn, void* p_user_data);
+
+// Sampled by the pass, which gets the texture's GL name from gl_frame_graph_get_texture
+void gl_frame_graph_read(struct gl_frame_graph* p_graph, size_t pass, gl_frame_graph_resource resource);
+
+/* Attaches resource to the pass's framebuffer, colors in the order they're written. p_clear_value is for
+ * GL_FRAME_GRAPH_LOAD_clear only: 4 floats for colors, the depth then the stencil for depth stencil attachments. The
+ * backbuffer can't be attached alongside textures. */
+void gl_frame_graph_write(struct gl_frame_graph* p_graph, size_t pass, gl_frame_graph_resource resource, enum gl_frame_graph_load load, const float* p_clear_value);
+
+void   gl_frame_graph_execute(struct gl_frame_graph* p_graph);
+
+// The GL name of a texture the pass being executed reads or writes
+GLuint gl_frame_graph_get_texture(const struct gl_frame_graph* p_graph, gl_frame_graph_resource resource);
+
+// Logs the mean CPU and GPU time of each pass since the last call
+void   gl_frame_graph_log_timings(struct gl_frame_graph* p_graph, int log_level);
+
+#endif
@@ -0,0 +1,252 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_geometry_pool.h"
+#include "gl_mesh.h"
+
+struct gl_geometry_pool_range {
+    size_t offset;
+    size_t size;
+};
+
+static struct gl_geometry_pool_layout* gl_geometry_pool_find_layout(struct gl_geometry_pool* p_pool, const struct mesh_primitive* p_mesh_primitive);
+static void gl_geometry_pool_layout_bind_buffers(const struct gl_geometry_pool_layout* p_layout);
+static void gl_geometry_pool_grow(GLuint* p_gl_buffer, size_t* p_capacity, struct darr* p_free_ranges, size_t element_size, size_t min_capacity, size_t size);
+static int  gl_geometry_pool_range_allocate(struct darr* p_free_ranges, size_t size, size_t* p_offset);
+static void gl_geometry_pool_range_free(struct darr* p_free_ranges, size_t offset, size_t size);
+
+void gl_geometry_pool_init(struct gl_geometry_pool* p_pool) {
+    darr_init(&p_pool->_layouts, sizeof(struct gl_geometry_pool_layout*));
+}
+
+void gl_geometry_pool_destroy(struct gl_geometry_pool* p_pool) {
+    for (size_t i = 0; i < p_pool->_layouts._length; ++i) {
+        struct gl_geometry_pool_layout* p_layout = *(struct gl_geometry_pool_layout**)darr_get(&p_pool->_layouts, i);
+
+        glDeleteVertexArrays(1, &p_layout->_gl_vao);
+        glDeleteBuffers(1, &p_layout->_gl_vbo);
+        glDeleteBuffers(1, &p_layout->_gl_ibo);
+        darr_free(&p_layout->_free_vertex_ranges);
+        darr_free(&p_layout->_free_index_ranges);
+        free(p_layout);
+    }
+
+    darr_free(&p_pool->_layouts);
+}
+
+int gl_geometry_pool_allocate(struct gl_geometry_pool* p_pool, const struct mesh_primitive* p_mesh_primitive, struct gl_geometry_pool_allocation* p_allocation) {
+    if (p_mesh_primitive->num_vertex_buffers != 1 ||
+        p_mesh_primitive->num_attributes == 0 ||
+        p_mesh_primitive->num_attributes > GL_GEOMETRY_POOL_MAX_ATTRIBUTES ||
+        p_mesh_primitive->vertex_count == 0) {
+        return 0;
+    }
+
+    const size_t stride = p_mesh_primitive->p_attributes[0].layout.stride;
+
+    for (size_t i = 0; i < p_mesh_primitive->num_attributes; ++i) {
+        if (p_mesh_primitive->p_attributes[i].layout.stride != stride) {
+            return 0;
+        }
+    }
+
+    if (stride == 0 || p_mesh_primitive->p_vertex_buffers[0].size < p_mesh_primitive->vertex_count * stride) {
+        return 0;
+    }
+
+    struct gl_geometry_pool_layout* p_layout = gl_geometry_pool_find_layout(p_pool, p_mesh_primitive);
+
+    const size_t num_vertices = p_mesh_primitive->vertex_count;
+    const size_t num_indices = p_mesh_primitive->index_buffer.p_bytes ? p_mesh_primitive->index_buffer.count : num_vertices;
+
+    size_t base_vertex;
+    size_t first_index;
+    int b_grown = 0;
+
+    while (!gl_geometry_pool_range_allocate(&p_layout->_free_vertex_ranges, num_vertices, &base_vertex)) {
+        gl_geometry_pool_grow(&p_layout->_gl_vbo, &p_layout->_vertex_capacity, &p_layout->_free_vertex_ranges, stride, GL_GEOMETRY_POOL_MIN_VERTICES, num_vertices);
+        b_grown = 1;
+    }
+
+    while (!gl_geometry_pool_range_allocate(&p_layout->_free_index_ranges, num_indices, &first_index)) {
+        gl_geometry_pool_grow(&p_layout->_gl_ibo, &p_layout->_index_capacity, &p_layout->_free_index_ranges, sizeof(GLuint), GL_GEOMETRY_POOL_MIN_INDICES, num_indices);
+        b_grown = 1;
+    }
+
+    // Growing replaces the buffers, which the VAO still points at the old ones of
+    if (b_grown) {
+        gl_geometry_pool_layout_bind_buffers(p_layout);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, p_layout->_gl_vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, base_vertex * stride, num_vertices * stride, p_mesh_primitive->p_vertex_buffers[0].p_bytes);
+
+    GLuint* p_indices = malloc(sizeof(GLuint) * num_indices);
+
+    if (p_mesh_primitive->index_buffer.p_bytes) {
+        const void* p_bytes = p_mesh_primitive->index_buffer.p_bytes;
+
+        for (size_t i = 0; i < num_indices; ++i) {
+            switch (p_mesh_primitive->index_buffer.type) {
+                case VERTEX_INDEX_TYPE_u8:  p_indices[i] = ((const uint8_t*)p_bytes)[i]; break;
+                case VERTEX_INDEX_TYPE_u16: p_indices[i] = ((const uint16_t*)p_bytes)[i]; break;
+                case VERTEX_INDEX_TYPE_u32: p_indices[i] = ((const uint32_t*)p_bytes)[i]; break;
+            }
+        }
+    } else {
+        for (size_t i = 0; i < num_indices; ++i) {
+            p_indices[i] = (GLuint)i;
+        }
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, p_layout->_gl_ibo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, first_index * sizeof(GLuint), num_indices * sizeof(GLuint), p_indices);
+
+    free(p_indices);
+
+    *p_allocation = (struct gl_geometry_pool_allocation) {
+        .p_layout = p_layout,
+        .gl_vao = p_layout->_gl_vao,
+        .base_vertex = base_vertex,
+        .num_vertices = num_vertices,
+        .first_index = first_index,
+        .num_indices = num_indices
+    };
+
+    return 1;
+}
+
+void gl_geometry_pool_release(const struct gl_geometry_pool_allocation* p_allocation) {
+    gl_geometry_pool_range_free(&p_allocation->p_layout->_free_vertex_ranges, p_allocation->base_vertex, p_allocation->num_vertices);
+    gl_geometry_pool_range_free(&p_allocation->p_layout->_free_index_ranges, p_allocation->first_index, p_allocation->num_indices);
+}
+
+struct gl_geometry_pool_layout* gl_geometry_pool_find_layout(struct gl_geometry_pool* p_pool, const struct mesh_primitive* p_mesh_primitive) {
+    for (size_t i = 0; i < p_pool->_layouts._length; ++i) {
+        struct gl_geometry_pool_layout* p_layout = *(struct gl_geometry_pool_layout**)darr_get(&p_pool->_layouts, i);
+
+        if (p_layout->_num_attributes != p_mesh_primitive->num_attributes || p_layout->_stride != p_mesh_primitive->p_attributes[0].layout.stride) {
+            continue;
+        }
+
+        int b_match = 1;
+
+        for (size_t j = 0; j < p_layout->_num_attributes && b_match; ++j) {
+            const struct vertex_attribute* p_a = &p_layout->_attributes[j];
+            const struct vertex_attribute* p_b = &p_mesh_primitive->p_attributes[j];
+
+            b_match =
+                p_a->index == p_b->index &&
+                p_a->layout.offset == p_b->layout.offset &&
+                p_a->layout.component_count == p_b->layout.component_count &&
+                p_a->layout.component_type == p_b->layout.component_type;
+        }
+
+        if (b_match) {
+            return p_layout;
+        }
+    }
+
+    struct gl_geometry_pool_layout* p_layout = malloc(sizeof(*p_layout));
+    *p_layout = (struct gl_geometry_pool_layout) {
+        ._num_attributes = p_mesh_primitive->num_attributes,
+        ._stride = p_mesh_primitive->p_attributes[0].layout.stride
+    };
+
+    memcpy(p_layout->_attributes, p_mesh_primitive->p_attributes, sizeof(*p_mesh_primitive->p_attributes) * p_mesh_primitive->num_attributes);
+    glGenVertexArrays(1, &p_layout->_gl_vao);
+    darr_init(&p_layout->_free_vertex_ranges, sizeof(struct gl_geometry_pool_range));
+    darr_init(&p_layout->_free_index_ranges, sizeof(struct gl_geometry_pool_range));
+
+    *(struct gl_geometry_pool_layout**)darr_push(&p_pool->_layouts) = p_layout;
+
+    return p_layout;
+}
+
+void gl_geometry_pool_layout_bind_buffers(const struct gl_geometry_pool_layout* p_layout) {
+    glBindVertexArray(p_layout->_gl_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, p_layout->_gl_vbo);
+
+    for (size_t i = 0; i < p_layout->_num_attributes; ++i) {
+        gl_mesh_set_vertex_attribute(&p_layout->_attributes[i]);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p_layout->_gl_ibo);
+}
+
+void gl_geometry_pool_grow(GLuint* p_gl_buffer, size_t* p_capacity, struct darr* p_free_ranges, size_t element_size, size_t min_capacity, size_t size) {
+    const size_t old_capacity = *p_capacity;
+    size_t capacity = old_capacity ? old_capacity * 2 : min_capacity;
+
+    // Enough that the free range at the end, however small it was, now fits size
+    while (capacity < old_capacity + size) {
+        capacity *= 2;
+    }
+
+    GLuint gl_buffer;
+    glGenBuffers(1, &gl_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, gl_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * element_size, NULL, GL_STATIC_DRAW);
+
+    if (*p_gl_buffer) {
+        glBindBuffer(GL_COPY_READ_BUFFER, *p_gl_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * element_size);
+        glDeleteBuffers(1, p_gl_buffer);
+    }
+
+    *p_gl_buffer = gl_buffer;
+    *p_capacity = capacity;
+
+    gl_geometry_pool_range_free(p_free_ranges, old_capacity, capacity - old_capacity);
+}
+
+int gl_geometry_pool_range_allocate(struct darr* p_free_ranges, size_t size, size_t* p_offset) {
+    struct gl_geometry_pool_range* p_ranges = p_free_ranges->_p_buffer;
+
+    for (size_t i = 0; i < p_free_ranges->_length; ++i) {
+        if (p_ranges[i].size < size) {
+            continue;
+        }
+
+        *p_offset = p_ranges[i].offset;
+        p_ranges[i].offset += size;
+        p_ranges[i].size -= size;
+
+        if (p_ranges[i].size == 0) {
+            memmove(&p_ranges[i], &p_ranges[i + 1], sizeof(*p_ranges) * (p_free_ranges->_length - i - 1));
+            --p_free_ranges->_length;
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+void gl_geometry_pool_range_free(struct darr* p_free_ranges, size_t offset, size_t size) {
+    struct gl_geometry_pool_range* p_ranges = p_free_ranges->_p_buffer;
+
+    size_t i = 0;
+    while (i < p_free_ranges->_length && p_ranges[i].offset < offset) {
+        ++i;
+    }
+
+    const int b_merge_prev = i > 0 && p_ranges[i - 1].offset + p_ranges[i - 1].size == offset;
+    const int b_merge_next = i < p_free_ranges->_length && offset + size == p_ranges[i].offset;
+
+    if (b_merge_prev && b_merge_next) {
+        p_ranges[i - 1].size += size + p_ranges[i].size;
+        memmove(&p_ranges[i], &p_ranges[i + 1], sizeof(*p_ranges) * (p_free_ranges->_length - i - 1));
+        --p_free_ranges->_length;
+    } else if (b_merge_prev) {
+        p_ranges[i - 1].size += size;
+    } else if (b_merge_next) {
+        p_ranges[i].offset = offset;
+        p_ranges[i].size += size;
+    } else {
+        darr_push(p_free_ranges);
+        p_ranges = p_free_ranges->_p_buffer;
+        memmove(&p_ranges[i + 1], &p_ranges[i], sizeof(*p_ranges) * (p_free_ranges->_length - i - 1));
+        p_ranges[i] = (struct gl_geometry_pool_range) { .offset = offset, .size = size };
+    }
+}
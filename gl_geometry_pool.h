@@ -0,0 +1,52 @@
+#ifndef _H__GL_GEOMETRY_POOL
+#define _H__GL_GEOMETRY_POOL
+
+#include "darr.h"
+#include "gl.h"
+#include "mesh.h"
+
+#define GL_GEOMETRY_POOL_MAX_ATTRIBUTES 8
+#define GL_GEOMETRY_POOL_MIN_VERTICES   65536
+#define GL_GEOMETRY_POOL_MIN_INDICES    (GL_GEOMETRY_POOL_MIN_VERTICES * 3)
+
+/* Vertices and indices for every primitive of one vertex layout, in one vertex buffer and one index buffer bound to
+ * one VAO, so switching between its primitives needs no rebinding and runs of them can be multi-drawn. Indices are
+ * widened to 32 bits so every primitive draws with the same index type. */
+struct gl_geometry_pool_layout {
+    struct vertex_attribute _attributes[GL_GEOMETRY_POOL_MAX_ATTRIBUTES];
+    size_t                  _num_attributes;
+    size_t                  _stride;
+    GLuint                  _gl_vao;
+    GLuint                  _gl_vbo;
+    GLuint                  _gl_ibo;
+    size_t                  _vertex_capacity;
+    size_t                  _index_capacity;
+    struct darr             _free_vertex_ranges; // struct gl_geometry_pool_range, sorted by offset
+    struct darr             _free_index_ranges;  // struct gl_geometry_pool_range, sorted by offset
+};
+
+struct gl_geometry_pool {
+    struct darr _layouts; // struct gl_geometry_pool_layout*, so they keep their addresses as more are added
+};
+
+// Where a primitive lives in a pool. Offsets and counts are in vertices and indices.
+struct gl_geometry_pool_allocation {
+    struct gl_geometry_pool_layout* p_layout;
+    GLuint                          gl_vao;
+    size_t                          base_vertex;
+    size_t                          num_vertices;
+    size_t                          first_index;
+    size_t                          num_indices;
+};
+
+// Buffers are created as layouts are first used, so this needs no GL context. Destroy every pooled mesh first.
+void gl_geometry_pool_init(struct gl_geometry_pool* p_pool);
+void gl_geometry_pool_destroy(struct gl_geometry_pool* p_pool);
+
+/* Uploads a primitive into the layout it uses, growing the layout's buffers as needed. Returns 0, allocating nothing,
+ * for primitives that can't share buffers: ones with more than one vertex buffer or with attributes of differing
+ * strides. */
+int  gl_geometry_pool_allocate(struct gl_geometry_pool* p_pool, const struct mesh_primitive* p_mesh_primitive, struct gl_geometry_pool_allocation* p_allocation);
+void gl_geometry_pool_release(const struct gl_geometry_pool_allocation* p_allocation);
+
+#endif
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "gl_mesh.h"
 #include "mesh.h"
 
@@ -5,6 +7,7 @@ int is_vertex_attribute_type_float(enum vertex_attribute_type vertex_attribute_t
 GLenum vertex_attribute_type_to_glenum(enum vertex_attribute_type vertex_attribute_type);
 int is_vertex_attribute_type_normalized(enum vertex_attribute_type vertex_attribute_type);
 GLenum index_type_to_glenum(enum vertex_index_type vertex_index_type);
+GLenum draw_mode_to_glenum(enum mesh_primitive_draw_mode draw_mode);
 
 void gl_mesh_create(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_mesh_primitive) {
     *p_gl_mesh = (struct gl_mesh){0};
@@ -27,25 +30,7 @@ void gl_mesh_create(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_me
         const struct vertex_attribute* p_attribute = &p_mesh_primitive->p_attributes[i];
 
         glBindBuffer(GL_ARRAY_BUFFER, p_gl_mesh->_gl_vbos[p_attribute->vertex_buffer_index]);
-
-        if (is_vertex_attribute_type_float(p_attribute->layout.component_type)) {
-            glVertexAttribPointer((GLuint)p_attribute->index,
-                (GLint)p_attribute->layout.component_count,
-                vertex_attribute_type_to_glenum(p_attribute->layout.component_type),
-                (GLboolean)is_vertex_attribute_type_normalized(p_attribute->layout.component_type),
-                (GLsizei)p_attribute->layout.stride,
-                (void*)(GLsizeiptr)p_attribute->layout.offset
-            );
-        } else {
-            glVertexAttribIPointer((GLuint)p_attribute->index,
-                (GLint)p_attribute->layout.component_count,
-                vertex_attribute_type_to_glenum(p_attribute->layout.component_type),
-                (GLsizei)p_attribute->layout.stride,
-                (void*)(GLsizeiptr)p_attribute->layout.offset
-            );
-        }
-        
-        glEnableVertexAttribArray(p_attribute->index);
+        gl_mesh_set_vertex_attribute(p_attribute);
     }
 
     if (p_mesh_primitive->index_buffer.p_bytes) {
@@ -68,21 +53,37 @@ void gl_mesh_create(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_me
         p_gl_mesh->_num_elements = p_mesh_primitive->vertex_count;
     }
 
-    switch (p_mesh_primitive->draw_mode) {
-        case MESH_PRIMITIVE_DRAW_MODE_points:         p_gl_mesh->_gl_draw_mode = GL_POINTS; break;
-        case MESH_PRIMITIVE_DRAW_MODE_line_strip:     p_gl_mesh->_gl_draw_mode = GL_LINE_STRIP; break;
-        case MESH_PRIMITIVE_DRAW_MODE_line_loop:      p_gl_mesh->_gl_draw_mode = GL_LINE_LOOP; break;
-        case MESH_PRIMITIVE_DRAW_MODE_lines:          p_gl_mesh->_gl_draw_mode = GL_LINES; break;
-        case MESH_PRIMITIVE_DRAW_MODE_triangle_strip: p_gl_mesh->_gl_draw_mode = GL_TRIANGLE_STRIP; break;
-        case MESH_PRIMITIVE_DRAW_MODE_triangle_fan:   p_gl_mesh->_gl_draw_mode = GL_TRIANGLE_FAN; break;
-        case MESH_PRIMITIVE_DRAW_MODE_triangles:      p_gl_mesh->_gl_draw_mode = GL_TRIANGLES; break;
+    p_gl_mesh->_gl_draw_mode = draw_mode_to_glenum(p_mesh_primitive->draw_mode);
+
+    memcpy(p_gl_mesh->_bounds_min, p_mesh_primitive->bounds_min, sizeof(p_gl_mesh->_bounds_min));
+    memcpy(p_gl_mesh->_bounds_max, p_mesh_primitive->bounds_max, sizeof(p_gl_mesh->_bounds_max));
+}
+
+void gl_mesh_create_pooled(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_mesh_primitive, struct gl_geometry_pool* p_pool) {
+    *p_gl_mesh = (struct gl_mesh){0};
+
+    if (!gl_geometry_pool_allocate(p_pool, p_mesh_primitive, &p_gl_mesh->_pool_allocation)) {
+        gl_mesh_create(p_gl_mesh, p_mesh_primitive);
+        return;
     }
 
+    // Only the ranges are the mesh's own; the VAO and buffers are shared by everything in the layout
+    p_gl_mesh->_gl_vao = p_gl_mesh->_pool_allocation.gl_vao;
+    p_gl_mesh->_gl_ibo_type = GL_UNSIGNED_INT;
+    p_gl_mesh->_gl_draw_mode = draw_mode_to_glenum(p_mesh_primitive->draw_mode);
+    p_gl_mesh->_num_elements = (GLsizei)p_gl_mesh->_pool_allocation.num_indices;
+
     memcpy(p_gl_mesh->_bounds_min, p_mesh_primitive->bounds_min, sizeof(p_gl_mesh->_bounds_min));
     memcpy(p_gl_mesh->_bounds_max, p_mesh_primitive->bounds_max, sizeof(p_gl_mesh->_bounds_max));
 }
 
 void gl_mesh_destroy(struct gl_mesh* p_gl_mesh) {
+    if (p_gl_mesh->_pool_allocation.p_layout) {
+        gl_geometry_pool_release(&p_gl_mesh->_pool_allocation);
+        *p_gl_mesh = (struct gl_mesh){0};
+        return;
+    }
+
     glDeleteBuffers(p_gl_mesh->_gl_vbos_len, p_gl_mesh->_gl_vbos);
     glDeleteBuffers(1, &p_gl_mesh->_gl_ibo);
     glDeleteVertexArrays(1, &p_gl_mesh->_gl_vao);
@@ -92,13 +93,98 @@ void gl_mesh_destroy(struct gl_mesh* p_gl_mesh) {
 void gl_mesh_draw(const struct gl_mesh* p_gl_mesh) {
     glBindVertexArray(p_gl_mesh->_gl_vao);
 
-    if (p_gl_mesh->_gl_ibo) {
+    if (p_gl_mesh->_pool_allocation.p_layout) {
+        glDrawElementsBaseVertex(p_gl_mesh->_gl_draw_mode, p_gl_mesh->_num_elements, GL_UNSIGNED_INT,
+            (const void*)(sizeof(GLuint) * p_gl_mesh->_pool_allocation.first_index),
+            (GLint)p_gl_mesh->_pool_allocation.base_vertex);
+    } else if (p_gl_mesh->_gl_ibo) {
         glDrawElements(p_gl_mesh->_gl_draw_mode, p_gl_mesh->_num_elements, p_gl_mesh->_gl_ibo_type, 0);
     } else {
         glDrawArrays(p_gl_mesh->_gl_draw_mode, 0, p_gl_mesh->_num_elements);
     }
 }
 
+void gl_mesh_draw_instanced(const struct gl_mesh* p_gl_mesh, GLuint gl_instance_buffer, size_t offset, GLsizei num_instances) {
+    glBindVertexArray(p_gl_mesh->_gl_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, gl_instance_buffer);
+
+    // A mat4 attribute is four vec4 columns, each advancing once per instance
+    for (GLuint i = 0; i < 4; ++i) {
+        const GLuint location = GL_MESH_INSTANCE_MATRIX_LOCATION + i;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 16, (const void*)(offset + sizeof(GLfloat) * 4 * i));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+
+    if (p_gl_mesh->_pool_allocation.p_layout) {
+        glDrawElementsInstancedBaseVertex(p_gl_mesh->_gl_draw_mode, p_gl_mesh->_num_elements, GL_UNSIGNED_INT,
+            (const void*)(sizeof(GLuint) * p_gl_mesh->_pool_allocation.first_index),
+            num_instances,
+            (GLint)p_gl_mesh->_pool_allocation.base_vertex);
+    } else if (p_gl_mesh->_gl_ibo) {
+        glDrawElementsInstanced(p_gl_mesh->_gl_draw_mode, p_gl_mesh->_num_elements, p_gl_mesh->_gl_ibo_type, 0, num_instances);
+    } else {
+        glDrawArraysInstanced(p_gl_mesh->_gl_draw_mode, 0, p_gl_mesh->_num_elements, num_instances);
+    }
+}
+
+void gl_mesh_multi_draw(const struct gl_mesh* const* pp_gl_meshes, size_t num_gl_meshes) {
+    GLsizei counts[GL_MESH_MAX_MULTI_DRAW];
+    const void* offsets[GL_MESH_MAX_MULTI_DRAW];
+    GLint base_vertices[GL_MESH_MAX_MULTI_DRAW];
+
+    for (size_t i = 0; i < num_gl_meshes;) {
+        const struct gl_mesh* p_gl_mesh = pp_gl_meshes[i];
+
+        if (!p_gl_mesh->_pool_allocation.p_layout) {
+            gl_mesh_draw(p_gl_mesh);
+            ++i;
+            continue;
+        }
+
+        size_t num_draws = 0;
+
+        while (i + num_draws < num_gl_meshes && num_draws < GL_MESH_MAX_MULTI_DRAW) {
+            const struct gl_mesh* p_next = pp_gl_meshes[i + num_draws];
+
+            if (p_next->_pool_allocation.p_layout != p_gl_mesh->_pool_allocation.p_layout || p_next->_gl_draw_mode != p_gl_mesh->_gl_draw_mode) {
+                break;
+            }
+
+            counts[num_draws] = p_next->_num_elements;
+            offsets[num_draws] = (const void*)(sizeof(GLuint) * p_next->_pool_allocation.first_index);
+            base_vertices[num_draws] = (GLint)p_next->_pool_allocation.base_vertex;
+            ++num_draws;
+        }
+
+        glBindVertexArray(p_gl_mesh->_gl_vao);
+        glMultiDrawElementsBaseVertex(p_gl_mesh->_gl_draw_mode, counts, GL_UNSIGNED_INT, offsets, (GLsizei)num_draws, base_vertices);
+
+        i += num_draws;
+    }
+}
+
+void gl_mesh_set_vertex_attribute(const struct vertex_attribute* p_attribute) {
+    if (is_vertex_attribute_type_float(p_attribute->layout.component_type)) {
+        glVertexAttribPointer((GLuint)p_attribute->index,
+            (GLint)p_attribute->layout.component_count,
+            vertex_attribute_type_to_glenum(p_attribute->layout.component_type),
+            (GLboolean)is_vertex_attribute_type_normalized(p_attribute->layout.component_type),
+            (GLsizei)p_attribute->layout.stride,
+            (void*)(GLsizeiptr)p_attribute->layout.offset
+        );
+    } else {
+        glVertexAttribIPointer((GLuint)p_attribute->index,
+            (GLint)p_attribute->layout.component_count,
+            vertex_attribute_type_to_glenum(p_attribute->layout.component_type),
+            (GLsizei)p_attribute->layout.stride,
+            (void*)(GLsizeiptr)p_attribute->layout.offset
+        );
+    }
+    
+    glEnableVertexAttribArray(p_attribute->index);
+}
+
 int is_vertex_attribute_type_float(enum vertex_attribute_type vertex_attribute_type) {
     return
         vertex_attribute_type == VERTEX_ATTRIBUTE_TYPE_f32 ||
@@ -147,4 +233,17 @@ GLenum index_type_to_glenum(enum vertex_index_type vertex_index_type) {
     }
 
     return GL_NONE;
-}
\ No newline at end of file
+}
+
+GLenum draw_mode_to_glenum(enum mesh_primitive_draw_mode draw_mode) {
+    switch (draw_mode) {
+        case MESH_PRIMITIVE_DRAW_MODE_points:         return GL_POINTS;
+        case MESH_PRIMITIVE_DRAW_MODE_line_strip:     return GL_LINE_STRIP;
+        case MESH_PRIMITIVE_DRAW_MODE_line_loop:      return GL_LINE_LOOP;
+        case MESH_PRIMITIVE_DRAW_MODE_lines:          return GL_LINES;
+        case MESH_PRIMITIVE_DRAW_MODE_triangle_strip: return GL_TRIANGLE_STRIP;
+        case MESH_PRIMITIVE_DRAW_MODE_triangle_fan:   return GL_TRIANGLE_FAN;
+        case MESH_PRIMITIVE_DRAW_MODE_triangles:      return GL_TRIANGLES;
+    }
+    return GL_TRIANGLES;
+}
@@ -2,10 +2,18 @@
 #define _H__GL_MESH
 
 #include "gl.h"
+#include "gl_geometry_pool.h"
 
 #define GL_MESH_MAX_VBOS 8
 
+// Most meshes one glMultiDrawElementsBaseVertex call is given, bounding the arrays gl_mesh_multi_draw builds
+#define GL_MESH_MAX_MULTI_DRAW 64
+
+// Instanced draws feed each instance's model matrix to this mat4 attribute, which takes it and the next three locations
+#define GL_MESH_INSTANCE_MATRIX_LOCATION 8
+
 struct mesh_primitive;
+struct vertex_attribute;
 
 struct gl_mesh {
     GLuint  _gl_vao;
@@ -17,10 +25,21 @@ struct gl_mesh {
     GLsizei _num_elements;
     GLfloat _bounds_min[3];
     GLfloat _bounds_max[3];
+    struct gl_geometry_pool_allocation _pool_allocation; // p_layout is 0 unless the mesh lives in a geometry pool
 };
 
 void gl_mesh_create(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_mesh_primitive);
+void gl_mesh_create_pooled(struct gl_mesh* p_gl_mesh, const struct mesh_primitive* p_mesh_primitive, struct gl_geometry_pool* p_pool); // falls back to gl_mesh_create for layouts the pool can't share
 void gl_mesh_destroy(struct gl_mesh* p_gl_mesh);
 void gl_mesh_draw(const struct gl_mesh* p_gl_mesh);
 
+// Draws each mesh in turn, as one call for every run of them sharing a pool layout and draw mode
+void gl_mesh_multi_draw(const struct gl_mesh* const* pp_gl_meshes, size_t num_gl_meshes);
+
+// Points the attribute at the GL_ARRAY_BUFFER binding, in the bound VAO
+void gl_mesh_set_vertex_attribute(const struct vertex_attribute* p_attribute);
+
+// Draws num_instances copies, with packed column-major model matrices read from gl_instance_buffer at byte offset
+void gl_mesh_draw_instanced(const struct gl_mesh* p_gl_mesh, GLuint gl_instance_buffer, size_t offset, GLsizei num_instances);
+
 #endif
\ No newline at end of file
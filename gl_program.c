@@ -1,8 +1,24 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "gl_program.h"
 #include "logging.h"
 
+static const char* g_gl_program_block_names[GL_PROGRAM_BLOCK_count] = {
+    "Frame",
+    "Material",
+    "Draw"
+};
+
+static const char* g_gl_program_uniform_names[GL_PROGRAM_UNIFORM_count] = {
+    "u_projection_matrix",
+    "u_view_matrix",
+    "u_model_matrix",
+    "u_color",
+    "u_id",
+    "u_texture"
+};
+
 enum error gl_shader_create(struct gl_shader* p_gl_shader, GLenum gl_shader_type) {
     p_gl_shader->gl_handle = glCreateShader(gl_shader_type);
     
@@ -49,6 +65,10 @@ void gl_shader_destroy(struct gl_shader* p_gl_shader) {
 enum error gl_program_create(struct gl_program* p_gl_program) {
     p_gl_program->gl_handle = glCreateProgram();
 
+    for (size_t i = 0; i < GL_PROGRAM_UNIFORM_count; ++i) {
+        p_gl_program->uniform_locations[i] = -1;
+    }
+
     if (p_gl_program->gl_handle) {
         return ERROR_OK;
     }
@@ -71,20 +91,45 @@ enum error gl_program_attach_shader(struct gl_program* p_gl_program, const struc
 }
 
 enum error gl_program_link(struct gl_program* p_gl_program) {
+    const enum error error = gl_program_link_begin(p_gl_program);
+
+    if (error != ERROR_OK) {
+        return error;
+    }
+
+    return gl_program_link_end(p_gl_program);
+}
+
+enum error gl_program_link_begin(struct gl_program* p_gl_program) {
     if (!glIsProgram(p_gl_program->gl_handle)) {
         return ERROR_INVALID_VALUE;
     }
 
     glLinkProgram(p_gl_program->gl_handle);
 
+    return ERROR_OK;
+}
+
+enum error gl_program_link_end(struct gl_program* p_gl_program) {
     GLint b_is_linked;
     glGetProgramiv(p_gl_program->gl_handle, GL_LINK_STATUS, &b_is_linked);
     
-    if (b_is_linked) {
-        return ERROR_OK;
+    if (!b_is_linked) {
+        return ERROR_SHADER_PROGRAM_LINKAGE;
+    }
+
+    for (size_t i = 0; i < GL_PROGRAM_UNIFORM_count; ++i) {
+        p_gl_program->uniform_locations[i] = glGetUniformLocation(p_gl_program->gl_handle, g_gl_program_uniform_names[i]);
+    }
+
+    for (size_t i = 0; i < GL_PROGRAM_BLOCK_count; ++i) {
+        const GLuint block_index = glGetUniformBlockIndex(p_gl_program->gl_handle, g_gl_program_block_names[i]);
+        if (block_index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(p_gl_program->gl_handle, block_index, (GLuint)i);
+        }
     }
 
-    return ERROR_SHADER_PROGRAM_LINKAGE;
+    return ERROR_OK;
 }
 
 void gl_program_destroy(struct gl_program* p_gl_program) {
@@ -21,13 +21,38 @@ enum shader_uniform_type {
     SHADER_UNIFORM_TYPE_mat4,
 };
 
+// Uniform blocks gl_program_link binds to these binding points, so one buffer binding serves every program using a block
+enum gl_program_block {
+    GL_PROGRAM_BLOCK_frame,    // "Frame", a struct gl_frame_uniforms
+    GL_PROGRAM_BLOCK_material, // "Material", a vec4 u_color
+    GL_PROGRAM_BLOCK_draw,     // "Draw", a mat4 u_model_matrix
+    GL_PROGRAM_BLOCK_count
+};
+
+// Uniforms gl_program_link looks up once, so drawing never looks them up by name
+enum gl_program_uniform {
+    GL_PROGRAM_UNIFORM_projection_matrix,
+    GL_PROGRAM_UNIFORM_view_matrix,
+    GL_PROGRAM_UNIFORM_model_matrix,
+    GL_PROGRAM_UNIFORM_color,
+    GL_PROGRAM_UNIFORM_id,
+    GL_PROGRAM_UNIFORM_texture,
+    GL_PROGRAM_UNIFORM_count
+};
+
 struct gl_program {
     GLuint gl_handle;
+    GLint  uniform_locations[GL_PROGRAM_UNIFORM_count]; // -1 for the ones the program doesn't have
 };
 
 enum error gl_program_create(struct gl_program* p_gl_program);
 enum error gl_program_attach_shader(struct gl_program* p_gl_program, const struct gl_shader* p_gl_shader);
 enum error gl_program_link(struct gl_program* p_gl_program);
+
+/* gl_program_link in two halves. Drivers may link in the background until the status is asked for, so starting
+ * several links before ending any lets them overlap. gl_program_link_end also suits programs given a binary. */
+enum error gl_program_link_begin(struct gl_program* p_gl_program);
+enum error gl_program_link_end(struct gl_program* p_gl_program);
 void       gl_program_destroy(struct gl_program* p_gl_program);
 void       gl_program_print_info(const struct gl_program* p_gl_program);
 
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_program_cache.h"
+#include "logging.h"
+#include "platform.h"
+
+#ifdef PLATFORM_LINUX
+#include <sys/stat.h>
+#endif
+
+#define LOG_CAT_GL_PROGRAM_CACHE "gl_program_cache"
+
+#define GL_PROGRAM_CACHE_MAGIC   0x42504358u // "XCPB"
+#define GL_PROGRAM_CACHE_VERSION 1
+
+struct gl_program_cache_pending {
+    uint64_t           hash;
+    struct gl_program* p_program;
+    GLuint             gl_shaders[GL_PROGRAM_CACHE_MAX_SHADERS];
+    size_t             num_shaders;
+};
+
+struct gl_program_cache_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t binary_format;
+    uint32_t binary_length;
+};
+
+static uint64_t gl_program_cache_hash(uint64_t hash, const void* p_bytes, size_t size);
+static void     gl_program_cache_make_path(const struct gl_program_cache* p_cache, uint64_t hash, char* s_path);
+static int      gl_program_cache_load_binary(const struct gl_program_cache* p_cache, uint64_t hash, struct gl_program* p_program);
+static void     gl_program_cache_save_binary(const struct gl_program_cache* p_cache, uint64_t hash, const struct gl_program* p_program);
+static GLuint   gl_program_cache_compile_shader(GLenum gl_shader_type, const char* s_source, const char* s_defines);
+static void     gl_program_cache_log_errors(const struct gl_program_cache_pending* p_pending);
+
+void gl_program_cache_init(struct gl_program_cache* p_cache, const char* s_directory) {
+    *p_cache = (struct gl_program_cache){0};
+    darr_init(&p_cache->_pending, sizeof(struct gl_program_cache_pending));
+
+    if (!s_directory) {
+        return;
+    }
+
+    snprintf(p_cache->_s_directory, sizeof(p_cache->_s_directory), "%s", s_directory);
+
+    // Contexts without program binaries report no formats, or don't know the query and leave it at 0
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+    glGetError();
+
+    p_cache->_b_binaries_supported = num_formats > 0;
+
+    if (!p_cache->_b_binaries_supported) {
+        cx_log_fmt(CX_LOG_INFO, LOG_CAT_GL_PROGRAM_CACHE, "Program binaries aren't supported, every program will be compiled\n");
+        return;
+    }
+
+#ifdef PLATFORM_WINDOWS
+    CreateDirectoryA(p_cache->_s_directory, NULL);
+#elif defined(PLATFORM_LINUX)
+    mkdir(p_cache->_s_directory, 0755);
+#endif
+}
+
+void gl_program_cache_destroy(struct gl_program_cache* p_cache) {
+    gl_program_cache_finish(p_cache);
+    darr_free(&p_cache->_pending);
+    *p_cache = (struct gl_program_cache){0};
+}
+
+enum error gl_program_cache_load(struct gl_program_cache* p_cache, const struct gl_program_source* p_sources, size_t num_sources, const char* s_defines, struct gl_program* p_program) {
+    if (num_sources == 0 || num_sources > GL_PROGRAM_CACHE_MAX_SHADERS) {
+        return ERROR_INVALID_VALUE;
+    }
+
+    uint64_t hash = 14695981039346656037u;
+
+    for (size_t i = 0; i < num_sources; ++i) {
+        const uint32_t gl_shader_type = p_sources[i].gl_shader_type;
+        hash = gl_program_cache_hash(hash, &gl_shader_type, sizeof(gl_shader_type));
+        hash = gl_program_cache_hash(hash, p_sources[i].s_source, strlen(p_sources[i].s_source) + 1);
+    }
+
+    if (s_defines) {
+        hash = gl_program_cache_hash(hash, s_defines, strlen(s_defines) + 1);
+    }
+
+    const enum error error = gl_program_create(p_program);
+
+    if (error != ERROR_OK) {
+        return error;
+    }
+
+    if (p_cache->_b_binaries_supported && gl_program_cache_load_binary(p_cache, hash, p_program)) {
+        return ERROR_OK;
+    }
+
+    struct gl_program_cache_pending pending = {
+        .hash = hash,
+        .p_program = p_program,
+        .num_shaders = num_sources
+    };
+
+    for (size_t i = 0; i < num_sources; ++i) {
+        pending.gl_shaders[i] = gl_program_cache_compile_shader(p_sources[i].gl_shader_type, p_sources[i].s_source, s_defines);
+        glAttachShader(p_program->gl_handle, pending.gl_shaders[i]);
+    }
+
+    if (p_cache->_b_binaries_supported) {
+        glProgramParameteri(p_program->gl_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    gl_program_link_begin(p_program);
+
+    *(struct gl_program_cache_pending*)darr_push(&p_cache->_pending) = pending;
+
+    return ERROR_OK;
+}
+
+enum error gl_program_cache_finish(struct gl_program_cache* p_cache) {
+    enum error result = ERROR_OK;
+
+    for (size_t i = 0; i < p_cache->_pending._length; ++i) {
+        const struct gl_program_cache_pending* p_pending = darr_get(&p_cache->_pending, i);
+
+        const enum error error = gl_program_link_end(p_pending->p_program);
+
+        if (error != ERROR_OK) {
+            gl_program_cache_log_errors(p_pending);
+            result = result == ERROR_OK ? error : result;
+        } else if (p_cache->_b_binaries_supported) {
+            gl_program_cache_save_binary(p_cache, p_pending->hash, p_pending->p_program);
+        }
+
+        for (size_t j = 0; j < p_pending->num_shaders; ++j) {
+            glDetachShader(p_pending->p_program->gl_handle, p_pending->gl_shaders[j]);
+            glDeleteShader(p_pending->gl_shaders[j]);
+        }
+    }
+
+    p_cache->_pending._length = 0;
+
+    return result;
+}
+
+uint64_t gl_program_cache_hash(uint64_t hash, const void* p_bytes, size_t size) {
+    // FNV-1a
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= ((const uint8_t*)p_bytes)[i];
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+void gl_program_cache_make_path(const struct gl_program_cache* p_cache, uint64_t hash, char* s_path) {
+    // The directory is cut short to leave room for "/<16 hex digits>.bin"
+    snprintf(s_path, GL_PROGRAM_CACHE_PATH_LEN, "%.*s/%08x%08x.bin", GL_PROGRAM_CACHE_PATH_LEN - 22, p_cache->_s_directory, (unsigned int)(hash >> 32), (unsigned int)hash);
+}
+
+int gl_program_cache_load_binary(const struct gl_program_cache* p_cache, uint64_t hash, struct gl_program* p_program) {
+    char s_path[GL_PROGRAM_CACHE_PATH_LEN];
+    gl_program_cache_make_path(p_cache, hash, s_path);
+
+    FILE* p_file = fopen(s_path, "rb");
+
+    if (!p_file) {
+        return 0;
+    }
+
+    struct gl_program_cache_file_header header;
+
+    if (fread(&header, sizeof(header), 1, p_file) != 1 || header.magic != GL_PROGRAM_CACHE_MAGIC || header.version != GL_PROGRAM_CACHE_VERSION) {
+        fclose(p_file);
+        return 0;
+    }
+
+    // The length is only trusted as far as the file goes, as a truncated or corrupt file is just a cache miss
+    const long binary_start = ftell(p_file);
+    const int b_has_length = binary_start >= 0 && fseek(p_file, 0, SEEK_END) == 0 && header.binary_length > 0 && ftell(p_file) - binary_start == (long)header.binary_length && fseek(p_file, binary_start, SEEK_SET) == 0;
+    void* p_binary = b_has_length ? malloc(header.binary_length) : NULL;
+
+    if (!p_binary) {
+        cx_log_fmt(CX_LOG_DEBUG, LOG_CAT_GL_PROGRAM_CACHE, "Ignoring program binary '%s', which is truncated or couldn't be allocated\n", s_path);
+        fclose(p_file);
+        return 0;
+    }
+
+    const int b_read = fread(p_binary, header.binary_length, 1, p_file) == 1;
+    fclose(p_file);
+
+    if (b_read) {
+        glProgramBinary(p_program->gl_handle, header.binary_format, p_binary, (GLsizei)header.binary_length);
+    }
+
+    free(p_binary);
+
+    if (b_read && gl_program_link_end(p_program) == ERROR_OK) {
+        return 1;
+    }
+
+    cx_log_fmt(CX_LOG_DEBUG, LOG_CAT_GL_PROGRAM_CACHE, "Discarding program binary '%s' the driver didn't accept\n", s_path);
+
+    // Start again from a program untouched by the failed load
+    gl_program_destroy(p_program);
+    gl_program_create(p_program);
+
+    return 0;
+}
+
+void gl_program_cache_save_binary(const struct gl_program_cache* p_cache, uint64_t hash, const struct gl_program* p_program) {
+    GLint binary_length = 0;
+    glGetProgramiv(p_program->gl_handle, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+
+    if (binary_length <= 0) {
+        return;
+    }
+
+    void* p_binary = malloc(binary_length);
+    GLsizei written = 0;
+    GLenum binary_format = 0;
+    glGetProgramBinary(p_program->gl_handle, binary_length, &written, &binary_format, p_binary);
+
+    char s_path[GL_PROGRAM_CACHE_PATH_LEN];
+    gl_program_cache_make_path(p_cache, hash, s_path);
+
+    FILE* p_file = fopen(s_path, "wb");
+
+    if (p_file) {
+        const struct gl_program_cache_file_header header = {
+            .magic = GL_PROGRAM_CACHE_MAGIC,
+            .version = GL_PROGRAM_CACHE_VERSION,
+            .binary_format = binary_format,
+            .binary_length = (uint32_t)written
+        };
+
+        fwrite(&header, sizeof(header), 1, p_file);
+        fwrite(p_binary, written, 1, p_file);
+        fclose(p_file);
+    } else {
+        cx_log_fmt(CX_LOG_WARNING, LOG_CAT_GL_PROGRAM_CACHE, "Failed to write program binary '%s'\n", s_path);
+    }
+
+    free(p_binary);
+}
+
+GLuint gl_program_cache_compile_shader(GLenum gl_shader_type, const char* s_source, const char* s_defines) {
+    const GLuint gl_shader = glCreateShader(gl_shader_type);
+
+    const char* s_strings[5];
+    GLint lengths[5] = { -1, -1, -1, -1, -1 };
+    GLsizei num_strings = 0;
+
+    if (s_defines && strncmp(s_source, "#version", 8) == 0) {
+        // Nothing but comments may come before #version, so the defines go right after it
+        const char* s_newline = strchr(s_source, '\n');
+        const char* s_body = s_newline ? s_newline + 1 : s_source + strlen(s_source);
+
+        s_strings[num_strings] = s_source;
+        lengths[num_strings++] = (GLint)(s_body - s_source);
+        s_strings[num_strings++] = "\n";
+        s_strings[num_strings++] = s_defines;
+        s_strings[num_strings++] = "\n";
+        s_strings[num_strings++] = s_body;
+    } else if (s_defines) {
+        s_strings[num_strings++] = s_defines;
+        s_strings[num_strings++] = "\n";
+        s_strings[num_strings++] = s_source;
+    } else {
+        s_strings[num_strings++] = s_source;
+    }
+
+    // Whether it compiled is left to gl_program_cache_finish, so the driver can get on with it in the meantime
+    glShaderSource(gl_shader, num_strings, s_strings, lengths);
+    glCompileShader(gl_shader);
+
+    return gl_shader;
+}
+
+void gl_program_cache_log_errors(const struct gl_program_cache_pending* p_pending) {
+    char s_log[1024];
+
+    for (size_t i = 0; i < p_pending->num_shaders; ++i) {
+        GLint b_is_compiled;
+        glGetShaderiv(p_pending->gl_shaders[i], GL_COMPILE_STATUS, &b_is_compiled);
+
+        if (!b_is_compiled) {
+            glGetShaderInfoLog(p_pending->gl_shaders[i], sizeof(s_log), NULL, s_log);
+            cx_log_fmt(CX_LOG_ERROR, LOG_CAT_GL_PROGRAM_CACHE, "Shader compilation failed: %s\n", s_log);
+        }
+    }
+
+    glGetProgramInfoLog(p_pending->p_program->gl_handle, sizeof(s_log), NULL, s_log);
+    cx_log_fmt(CX_LOG_ERROR, LOG_CAT_GL_PROGRAM_CACHE, "Program linkage failed: %s\n", s_log);
+}
@@ -0,0 +1,39 @@
+#ifndef _H__GL_PROGRAM_CACHE
+#define _H__GL_PROGRAM_CACHE
+
+#include <stdint.h>
+
+#include "darr.h"
+#include "errors.h"
+#include "gl.h"
+#include "gl_program.h"
+
+#define GL_PROGRAM_CACHE_MAX_SHADERS 4
+#define GL_PROGRAM_CACHE_PATH_LEN    260
+
+struct gl_program_source {
+    GLenum      gl_shader_type;
+    const char* s_source;
+};
+
+/* Builds programs from shader sources, keyed by a hash of the sources and defines. Where the driver supports program
+ * binaries, linked programs are saved to the cache directory and later loaded from there rather than compiled. A
+ * binary the driver no longer accepts, such as after a driver update, is compiled again and replaced. */
+struct gl_program_cache {
+    char        _s_directory[GL_PROGRAM_CACHE_PATH_LEN];
+    int         _b_binaries_supported;
+    struct darr _pending; // struct gl_program_cache_pending, compiled programs gl_program_cache_finish hasn't checked
+};
+
+void gl_program_cache_init(struct gl_program_cache* p_cache, const char* s_directory); // 0 to never touch the disk
+void gl_program_cache_destroy(struct gl_program_cache* p_cache);
+
+/* Creates p_program from the sources, with s_defines (or 0) inserted after each source's #version line. A program
+ * found in the cache is ready on return. One that has to be compiled is only started, so several can compile at
+ * once, and can't be used, or moved, until gl_program_cache_finish. */
+enum error gl_program_cache_load(struct gl_program_cache* p_cache, const struct gl_program_source* p_sources, size_t num_sources, const char* s_defines, struct gl_program* p_program);
+
+// Waits for every started program, saving binaries of the ones that linked. Returns the first failure, if any.
+enum error gl_program_cache_finish(struct gl_program_cache* p_cache);
+
+#endif
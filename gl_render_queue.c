@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "gl.h"
+#include "gl_mesh.h"
+#include "gl_render_queue.h"
+#include "render_queue.h"
+
+#define GL_RENDER_QUEUE_MATERIAL_SIZE (sizeof(GLfloat) * 4)
+#define GL_RENDER_QUEUE_DRAW_SIZE     (sizeof(GLfloat) * 16)
+
+static void   gl_render_queue_upload_instances(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue);
+static void   gl_render_queue_upload_uniforms(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue);
+static void*  gl_render_queue_push_uniforms(struct gl_render_queue* p_gl_queue, size_t size);
+static size_t gl_render_queue_uniforms_stride(size_t size);
+
+void gl_render_queue_create(struct gl_render_queue* p_gl_queue) {
+    *p_gl_queue = (struct gl_render_queue){0};
+    glGenBuffers(1, &p_gl_queue->_gl_instance_buffer);
+    gl_uniform_buffer_create(&p_gl_queue->_uniform_ring);
+    darr_init(&p_gl_queue->_uniform_bytes, sizeof(uint8_t));
+}
+
+void gl_render_queue_destroy(struct gl_render_queue* p_gl_queue) {
+    glDeleteBuffers(1, &p_gl_queue->_gl_instance_buffer);
+    gl_uniform_buffer_destroy(&p_gl_queue->_uniform_ring);
+    darr_free(&p_gl_queue->_uniform_bytes);
+    *p_gl_queue = (struct gl_render_queue){0};
+}
+
+void gl_render_queue_execute(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue) {
+    const struct render_command* p_commands = p_queue->commands._p_buffer;
+
+    const size_t material_stride = gl_render_queue_uniforms_stride(GL_RENDER_QUEUE_MATERIAL_SIZE);
+    const size_t draw_stride = gl_render_queue_uniforms_stride(GL_RENDER_QUEUE_DRAW_SIZE);
+
+    // Walks the commands in the same order gl_render_queue_upload_uniforms laid out their ranges
+    size_t uniforms_offset = 0;
+
+    gl_render_queue_upload_instances(p_gl_queue, p_queue);
+    gl_render_queue_upload_uniforms(p_gl_queue, p_queue);
+
+    for (size_t i = 0; i < p_queue->commands._length; ++i) {
+        const struct render_command* p_command = &p_commands[i];
+
+        switch (p_command->type) {
+            case RENDER_COMMAND_TYPE_program: {
+                glUseProgram(p_command->as_program);
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_texture: {
+                glBindTexture(GL_TEXTURE_2D, p_command->as_texture);
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_color: {
+                gl_uniform_buffer_bind_range(&p_gl_queue->_uniform_ring, GL_PROGRAM_BLOCK_material, uniforms_offset, GL_RENDER_QUEUE_MATERIAL_SIZE);
+                uniforms_offset += material_stride;
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_draw: {
+                gl_uniform_buffer_bind_range(&p_gl_queue->_uniform_ring, GL_PROGRAM_BLOCK_draw, uniforms_offset, GL_RENDER_QUEUE_DRAW_SIZE);
+                uniforms_offset += draw_stride;
+                gl_mesh_draw(p_command->as_draw.p_mesh);
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_draw_instanced: {
+                gl_mesh_draw_instanced(
+                    p_command->as_draw_instanced.p_mesh,
+                    p_gl_queue->_gl_instance_buffer,
+                    p_command->as_draw_instanced.first_instance * p_queue->instance_matrices._element_size,
+                    (GLsizei)p_command->as_draw_instanced.num_instances);
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_draw_multi: {
+                const void** pp_meshes = darr_get(&p_queue->multi_draw_meshes, p_command->as_draw_multi.first_mesh);
+                gl_uniform_buffer_bind_range(&p_gl_queue->_uniform_ring, GL_PROGRAM_BLOCK_draw, uniforms_offset, GL_RENDER_QUEUE_DRAW_SIZE);
+                uniforms_offset += draw_stride;
+                gl_mesh_multi_draw((const struct gl_mesh* const*)pp_meshes, p_command->as_draw_multi.num_meshes);
+                break;
+            }
+        }
+    }
+}
+
+void gl_render_queue_upload_instances(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue) {
+    const GLsizeiptr size = (GLsizeiptr)(p_queue->instance_matrices._length * p_queue->instance_matrices._element_size);
+
+    if (size == 0) {
+        return;
+    }
+
+    if (size > p_gl_queue->_instance_buffer_size) {
+        p_gl_queue->_instance_buffer_size = size > p_gl_queue->_instance_buffer_size * 2 ? size : p_gl_queue->_instance_buffer_size * 2;
+    }
+
+    // Orphaning the old storage lets the driver hand out fresh memory instead of waiting for last frame's draws to finish reading it
+    glBindBuffer(GL_ARRAY_BUFFER, p_gl_queue->_gl_instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, p_gl_queue->_instance_buffer_size, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, p_queue->instance_matrices._p_buffer);
+}
+
+void gl_render_queue_upload_uniforms(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue) {
+    const struct render_command* p_commands = p_queue->commands._p_buffer;
+
+    p_gl_queue->_uniform_bytes._length = 0;
+
+    for (size_t i = 0; i < p_queue->commands._length; ++i) {
+        const struct render_command* p_command = &p_commands[i];
+
+        switch (p_command->type) {
+            case RENDER_COMMAND_TYPE_color: {
+                GLfloat* p_color = gl_render_queue_push_uniforms(p_gl_queue, GL_RENDER_QUEUE_MATERIAL_SIZE);
+                memcpy(p_color, p_command->as_color, sizeof(p_command->as_color));
+                p_color[3] = 1;
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_draw: {
+                memcpy(gl_render_queue_push_uniforms(p_gl_queue, GL_RENDER_QUEUE_DRAW_SIZE), p_command->as_draw.p_model_matrix, GL_RENDER_QUEUE_DRAW_SIZE);
+                break;
+            }
+
+            case RENDER_COMMAND_TYPE_draw_multi: {
+                memcpy(gl_render_queue_push_uniforms(p_gl_queue, GL_RENDER_QUEUE_DRAW_SIZE), p_command->as_draw_multi.p_model_matrix, GL_RENDER_QUEUE_DRAW_SIZE);
+                break;
+            }
+
+            default: break;
+        }
+    }
+
+    gl_uniform_buffer_update(&p_gl_queue->_uniform_ring, p_gl_queue->_uniform_bytes._p_buffer, p_gl_queue->_uniform_bytes._length);
+}
+
+void* gl_render_queue_push_uniforms(struct gl_render_queue* p_gl_queue, size_t size) {
+    const size_t offset = p_gl_queue->_uniform_bytes._length;
+    darr_set_length(&p_gl_queue->_uniform_bytes, offset + gl_render_queue_uniforms_stride(size));
+    return darr_get(&p_gl_queue->_uniform_bytes, offset);
+}
+
+size_t gl_render_queue_uniforms_stride(size_t size) {
+    // Ranges have to start on the alignment, so each takes up a whole number of alignments
+    const size_t alignment = gl_uniform_buffer_offset_alignment();
+    return (size + alignment - 1) / alignment * alignment;
+}
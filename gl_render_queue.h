@@ -0,0 +1,27 @@
+#ifndef _H__GL_RENDER_QUEUE
+#define _H__GL_RENDER_QUEUE
+
+#include "darr.h"
+#include "gl.h"
+#include "gl_uniform_buffer.h"
+
+struct render_queue;
+
+// Holds the GL objects needed to run render queues, reused from frame to frame
+struct gl_render_queue {
+    GLuint                   _gl_instance_buffer;
+    GLsizeiptr               _instance_buffer_size;
+    struct gl_uniform_buffer _uniform_ring;  // a Material range per color command and a Draw range per draw
+    struct darr              _uniform_bytes; // uint8_t, staging for _uniform_ring
+};
+
+void gl_render_queue_create(struct gl_render_queue* p_gl_queue);
+void gl_render_queue_destroy(struct gl_render_queue* p_gl_queue);
+
+/* Runs a render queue's commands. Handles are GL names, meshes are struct gl_mesh, and each program takes its color
+ * through the "Material" block and its model matrix through the "Draw" block, or for instanced programs the mat4
+ * attribute at GL_MESH_INSTANCE_MATRIX_LOCATION. All of a frame's block contents are uploaded in one go, leaving one
+ * range bind per change. */
+void gl_render_queue_execute(struct gl_render_queue* p_gl_queue, const struct render_queue* p_queue);
+
+#endif
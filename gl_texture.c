@@ -1,17 +1,161 @@
+#include "cooked_texture.h"
 #include "gl_texture.h"
 #include "image.h"
 #include "texture_sampler.h"
 
-static GLint texture_filter_min_to_glenum(enum texture_filter_min filter_min);
-static GLint texture_filter_mag_to_glenum(enum texture_filter_mag filter_mag);
+static GLenum gl_texture_pixel_format(unsigned int num_channels);
+static GLenum gl_texture_cooked_internal_format(uint32_t format);
+static void   gl_texture_set_swizzle(unsigned int num_channels);
+static void   gl_texture_set_filters(const struct texture_sampler* p_sampler, int b_generate_mipmaps);
+static GLint  texture_filter_min_to_glenum(enum texture_filter_min filter_min);
+static GLint  texture_filter_mag_to_glenum(enum texture_filter_mag filter_mag);
 
 void gl_texture_create(struct gl_texture* p_gl_texture, const struct image* p_image, const struct texture_sampler* p_sampler) {
-    const GLenum gl_texture_target = GL_TEXTURE_2D;
+    gl_texture_create_storage(p_gl_texture, p_image);
+    gl_texture_upload_rows(p_gl_texture, p_image, 0, p_image->height, p_image->p_pixel_data);
+    gl_texture_finish(p_gl_texture, p_sampler, 1);
+}
+
+void gl_texture_destroy(struct gl_texture* p_gl_texture) {
+    glDeleteTextures(1, &p_gl_texture->gl_handle);
+    *p_gl_texture = (struct gl_texture){0};
+}
+
+void gl_texture_create_cooked(struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, const struct texture_sampler* p_sampler) {
+    gl_texture_create_cooked_storage(p_gl_texture, p_cooked_texture);
+
+    // Every level is already in the file's layout, so each one goes straight from the loaded data
+    for (uint32_t i = 0; i < p_cooked_texture->num_levels; ++i) {
+        const void* p_pixels = (const uint8_t*)p_cooked_texture->p_data + p_cooked_texture->levels[i].offset;
+        gl_texture_upload_cooked_rows(p_gl_texture, p_cooked_texture, i, 0, gl_texture_cooked_num_rows(p_cooked_texture, i), p_pixels);
+    }
+
+    gl_texture_finish(p_gl_texture, p_sampler, 0);
+}
+
+void gl_texture_create_storage(struct gl_texture* p_gl_texture, const struct image* p_image) {
+    *p_gl_texture = (struct gl_texture){0};
+
+    static const GLint gl_internal_formats[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
 
     glGenTextures(1, &p_gl_texture->gl_handle);
-    glBindTexture(gl_texture_target, p_gl_texture->gl_handle);
-    glTexImage2D(gl_texture_target, 0, GL_RGB, p_image->width, p_image->height, 0, GL_RGB, GL_UNSIGNED_BYTE, p_image->p_pixel_data);
+    glBindTexture(GL_TEXTURE_2D, p_gl_texture->gl_handle);
+    glTexImage2D(GL_TEXTURE_2D, 0, gl_internal_formats[p_image->num_channels - 1], p_image->width, p_image->height, 0, gl_texture_pixel_format(p_image->num_channels), GL_UNSIGNED_BYTE, NULL);
 
+    gl_texture_set_swizzle(p_image->num_channels);
+}
+
+size_t gl_texture_row_size(const struct image* p_image) {
+    return (size_t)p_image->width * p_image->num_channels;
+}
+
+void gl_texture_upload_rows(const struct gl_texture* p_gl_texture, const struct image* p_image, size_t first_row, size_t num_rows, const void* p_pixels) {
+    glBindTexture(GL_TEXTURE_2D, p_gl_texture->gl_handle);
+
+    // Rows are tightly packed, which for fewer than 4 channels isn't always the 4 byte alignment GL assumes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)first_row, p_image->width, (GLsizei)num_rows, gl_texture_pixel_format(p_image->num_channels), GL_UNSIGNED_BYTE, p_pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void gl_texture_create_cooked_storage(struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture) {
+    *p_gl_texture = (struct gl_texture){0};
+
+    const uint32_t num_channels = cooked_texture_num_channels(p_cooked_texture->format);
+    const GLenum gl_internal_format = gl_texture_cooked_internal_format(p_cooked_texture->format);
+
+    glGenTextures(1, &p_gl_texture->gl_handle);
+    glBindTexture(GL_TEXTURE_2D, p_gl_texture->gl_handle);
+
+    for (uint32_t i = 0; i < p_cooked_texture->num_levels; ++i) {
+        const struct cooked_texture_level* p_level = &p_cooked_texture->levels[i];
+
+        if (cooked_texture_is_compressed(p_cooked_texture->format)) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, gl_internal_format, (GLsizei)p_level->width, (GLsizei)p_level->height, 0, (GLsizei)p_level->size, NULL);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, (GLint)i, (GLint)gl_internal_format, (GLsizei)p_level->width, (GLsizei)p_level->height, 0, gl_texture_pixel_format(num_channels), GL_UNSIGNED_BYTE, NULL);
+        }
+    }
+
+    // Without this a texture cooked without mipmaps would be incomplete under a mipmapping filter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)p_cooked_texture->num_levels - 1);
+
+    gl_texture_set_swizzle(num_channels);
+}
+
+size_t gl_texture_cooked_num_rows(const struct cooked_texture* p_cooked_texture, uint32_t level) {
+    const uint32_t height = p_cooked_texture->levels[level].height;
+    return cooked_texture_is_compressed(p_cooked_texture->format) ? (height + 3) / 4 : height;
+}
+
+size_t gl_texture_cooked_row_size(const struct cooked_texture* p_cooked_texture, uint32_t level) {
+    // Levels are tightly packed, blocks or pixels alike
+    return p_cooked_texture->levels[level].size / gl_texture_cooked_num_rows(p_cooked_texture, level);
+}
+
+void gl_texture_upload_cooked_rows(const struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, uint32_t level, size_t first_row, size_t num_rows, const void* p_pixels) {
+    const struct cooked_texture_level* p_level = &p_cooked_texture->levels[level];
+
+    glBindTexture(GL_TEXTURE_2D, p_gl_texture->gl_handle);
+
+    if (cooked_texture_is_compressed(p_cooked_texture->format)) {
+        // The last row of blocks can run past the bottom of a level whose height isn't a multiple of 4
+        const size_t first_pixel_row = first_row * 4;
+        const size_t num_pixel_rows = first_pixel_row + num_rows * 4 <= p_level->height ? num_rows * 4 : p_level->height - first_pixel_row;
+        const GLsizei size = (GLsizei)(num_rows * gl_texture_cooked_row_size(p_cooked_texture, level));
+
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, (GLint)first_pixel_row, (GLsizei)p_level->width, (GLsizei)num_pixel_rows, gl_texture_cooked_internal_format(p_cooked_texture->format), size, p_pixels);
+    } else {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, (GLint)level, 0, (GLint)first_row, (GLsizei)p_level->width, (GLsizei)num_rows, gl_texture_pixel_format(cooked_texture_num_channels(p_cooked_texture->format)), GL_UNSIGNED_BYTE, p_pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+}
+
+void gl_texture_finish(struct gl_texture* p_gl_texture, const struct texture_sampler* p_sampler, int b_generate_mipmaps) {
+    glBindTexture(GL_TEXTURE_2D, p_gl_texture->gl_handle);
+    gl_texture_set_filters(p_sampler, b_generate_mipmaps);
+
+    p_gl_texture->b_is_ready = 1;
+}
+
+GLenum gl_texture_pixel_format(unsigned int num_channels) {
+    switch (num_channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 4: return GL_RGBA;
+    }
+    return GL_RGB;
+}
+
+GLenum gl_texture_cooked_internal_format(uint32_t format) {
+    static const GLenum gl_internal_formats[] = {
+        [COOKED_TEXTURE_FORMAT_r8]    = GL_R8,
+        [COOKED_TEXTURE_FORMAT_rg8]   = GL_RG8,
+        [COOKED_TEXTURE_FORMAT_rgb8]  = GL_RGB8,
+        [COOKED_TEXTURE_FORMAT_rgba8] = GL_RGBA8,
+        [COOKED_TEXTURE_FORMAT_bc1]   = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+        [COOKED_TEXTURE_FORMAT_bc3]   = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+        [COOKED_TEXTURE_FORMAT_bc4]   = GL_COMPRESSED_RED_RGTC1,
+        [COOKED_TEXTURE_FORMAT_bc5]   = GL_COMPRESSED_RG_RGTC2
+    };
+
+    return gl_internal_formats[format];
+}
+
+void gl_texture_set_swizzle(unsigned int num_channels) {
+    // Images with 1 or 2 channels are greyscale, and with alpha, rather than red and green
+    static const GLint gl_swizzles[2][4] = {
+        { GL_RED, GL_RED, GL_RED, GL_ONE },
+        { GL_RED, GL_RED, GL_RED, GL_GREEN }
+    };
+
+    if (num_channels == 1 || num_channels == 2) {
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, gl_swizzles[num_channels - 1]);
+    }
+}
+
+void gl_texture_set_filters(const struct texture_sampler* p_sampler, int b_generate_mipmaps) {
     GLint gl_filter_min = GL_LINEAR;
     GLint gl_filter_mag = GL_LINEAR;
     
@@ -19,17 +163,13 @@ void gl_texture_create(struct gl_texture* p_gl_texture, const struct image* p_im
         gl_filter_min = texture_filter_min_to_glenum(p_sampler->filter_min);
         gl_filter_mag = texture_filter_mag_to_glenum(p_sampler->filter_mag);
         
-        if (gl_filter_min != GL_NEAREST && gl_filter_min != GL_LINEAR) {
-            glGenerateMipmap(gl_texture_target);
+        if (b_generate_mipmaps && gl_filter_min != GL_NEAREST && gl_filter_min != GL_LINEAR) {
+            glGenerateMipmap(GL_TEXTURE_2D);
         }
     }
 
-    glTexParameteri(gl_texture_target, GL_TEXTURE_MIN_FILTER, gl_filter_min);
-    glTexParameteri(gl_texture_target, GL_TEXTURE_MAG_FILTER, gl_filter_mag);
-}
-
-void gl_texture_destroy(struct gl_texture* p_gl_texture) {
-    glDeleteTextures(1, &p_gl_texture->gl_handle);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, gl_filter_min);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, gl_filter_mag);
 }
 
 GLint texture_filter_min_to_glenum(enum texture_filter_min filter_min) {
@@ -1,16 +1,38 @@
 #ifndef _H__GL_TEXTURE
 #define _H__GL_TEXTURE
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "gl.h"
 
+struct cooked_texture;
 struct image;
 struct texture_sampler;
 
 struct gl_texture {
     GLuint gl_handle;
+    int    b_is_ready; // 0 while the texture's pixels are still being uploaded
 };
 
 void gl_texture_create(struct gl_texture* p_gl_texture, const struct image* p_image, const struct texture_sampler* p_sampler);
 void gl_texture_destroy(struct gl_texture* p_gl_texture);
 
-#endif
\ No newline at end of file
+// Uploads every level of a cooked texture as it is, compressed ones with glCompressedTexSubImage2D. Ready on return.
+void gl_texture_create_cooked(struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, const struct texture_sampler* p_sampler);
+
+/* gl_texture_create in pieces, for uploading a texture a few rows at a time. The texture's storage is allocated
+ * without pixels, rows are uploaded from p_pixels, which may be an offset into the bound pixel unpack buffer, and
+ * finishing generates mipmaps if asked and sets filters before marking the texture ready. */
+void   gl_texture_create_storage(struct gl_texture* p_gl_texture, const struct image* p_image);
+size_t gl_texture_row_size(const struct image* p_image);
+void   gl_texture_upload_rows(const struct gl_texture* p_gl_texture, const struct image* p_image, size_t first_row, size_t num_rows, const void* p_pixels);
+void   gl_texture_finish(struct gl_texture* p_gl_texture, const struct texture_sampler* p_sampler, int b_generate_mipmaps);
+
+// The same for a cooked texture, storage being allocated for every level. A compressed level's rows are of 4x4 blocks.
+void   gl_texture_create_cooked_storage(struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture);
+size_t gl_texture_cooked_num_rows(const struct cooked_texture* p_cooked_texture, uint32_t level);
+size_t gl_texture_cooked_row_size(const struct cooked_texture* p_cooked_texture, uint32_t level);
+void   gl_texture_upload_cooked_rows(const struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, uint32_t level, size_t first_row, size_t num_rows, const void* p_pixels);
+
+#endif
@@ -0,0 +1,269 @@
+#include <string.h>
+
+#include "cooked_texture.h"
+#include "gl_texture.h"
+#include "gl_texture_upload_queue.h"
+#include "image.h"
+#include "parallel.h"
+
+#define GL_TEXTURE_UPLOAD_QUEUE_ALIGNMENT 16
+
+struct gl_texture_upload {
+    struct gl_texture*            p_gl_texture;
+    const struct image*           p_image;          // either this,
+    const struct cooked_texture*  p_cooked_texture; // or this
+    const struct texture_sampler* p_sampler;
+    uint32_t                      num_levels;
+    uint32_t                      level;            // num_levels once every level is in
+    size_t                        next_row;         // of level
+};
+
+// Rows of one level of one upload that go into the current buffer, at offset
+struct gl_texture_upload_slice {
+    size_t   upload;
+    uint32_t level;
+    size_t   first_row;
+    size_t   num_rows;
+    size_t   offset;
+};
+
+struct gl_texture_upload_queue_copy_data {
+    const struct gl_texture_upload_queue* p_queue;
+    uint8_t*                              p_mapped;
+};
+
+static size_t         gl_texture_upload_num_rows(const struct gl_texture_upload* p_upload, uint32_t level);
+static size_t         gl_texture_upload_row_size(const struct gl_texture_upload* p_upload, uint32_t level);
+static const uint8_t* gl_texture_upload_pixels(const struct gl_texture_upload* p_upload, uint32_t level);
+static void           gl_texture_upload_queue_copy_slice(size_t index, void* p_user_data);
+
+void gl_texture_upload_queue_create(struct gl_texture_upload_queue* p_queue, size_t budget) {
+    *p_queue = (struct gl_texture_upload_queue) {
+        ._budget = budget ? budget : GL_TEXTURE_UPLOAD_QUEUE_DEFAULT_BUDGET
+    };
+
+    darr_init(&p_queue->_uploads, sizeof(struct gl_texture_upload));
+    darr_init(&p_queue->_slices, sizeof(struct gl_texture_upload_slice));
+
+    for (size_t i = 0; i < GL_TEXTURE_UPLOAD_QUEUE_NUM_BUFFERS; ++i) {
+        glGenBuffers(1, &p_queue->_buffers[i].gl_pbo);
+    }
+}
+
+void gl_texture_upload_queue_destroy(struct gl_texture_upload_queue* p_queue) {
+    for (size_t i = 0; i < GL_TEXTURE_UPLOAD_QUEUE_NUM_BUFFERS; ++i) {
+        if (p_queue->_buffers[i].gl_fence) {
+            glDeleteSync(p_queue->_buffers[i].gl_fence);
+        }
+
+        glDeleteBuffers(1, &p_queue->_buffers[i].gl_pbo);
+    }
+
+    darr_free(&p_queue->_uploads);
+    darr_free(&p_queue->_slices);
+}
+
+void gl_texture_upload_queue_push(struct gl_texture_upload_queue* p_queue, struct gl_texture* p_gl_texture, const struct image* p_image, const struct texture_sampler* p_sampler) {
+    gl_texture_create_storage(p_gl_texture, p_image);
+
+    struct gl_texture_upload* p_upload = darr_push(&p_queue->_uploads);
+    *p_upload = (struct gl_texture_upload) {
+        .p_gl_texture = p_gl_texture,
+        .p_image = p_image,
+        .p_sampler = p_sampler,
+        .num_levels = 1
+    };
+}
+
+void gl_texture_upload_queue_push_cooked(struct gl_texture_upload_queue* p_queue, struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, const struct texture_sampler* p_sampler) {
+    gl_texture_create_cooked_storage(p_gl_texture, p_cooked_texture);
+
+    struct gl_texture_upload* p_upload = darr_push(&p_queue->_uploads);
+    *p_upload = (struct gl_texture_upload) {
+        .p_gl_texture = p_gl_texture,
+        .p_cooked_texture = p_cooked_texture,
+        .p_sampler = p_sampler,
+        .num_levels = p_cooked_texture->num_levels
+    };
+}
+
+void gl_texture_upload_queue_cancel(struct gl_texture_upload_queue* p_queue, const struct gl_texture* p_gl_texture) {
+    struct gl_texture_upload* p_uploads = p_queue->_uploads._p_buffer;
+
+    for (size_t i = 0; i < p_queue->_uploads._length; ++i) {
+        if (p_uploads[i].p_gl_texture == p_gl_texture) {
+            // Shifted rather than swapped out, so textures keep loading in the order they were asked for
+            memmove(&p_uploads[i], &p_uploads[i + 1], sizeof(*p_uploads) * (p_queue->_uploads._length - i - 1));
+            --p_queue->_uploads._length;
+            return;
+        }
+    }
+}
+
+void gl_texture_upload_queue_update(struct gl_texture_upload_queue* p_queue) {
+    if (p_queue->_uploads._length == 0) {
+        return;
+    }
+
+    struct gl_texture_upload_queue_buffer* p_buffer = &p_queue->_buffers[p_queue->_next_buffer];
+
+    if (p_buffer->gl_fence) {
+        const GLenum gl_status = glClientWaitSync(p_buffer->gl_fence, 0, 0);
+
+        if (gl_status != GL_ALREADY_SIGNALED && gl_status != GL_CONDITION_SATISFIED) {
+            return;
+        }
+
+        glDeleteSync(p_buffer->gl_fence);
+        p_buffer->gl_fence = 0;
+    }
+
+    // Whole rows from the front of the queue until the budget runs out, though always at least one row
+    struct gl_texture_upload* p_uploads = p_queue->_uploads._p_buffer;
+    size_t size = 0;
+    int b_is_full = 0;
+
+    p_queue->_slices._length = 0;
+
+    for (size_t i = 0; i < p_queue->_uploads._length && !b_is_full; ++i) {
+        uint32_t level = p_uploads[i].level;
+        size_t next_row = p_uploads[i].next_row;
+
+        // A level at a time, so the small ones at the end of a mip chain share an update
+        while (level < p_uploads[i].num_levels) {
+            if (size >= p_queue->_budget) {
+                b_is_full = 1;
+                break;
+            }
+
+            const size_t row_size = gl_texture_upload_row_size(&p_uploads[i], level);
+            const size_t rows_left = gl_texture_upload_num_rows(&p_uploads[i], level) - next_row;
+            const size_t rows_in_budget = row_size ? (p_queue->_budget - size) / row_size : rows_left;
+
+            if (rows_in_budget == 0 && size > 0) {
+                b_is_full = 1;
+                break;
+            }
+
+            const size_t num_rows = rows_left <= rows_in_budget ? rows_left : (rows_in_budget ? rows_in_budget : 1);
+
+            struct gl_texture_upload_slice* p_slice = darr_push(&p_queue->_slices);
+            *p_slice = (struct gl_texture_upload_slice) {
+                .upload = i,
+                .level = level,
+                .first_row = next_row,
+                .num_rows = num_rows,
+                .offset = size
+            };
+
+            size += (num_rows * row_size + GL_TEXTURE_UPLOAD_QUEUE_ALIGNMENT - 1) & ~(size_t)(GL_TEXTURE_UPLOAD_QUEUE_ALIGNMENT - 1);
+
+            next_row += num_rows;
+
+            if (next_row == gl_texture_upload_num_rows(&p_uploads[i], level)) {
+                ++level;
+                next_row = 0;
+            }
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p_buffer->gl_pbo);
+
+    if ((GLsizeiptr)size > p_buffer->size) {
+        p_buffer->size = (GLsizeiptr)(size > p_queue->_budget ? size : p_queue->_budget);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, p_buffer->size, NULL, GL_STREAM_DRAW);
+    }
+
+    if (size) {
+        /* GL 3.3 has no persistent mapping, but the fence already says the GPU is done with this buffer, so it can be
+         * mapped unsynchronized for the same effect: no waiting in the driver and no new allocation. */
+        uint8_t* p_mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+        if (!p_mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+
+        struct gl_texture_upload_queue_copy_data copy_data = {
+            .p_queue = p_queue,
+            .p_mapped = p_mapped
+        };
+
+        parallel_for(p_queue->_slices._length, gl_texture_upload_queue_copy_slice, &copy_data);
+
+        // The buffer's contents can be lost while it's mapped, in which case every slice is simply tried again next time
+        if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+    }
+
+    const struct gl_texture_upload_slice* p_slices = p_queue->_slices._p_buffer;
+
+    for (size_t i = 0; i < p_queue->_slices._length; ++i) {
+        struct gl_texture_upload* p_upload = &p_uploads[p_slices[i].upload];
+        const void* p_offset = (const void*)(uintptr_t)p_slices[i].offset;
+
+        if (p_upload->p_cooked_texture) {
+            gl_texture_upload_cooked_rows(p_upload->p_gl_texture, p_upload->p_cooked_texture, p_slices[i].level, p_slices[i].first_row, p_slices[i].num_rows, p_offset);
+        } else {
+            gl_texture_upload_rows(p_upload->p_gl_texture, p_upload->p_image, p_slices[i].first_row, p_slices[i].num_rows, p_offset);
+        }
+
+        p_upload->level = p_slices[i].level;
+        p_upload->next_row = p_slices[i].first_row + p_slices[i].num_rows;
+
+        if (p_upload->next_row == gl_texture_upload_num_rows(p_upload, p_upload->level)) {
+            ++p_upload->level;
+            p_upload->next_row = 0;
+        }
+
+        // Cooked textures come with their mipmaps
+        if (p_upload->level == p_upload->num_levels) {
+            gl_texture_finish(p_upload->p_gl_texture, p_upload->p_sampler, !p_upload->p_cooked_texture);
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    p_buffer->gl_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    p_queue->_next_buffer = (p_queue->_next_buffer + 1) % GL_TEXTURE_UPLOAD_QUEUE_NUM_BUFFERS;
+
+    // A narrow texture can fit in what a wide one left of the budget and finish first, so the queue is compacted
+    size_t num_uploads = 0;
+
+    for (size_t i = 0; i < p_queue->_uploads._length; ++i) {
+        if (p_uploads[i].level != p_uploads[i].num_levels) {
+            p_uploads[num_uploads++] = p_uploads[i];
+        }
+    }
+
+    p_queue->_uploads._length = num_uploads;
+}
+
+void gl_texture_upload_queue_copy_slice(size_t index, void* p_user_data) {
+    const struct gl_texture_upload_queue_copy_data* p_data = p_user_data;
+    const struct gl_texture_upload_slice* p_slice = darr_get(&p_data->p_queue->_slices, index);
+    const struct gl_texture_upload* p_upload = darr_get(&p_data->p_queue->_uploads, p_slice->upload);
+
+    const size_t row_size = gl_texture_upload_row_size(p_upload, p_slice->level);
+    const uint8_t* p_pixels = gl_texture_upload_pixels(p_upload, p_slice->level);
+
+    memcpy(&p_data->p_mapped[p_slice->offset], &p_pixels[p_slice->first_row * row_size], p_slice->num_rows * row_size);
+}
+
+size_t gl_texture_upload_num_rows(const struct gl_texture_upload* p_upload, uint32_t level) {
+    return p_upload->p_cooked_texture ? gl_texture_cooked_num_rows(p_upload->p_cooked_texture, level) : p_upload->p_image->height;
+}
+
+size_t gl_texture_upload_row_size(const struct gl_texture_upload* p_upload, uint32_t level) {
+    return p_upload->p_cooked_texture ? gl_texture_cooked_row_size(p_upload->p_cooked_texture, level) : gl_texture_row_size(p_upload->p_image);
+}
+
+const uint8_t* gl_texture_upload_pixels(const struct gl_texture_upload* p_upload, uint32_t level) {
+    if (p_upload->p_cooked_texture) {
+        return (const uint8_t*)p_upload->p_cooked_texture->p_data + p_upload->p_cooked_texture->levels[level].offset;
+    }
+
+    return p_upload->p_image->p_pixel_data;
+}
@@ -0,0 +1,49 @@
+#ifndef _H__GL_TEXTURE_UPLOAD_QUEUE
+#define _H__GL_TEXTURE_UPLOAD_QUEUE
+
+#include <stddef.h>
+
+#include "darr.h"
+#include "gl.h"
+
+#define GL_TEXTURE_UPLOAD_QUEUE_NUM_BUFFERS    3
+#define GL_TEXTURE_UPLOAD_QUEUE_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+struct cooked_texture;
+struct gl_texture;
+struct image;
+struct texture_sampler;
+
+struct gl_texture_upload_queue_buffer {
+    GLuint     gl_pbo;
+    GLsizeiptr size;
+    GLsync     gl_fence; // 0 unless uploads from gl_pbo may still be in flight
+};
+
+/* Uploads textures a slice of rows at a time, no more than a budget of bytes per update, so that textures first seen
+ * mid-level load over several frames instead of stalling one. Rows are copied on the parallel workers into one of a
+ * ring of pixel unpack buffers, whose transfers to the textures the driver can then carry out without the CPU
+ * waiting. Cooked textures go a level at a time, largest first, compressed levels a row of blocks at a time. Until
+ * gl_texture.b_is_ready, which is once the last level is in, a texture has no pixels, and something else should be
+ * bound in its place. */
+struct gl_texture_upload_queue {
+    struct gl_texture_upload_queue_buffer _buffers[GL_TEXTURE_UPLOAD_QUEUE_NUM_BUFFERS];
+    size_t                                _next_buffer;
+    size_t                                _budget;
+    struct darr                           _uploads; // struct gl_texture_upload, in the order they were pushed
+    struct darr                           _slices;  // struct gl_texture_upload_slice, of the current update
+};
+
+void gl_texture_upload_queue_create(struct gl_texture_upload_queue* p_queue, size_t budget); // bytes per update, 0 for the default
+void gl_texture_upload_queue_destroy(struct gl_texture_upload_queue* p_queue);
+
+/* Creates p_gl_texture's storage and queues its pixels. The image and sampler must outlive the upload, and a texture
+ * destroyed before it's ready must be cancelled first. */
+void gl_texture_upload_queue_push(struct gl_texture_upload_queue* p_queue, struct gl_texture* p_gl_texture, const struct image* p_image, const struct texture_sampler* p_sampler);
+void gl_texture_upload_queue_push_cooked(struct gl_texture_upload_queue* p_queue, struct gl_texture* p_gl_texture, const struct cooked_texture* p_cooked_texture, const struct texture_sampler* p_sampler);
+void gl_texture_upload_queue_cancel(struct gl_texture_upload_queue* p_queue, const struct gl_texture* p_gl_texture);
+
+// Issues the next budget's worth of rows, once per frame. Skips a frame rather than wait for the GPU to free a buffer.
+void gl_texture_upload_queue_update(struct gl_texture_upload_queue* p_queue);
+
+#endif
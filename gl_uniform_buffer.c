@@ -0,0 +1,44 @@
+#include "gl_uniform_buffer.h"
+
+void gl_uniform_buffer_create(struct gl_uniform_buffer* p_gl_uniform_buffer) {
+    *p_gl_uniform_buffer = (struct gl_uniform_buffer){0};
+    glGenBuffers(1, &p_gl_uniform_buffer->gl_handle);
+}
+
+void gl_uniform_buffer_destroy(struct gl_uniform_buffer* p_gl_uniform_buffer) {
+    glDeleteBuffers(1, &p_gl_uniform_buffer->gl_handle);
+    *p_gl_uniform_buffer = (struct gl_uniform_buffer){0};
+}
+
+void gl_uniform_buffer_update(struct gl_uniform_buffer* p_gl_uniform_buffer, const void* p_data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    if ((GLsizeiptr)size > p_gl_uniform_buffer->_size) {
+        p_gl_uniform_buffer->_size = (GLsizeiptr)size > p_gl_uniform_buffer->_size * 2 ? (GLsizeiptr)size : p_gl_uniform_buffer->_size * 2;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, p_gl_uniform_buffer->gl_handle);
+    glBufferData(GL_UNIFORM_BUFFER, p_gl_uniform_buffer->_size, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)size, p_data);
+}
+
+void gl_uniform_buffer_bind(const struct gl_uniform_buffer* p_gl_uniform_buffer, enum gl_program_block block) {
+    glBindBufferBase(GL_UNIFORM_BUFFER, (GLuint)block, p_gl_uniform_buffer->gl_handle);
+}
+
+void gl_uniform_buffer_bind_range(const struct gl_uniform_buffer* p_gl_uniform_buffer, enum gl_program_block block, size_t offset, size_t size) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, (GLuint)block, p_gl_uniform_buffer->gl_handle, (GLintptr)offset, (GLsizeiptr)size);
+}
+
+size_t gl_uniform_buffer_offset_alignment(void) {
+    static GLint alignment = 0;
+
+    if (alignment == 0) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = alignment > 0 ? alignment : 256;
+    }
+
+    return (size_t)alignment;
+}
@@ -0,0 +1,31 @@
+#ifndef _H__GL_UNIFORM_BUFFER
+#define _H__GL_UNIFORM_BUFFER
+
+#include "gl.h"
+#include "gl_program.h"
+
+// The "Frame" block, laid out to match std140
+struct gl_frame_uniforms {
+    float projection_matrix[16];
+    float view_matrix[16];
+    float camera_position[4];
+};
+
+struct gl_uniform_buffer {
+    GLuint     gl_handle;
+    GLsizeiptr _size;
+};
+
+void gl_uniform_buffer_create(struct gl_uniform_buffer* p_gl_uniform_buffer);
+void gl_uniform_buffer_destroy(struct gl_uniform_buffer* p_gl_uniform_buffer);
+
+// Replaces the contents, orphaning the old storage so draws still reading it don't stall the upload
+void gl_uniform_buffer_update(struct gl_uniform_buffer* p_gl_uniform_buffer, const void* p_data, size_t size);
+
+void gl_uniform_buffer_bind(const struct gl_uniform_buffer* p_gl_uniform_buffer, enum gl_program_block block);
+void gl_uniform_buffer_bind_range(const struct gl_uniform_buffer* p_gl_uniform_buffer, enum gl_program_block block, size_t offset, size_t size);
+
+// What bound range offsets must be multiples of
+size_t gl_uniform_buffer_offset_alignment(void);
+
+#endif
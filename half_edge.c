@@ -1,87 +1,239 @@
+#include <string.h>
+
 #include "darr.h"
 #include "half_edge.h"
+#include "logging.h"
+#include "serialization.h"
 #include "stdlib.h"
 #include "vector.h"
 
-static int vec3_sort_cmp(const float* p_a, const float* p_b) {
-	if (p_a[0] < p_b[0]) {
-		return -1;
-	}
+struct he_pointer_index {
+    const void* p;
+    uint32_t    index;
+};
 
-	if (p_b[0] < p_a[0]) {
-		return 1;
-	}
+static int      he_pointer_index_cmp(const void* p_a, const void* p_b);
+static uint32_t he_pointer_index_find(const struct darr* p_sorted, const void* p);
 
-	if (p_a[1] < p_b[1]) {
-		return -1;
-	}
+int he_pointer_index_cmp(const void* p_a, const void* p_b) {
+    const uintptr_t a = (uintptr_t)((const struct he_pointer_index*)p_a)->p;
+    const uintptr_t b = (uintptr_t)((const struct he_pointer_index*)p_b)->p;
+    return (a > b) - (a < b);
+}
 
-	if (p_b[1] < p_a[1]) {
-		return 1;
-	}
+uint32_t he_pointer_index_find(const struct darr* p_sorted, const void* p) {
+    const struct he_pointer_index key = { .p = p };
+    const struct he_pointer_index* p_found = bsearch(&key, p_sorted->_p_buffer, p_sorted->_length, p_sorted->_element_size, he_pointer_index_cmp);
+    return p_found ? p_found->index : HE_INVALID_INDEX;
+}
 
-	if (p_a[2] < p_b[2]) {
-		return -1;
-	}
+void half_edge_free(struct he_mesh* p_mesh) {
+    void* p_block = p_mesh->p_buffer;
+    while (p_block) {
+        void* p_next = *(void**)p_block;
+        free(p_block);
+        p_block = p_next;
+    }
+    *p_mesh = (struct he_mesh){0};
+}
 
-	if (p_b[2] < p_a[2]) {
-		return 1;
-	}
+void half_edge_compact(const struct he_mesh* p_mesh, struct he_compact_mesh* p_result) {
+    // Gather edges in face order and give every distinct vertex and edge pointer an index
 
-	return 0;
-}
+    struct darr edges;
+    struct darr edge_indices;
+    struct darr vertex_indices;
+    darr_init(&edges, sizeof(struct he_edge*));
+    darr_init(&edge_indices, sizeof(struct he_pointer_index));
+    darr_init(&vertex_indices, sizeof(struct he_pointer_index));
 
-void half_edge_get_vertices(const struct he_mesh* p_mesh, float* p_vertices, size_t* p_num_vertices) {
-    struct darr vertices;
-    darr_init(&vertices, sizeof(float) * 3);
+    uint32_t num_faces = 0;
 
     struct he_face* p_face = p_mesh->p_faces;
     while (p_face) {
         struct he_edge* p_edge = p_face->p_edges;
         do {
-            float* p_v = darr_push(&vertices);
-            vec3_set(p_edge->p_tail->position, p_v);
+            *(struct he_edge**)darr_push(&edges) = p_edge;
+            *(struct he_pointer_index*)darr_push(&edge_indices) = (struct he_pointer_index) {
+                .p = p_edge,
+                .index = (uint32_t)(edges._length - 1)
+            };
+            *(struct he_pointer_index*)darr_push(&vertex_indices) = (struct he_pointer_index) {
+                .p = p_edge->p_tail
+            };
             p_edge = p_edge->p_next;
         } while (p_edge != p_face->p_edges);
+        ++num_faces;
         p_face = p_face->p_next;
     }
 
-    if (vertices._length == 0) {
-        *p_num_vertices = 0;
-        return;
+    qsort(edge_indices._p_buffer, edge_indices._length, edge_indices._element_size, he_pointer_index_cmp);
+    qsort(vertex_indices._p_buffer, vertex_indices._length, vertex_indices._element_size, he_pointer_index_cmp);
+
+    uint32_t num_vertices = 0;
+    for (size_t i = 0; i < vertex_indices._length; ++i) {
+        struct he_pointer_index* p_a = darr_get(&vertex_indices, i);
+        if (num_vertices && ((struct he_pointer_index*)darr_get(&vertex_indices, num_vertices - 1))->p == p_a->p) {
+            continue;
+        }
+        struct he_pointer_index* p_b = darr_get(&vertex_indices, num_vertices);
+        p_b->p = p_a->p;
+        p_b->index = num_vertices;
+        ++num_vertices;
+    }
+    darr_set_length(&vertex_indices, num_vertices);
+
+    half_edge_compact_init(p_result, num_vertices, (uint32_t)edges._length, num_faces);
+
+    for (uint32_t i = 0; i < num_vertices; ++i) {
+        const struct he_vertex* p_vertex = ((struct he_pointer_index*)darr_get(&vertex_indices, i))->p;
+        vec3_set(p_vertex->position, &p_result->p_positions[i * 3]);
     }
 
-    qsort(vertices._p_buffer, vertices._length, vertices._element_size, (void*)vec3_sort_cmp);
+    uint32_t f = 0;
+    uint32_t e = 0;
 
-    size_t m = 1;
+    p_face = p_mesh->p_faces;
+    while (p_face) {
+        p_result->p_face_edges[f] = e;
 
-    if (p_vertices) {
-        vec3_set(darr_get(&vertices, 0), &p_vertices[0]);
-        for (size_t i = 1; i < vertices._length; ++i) {
-            float* p_a = darr_get(&vertices, i);
-            float* p_b = darr_get(&vertices, m - 1);
-            if (!vec3_cmp(p_a, p_b)) {
-                if (i != m) {
-                    vec3_set(p_a, darr_get(&vertices, m));
-                    vec3_set(p_a, &p_vertices[m * 3]);
-                }
-                ++m;
-            }
-        }
-    } else {
-        for (size_t i = 1; i < vertices._length; ++i) {
-            const float* p_a = darr_get(&vertices, i);
-            const float* p_b = darr_get(&vertices, m - 1);
-            if (!vec3_cmp(p_a, p_b)) {
-                if (i != m) {
-                    vec3_set(p_a, darr_get(&vertices, m));
-                }
-                ++m;
-            }
-        }
+        const uint32_t first = e;
+        struct he_edge* p_edge = p_face->p_edges;
+        do {
+            p_result->p_edge_tails[e] = he_pointer_index_find(&vertex_indices, p_edge->p_tail);
+            p_result->p_edge_twins[e] = he_pointer_index_find(&edge_indices, p_edge->p_twin);
+            p_result->p_edge_faces[e] = f;
+            p_result->p_edge_nexts[e] = p_edge->p_next == p_face->p_edges ? first : e + 1;
+            ++e;
+            p_edge = p_edge->p_next;
+        } while (p_edge != p_face->p_edges);
+
+        ++f;
+        p_face = p_face->p_next;
+    }
+
+    darr_free(&edges);
+    darr_free(&edge_indices);
+    darr_free(&vertex_indices);
+}
+
+void half_edge_expand(const struct he_compact_mesh* p_mesh, struct he_mesh* p_result) {
+    // A single block laid out like one link of the node chain used by quickhull, so half_edge_free releases either form
+
+    const size_t size_vertices = sizeof(struct he_vertex) * p_mesh->num_vertices;
+    const size_t size_edges = sizeof(struct he_edge) * p_mesh->num_edges;
+    const size_t size_faces = sizeof(struct he_face) * p_mesh->num_faces;
+
+    *p_result = (struct he_mesh){0};
+
+    void** p_block = calloc(1, sizeof(void*) + size_vertices + size_edges + size_faces);
+    p_result->p_buffer = p_block;
+
+    struct he_vertex* p_vertices = (struct he_vertex*)(p_block + 1);
+    struct he_edge* p_edges = (struct he_edge*)((char*)p_vertices + size_vertices);
+    struct he_face* p_faces = (struct he_face*)((char*)p_edges + size_edges);
+
+    for (uint32_t i = 0; i < p_mesh->num_vertices; ++i) {
+        vec3_set(&p_mesh->p_positions[i * 3], p_vertices[i].position);
+    }
+
+    for (uint32_t i = 0; i < p_mesh->num_edges; ++i) {
+        struct he_edge* p_edge = &p_edges[i];
+        p_edge->p_next = &p_edges[p_mesh->p_edge_nexts[i]];
+        p_edge->p_next->p_prev = p_edge;
+        p_edge->p_twin = p_mesh->p_edge_twins[i] == HE_INVALID_INDEX ? 0 : &p_edges[p_mesh->p_edge_twins[i]];
+        p_edge->p_tail = &p_vertices[p_mesh->p_edge_tails[i]];
+        p_edge->p_face = &p_faces[p_mesh->p_edge_faces[i]];
+    }
+
+    for (uint32_t i = 0; i < p_mesh->num_faces; ++i) {
+        struct he_face* p_face = &p_faces[i];
+        p_face->p_edges = &p_edges[p_mesh->p_face_edges[i]];
+        p_face->p_prev = i > 0 ? &p_faces[i - 1] : 0;
+        p_face->p_next = i + 1 < p_mesh->num_faces ? &p_faces[i + 1] : 0;
+        darr_init(&p_face->qh_conflicts, sizeof(uint32_t));
     }
 
-    darr_free(&vertices);
+    p_result->p_faces = p_mesh->num_faces ? p_faces : 0;
+}
+
+size_t half_edge_compact_size(uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces) {
+    return sizeof(float) * 3 * num_vertices + sizeof(uint32_t) * (4 * (size_t)num_edges + num_faces);
+}
+
+void half_edge_compact_init(struct he_compact_mesh* p_mesh, uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces) {
+    void* p_bytes = malloc(half_edge_compact_size(num_vertices, num_edges, num_faces));
+    half_edge_compact_view(p_mesh, num_vertices, num_edges, num_faces, p_bytes);
+    p_mesh->_p_buffer = p_bytes;
+}
+
+void half_edge_compact_view(struct he_compact_mesh* p_mesh, uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces, void* p_bytes) {
+    *p_mesh = (struct he_compact_mesh) {
+        .num_vertices = num_vertices,
+        .num_edges = num_edges,
+        .num_faces = num_faces,
+        .p_positions = p_bytes
+    };
+
+    p_mesh->p_edge_tails = (uint32_t*)(p_mesh->p_positions + num_vertices * 3);
+    p_mesh->p_edge_nexts = p_mesh->p_edge_tails + num_edges;
+    p_mesh->p_edge_twins = p_mesh->p_edge_nexts + num_edges;
+    p_mesh->p_edge_faces = p_mesh->p_edge_twins + num_edges;
+    p_mesh->p_face_edges = p_mesh->p_edge_faces + num_edges;
+}
+
+void half_edge_compact_free(struct he_compact_mesh* p_mesh) {
+    free(p_mesh->_p_buffer);
+    *p_mesh = (struct he_compact_mesh){0};
+}
+
+int half_edge_compact_serialize(FILE* p_file, const struct he_compact_mesh* p_mesh) {
+    serialize_uint32(p_file, p_mesh->num_vertices);
+    serialize_uint32(p_file, p_mesh->num_edges);
+    serialize_uint32(p_file, p_mesh->num_faces);
 
-    *p_num_vertices = m;
-}
\ No newline at end of file
+    serialize_bytes(p_file, p_mesh->p_positions, sizeof(float) * 3 * p_mesh->num_vertices);
+    serialize_bytes(p_file, p_mesh->p_edge_tails, sizeof(uint32_t) * p_mesh->num_edges);
+    serialize_bytes(p_file, p_mesh->p_edge_nexts, sizeof(uint32_t) * p_mesh->num_edges);
+    serialize_bytes(p_file, p_mesh->p_edge_twins, sizeof(uint32_t) * p_mesh->num_edges);
+    serialize_bytes(p_file, p_mesh->p_edge_faces, sizeof(uint32_t) * p_mesh->num_edges);
+    serialize_bytes(p_file, p_mesh->p_face_edges, sizeof(uint32_t) * p_mesh->num_faces);
+
+    return !ferror(p_file);
+}
+
+int half_edge_compact_deserialize(FILE* p_file, struct he_compact_mesh* p_mesh) {
+    uint32_t num_vertices, num_edges, num_faces;
+    deserialize_uint32(p_file, &num_vertices);
+    deserialize_uint32(p_file, &num_edges);
+    deserialize_uint32(p_file, &num_faces);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, "half-edge", "Failed to deserialize compact half-edge mesh: unexpected end of file\n");
+        *p_mesh = (struct he_compact_mesh){0};
+        return 0;
+    }
+
+    half_edge_compact_init(p_mesh, num_vertices, num_edges, num_faces);
+
+    // The arrays are contiguous and serialized in layout order, so they can be read back in one go
+    deserialize_bytes(p_file, p_mesh->_p_buffer, half_edge_compact_size(num_vertices, num_edges, num_faces));
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, "half-edge", "Failed to deserialize compact half-edge mesh: unexpected end of file\n");
+        half_edge_compact_free(p_mesh);
+        return 0;
+    }
+
+    return 1;
+}
+
+void half_edge_get_vertices(const struct he_compact_mesh* p_mesh, float* p_vertices, size_t* p_num_vertices) {
+    // Vertices are already unique in the compact form
+
+    *p_num_vertices = p_mesh->num_vertices;
+
+    if (p_vertices) {
+        memcpy(p_vertices, p_mesh->p_positions, sizeof(float) * 3 * p_mesh->num_vertices);
+    }
+}
@@ -2,6 +2,11 @@
 #define _H__HALF_EDGE
 
 #include <stdint.h>
+#include <stdio.h>
+
+#include "darr.h"
+
+#define HE_INVALID_INDEX UINT32_MAX
 
 struct he_vertex {
 	struct he_vertex* p_prev;
@@ -24,18 +29,49 @@ struct he_face {
 	struct he_face* p_next;
 	struct he_edge* p_edges;
 
-	struct he_vertex* p_qh_conflict_list;
-	int               b_qh_processed;
+	struct darr qh_conflicts; // uint32_t indices into the quickhull input point cloud
+	float       qh_plane[4];
+	float       qh_furthest_dist;
+	uint32_t    qh_furthest_conflict;
+	int         b_qh_processed;
+	int         b_qh_new;
 }; 
 
 struct he_mesh {
-	void*             p_buffer;
+	void*             p_buffer; // chain of node blocks; first pointer-sized field of each block links to the next
 	struct he_vertex* p_free_vertices;
 	struct he_edge*   p_free_edges;
 	struct he_face*   p_free_faces;
 	struct he_face*   p_faces;
 };
 
-void half_edge_get_vertices(const struct he_mesh* p_mesh, float* p_vertices, size_t* p_num_vertices);
+/* Index-based half-edge mesh. Every link is a 32-bit index into one of the SoA arrays below, and the arrays are laid out
+ * back to back in the order they are declared, so a compact mesh can be written to an asset file as a single blob and
+ * later viewed in place (e.g. from a memory-mapped file) with half_edge_compact_view. Edges are stored grouped by face. */
+struct he_compact_mesh {
+	uint32_t num_vertices;
+	uint32_t num_edges;
+	uint32_t num_faces;
+
+	float*    p_positions;  // [num_vertices * 3]
+	uint32_t* p_edge_tails; // [num_edges] vertex index
+	uint32_t* p_edge_nexts; // [num_edges] edge index
+	uint32_t* p_edge_twins; // [num_edges] edge index
+	uint32_t* p_edge_faces; // [num_edges] face index
+	uint32_t* p_face_edges; // [num_faces] edge index of the face's first edge
+
+	void* _p_buffer; // allocation owned by the mesh; 0 when viewing external memory
+};
+
+void   half_edge_free(struct he_mesh* p_mesh);
+void   half_edge_compact(const struct he_mesh* p_mesh, struct he_compact_mesh* p_result);
+void   half_edge_expand(const struct he_compact_mesh* p_mesh, struct he_mesh* p_result);
+size_t half_edge_compact_size(uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces);
+void   half_edge_compact_init(struct he_compact_mesh* p_mesh, uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces);
+void   half_edge_compact_view(struct he_compact_mesh* p_mesh, uint32_t num_vertices, uint32_t num_edges, uint32_t num_faces, void* p_bytes);
+void   half_edge_compact_free(struct he_compact_mesh* p_mesh);
+int    half_edge_compact_serialize(FILE* p_file, const struct he_compact_mesh* p_mesh);
+int    half_edge_compact_deserialize(FILE* p_file, struct he_compact_mesh* p_mesh);
+void   half_edge_get_vertices(const struct he_compact_mesh* p_mesh, float* p_vertices, size_t* p_num_vertices);
 
 #endif
\ No newline at end of file
@@ -37,7 +37,8 @@ static const struct gltf_accessor* get_gltf_mesh_primitive_vertex_attribute_acce
 
 static void discover_joint_hierarchy(const struct gltf* p_gltf, const struct gltf_skin* p_gltf_skin, struct skeleton* p_skeleton, size_t joint_index);
 
-static struct scene_entity* process_scene_node(struct gltf_importer* p_importer, const struct gltf_node* p_gltf_node, struct scene* p_scene);
+static size_t               count_scene_nodes(const struct gltf* p_gltf, const struct gltf_node* p_gltf_node);
+static struct scene_entity* process_scene_node(struct gltf_importer* p_importer, const struct gltf_node* p_gltf_node, struct scene* p_scene, struct scene_entity* const** ppp_entities);
 
 static size_t gltf_accessor_element_size(const struct gltf_accessor* p_gltf_accessor);
 static void   copy_gltf_accessor(const struct gltf* p_gltf, const struct gltf_accessor* p_gltf_accessor, void* p_dst, size_t dst_stride);
@@ -515,11 +516,33 @@ void import_gltf_scene(struct gltf_importer* p_importer, size_t gltf_scene_index
     struct scene* p_scene = malloc(sizeof(struct scene));
     scene_init(p_scene);
 
+    // Spawn every node's entity in one batch, then hand them out in the same order the nodes are visited
+    size_t num_nodes = 0;
     for (size_t i = 0; i < p_gltf_scene->num_root_nodes; ++i) {
-        const struct gltf_node* p_gltf_root_node = &p_importer->p_gltf->p_nodes[p_gltf_scene->p_root_nodes_indices[i]];
-        process_scene_node(p_importer, p_gltf_root_node, p_scene);
+        num_nodes += count_scene_nodes(p_importer->p_gltf, &p_importer->p_gltf->p_nodes[p_gltf_scene->p_root_nodes_indices[i]]);
     }
 
+    struct scene_entity** pp_entities = malloc(sizeof(struct scene_entity*) * (num_nodes ? num_nodes : 1));
+
+    const size_t num_entities = scene_new_entities(p_scene, num_nodes, pp_entities);
+
+    if (num_entities == num_nodes) {
+        struct scene_entity* const* pp_next_entity = pp_entities;
+
+        for (size_t i = 0; i < p_gltf_scene->num_root_nodes; ++i) {
+            const struct gltf_node* p_gltf_root_node = &p_importer->p_gltf->p_nodes[p_gltf_scene->p_root_nodes_indices[i]];
+            process_scene_node(p_importer, p_gltf_root_node, p_scene, &pp_next_entity);
+        }
+    } else {
+        cx_log_fmt(CX_LOG_ERROR, 0, "Not enough entities for the %u nodes of scene %u\n", (unsigned int)num_nodes, (unsigned int)gltf_scene_index);
+
+        for (size_t i = 0; i < num_entities; ++i) {
+            scene_destroy_entity(p_scene, pp_entities[i]);
+        }
+    }
+
+    free(pp_entities);
+
     asset_handle handle = asset_package_new_record(p_importer->p_asset_package, ASSET_TYPE_SCENE);
     handle->_asset._p_data = p_scene;
 
@@ -567,16 +590,26 @@ void discover_joint_hierarchy(const struct gltf* p_gltf, const struct gltf_skin*
     }
 }
 
-struct scene_entity* process_scene_node(struct gltf_importer* p_importer, const struct gltf_node* p_gltf_node, struct scene* p_scene) {
-    struct scene_entity* p_entity = scene_new_entity(p_scene);
+size_t count_scene_nodes(const struct gltf* p_gltf, const struct gltf_node* p_gltf_node) {
+    size_t count = 1;
+    for (size_t i = 0; i < p_gltf_node->num_children; ++i) {
+        count += count_scene_nodes(p_gltf, &p_gltf->p_nodes[p_gltf_node->p_children_indices[i]]);
+    }
+    return count;
+}
+
+struct scene_entity* process_scene_node(struct gltf_importer* p_importer, const struct gltf_node* p_gltf_node, struct scene* p_scene, struct scene_entity* const** ppp_entities) {
+    struct scene_entity* p_entity = *(*ppp_entities)++;
     
-    p_entity->p_mesh = p_importer->p_result->p_meshes[p_gltf_node->mesh_index];
+    if (p_gltf_node->mesh_index != GLTF_INVALID_INDEX) {
+        scene_set_entity_mesh(p_scene, p_entity->_id, p_importer->p_result->p_meshes[p_gltf_node->mesh_index]);
+    }
 
     matrix_decompose_trs(p_gltf_node->matrix, p_entity->transform.position, p_entity->transform.rotation, p_entity->transform.scale);
 
     for (size_t i = 0; i < p_gltf_node->num_children; ++i) {
         const struct gltf_node* p_child_gltf_node = &p_importer->p_gltf->p_nodes[p_gltf_node->p_children_indices[i]];
-        struct scene_entity* p_child_entity = process_scene_node(p_importer, p_child_gltf_node, p_scene);
+        struct scene_entity* p_child_entity = process_scene_node(p_importer, p_child_gltf_node, p_scene, ppp_entities);
         p_child_entity->transform.p_local_transform = &p_entity->transform;
     }
 
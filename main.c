@@ -1,12 +1,21 @@
 #include <stdio.h>
-#include <time.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "asset.h"
+#include "convex_decomposition.h"
+#include "cooked_texture.h"
 #include "dev.h"
 #include "gl_context.h"
+#include "gl_frame_graph.h"
+#include "gl_geometry_pool.h"
 #include "gl_mesh.h"
 #include "gl_program.h"
+#include "gl_program_cache.h"
+#include "gl_render_queue.h"
 #include "gl_texture.h"
+#include "gl_texture_upload_queue.h"
+#include "gl_uniform_buffer.h"
 #include "gl.h"
 #include "gltf.h"
 #include "input.h"
@@ -19,19 +28,43 @@
 #include "mesh_factory.h"
 #include "mesh.h"
 #include "mouse_buttons.h"
+#include "parallel.h"
 #include "physics.h"
+#include "platform_time.h"
 #include "platform_window.h"
+#include "render_queue.h"
 #include "scene.h"
 #include "skeletal_animation_debug.h"
 #include "static_mesh.h"
 #include "texture.h"
 #include "transform.h"
+#include "triangle_bvh.h"
 #include "vector.h"
 
+// What the frame's passes draw with, handed to each as its user data
+struct frame_pass_data {
+    struct gl_render_queue*    p_gl_render_queue;
+    const struct render_queue* p_render_queue;
+    GLuint                     gl_screen_program;
+    GLuint                     gl_empty_vao;
+    gl_frame_graph_resource    color;
+    size_t                     framebuffer_size[2];
+    const float*               p_projection_matrix;
+    const float*               p_view_matrix;
+    float                      delta_seconds;
+};
+
 static void platform_window_on_created(struct platform_window*, void*);
 static void platform_window_on_key(struct platform_window*, void*, enum key, int);
 static void platform_window_on_mouse_button(struct platform_window*, void*, enum mouse_button, int);
 static void platform_window_on_mouse_move(struct platform_window*, void*, int, int);
+static void scene_pass(struct gl_frame_graph*, void*);
+static void dev_pass(struct gl_frame_graph*, void*);
+static void mesh_id_pass(struct gl_frame_graph*, void*);
+static void screen_pass(struct gl_frame_graph*, void*);
+static int  compare_frame_times(const void*, const void*);
+static void log_frame_times(const struct darr*);
+static void run_entity_benchmark(size_t);
 
 void platform_window_on_created(struct platform_window* p_platform_window, void*) {
     platform_window_set_on_key_callback(p_platform_window, platform_window_on_key, 0);
@@ -64,9 +97,39 @@ void platform_window_on_mouse_move(struct platform_window*, void*, int delta_x,
     input_event_broadcast(INPUT_EVENT_mouse_move, &event_data);
 }
 
-int main(int, const char*[]) {
+int main(int argc, const char* argv[]) {
     printf("It's the 9th of September 2025 and I'm writing yet another game engine project.\n");
 
+    /* --headless steps frames by a fixed amount with no input, so every run draws the same frames, and --frames N quits
+     * after N of them. Either one reports the CPU time of each frame on exit. On Linux the window is always headless and
+     * rendering goes to an offscreen surface; on Windows the window is still created, as WGL needs one.
+     * --bench-entities N times creating, looking up and destroying N entities of an empty scene, then quits without
+     * opening a window. */
+    int b_headless = 0;
+    unsigned long max_frames = 0;
+    unsigned long num_benchmark_entities = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--headless")) {
+            b_headless = 1;
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            max_frames = strtoul(argv[++i], 0, 10);
+        } else if (!strcmp(argv[i], "--bench-entities") && i + 1 < argc) {
+            num_benchmark_entities = strtoul(argv[++i], 0, 10);
+        } else {
+            cx_log_fmt(CX_LOG_WARNING, "main", "Ignoring unknown argument '%s'\n", argv[i]);
+        }
+    }
+
+    matrix_select_isa(MATRIX_ISA_avx);
+    parallel_init(0);
+
+    if (num_benchmark_entities) {
+        run_entity_benchmark(num_benchmark_entities);
+        parallel_shutdown();
+        return 0;
+    }
+
     unsigned int window_size[] = { 1200, 900 };
 
     struct platform_window platform_window;
@@ -75,41 +138,21 @@ int main(int, const char*[]) {
     struct gl_context gl_context;
     gl_context_create(&platform_window, 3, 3, &gl_context);
 
-    // create framebuffer
-
+    // The scene is drawn at this resolution then stretched over the window. Its attachments belong to the frame graph.
     GLsizei framebuffer_resolution[] = { 800, 600 };
 
-    GLuint gl_color_attachment;
-    GLuint gl_depth_stencil_attachment;
-    GLuint gl_framebuffer;
+    // create shader programs
 
-    glGenTextures(1, &gl_color_attachment);
-    glBindTexture(GL_TEXTURE_2D, gl_color_attachment);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, framebuffer_resolution[0], framebuffer_resolution[1], 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    struct gl_program_cache gl_program_cache;
+    gl_program_cache_init(&gl_program_cache, "shader_cache");
 
-    glGenTextures(1, &gl_depth_stencil_attachment);
-    glBindTexture(GL_TEXTURE_2D, gl_depth_stencil_attachment);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, framebuffer_resolution[0], framebuffer_resolution[1], 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-
-    glGenFramebuffers(1, &gl_framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gl_framebuffer);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gl_color_attachment, 0);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gl_depth_stencil_attachment, 0);
-
-    // create shader program
-
-    struct gl_shader gl_vertex_shader;
-    struct gl_shader gl_fragment_shader;
     struct gl_program gl_program;
+    struct gl_program gl_instanced_program;
 
-    gl_shader_create(&gl_vertex_shader, GL_VERTEX_SHADER);
-    gl_shader_compile(&gl_vertex_shader,
+    const char* s_vertex_shader =
         "#version 330 core\n"
-        "uniform mat4 u_projection_matrix;"
-        "uniform mat4 u_view_matrix;"
-        "uniform mat4 u_model_matrix;"
+        "layout (std140) uniform Frame { mat4 u_projection_matrix; mat4 u_view_matrix; vec4 u_camera_position; };"
+        "layout (std140) uniform Draw { mat4 u_model_matrix; };"
         "layout (location=0) in vec3 a_pos;"
         "layout (location=1) in vec3 a_normal;"
         "layout (location=3) in vec2 a_texcoords;"
@@ -119,12 +162,27 @@ int main(int, const char*[]) {
             "v_normal = normalize(mat3(transpose(inverse(u_model_matrix))) * a_normal);"
             "v_texcoords = a_texcoords;"
             "gl_Position = u_projection_matrix * u_view_matrix * u_model_matrix * vec4(a_pos, 1.0);"
-        "}");
+        "}";
+
+    // Same as above but with the model matrix as a per-instance attribute, at GL_MESH_INSTANCE_MATRIX_LOCATION
+    const char* s_instanced_vertex_shader =
+        "#version 330 core\n"
+        "layout (std140) uniform Frame { mat4 u_projection_matrix; mat4 u_view_matrix; vec4 u_camera_position; };"
+        "layout (location=0) in vec3 a_pos;"
+        "layout (location=1) in vec3 a_normal;"
+        "layout (location=3) in vec2 a_texcoords;"
+        "layout (location=8) in mat4 a_model_matrix;"
+        "out vec3 v_normal;"
+        "out vec2 v_texcoords;"
+        "void main() {"
+            "v_normal = normalize(mat3(transpose(inverse(a_model_matrix))) * a_normal);"
+            "v_texcoords = a_texcoords;"
+            "gl_Position = u_projection_matrix * u_view_matrix * a_model_matrix * vec4(a_pos, 1.0);"
+        "}";
 
-    gl_shader_create(&gl_fragment_shader, GL_FRAGMENT_SHADER);
-    gl_shader_compile(&gl_fragment_shader,
+    const char* s_fragment_shader =
         "#version 330 core\n"
-        "uniform vec3 u_color;"
+        "layout (std140) uniform Material { vec4 u_color; };"
         "uniform sampler2D u_texture;"
         "in vec3 v_normal;"
         "in vec2 v_texcoords;"
@@ -134,69 +192,112 @@ int main(int, const char*[]) {
             "const float ka = 0.3;"
             
             "vec3 texture_rgb = texture(u_texture, v_texcoords).rgb;"
-            "vec3 albedo = texture_rgb * u_color;"
+            "vec3 albedo = texture_rgb * u_color.rgb;"
 
             "float kd = max(dot(v_normal, -light_dir), 0);"
 
             "f_color = vec4(min((ka + kd), 1) * albedo, 1);"
-        "}");
+        "}";
 
-    gl_program_create(&gl_program);
-    gl_program_attach_shader(&gl_program, &gl_vertex_shader);
-    gl_program_attach_shader(&gl_program, &gl_fragment_shader);
-    gl_program_link(&gl_program);
+    const struct gl_program_source program_sources[] = {
+        { GL_VERTEX_SHADER, s_vertex_shader },
+        { GL_FRAGMENT_SHADER, s_fragment_shader }
+    };
+
+    const struct gl_program_source instanced_program_sources[] = {
+        { GL_VERTEX_SHADER, s_instanced_vertex_shader },
+        { GL_FRAGMENT_SHADER, s_fragment_shader }
+    };
 
-    gl_shader_destroy(&gl_vertex_shader);
-    gl_shader_destroy(&gl_fragment_shader);
+    gl_program_cache_load(&gl_program_cache, program_sources, 2, 0, &gl_program);
+    gl_program_cache_load(&gl_program_cache, instanced_program_sources, 2, 0, &gl_instanced_program);
 
     // create screen shader program
 
-    struct gl_shader gl_screen_vertex_shader;
-    struct gl_shader gl_screen_fragment_shader;
     struct gl_program gl_screen_program;
 
-    gl_shader_create(&gl_screen_vertex_shader, GL_VERTEX_SHADER);
-    gl_shader_compile(&gl_screen_vertex_shader,
-        "#version 330 core\n"
-        "out vec2 v_texcoords;\n"
-        "void main() {\n"
-            "vec2 vertices[3] = vec2[3](vec2(-1, -1), vec2(3, -1), vec2(-1, 3));\n"
-            "gl_Position = vec4(vertices[gl_VertexID], 0, 1);\n"
-            "v_texcoords = 0.5 * gl_Position.xy + vec2(0.5);\n"
-        "}");
-
-    gl_shader_create(&gl_screen_fragment_shader, GL_FRAGMENT_SHADER);
-    gl_shader_compile(&gl_screen_fragment_shader,
-        "#version 330 core\n"
-        "uniform sampler2D u_texture;\n"
-        "in vec2 v_texcoords;\n"
-        "out vec4 f_color;\n"
-        "void main() {\n"
-            "f_color = texture(u_texture, v_texcoords);\n"
-        "}");
+    const struct gl_program_source screen_program_sources[] = {
+        {
+            GL_VERTEX_SHADER,
+            "#version 330 core\n"
+            "out vec2 v_texcoords;\n"
+            "void main() {\n"
+                "vec2 vertices[3] = vec2[3](vec2(-1, -1), vec2(3, -1), vec2(-1, 3));\n"
+                "gl_Position = vec4(vertices[gl_VertexID], 0, 1);\n"
+                "v_texcoords = 0.5 * gl_Position.xy + vec2(0.5);\n"
+            "}"
+        },
+        {
+            GL_FRAGMENT_SHADER,
+            "#version 330 core\n"
+            "uniform sampler2D u_texture;\n"
+            "in vec2 v_texcoords;\n"
+            "out vec4 f_color;\n"
+            "void main() {\n"
+                "f_color = texture(u_texture, v_texcoords);\n"
+            "}"
+        }
+    };
 
-    gl_program_create(&gl_screen_program);
-    gl_program_attach_shader(&gl_screen_program, &gl_screen_vertex_shader);
-    gl_program_attach_shader(&gl_screen_program, &gl_screen_fragment_shader);
-    gl_program_link(&gl_screen_program);
+    gl_program_cache_load(&gl_program_cache, screen_program_sources, 2, 0, &gl_screen_program);
 
-    gl_shader_destroy(&gl_screen_vertex_shader);
-    gl_shader_destroy(&gl_screen_fragment_shader);
+    // The programs above compile while the scene loads, and are waited for once the dev tools have started theirs
 
     register_asset_type(ASSET_TYPE_IMAGE, "image", sizeof(struct image), 0, 0, 0);
     register_asset_type(ASSET_TYPE_TEXTURE, "texture", sizeof(struct texture), 0, 0, 0);
     register_asset_type(ASSET_TYPE_MATERIAL, "material", sizeof(struct material), 0, 0, 0);
     register_asset_type(ASSET_TYPE_STATIC_MESH, "static_mesh", sizeof(struct static_mesh), 0, 0, (void*)static_mesh_free);
-    register_asset_type(ASSET_TYPE_SCENE, "scene", sizeof(struct scene), 0, 0, (void*)scene_destroy);
+    register_asset_type(ASSET_TYPE_SCENE, "scene", sizeof(struct scene), scene_serialize, scene_deserialize, (void*)scene_destroy);
+    ASSET_REGISTER_TYPE(convex_decomposition, ASSET_TYPE_CONVEX_DECOMPOSITION);
+    ASSET_REGISTER_TYPE(triangle_bvh, ASSET_TYPE_TRIANGLE_BVH);
+    ASSET_REGISTER_TYPE(cooked_texture, ASSET_TYPE_COOKED_TEXTURE);
 
     struct asset_package asset_package;
     asset_package_init(&asset_package);
 
     struct gltf gltf;
-    gltf_load_from_file("res/Industrial_exterior_v2.glb", &gltf);
+    const char* s_level_path = "res/Industrial_exterior_v2.glb";
+
+    struct import_gltf_result import_gltf_result = {0};
+
+    if (gltf_load_from_file(s_level_path, &gltf) == GLTF_SUCCESS) {
+        import_gltf(&gltf, &asset_package, &import_gltf_result);
+    }
 
-    struct import_gltf_result import_gltf_result;
-    import_gltf(&gltf, &asset_package, &import_gltf_result);
+    // Without the level there's nothing to run, and a build box running --frames needs a failure it can see
+    if (import_gltf_result.num_scenes == 0) {
+        cx_log_fmt(CX_LOG_ERROR, "main", "Couldn't load a scene from '%s'\n", s_level_path);
+
+        gltf_free(&gltf);
+        import_gltf_free(&import_gltf_result);
+        gl_program_cache_destroy(&gl_program_cache);
+        gl_context_destroy(&gl_context);
+        platform_window_destroy(&platform_window);
+        parallel_shutdown();
+
+        return 1;
+    }
+
+    // Textures load their images' mip chains, cooked offline and cached, rather than generating them on the GPU
+    struct cooked_texture_params cooked_texture_params;
+    cooked_texture_params_default(&cooked_texture_params);
+    cooked_texture_params.b_s3tc = gl_context_has_extension("GL_EXT_texture_compression_s3tc");
+
+    asset_handle* p_cooked_textures = malloc(sizeof(asset_handle) * import_gltf_result.num_images);
+    cooked_texture_cook_images(&asset_package, import_gltf_result.p_images, import_gltf_result.num_images, &cooked_texture_params, "texture_cache", p_cooked_textures);
+
+    for (size_t i = 0; i < import_gltf_result.num_textures; ++i) {
+        struct texture* p_texture = import_gltf_result.p_textures[i]->_asset._p_data;
+
+        for (size_t j = 0; j < import_gltf_result.num_images; ++j) {
+            if (p_texture->p_source_image == import_gltf_result.p_images[j] && p_cooked_textures[j]) {
+                p_texture->p_source_image = p_cooked_textures[j];
+                break;
+            }
+        }
+    }
+
+    free(p_cooked_textures);
     
     struct scene* p_scene = import_gltf_result.p_scenes[0]->_asset._p_data;
 
@@ -231,8 +332,29 @@ int main(int, const char*[]) {
     physics_world_add_solver(&physics_world, physics_collision_solver_impulse);
     physics_world_add_solver(&physics_world, physics_collision_solver_smooth_positions);
 
+    // Level geometry collides as triangle meshes. Each static mesh gets one BVH, shared by every entity that draws it.
+    {
+        struct scene_query query;
+        scene_query_init(&query, p_scene, SCENE_COMPONENT_BIT(SCENE_COMPONENT_mesh));
+
+        while (scene_query_next(&query)) {
+            const asset_handle bvh_handle = triangle_bvh_find_or_build(&asset_package, *(asset_handle*)scene_query_get(&query, SCENE_COMPONENT_mesh));
+
+            if (!bvh_handle) {
+                continue;
+            }
+
+            struct physics_object* p_physics_object = physics_world_new_object(&physics_world, &query.p_entity->transform, 0);
+            physics_world_new_object_collider(&physics_world, p_physics_object, PHYSICS_COLLIDER_TYPE_mesh);
+            p_physics_object->_p_collider->as_mesh.p_bvh = bvh_handle->_asset._p_data;
+
+            *(struct physics_object**)scene_add_component(p_scene, query.entity_id, SCENE_COMPONENT_physics_object) = p_physics_object;
+        }
+    }
+
     {
         struct scene_entity* p_new_entity;
+        struct physics_object** pp_physics_object;
 
         // Sphere 1
         
@@ -240,8 +362,9 @@ int main(int, const char*[]) {
 
         p_new_entity->transform.position[1] = 3;
 
-        p_new_entity->p_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
-        physics_world_new_object_collider(&physics_world, p_new_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
+        pp_physics_object = scene_add_component(p_scene, p_new_entity->_id, SCENE_COMPONENT_physics_object);
+        *pp_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
+        physics_world_new_object_collider(&physics_world, *pp_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
         
         // Sphere 2
         
@@ -250,8 +373,9 @@ int main(int, const char*[]) {
         p_new_entity->transform.position[1] = 3;
         p_new_entity->transform.position[0] = 2;
 
-        p_new_entity->p_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
-        physics_world_new_object_collider(&physics_world, p_new_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_capsule);
+        pp_physics_object = scene_add_component(p_scene, p_new_entity->_id, SCENE_COMPONENT_physics_object);
+        *pp_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
+        physics_world_new_object_collider(&physics_world, *pp_physics_object, PHYSICS_COLLIDER_TYPE_capsule);
         
         // // Sphere 3
         
@@ -260,24 +384,60 @@ int main(int, const char*[]) {
         // p_new_entity->transform.position[1] = 3;
         // p_new_entity->transform.position[0] = -2;
 
-        // p_new_entity->p_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 1);
-        // physics_world_new_object_collider(&physics_world, p_new_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
+        // pp_physics_object = scene_add_component(p_scene, p_new_entity->_id, SCENE_COMPONENT_physics_object);
+        // *pp_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 1);
+        // physics_world_new_object_collider(&physics_world, *pp_physics_object, PHYSICS_COLLIDER_TYPE_sphere);
         
         // // Plane 1
 
         // p_new_entity = scene_new_entity(p_scene);
 
-        // p_new_entity->p_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
-        // physics_world_new_object_collider(&physics_world, p_new_entity->p_physics_object, PHYSICS_COLLIDER_TYPE_plane);
+        // pp_physics_object = scene_add_component(p_scene, p_new_entity->_id, SCENE_COMPONENT_physics_object);
+        // *pp_physics_object = physics_world_new_object(&physics_world, &p_new_entity->transform, 0);
+        // physics_world_new_object_collider(&physics_world, *pp_physics_object, PHYSICS_COLLIDER_TYPE_plane);
     }
     
-    dev_init(&platform_window, p_scene, &physics_world);
+    dev_init(&platform_window, p_scene, &physics_world, &gl_program_cache);
+
+    gl_program_cache_finish(&gl_program_cache);
+
+    struct darr visible_entities;
+    darr_init(&visible_entities, sizeof(scene_entity_id));
+
+    struct scene_cull_stats cull_stats = {0};
+
+    struct render_queue render_queue;
+    render_queue_init(&render_queue);
+
+    struct gl_render_queue gl_render_queue;
+    gl_render_queue_create(&gl_render_queue);
+
+    struct gl_geometry_pool gl_geometry_pool;
+    gl_geometry_pool_init(&gl_geometry_pool);
+
+    struct gl_uniform_buffer gl_frame_uniform_buffer;
+    gl_uniform_buffer_create(&gl_frame_uniform_buffer);
+
+    struct gl_texture_upload_queue gl_texture_upload_queue;
+    gl_texture_upload_queue_create(&gl_texture_upload_queue, 0);
+
+    struct gl_frame_graph gl_frame_graph;
+    gl_frame_graph_create(&gl_frame_graph);
+
+    // The screen pass's triangle comes from gl_VertexID alone, but core profile still wants a vertex array bound
+    GLuint gl_empty_vao;
+    glGenVertexArrays(1, &gl_empty_vao);
+
+    struct darr frame_times;
+    darr_init(&frame_times, sizeof(double));
+
+    double stats_log_time = platform_time_seconds();
 
-    clock_t old_frame_start = clock();
+    double old_frame_start = platform_time_seconds();
 
-    while (platform_window_is_open(&platform_window)) {
-        const clock_t frame_start = clock();
-        const float frame_delta_seconds = (float)(frame_start - old_frame_start) / CLOCKS_PER_SEC;
+    while (platform_window_is_open(&platform_window) && (max_frames == 0 || frame_times._length < max_frames)) {
+        const double frame_start = platform_time_seconds();
+        const float frame_delta_seconds = b_headless ? 1.0f / 60.0f : (float)(frame_start - old_frame_start);
         old_frame_start = frame_start;
 
         input_frame_reset();
@@ -373,49 +533,58 @@ int main(int, const char*[]) {
 
         // DRAW
         {
-            glEnable(GL_CULL_FACE);
-            glEnable(GL_DEPTH_TEST); 
-            glViewport(0, 0, framebuffer_resolution[0], framebuffer_resolution[1]);
-            glBindFramebuffer(GL_FRAMEBUFFER, gl_framebuffer);
-            glClearColor(0.1f, 0.1f, 0.1f, 0.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // Last frame's newly seen textures start uploading before this frame's draws are issued
+            gl_texture_upload_queue_update(&gl_texture_upload_queue);
 
-            glUseProgram(gl_program.gl_handle);
+            // Every program declaring the Frame block reads it from here, however many there are
+            struct gl_frame_uniforms frame_uniforms = {
+                .camera_position = { camera_position[0], camera_position[1], camera_position[2], 1 }
+            };
+            memcpy(frame_uniforms.projection_matrix, projection_matrix, sizeof(frame_uniforms.projection_matrix));
+            memcpy(frame_uniforms.view_matrix, view_matrix, sizeof(frame_uniforms.view_matrix));
 
-            GLuint gl_uniform_location;
-            
-            gl_uniform_location = glGetUniformLocation(gl_program.gl_handle, "u_projection_matrix");
-            glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, projection_matrix);
-            
-            gl_uniform_location = glGetUniformLocation(gl_program.gl_handle, "u_view_matrix");
-            glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, view_matrix);
+            gl_uniform_buffer_update(&gl_frame_uniform_buffer, &frame_uniforms, sizeof(frame_uniforms));
+            gl_uniform_buffer_bind(&gl_frame_uniform_buffer, GL_PROGRAM_BLOCK_frame);
 
-            glActiveTexture(GL_TEXTURE0);
+            scene_update_transforms(p_scene);
 
-            const GLuint gl_model_matrix_uniform_location = glGetUniformLocation(gl_program.gl_handle, "u_model_matrix");
-            const GLuint gl_color_uniform_location = glGetUniformLocation(gl_program.gl_handle, "u_color");
-            
-            for (size_t i = 0; i < p_scene->_entities._length; ++i) {
-                struct scene_entity* p_entity = *(struct scene_entity**)darr_get(&p_scene->_entities, i);
+            float view_projection_matrix[16];
+            matrix_multiply(projection_matrix, view_matrix, view_projection_matrix);
+
+            float frustum_planes[24];
+            matrix_frustum_planes(view_projection_matrix, frustum_planes);
+
+            scene_cull(p_scene, frustum_planes, &visible_entities, &cull_stats);
+
+            if (frame_start - stats_log_time >= 1.0) {
+                stats_log_time = frame_start;
+                cx_log_fmt(CX_LOG_TRACE, "main", "Culling: tested=%u visible=%u culled=%u unbounded=%u\n", (unsigned int)cull_stats.num_tested, (unsigned int)cull_stats.num_visible, (unsigned int)cull_stats.num_culled, (unsigned int)cull_stats.num_unbounded);
+
+                // A benchmark's pass timings are logged once, over the whole run
+                if (!b_headless && !max_frames) {
+                    gl_frame_graph_log_timings(&gl_frame_graph, CX_LOG_TRACE);
+                }
+            }
+
+            render_queue_clear(&render_queue);
 
-                transform_compute_world_trs_matrix(&p_entity->transform);
+            for (size_t i = 0; i < visible_entities._length; ++i) {
+                const scene_entity_id entity_id = *(scene_entity_id*)darr_get(&visible_entities, i);
+                const asset_handle* pp_mesh = scene_get_component(p_scene, entity_id, SCENE_COMPONENT_mesh);
 
-                if (!p_entity->p_mesh) {
+                if (!pp_mesh) {
                     continue;
                 }
 
-                glUniformMatrix4fv(gl_model_matrix_uniform_location, 1, GL_FALSE, p_entity->transform.world_trs_matrix);
+                const struct transform* p_transform = &scene_get_entity(p_scene, entity_id)->transform;
 
-                struct static_mesh* p_mesh = p_entity->p_mesh->_asset._p_data;
+                struct static_mesh* p_mesh = (*pp_mesh)->_asset._p_data;
 
                 if (!p_mesh->b_loaded_device_meshes) {
-                    static_mesh_load_device_meshes(p_mesh);
+                    static_mesh_load_device_meshes(p_mesh, &gl_geometry_pool);
                 }
 
                 for (size_t j = 0; j < p_mesh->num_primitives; ++j) {
-                    float model_color[] = { 1, 1, 1 };
-                    glUniform3fv(gl_color_uniform_location, 1, model_color);
-
                     GLuint gl_texture_handle = gl_white_texture.gl_handle;
 
                     if (p_mesh->p_materials[j]) {
@@ -423,47 +592,213 @@ int main(int, const char*[]) {
                         if (p_material->p_texture) {
                             struct texture* p_texture = p_material->p_texture->_asset._p_data;
                             if (p_texture->gl_texture.gl_handle == 0) {
-                                texture_load_device_texture(p_texture);
+                                texture_load_device_texture(p_texture, &gl_texture_upload_queue);
+                            }
+
+                            // White stands in until the texture's upload has finished
+                            if (p_texture->gl_texture.b_is_ready) {
+                                gl_texture_handle = p_texture->gl_texture.gl_handle;
                             }
-                            gl_texture_handle = p_texture->gl_texture.gl_handle;
                         }
                     }
 
-                    glBindTexture(GL_TEXTURE_2D, gl_texture_handle);
-
-                    gl_mesh_draw(&p_mesh->p_gl_meshes[j]);
+                    const struct gl_mesh* p_gl_mesh = &p_mesh->p_gl_meshes[j];
+
+                    /* Copies of a mesh are batched by the mesh's address rather than sorted by depth, so however many
+                     * there are they cost one instanced draw. Addresses that collide in 32 bits only split batches. */
+                    struct render_item* p_item = render_queue_push(&render_queue);
+                    *p_item = (struct render_item) {
+                        .key = render_queue_make_batch_key(0, gl_program.gl_handle, gl_texture_handle, (uint32_t)(uintptr_t)p_gl_mesh),
+                        .program = gl_program.gl_handle,
+                        .instanced_program = gl_instanced_program.gl_handle,
+                        .texture = gl_texture_handle,
+                        .color = { 1, 1, 1 },
+                        .p_model_matrix = p_transform->world_trs_matrix,
+                        .p_mesh = p_gl_mesh
+                    };
                 }
             }
 
-            dev_draw(gl_framebuffer, framebuffer_resolution[0], framebuffer_resolution[1], projection_matrix, view_matrix);
+            render_queue_sort(&render_queue);
+            render_queue_build_commands(&render_queue);
 
-            // SCREEN QUAD
-            {
-                platform_window_size(&platform_window, &window_size[0], &window_size[1]);
+            platform_window_size(&platform_window, &window_size[0], &window_size[1]);
 
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                glViewport(0, 0, (GLsizei)window_size[0], (GLsizei)window_size[1]);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            struct frame_pass_data frame_pass_data = {
+                .p_gl_render_queue = &gl_render_queue,
+                .p_render_queue = &render_queue,
+                .gl_screen_program = gl_screen_program.gl_handle,
+                .gl_empty_vao = gl_empty_vao,
+                .framebuffer_size = { (size_t)framebuffer_resolution[0], (size_t)framebuffer_resolution[1] },
+                .p_projection_matrix = projection_matrix,
+                .p_view_matrix = view_matrix,
+                .delta_seconds = frame_delta_seconds
+            };
 
-                glUseProgram(gl_screen_program.gl_handle);
+            // New passes are added here, declaring what they read and write, and the graph works out the rest
+            gl_frame_graph_begin(&gl_frame_graph, (GLsizei)window_size[0], (GLsizei)window_size[1]);
 
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, gl_color_attachment);
+            const gl_frame_graph_resource color = gl_frame_graph_create_texture(&gl_frame_graph, framebuffer_resolution[0], framebuffer_resolution[1], GL_FRAME_GRAPH_FORMAT_rgb8);
+            const gl_frame_graph_resource depth_stencil = gl_frame_graph_create_texture(&gl_frame_graph, framebuffer_resolution[0], framebuffer_resolution[1], GL_FRAME_GRAPH_FORMAT_depth24_stencil8);
+            frame_pass_data.color = color;
 
-                GLuint gl_empty_vao;
-                glGenVertexArrays(1, &gl_empty_vao);
-                glBindVertexArray(gl_empty_vao);
-                glDrawArrays(GL_TRIANGLES, 0, 3);
-                glDeleteVertexArrays(1, &gl_empty_vao);
-            }
+            const float clear_color[] = { 0.1f, 0.1f, 0.1f, 0.0f };
+            const float clear_depth_stencil[] = { 1.0f, 0.0f };
+
+            size_t pass = gl_frame_graph_add_pass(&gl_frame_graph, "scene", scene_pass, &frame_pass_data);
+            gl_frame_graph_write(&gl_frame_graph, pass, color, GL_FRAME_GRAPH_LOAD_clear, clear_color);
+            gl_frame_graph_write(&gl_frame_graph, pass, depth_stencil, GL_FRAME_GRAPH_LOAD_clear, clear_depth_stencil);
+
+            pass = gl_frame_graph_add_pass(&gl_frame_graph, "dev", dev_pass, &frame_pass_data);
+            gl_frame_graph_write(&gl_frame_graph, pass, color, GL_FRAME_GRAPH_LOAD_keep, 0);
+            gl_frame_graph_write(&gl_frame_graph, pass, depth_stencil, GL_FRAME_GRAPH_LOAD_keep, 0);
+
+            gl_frame_graph_add_pass(&gl_frame_graph, "mesh_id", mesh_id_pass, &frame_pass_data);
+
+            pass = gl_frame_graph_add_pass(&gl_frame_graph, "screen", screen_pass, &frame_pass_data);
+            gl_frame_graph_read(&gl_frame_graph, pass, color);
+            gl_frame_graph_write(&gl_frame_graph, pass, GL_FRAME_GRAPH_BACKBUFFER, GL_FRAME_GRAPH_LOAD_dont_care, 0);
+
+            gl_frame_graph_execute(&gl_frame_graph);
         }
 
         gl_context_swap_buffers(&gl_context);
+
+        if (b_headless || max_frames) {
+            *(double*)darr_push(&frame_times) = platform_time_seconds() - frame_start;
+        }
+    }
+
+    if (b_headless || max_frames) {
+        log_frame_times(&frame_times);
+        gl_frame_graph_log_timings(&gl_frame_graph, CX_LOG_INFO);
     }
 
+    darr_free(&frame_times);
+
+    darr_free(&visible_entities);
+    render_queue_free(&render_queue);
+    gl_render_queue_destroy(&gl_render_queue);
+    gl_geometry_pool_destroy(&gl_geometry_pool);
+    gl_uniform_buffer_destroy(&gl_frame_uniform_buffer);
+    gl_texture_upload_queue_destroy(&gl_texture_upload_queue);
+    gl_frame_graph_destroy(&gl_frame_graph);
+    glDeleteVertexArrays(1, &gl_empty_vao);
+    gl_program_cache_destroy(&gl_program_cache);
+
     gl_context_destroy(&gl_context);
 
     platform_window_destroy(&platform_window);
 
+    parallel_shutdown();
+
     return 0;
+}
+
+void scene_pass(struct gl_frame_graph* p_graph, void* p_user_data) {
+    const struct frame_pass_data* p_data = p_user_data;
+
+    glEnable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+    glActiveTexture(GL_TEXTURE0);
+
+    gl_render_queue_execute(p_data->p_gl_render_queue, p_data->p_render_queue);
+}
+
+void dev_pass(struct gl_frame_graph* p_graph, void* p_user_data) {
+    const struct frame_pass_data* p_data = p_user_data;
+    dev_draw(p_data->p_projection_matrix, p_data->p_view_matrix, p_data->delta_seconds);
+}
+
+void mesh_id_pass(struct gl_frame_graph* p_graph, void* p_user_data) {
+    const struct frame_pass_data* p_data = p_user_data;
+    dev_capture_target_mesh(p_data->framebuffer_size[0], p_data->framebuffer_size[1], p_data->p_projection_matrix, p_data->p_view_matrix);
+}
+
+void screen_pass(struct gl_frame_graph* p_graph, void* p_user_data) {
+    const struct frame_pass_data* p_data = p_user_data;
+
+    // The triangle covers every pixel, so nothing is cleared for it and nothing needs testing against
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(p_data->gl_screen_program);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, gl_frame_graph_get_texture(p_graph, p_data->color));
+    glBindVertexArray(p_data->gl_empty_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+int compare_frame_times(const void* p_a, const void* p_b) {
+    const double a = *(const double*)p_a;
+    const double b = *(const double*)p_b;
+    return (a > b) - (a < b);
+}
+
+void log_frame_times(const struct darr* p_frame_times) {
+    const size_t n = p_frame_times->_length;
+
+    if (n == 0) {
+        return;
+    }
+
+    double* p_sorted = malloc(sizeof(double) * n);
+    memcpy(p_sorted, p_frame_times->_p_buffer, sizeof(double) * n);
+    qsort(p_sorted, n, sizeof(double), compare_frame_times);
+
+    double total = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        total += p_sorted[i];
+    }
+
+    cx_log_fmt(CX_LOG_INFO, "main", "%u frames, CPU ms: mean=%.3f min=%.3f median=%.3f p95=%.3f p99=%.3f max=%.3f (first frame %.3f)\n",
+        (unsigned int)n, total / n * 1000.0, p_sorted[0] * 1000.0, p_sorted[n / 2] * 1000.0, p_sorted[n * 95 / 100] * 1000.0, p_sorted[n * 99 / 100] * 1000.0, p_sorted[n - 1] * 1000.0, ((const double*)p_frame_times->_p_buffer)[0] * 1000.0);
+
+    free(p_sorted);
+}
+
+void run_entity_benchmark(size_t num_entities) {
+    struct scene scene;
+    scene_init(&scene);
+
+    struct scene_entity** pp_entities = malloc(sizeof(struct scene_entity*) * num_entities);
+    scene_entity_id* p_ids = malloc(sizeof(scene_entity_id) * num_entities);
+
+    double start = platform_time_seconds();
+    num_entities = scene_new_entities(&scene, num_entities, pp_entities);
+    scene_update_transforms(&scene);
+    const double create_seconds = platform_time_seconds() - start;
+
+    for (size_t i = 0; i < num_entities; ++i) {
+        p_ids[i] = pp_entities[i]->_id;
+    }
+
+    // Shuffled with a fixed seed, so every run looks up and destroys in the same order. Two rand() calls cover more
+    // than RAND_MAX ids where it's only 15 bits.
+    srand(117);
+    for (size_t i = num_entities; i-- > 1;) {
+        const size_t j = ((size_t)rand() * ((size_t)RAND_MAX + 1) + (size_t)rand()) % (i + 1);
+        const scene_entity_id id = p_ids[i];
+        p_ids[i] = p_ids[j];
+        p_ids[j] = id;
+    }
+
+    start = platform_time_seconds();
+    size_t num_found = 0;
+    for (size_t i = 0; i < num_entities; ++i) {
+        num_found += scene_get_entity(&scene, p_ids[i]) != 0;
+    }
+    const double lookup_seconds = platform_time_seconds() - start;
+
+    start = platform_time_seconds();
+    scene_destroy_entities(&scene, p_ids, num_entities);
+    scene_update_transforms(&scene);
+    const double destroy_seconds = platform_time_seconds() - start;
+
+    cx_log_fmt(CX_LOG_INFO, "main", "%u entities: create %.3f ms, lookup %.1f ns per id (%u found), destroy in random order %.3f ms\n",
+        (unsigned int)num_entities, create_seconds * 1000.0, num_entities ? lookup_seconds * 1e9 / num_entities : 0.0, (unsigned int)num_found, destroy_seconds * 1000.0);
+
+    free(pp_entities);
+    free(p_ids);
+    scene_destroy(&scene);
 }
\ No newline at end of file
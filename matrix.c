@@ -2,8 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "logging.h"
 #include "math_utils.h"
 #include "matrix.h"
+#include "matrix_simd.h"
 #include "vector.h"
 
 // Note: matrices are expected in column-major order
@@ -11,6 +13,95 @@
 #define MAT_ELEM(MAT, N, COL, ROW) (MAT[((N)*(COL))+(ROW)])
 #define MAT4_ELEM(MAT, COL, ROW) MAT_ELEM(MAT, 4, COL, ROW)
 
+#define CX_LOG_CAT_MATRIX "matrix"
+
+static void   matrix_scalar_multiply(const float* p_m1, const float* p_m2, float* p_result);
+static void   matrix_scalar_multiply_vec4(const float* p_m, const float* p_v, float* p_result);
+static void   matrix_scalar_multiply_vec3(const float* p_m, const float* p_v, float* p_result);
+static int    matrix_scalar_inverse_4(const float* p_m, float* p_result);
+static int    matrix_scalar_inverse_affine(const float* p_m, float* p_result);
+static void   matrix_scalar_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n);
+static void   matrix_scalar_transform_aabbs(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n);
+static size_t matrix_scalar_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible);
+static void   quaternion_scalar_multiply(const float* p_q1, const float* p_q2, float* p_result);
+static void   quaternion_scalar_rotate_vec3(const float* p_q, const float* p_v, float* p_result);
+
+#define MATRIX_SCALAR_KERNELS {       \
+    matrix_scalar_multiply,           \
+    matrix_scalar_multiply_vec4,      \
+    matrix_scalar_multiply_vec3,      \
+    matrix_scalar_inverse_4,          \
+    matrix_scalar_inverse_affine,     \
+    matrix_scalar_transform_points,   \
+    matrix_scalar_transform_aabbs,    \
+    matrix_scalar_frustum_cull_aabbs, \
+    quaternion_scalar_multiply,       \
+    quaternion_scalar_rotate_vec3     \
+}
+
+/* Kernels for the hot 4x4 and quaternion operations. Starts out scalar so everything works before (or without)
+ * matrix_select_isa being called. */
+static struct matrix_kernels {
+    void   (*f_multiply)(const float*, const float*, float*);
+    void   (*f_multiply_vec4)(const float*, const float*, float*);
+    void   (*f_multiply_vec3)(const float*, const float*, float*);
+    int    (*f_inverse_4)(const float*, float*);
+    int    (*f_inverse_affine)(const float*, float*);
+    void   (*f_transform_points)(const float*, const void*, size_t, void*, size_t);
+    void   (*f_transform_aabbs)(const float*, const void*, size_t, void*, size_t);
+    size_t (*f_frustum_cull_aabbs)(const float*, const void*, size_t, size_t, uint32_t*);
+    void   (*f_quaternion_multiply)(const float*, const float*, float*);
+    void   (*f_quaternion_rotate_vec3)(const float*, const float*, float*);
+} g_matrix_kernels = MATRIX_SCALAR_KERNELS;
+
+enum matrix_isa matrix_select_isa(enum matrix_isa max_isa) {
+    enum matrix_isa isa = MATRIX_ISA_scalar;
+
+#if MATRIX_SIMD_SSE
+    if (max_isa >= MATRIX_ISA_sse) {
+        isa = MATRIX_ISA_sse;
+    }
+#endif
+
+#if MATRIX_SIMD_AVX
+    if (max_isa >= MATRIX_ISA_avx && matrix_avx_supported()) {
+        isa = MATRIX_ISA_avx;
+    }
+#endif
+
+    g_matrix_kernels = (struct matrix_kernels)MATRIX_SCALAR_KERNELS;
+
+#if MATRIX_SIMD_SSE
+    if (isa >= MATRIX_ISA_sse) {
+        g_matrix_kernels = (struct matrix_kernels) {
+            matrix_sse_multiply,
+            matrix_sse_multiply_vec4,
+            matrix_sse_multiply_vec3,
+            matrix_sse_inverse_4,
+            matrix_sse_inverse_affine,
+            matrix_sse_transform_points,
+            matrix_sse_transform_aabbs,
+            matrix_sse_frustum_cull_aabbs,
+            quaternion_sse_multiply,
+            quaternion_sse_rotate_vec3
+        };
+    }
+#endif
+
+#if MATRIX_SIMD_AVX
+    // Only the 4x4 multiply and culling have enough independent work to fill 8-wide registers
+    if (isa >= MATRIX_ISA_avx) {
+        g_matrix_kernels.f_multiply = matrix_avx_multiply;
+        g_matrix_kernels.f_frustum_cull_aabbs = matrix_avx_frustum_cull_aabbs;
+    }
+#endif
+
+    static const char* const s_isa_names[] = { "scalar", "sse", "avx" };
+    cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_MATRIX, "Using %s matrix kernels\n", s_isa_names[isa]);
+
+    return isa;
+}
+
 void matrix_copy(const float* p_m, float* p_result) {
     memcpy(p_result, p_m, sizeof(*p_m) * 16);
 }
@@ -98,6 +189,15 @@ void matrix_make_rotation_from_quaternion(const float* p_quaternion, float* p_re
     p_result[15] = 1.f;
 }
 
+void matrix_make_trs(const float* p_t, const float* p_r, const float* p_s, float* p_result) {
+    // T * R * S without the generic multiplies: the rotation's columns scaled, then the translation
+    matrix_make_rotation_from_quaternion(p_r, p_result);
+    vec3_mul_s(&p_result[0], p_s[0], &p_result[0]);
+    vec3_mul_s(&p_result[4], p_s[1], &p_result[4]);
+    vec3_mul_s(&p_result[8], p_s[2], &p_result[8]);
+    vec3_set(p_t, &p_result[12]);
+}
+
 void matrix_make_orthographic_projection(float left, float right, float top, float bottom, float n, float f, float* p_result) {
     const float width = right - left;
 	const float height = top - bottom;
@@ -175,6 +275,18 @@ void matrix_make_lookat(const float* p_pos, const float* p_target, const float*
 }
 
 void matrix_multiply(const float* p_m1, const float* p_m2, float* p_result) {
+    g_matrix_kernels.f_multiply(p_m1, p_m2, p_result);
+}
+
+void matrix_multiply_vec4(const float* p_m, const float* p_v, float* p_result) {
+    g_matrix_kernels.f_multiply_vec4(p_m, p_v, p_result);
+}
+
+void matrix_multiply_vec3(const float* p_m, const float* p_v, float* p_result) {
+    g_matrix_kernels.f_multiply_vec3(p_m, p_v, p_result);
+}
+
+void matrix_scalar_multiply(const float* p_m1, const float* p_m2, float* p_result) {
     float result[16] = {0};
     for (int n = 0; n < 4; ++n) {
         for (int m = 0; m < 4; ++m) {
@@ -186,7 +298,7 @@ void matrix_multiply(const float* p_m1, const float* p_m2, float* p_result) {
     memcpy(p_result, result, sizeof(*result) * 16);
 }
 
-void matrix_multiply_vec4(const float* p_m, const float* p_v, float* p_result) {
+void matrix_scalar_multiply_vec4(const float* p_m, const float* p_v, float* p_result) {
     float result[] = {
         MAT4_ELEM(p_m, 0, 0) * p_v[0] +
         MAT4_ELEM(p_m, 1, 0) * p_v[1] +
@@ -214,7 +326,7 @@ void matrix_multiply_vec4(const float* p_m, const float* p_v, float* p_result) {
     p_result[3] = result[3];
 }
 
-void matrix_multiply_vec3(const float* p_m, const float* p_v, float* p_result) {
+void matrix_scalar_multiply_vec3(const float* p_m, const float* p_v, float* p_result) {
     float result[] = {
         MAT4_ELEM(p_m, 0, 0) * p_v[0] +
         MAT4_ELEM(p_m, 1, 0) * p_v[1] +
@@ -236,6 +348,77 @@ void matrix_multiply_vec3(const float* p_m, const float* p_v, float* p_result) {
     p_result[2] = result[2];
 }
 
+void matrix_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n) {
+    g_matrix_kernels.f_transform_points(p_m, p_src, stride ? stride : sizeof(float) * 3, p_dst, n);
+}
+
+void matrix_transform_aabb(const float* p_m, const float* p_min, const float* p_max, float* p_result_min, float* p_result_max) {
+    float aabb[6];
+    vec3_set(p_min, &aabb[0]);
+    vec3_set(p_max, &aabb[3]);
+    g_matrix_kernels.f_transform_aabbs(p_m, aabb, sizeof(aabb), aabb, 1);
+    vec3_set(&aabb[0], p_result_min);
+    vec3_set(&aabb[3], p_result_max);
+}
+
+size_t matrix_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible) {
+    return g_matrix_kernels.f_frustum_cull_aabbs(p_planes, p_aabbs, stride ? stride : sizeof(float) * 6, n, p_visible);
+}
+
+void matrix_scalar_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n) {
+    const char* p_src_bytes = p_src;
+    char* p_dst_bytes = p_dst;
+    for (size_t i = 0; i < n; ++i) {
+        matrix_scalar_multiply_vec3(p_m, (const float*)(p_src_bytes + i * stride), (float*)(p_dst_bytes + i * stride));
+    }
+}
+
+void matrix_scalar_transform_aabbs(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n) {
+    // Bounds of the transformed box, from the translation plus each axis' smallest/largest contribution (Arvo)
+    const char* p_src_bytes = p_src;
+    char* p_dst_bytes = p_dst;
+    for (size_t a = 0; a < n; ++a) {
+        const float* p_aabb = (const float*)(p_src_bytes + a * stride);
+        float result[6];
+
+        for (int i = 0; i < 3; ++i) {
+            result[i] = result[i + 3] = p_m[12 + i];
+            for (int j = 0; j < 3; ++j) {
+                const float e = MAT4_ELEM(p_m, j, i) * p_aabb[j];
+                const float f = MAT4_ELEM(p_m, j, i) * p_aabb[j + 3];
+                result[i] += fminf(e, f);
+                result[i + 3] += fmaxf(e, f);
+            }
+        }
+
+        memcpy(p_dst_bytes + a * stride, result, sizeof(result));
+    }
+}
+
+size_t matrix_scalar_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible) {
+    // A box is outside if its corner furthest along some plane's normal is still behind that plane
+    const char* p_bytes = p_aabbs;
+    size_t num_visible = 0;
+
+    for (size_t a = 0; a < n; ++a) {
+        const float* p_aabb = (const float*)(p_bytes + a * stride);
+        int b_visible = 1;
+
+        for (size_t i = 0; i < 6 && b_visible; ++i) {
+            const float* p_plane = &p_planes[i * 4];
+            const float x = p_plane[0] >= 0 ? p_aabb[3] : p_aabb[0];
+            const float y = p_plane[1] >= 0 ? p_aabb[4] : p_aabb[1];
+            const float z = p_plane[2] >= 0 ? p_aabb[5] : p_aabb[2];
+            b_visible = p_plane[0] * x + p_plane[1] * y + p_plane[2] * z + p_plane[3] >= 0;
+        }
+
+        p_visible[num_visible] = (uint32_t)a;
+        num_visible += b_visible;
+    }
+
+    return num_visible;
+}
+
 void matrix_decompose_trs(const float* p_m, float* p_t, float* p_r, float* p_s) {
     vec3_set(&p_m[12], p_t);
 
@@ -248,6 +431,24 @@ void matrix_decompose_trs(const float* p_m, float* p_t, float* p_r, float* p_s)
     quaternion_identity(p_r);
 }
 
+void matrix_frustum_planes(const float* p_m, float* p_planes) {
+    // Gribb-Hartmann: each clip plane is the w row plus or minus the x, y or z row of the view projection
+    for (size_t i = 0; i < 6; ++i) {
+        const size_t row = i / 2;
+        const float sign = (i % 2) ? -1.0f : 1.0f;
+        float* p_plane = &p_planes[i * 4];
+
+        for (size_t j = 0; j < 4; ++j) {
+            p_plane[j] = p_m[j * 4 + 3] + sign * p_m[j * 4 + row];
+        }
+
+        const float len = vec3_len(p_plane);
+        if (len > 0) {
+            vec_mul_s(4, p_plane, 1.0f / len, p_plane);
+        }
+    }
+}
+
 float matrix_determinant(size_t n, const float* p_m) {
     if (n == 0) {
         return 1;
@@ -261,6 +462,20 @@ float matrix_determinant(size_t n, const float* p_m) {
         return p_m[0] * p_m[3] - p_m[2] * p_m[1];
     }
 
+    if (n == 4) {
+        // Same terms as matrix_scalar_inverse_4: (a x b).v + (c x d).u
+        float s[3], t[3], u[3], v[3], temp[3];
+        vec3_cross(&p_m[0], &p_m[4], s);
+        vec3_cross(&p_m[8], &p_m[12], t);
+        vec3_mul_s(&p_m[0], p_m[7], u);
+        vec3_mul_s(&p_m[4], p_m[3], temp);
+        vec3_sub(u, temp, u);
+        vec3_mul_s(&p_m[8], p_m[15], v);
+        vec3_mul_s(&p_m[12], p_m[11], temp);
+        vec3_sub(v, temp, v);
+        return vec3_dot(s, v) + vec3_dot(t, u);
+    }
+
     float subm[16];
 
     float result = 0;
@@ -317,13 +532,18 @@ void matrix_cofactor(size_t n, const float* p_m, float* p_result) {
                 }
                 ++p;
             }
-            MAT_ELEM(result, n, i, j) = powf(-1, i + j) * matrix_determinant(n - 1, subm);
+            MAT_ELEM(result, n, i, j) = ((i + j) & 1 ? -1 : 1) * matrix_determinant(n - 1, subm);
         }
     }
     memcpy(p_result, result, sizeof(*result) * n * n);
 }
 
 void matrix_inverse(size_t n, const float* p_m, float* p_result) {
+    if (n == 4) {
+        g_matrix_kernels.f_inverse_4(p_m, p_result);
+        return;
+    }
+
     const float d = matrix_determinant(n, p_m);
 
     if (FLT_CMP(d, 0)) {
@@ -337,6 +557,103 @@ void matrix_inverse(size_t n, const float* p_m, float* p_result) {
     matrix_multiply_s(n, n, p_result, dinv, p_result);
 }
 
+void matrix_inverse_affine(const float* p_m, float* p_result) {
+    g_matrix_kernels.f_inverse_affine(p_m, p_result);
+}
+
+/* Cramer's rule, written as in Lengyel's FGED vol. 1: with a, b, c, d the upper 3x3 columns and x, y, z, w the bottom
+ * row, the adjugate falls out of four cross products and a handful of dots. */
+int matrix_scalar_inverse_4(const float* p_m, float* p_result) {
+    const float* a = &p_m[0];
+    const float* b = &p_m[4];
+    const float* c = &p_m[8];
+    const float* d = &p_m[12];
+    const float x = p_m[3];
+    const float y = p_m[7];
+    const float z = p_m[11];
+    const float w = p_m[15];
+
+    float s[3], t[3], u[3], v[3], temp[3];
+    vec3_cross(a, b, s);
+    vec3_cross(c, d, t);
+    vec3_mul_s(a, y, u);
+    vec3_mul_s(b, x, temp);
+    vec3_sub(u, temp, u);
+    vec3_mul_s(c, w, v);
+    vec3_mul_s(d, z, temp);
+    vec3_sub(v, temp, v);
+
+    const float det = vec3_dot(s, v) + vec3_dot(t, u);
+    if (fabsf(det) < FLT_MIN) {
+        return 0;
+    }
+
+    const float inv_det = 1 / det;
+    vec3_mul_s(s, inv_det, s);
+    vec3_mul_s(t, inv_det, t);
+    vec3_mul_s(u, inv_det, u);
+    vec3_mul_s(v, inv_det, v);
+
+    // Rows of the inverse
+    float r[4][4];
+    vec3_cross(b, v, r[0]);
+    vec3_mul_s(t, y, temp);
+    vec3_add(r[0], temp, r[0]);
+    r[0][3] = -vec3_dot(b, t);
+
+    vec3_cross(v, a, r[1]);
+    vec3_mul_s(t, x, temp);
+    vec3_sub(r[1], temp, r[1]);
+    r[1][3] = vec3_dot(a, t);
+
+    vec3_cross(d, u, r[2]);
+    vec3_mul_s(s, w, temp);
+    vec3_add(r[2], temp, r[2]);
+    r[2][3] = -vec3_dot(d, s);
+
+    vec3_cross(u, c, r[3]);
+    vec3_mul_s(s, z, temp);
+    vec3_sub(r[3], temp, r[3]);
+    r[3][3] = vec3_dot(c, s);
+
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            MAT4_ELEM(p_result, col, row) = r[row][col];
+        }
+    }
+
+    return 1;
+}
+
+int matrix_scalar_inverse_affine(const float* p_m, float* p_result) {
+    // Rows of the 3x3 inverse are the cross products of pairs of columns, over the determinant
+    float r[3][3];
+    vec3_cross(&p_m[4], &p_m[8], r[0]);
+    vec3_cross(&p_m[8], &p_m[0], r[1]);
+    vec3_cross(&p_m[0], &p_m[4], r[2]);
+
+    const float det = vec3_dot(&p_m[0], r[0]);
+    if (fabsf(det) < FLT_MIN) {
+        return 0;
+    }
+
+    const float inv_det = 1 / det;
+    const float t[3] = { p_m[12], p_m[13], p_m[14] };
+
+    for (int row = 0; row < 3; ++row) {
+        vec3_mul_s(r[row], inv_det, r[row]);
+        MAT4_ELEM(p_result, 0, row) = r[row][0];
+        MAT4_ELEM(p_result, 1, row) = r[row][1];
+        MAT4_ELEM(p_result, 2, row) = r[row][2];
+        MAT4_ELEM(p_result, 3, row) = -vec3_dot(r[row], t);
+    }
+
+    p_result[3] = p_result[7] = p_result[11] = 0;
+    p_result[15] = 1;
+
+    return 1;
+}
+
 void matrix_add(size_t n, size_t m, const float* p_m1, const float* p_m2, float* p_result) {
     for (size_t ni = 0; ni < n; ++ni) {
         for (size_t mi = 0; mi < m; ++mi) {
@@ -375,6 +692,14 @@ void quaternion_from_axis_angle(const float* p_axis, float angle, float* p_resul
 }
 
 void quaternion_multiply(const float* p_q1, const float* p_q2, float* p_result) {
+    g_matrix_kernels.f_quaternion_multiply(p_q1, p_q2, p_result);
+}
+
+void quaternion_rotate_vec3(const float* p_q, const float* p_v, float* p_result) {
+    g_matrix_kernels.f_quaternion_rotate_vec3(p_q, p_v, p_result);
+}
+
+void quaternion_scalar_multiply(const float* p_q1, const float* p_q2, float* p_result) {
     float result[4];
     result[0] = p_q1[3] * p_q2[0] + p_q1[0] * p_q2[3] + p_q1[1] * p_q2[2] - p_q1[2] * p_q2[1];
     result[1] = p_q1[3] * p_q2[1] - p_q1[0] * p_q2[2] + p_q1[1] * p_q2[3] + p_q1[2] * p_q2[0];
@@ -386,17 +711,21 @@ void quaternion_multiply(const float* p_q1, const float* p_q2, float* p_result)
     p_result[3] = result[3];
 }
 
-void quaternion_rotate_vec3(const float* p_q, const float* p_v, float* p_result) {
+void quaternion_scalar_rotate_vec3(const float* p_q, const float* p_v, float* p_result) {
+    // p_result may alias p_v, which is still needed after p_result is first written
+    float v[3];
+    vec3_set(p_v, v);
+
     float temp[3];
     
-    vec3_mul_s(p_v, p_q[3] * p_q[3] - vec3_dot(p_q, p_q), temp);
+    vec3_mul_s(v, p_q[3] * p_q[3] - vec3_dot(p_q, p_q), temp);
 
-    vec3_cross(p_q, p_v, p_result);
+    vec3_cross(p_q, v, p_result);
     vec3_mul_s(p_result, 2 * p_q[3], p_result);
 
     vec3_add(temp, p_result, p_result);
     
-    vec3_mul_s(p_q, 2 * vec3_dot(p_q, p_v), temp);
+    vec3_mul_s(p_q, 2 * vec3_dot(p_q, v), temp);
     
     vec3_add(temp, p_result, p_result);
 }
\ No newline at end of file
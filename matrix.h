@@ -1,8 +1,18 @@
 #ifndef _H__MATRIX
 #define _H__MATRIX
 
+#include <stddef.h>
 #include <stdint.h>
 
+enum matrix_isa {
+    MATRIX_ISA_scalar,
+    MATRIX_ISA_sse,
+    MATRIX_ISA_avx
+};
+
+// Picks the fastest kernels the CPU supports, up to max_isa. Until this is called the scalar kernels are used.
+enum matrix_isa matrix_select_isa(enum matrix_isa max_isa);
+
 void matrix_copy(const float* p_m, float* p_result);
 void matrix_make_identity(float* p_result);
 void matrix_make_translation(float t_x, float t_y, float t_z, float* p_result);
@@ -12,6 +22,7 @@ void matrix_make_rotation_x(float r, float* p_result);
 void matrix_make_rotation_y(float r, float* p_result);
 void matrix_make_rotation_z(float r, float* p_result);
 void matrix_make_rotation_from_quaternion(const float* p_quaternion, float* p_result);
+void matrix_make_trs(const float* p_t, const float* p_r, const float* p_s, float* p_result);
 void matrix_make_orthographic_projection(float left, float right, float top, float bottom, float n, float f, float* p_result);
 void matrix_make_perspective_projection(float vfov, float aspect, float n, float f, float* p_result);
 void matrix_make_lookat(const float* p_pos, const float* p_target, const float* p_up, float* p_result);
@@ -19,11 +30,21 @@ void matrix_multiply(const float* p_m1, const float* p_m2, float* p_result);
 void matrix_multiply_vec4(const float* p_m, const float* p_v, float* p_result);
 void matrix_multiply_vec3(const float* p_m, const float* p_v, float* p_result);
 void matrix_decompose_trs(const float* p_m, float* p_t, float* p_r, float* p_s);
+void matrix_frustum_planes(const float* p_m, float* p_planes); // 6 normalised (a, b, c, d) from a view projection, inside where ax + by + cz + d >= 0
+
+/* Batched versions of the above for bulk geometry. Strided arrays are read and written every stride bytes, with 0
+ * meaning tightly packed, so vertex positions can be transformed in place inside interleaved buffers. */
+void matrix_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n);
+void matrix_transform_aabb(const float* p_m, const float* p_min, const float* p_max, float* p_result_min, float* p_result_max);
+
+// Writes the indices of the boxes (min[3], max[3]) touching the frustum to p_visible, in order, and returns how many
+size_t matrix_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible);
 
 float matrix_determinant(size_t n, const float* p_m);
 void  matrix_transpose(size_t n, const float* p_m, float* p_result);
 void  matrix_cofactor(size_t n, const float* p_m, float* p_result);
 void  matrix_inverse(size_t n, const float* p_m, float* p_result);
+void  matrix_inverse_affine(const float* p_m, float* p_result); // 4x4 with a bottom row of (0, 0, 0, 1)
 
 void matrix_add(size_t n, size_t m, const float* p_m1, const float* p_m2, float* p_result);
 void matrix_multiply_s(size_t n, size_t m, const float* p_m1, float s, float* p_result);
@@ -0,0 +1,441 @@
+#include <float.h>
+#include <math.h>
+
+#include "matrix_simd.h"
+
+#if MATRIX_SIMD_SSE
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define MATRIX_SIMD_TARGET_AVX __attribute__((target("avx")))
+#else
+#define MATRIX_SIMD_TARGET_AVX
+#endif
+
+#define SSE_SWIZZLE(V, X, Y, Z, W) _mm_shuffle_ps(V, V, _MM_SHUFFLE(W, Z, Y, X))
+
+/* Helpers are macros rather than functions so that unoptimised builds, which don't inline, don't spill every __m128
+ * argument to the stack */
+#define SSE_MASK_XYZ() _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))
+#define SSE_SIGN_W()   _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, 0, 0, 0))
+
+#define SSE_LOAD_VEC3(P_V) _mm_set_ps(0, (P_V)[2], (P_V)[1], (P_V)[0])
+
+// The w lanes cancel to zero, so crosses of vectors with w = 0 stay that way
+#define SSE_CROSS(A, B) _mm_sub_ps(                                     \
+    _mm_mul_ps(SSE_SWIZZLE(A, 1, 2, 0, 3), SSE_SWIZZLE(B, 2, 0, 1, 3)), \
+    _mm_mul_ps(SSE_SWIZZLE(A, 2, 0, 1, 3), SSE_SWIZZLE(B, 1, 2, 0, 3)))
+
+// Sum of the four lanes, broadcast to all lanes; pass a variable, not an expression, as it is evaluated four times
+#define SSE_HSUM(M) _mm_add_ps(                                         \
+    _mm_add_ps(M, SSE_SWIZZLE(M, 1, 0, 3, 2)),                          \
+    _mm_add_ps(SSE_SWIZZLE(M, 2, 3, 0, 1), SSE_SWIZZLE(M, 3, 2, 1, 0)))
+
+#define SSE_STORE_VEC3(V, P_RESULT) do {                      \
+    _mm_storel_pi((__m64*)(P_RESULT), V);                       \
+    _mm_store_ss(&(P_RESULT)[2], _mm_movehl_ps(V, V));          \
+} while (0)
+
+static void sse_store_vec3(__m128 v, float* p_result);
+
+void sse_store_vec3(__m128 v, float* p_result) {
+    SSE_STORE_VEC3(v, p_result);
+}
+
+void matrix_sse_multiply(const float* p_m1, const float* p_m2, float* p_result) {
+    const __m128 a0 = _mm_loadu_ps(&p_m1[ 0]);
+    const __m128 a1 = _mm_loadu_ps(&p_m1[ 4]);
+    const __m128 a2 = _mm_loadu_ps(&p_m1[ 8]);
+    const __m128 a3 = _mm_loadu_ps(&p_m1[12]);
+
+    __m128 result[4];
+    for (int c = 0; c < 4; ++c) {
+        const __m128 b = _mm_loadu_ps(&p_m2[c * 4]);
+        result[c] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, SSE_SWIZZLE(b, 0, 0, 0, 0)), _mm_mul_ps(a1, SSE_SWIZZLE(b, 1, 1, 1, 1))),
+            _mm_add_ps(_mm_mul_ps(a2, SSE_SWIZZLE(b, 2, 2, 2, 2)), _mm_mul_ps(a3, SSE_SWIZZLE(b, 3, 3, 3, 3))));
+    }
+
+    _mm_storeu_ps(&p_result[ 0], result[0]);
+    _mm_storeu_ps(&p_result[ 4], result[1]);
+    _mm_storeu_ps(&p_result[ 8], result[2]);
+    _mm_storeu_ps(&p_result[12], result[3]);
+}
+
+void matrix_sse_multiply_vec4(const float* p_m, const float* p_v, float* p_result) {
+    const __m128 v = _mm_loadu_ps(p_v);
+    const __m128 result = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p_m[0]), SSE_SWIZZLE(v, 0, 0, 0, 0)), _mm_mul_ps(_mm_loadu_ps(&p_m[ 4]), SSE_SWIZZLE(v, 1, 1, 1, 1))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p_m[8]), SSE_SWIZZLE(v, 2, 2, 2, 2)), _mm_mul_ps(_mm_loadu_ps(&p_m[12]), SSE_SWIZZLE(v, 3, 3, 3, 3))));
+    _mm_storeu_ps(p_result, result);
+}
+
+void matrix_sse_multiply_vec3(const float* p_m, const float* p_v, float* p_result) {
+    const __m128 result = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p_m[0]), _mm_set1_ps(p_v[0])), _mm_mul_ps(_mm_loadu_ps(&p_m[4]), _mm_set1_ps(p_v[1]))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&p_m[8]), _mm_set1_ps(p_v[2])), _mm_loadu_ps(&p_m[12])));
+    sse_store_vec3(result, p_result);
+}
+
+// Four points at a time, transposed so each register holds one coordinate of all four
+void matrix_sse_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n) {
+    const __m128 m00 = _mm_set1_ps(p_m[0]), m01 = _mm_set1_ps(p_m[4]), m02 = _mm_set1_ps(p_m[ 8]), m03 = _mm_set1_ps(p_m[12]);
+    const __m128 m10 = _mm_set1_ps(p_m[1]), m11 = _mm_set1_ps(p_m[5]), m12 = _mm_set1_ps(p_m[ 9]), m13 = _mm_set1_ps(p_m[13]);
+    const __m128 m20 = _mm_set1_ps(p_m[2]), m21 = _mm_set1_ps(p_m[6]), m22 = _mm_set1_ps(p_m[10]), m23 = _mm_set1_ps(p_m[14]);
+
+    const char* p_src_bytes = p_src;
+    char* p_dst_bytes = p_dst;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float* p_v0 = (const float*)(p_src_bytes + (i + 0) * stride);
+        const float* p_v1 = (const float*)(p_src_bytes + (i + 1) * stride);
+        const float* p_v2 = (const float*)(p_src_bytes + (i + 2) * stride);
+        const float* p_v3 = (const float*)(p_src_bytes + (i + 3) * stride);
+        const __m128 x = _mm_setr_ps(p_v0[0], p_v1[0], p_v2[0], p_v3[0]);
+        const __m128 y = _mm_setr_ps(p_v0[1], p_v1[1], p_v2[1], p_v3[1]);
+        const __m128 z = _mm_setr_ps(p_v0[2], p_v1[2], p_v2[2], p_v3[2]);
+
+        float result[3][4];
+        _mm_storeu_ps(result[0], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_add_ps(_mm_mul_ps(m02, z), m03)));
+        _mm_storeu_ps(result[1], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m12, z), m13)));
+        _mm_storeu_ps(result[2], _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), _mm_add_ps(_mm_mul_ps(m22, z), m23)));
+
+        for (int j = 0; j < 4; ++j) {
+            float* p_result = (float*)(p_dst_bytes + (i + j) * stride);
+            p_result[0] = result[0][j];
+            p_result[1] = result[1][j];
+            p_result[2] = result[2][j];
+        }
+    }
+
+    for (; i < n; ++i) {
+        matrix_sse_multiply_vec3(p_m, (const float*)(p_src_bytes + i * stride), (float*)(p_dst_bytes + i * stride));
+    }
+}
+
+// Center/extent form: the center transforms as a point, the extent by the absolute value of the 3x3
+void matrix_sse_transform_aabbs(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 c0 = _mm_loadu_ps(&p_m[ 0]);
+    const __m128 c1 = _mm_loadu_ps(&p_m[ 4]);
+    const __m128 c2 = _mm_loadu_ps(&p_m[ 8]);
+    const __m128 c3 = _mm_loadu_ps(&p_m[12]);
+    const __m128 a0 = _mm_and_ps(c0, abs_mask);
+    const __m128 a1 = _mm_and_ps(c1, abs_mask);
+    const __m128 a2 = _mm_and_ps(c2, abs_mask);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    const char* p_src_bytes = p_src;
+    char* p_dst_bytes = p_dst;
+    for (size_t i = 0; i < n; ++i) {
+        const float* p_aabb = (const float*)(p_src_bytes + i * stride);
+        const __m128 min = _mm_loadu_ps(p_aabb);
+        const __m128 max = _mm_set_ps(0, p_aabb[5], p_aabb[4], p_aabb[3]);
+        const __m128 center = _mm_mul_ps(_mm_add_ps(min, max), half);
+        const __m128 extent = _mm_mul_ps(_mm_sub_ps(max, min), half);
+
+        const __m128 world_center = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(c0, SSE_SWIZZLE(center, 0, 0, 0, 0)), _mm_mul_ps(c1, SSE_SWIZZLE(center, 1, 1, 1, 1))),
+            _mm_add_ps(_mm_mul_ps(c2, SSE_SWIZZLE(center, 2, 2, 2, 2)), c3));
+        const __m128 world_extent = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, SSE_SWIZZLE(extent, 0, 0, 0, 0)), _mm_mul_ps(a1, SSE_SWIZZLE(extent, 1, 1, 1, 1))),
+            _mm_mul_ps(a2, SSE_SWIZZLE(extent, 2, 2, 2, 2)));
+
+        float* p_result = (float*)(p_dst_bytes + i * stride);
+        const __m128 result_min = _mm_sub_ps(world_center, world_extent);
+        const __m128 result_max = _mm_add_ps(world_center, world_extent);
+        SSE_STORE_VEC3(result_min, &p_result[0]);
+        SSE_STORE_VEC3(result_max, &p_result[3]);
+    }
+}
+
+/* Four boxes at a time, transposed so each register holds one bound of all four. A plane's sign is the same for every
+ * lane, so its furthest corner is picked per plane rather than per box. */
+size_t matrix_sse_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible) {
+    const char* p_bytes = p_aabbs;
+    size_t num_visible = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        const float* p_a0 = (const float*)(p_bytes + (i + 0) * stride);
+        const float* p_a1 = (const float*)(p_bytes + (i + 1) * stride);
+        const float* p_a2 = (const float*)(p_bytes + (i + 2) * stride);
+        const float* p_a3 = (const float*)(p_bytes + (i + 3) * stride);
+        __m128 bounds[6];
+
+        for (int j = 0; j < 6; ++j) {
+            bounds[j] = _mm_setr_ps(p_a0[j], p_a1[j], p_a2[j], p_a3[j]);
+        }
+
+        __m128 outside = _mm_setzero_ps();
+
+        for (int j = 0; j < 6; ++j) {
+            const float* p_plane = &p_planes[j * 4];
+            const __m128 x = p_plane[0] >= 0 ? bounds[3] : bounds[0];
+            const __m128 y = p_plane[1] >= 0 ? bounds[4] : bounds[1];
+            const __m128 z = p_plane[2] >= 0 ? bounds[5] : bounds[2];
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p_plane[0]), x), _mm_mul_ps(_mm_set1_ps(p_plane[1]), y)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p_plane[2]), z), _mm_set1_ps(p_plane[3])));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        const int visible_mask = ~_mm_movemask_ps(outside);
+
+        for (int j = 0; j < 4; ++j) {
+            p_visible[num_visible] = (uint32_t)(i + j);
+            num_visible += (visible_mask >> j) & 1;
+        }
+    }
+
+    for (; i < n; ++i) {
+        const float* p_aabb = (const float*)(p_bytes + i * stride);
+        int b_visible = 1;
+
+        for (int j = 0; j < 6 && b_visible; ++j) {
+            const float* p_plane = &p_planes[j * 4];
+            const float x = p_plane[0] >= 0 ? p_aabb[3] : p_aabb[0];
+            const float y = p_plane[1] >= 0 ? p_aabb[4] : p_aabb[1];
+            const float z = p_plane[2] >= 0 ? p_aabb[5] : p_aabb[2];
+            b_visible = p_plane[0] * x + p_plane[1] * y + p_plane[2] * z + p_plane[3] >= 0;
+        }
+
+        p_visible[num_visible] = (uint32_t)i;
+        num_visible += b_visible;
+    }
+
+    return num_visible;
+}
+
+/* Cramer's rule, written as in Lengyel's FGED vol. 1: with a, b, c, d the upper 3x3 columns and x, y, z, w the bottom
+ * row, the adjugate falls out of four cross products and a handful of dots. */
+int matrix_sse_inverse_4(const float* p_m, float* p_result) {
+    const __m128 mask = SSE_MASK_XYZ();
+    const __m128 c0 = _mm_loadu_ps(&p_m[ 0]);
+    const __m128 c1 = _mm_loadu_ps(&p_m[ 4]);
+    const __m128 c2 = _mm_loadu_ps(&p_m[ 8]);
+    const __m128 c3 = _mm_loadu_ps(&p_m[12]);
+
+    const __m128 a = _mm_and_ps(c0, mask);
+    const __m128 b = _mm_and_ps(c1, mask);
+    const __m128 c = _mm_and_ps(c2, mask);
+    const __m128 d = _mm_and_ps(c3, mask);
+    const __m128 x = SSE_SWIZZLE(c0, 3, 3, 3, 3);
+    const __m128 y = SSE_SWIZZLE(c1, 3, 3, 3, 3);
+    const __m128 z = SSE_SWIZZLE(c2, 3, 3, 3, 3);
+    const __m128 w = SSE_SWIZZLE(c3, 3, 3, 3, 3);
+
+    __m128 s = SSE_CROSS(a, b);
+    __m128 t = SSE_CROSS(c, d);
+    __m128 u = _mm_sub_ps(_mm_mul_ps(a, y), _mm_mul_ps(b, x));
+    __m128 v = _mm_sub_ps(_mm_mul_ps(c, w), _mm_mul_ps(d, z));
+
+    const __m128 det_terms = _mm_add_ps(_mm_mul_ps(s, v), _mm_mul_ps(t, u));
+    const __m128 det = SSE_HSUM(det_terms);
+    if (fabsf(_mm_cvtss_f32(det)) < FLT_MIN) {
+        return 0;
+    }
+
+    const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1), det);
+    s = _mm_mul_ps(s, inv_det);
+    t = _mm_mul_ps(t, inv_det);
+    u = _mm_mul_ps(u, inv_det);
+    v = _mm_mul_ps(v, inv_det);
+
+    // Upper 3x3 of the rows of the inverse, w = 0, transposed into columns
+    __m128 r0 = _mm_add_ps(SSE_CROSS(b, v), _mm_mul_ps(t, y));
+    __m128 r1 = _mm_sub_ps(SSE_CROSS(v, a), _mm_mul_ps(t, x));
+    __m128 r2 = _mm_add_ps(SSE_CROSS(d, u), _mm_mul_ps(s, w));
+    __m128 r3 = _mm_sub_ps(SSE_CROSS(u, c), _mm_mul_ps(s, z));
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    // The last column is (-b.t, a.t, -d.s, c.s): the four dots at once by transposing their products
+    __m128 p0 = _mm_mul_ps(b, t);
+    __m128 p1 = _mm_mul_ps(a, t);
+    __m128 p2 = _mm_mul_ps(d, s);
+    __m128 p3 = _mm_mul_ps(c, s);
+    _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+    const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+    r3 = _mm_xor_ps(_mm_add_ps(_mm_add_ps(p0, p1), p2), sign);
+
+    _mm_storeu_ps(&p_result[ 0], r0);
+    _mm_storeu_ps(&p_result[ 4], r1);
+    _mm_storeu_ps(&p_result[ 8], r2);
+    _mm_storeu_ps(&p_result[12], r3);
+
+    return 1;
+}
+
+int matrix_sse_inverse_affine(const float* p_m, float* p_result) {
+    const __m128 mask = SSE_MASK_XYZ();
+    const __m128 c0 = _mm_and_ps(_mm_loadu_ps(&p_m[ 0]), mask);
+    const __m128 c1 = _mm_and_ps(_mm_loadu_ps(&p_m[ 4]), mask);
+    const __m128 c2 = _mm_and_ps(_mm_loadu_ps(&p_m[ 8]), mask);
+    const __m128 t  = _mm_loadu_ps(&p_m[12]);
+
+    // Rows of the 3x3 inverse are the cross products of pairs of columns, over the determinant
+    __m128 r0 = SSE_CROSS(c1, c2);
+    __m128 r1 = SSE_CROSS(c2, c0);
+    __m128 r2 = SSE_CROSS(c0, c1);
+
+    const __m128 det_terms = _mm_mul_ps(c0, r0);
+    const __m128 det = SSE_HSUM(det_terms);
+    if (fabsf(_mm_cvtss_f32(det)) < FLT_MIN) {
+        return 0;
+    }
+
+    const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1), det);
+    r0 = _mm_mul_ps(r0, inv_det);
+    r1 = _mm_mul_ps(r1, inv_det);
+    r2 = _mm_mul_ps(r2, inv_det);
+    __m128 r3 = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    const __m128 inv_t = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(r0, SSE_SWIZZLE(t, 0, 0, 0, 0)), _mm_mul_ps(r1, SSE_SWIZZLE(t, 1, 1, 1, 1))),
+        _mm_mul_ps(r2, SSE_SWIZZLE(t, 2, 2, 2, 2)));
+
+    _mm_storeu_ps(&p_result[ 0], r0);
+    _mm_storeu_ps(&p_result[ 4], r1);
+    _mm_storeu_ps(&p_result[ 8], r2);
+    _mm_storeu_ps(&p_result[12], _mm_sub_ps(_mm_set_ps(1, 0, 0, 0), inv_t));
+
+    return 1;
+}
+
+void quaternion_sse_multiply(const float* p_q1, const float* p_q2, float* p_result) {
+    const __m128 a = _mm_loadu_ps(p_q1);
+    const __m128 b = _mm_loadu_ps(p_q2);
+    const __m128 sign_w = SSE_SIGN_W();
+
+    const __m128 t0 = _mm_mul_ps(SSE_SWIZZLE(a, 3, 3, 3, 3), b);
+    const __m128 t1 = _mm_mul_ps(SSE_SWIZZLE(a, 0, 1, 2, 0), SSE_SWIZZLE(b, 3, 3, 3, 0));
+    const __m128 t2 = _mm_mul_ps(SSE_SWIZZLE(a, 1, 2, 0, 1), SSE_SWIZZLE(b, 2, 0, 1, 1));
+    const __m128 t3 = _mm_mul_ps(SSE_SWIZZLE(a, 2, 0, 1, 2), SSE_SWIZZLE(b, 1, 2, 0, 2));
+
+    _mm_storeu_ps(p_result, _mm_sub_ps(_mm_add_ps(t0, _mm_xor_ps(_mm_add_ps(t1, t2), sign_w)), t3));
+}
+
+void quaternion_sse_rotate_vec3(const float* p_q, const float* p_v, float* p_result) {
+    const __m128 q = _mm_loadu_ps(p_q);
+    const __m128 u = _mm_and_ps(q, SSE_MASK_XYZ());
+    const __m128 w = SSE_SWIZZLE(q, 3, 3, 3, 3);
+    const __m128 v = SSE_LOAD_VEC3(p_v);
+    const __m128 two_w = _mm_add_ps(w, w);
+
+    // v (w^2 - u.u) + 2w (u x v) + 2u (u.v)
+    const __m128 uu_terms = _mm_mul_ps(u, u);
+    const __m128 uv_terms = _mm_mul_ps(u, v);
+    const __m128 uu = SSE_HSUM(uu_terms);
+    const __m128 uv = SSE_HSUM(uv_terms);
+
+    const __m128 result = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(v, _mm_sub_ps(_mm_mul_ps(w, w), uu)), _mm_mul_ps(SSE_CROSS(u, v), two_w)),
+        _mm_mul_ps(u, _mm_add_ps(uv, uv)));
+    sse_store_vec3(result, p_result);
+}
+
+#endif
+
+#if MATRIX_SIMD_AVX
+
+int matrix_avx_supported(void) {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#else
+    // AVX needs both the instructions (CPUID.1:ECX bit 28) and the OS saving ymm state (OSXSAVE, then XCR0 bits 1-2)
+    int info[4];
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) {
+        return 0;
+    }
+    return (_xgetbv(0) & 6) == 6;
+#endif
+}
+
+/* Two result columns per 8-wide register: each 128-bit half picks its own column's element with an in-lane shuffle.
+ * A0-A3 are the columns of the left matrix, duplicated into both halves. */
+#define AVX_MULTIPLY(A0, A1, A2, A3, P_M2, P_RESULT) do {                                                                   \
+    const __m256 b01 = _mm256_loadu_ps(&(P_M2)[0]);                                                                       \
+    const __m256 b23 = _mm256_loadu_ps(&(P_M2)[8]);                                                                       \
+    const __m256 r01 = _mm256_add_ps(                                                                                     \
+        _mm256_add_ps(_mm256_mul_ps(A0, _mm256_shuffle_ps(b01, b01, 0x00)), _mm256_mul_ps(A1, _mm256_shuffle_ps(b01, b01, 0x55))), \
+        _mm256_add_ps(_mm256_mul_ps(A2, _mm256_shuffle_ps(b01, b01, 0xAA)), _mm256_mul_ps(A3, _mm256_shuffle_ps(b01, b01, 0xFF)))); \
+    const __m256 r23 = _mm256_add_ps(                                                                                     \
+        _mm256_add_ps(_mm256_mul_ps(A0, _mm256_shuffle_ps(b23, b23, 0x00)), _mm256_mul_ps(A1, _mm256_shuffle_ps(b23, b23, 0x55))), \
+        _mm256_add_ps(_mm256_mul_ps(A2, _mm256_shuffle_ps(b23, b23, 0xAA)), _mm256_mul_ps(A3, _mm256_shuffle_ps(b23, b23, 0xFF)))); \
+    _mm256_storeu_ps(&(P_RESULT)[0], r01);                                                                                \
+    _mm256_storeu_ps(&(P_RESULT)[8], r23);                                                                                \
+} while (0)
+
+#define AVX_LOAD_DUPLICATED(P) _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(P)), _mm_loadu_ps(P), 1)
+
+MATRIX_SIMD_TARGET_AVX void matrix_avx_multiply(const float* p_m1, const float* p_m2, float* p_result) {
+    const __m256 a0 = AVX_LOAD_DUPLICATED(&p_m1[ 0]);
+    const __m256 a1 = AVX_LOAD_DUPLICATED(&p_m1[ 4]);
+    const __m256 a2 = AVX_LOAD_DUPLICATED(&p_m1[ 8]);
+    const __m256 a3 = AVX_LOAD_DUPLICATED(&p_m1[12]);
+    AVX_MULTIPLY(a0, a1, a2, a3, p_m2, p_result);
+
+    // Callers run legacy SSE code; clear the upper halves to avoid the transition stall (unoptimised builds don't)
+    _mm256_zeroupper();
+}
+
+// As matrix_sse_frustum_cull_aabbs, eight boxes at a time
+MATRIX_SIMD_TARGET_AVX size_t matrix_avx_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible) {
+    const char* p_bytes = p_aabbs;
+    size_t num_visible = 0;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        const float* pp_aabbs[8];
+        for (int k = 0; k < 8; ++k) {
+            pp_aabbs[k] = (const float*)(p_bytes + (i + k) * stride);
+        }
+
+        __m256 bounds[6];
+
+        for (int j = 0; j < 6; ++j) {
+            bounds[j] = _mm256_setr_ps(pp_aabbs[0][j], pp_aabbs[1][j], pp_aabbs[2][j], pp_aabbs[3][j], pp_aabbs[4][j], pp_aabbs[5][j], pp_aabbs[6][j], pp_aabbs[7][j]);
+        }
+
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int j = 0; j < 6; ++j) {
+            const float* p_plane = &p_planes[j * 4];
+            const __m256 x = p_plane[0] >= 0 ? bounds[3] : bounds[0];
+            const __m256 y = p_plane[1] >= 0 ? bounds[4] : bounds[1];
+            const __m256 z = p_plane[2] >= 0 ? bounds[5] : bounds[2];
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p_plane[0]), x), _mm256_mul_ps(_mm256_set1_ps(p_plane[1]), y)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p_plane[2]), z), _mm256_set1_ps(p_plane[3])));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        const int visible_mask = ~_mm256_movemask_ps(outside);
+
+        for (int j = 0; j < 8; ++j) {
+            p_visible[num_visible] = (uint32_t)(i + j);
+            num_visible += (visible_mask >> j) & 1;
+        }
+    }
+
+    _mm256_zeroupper();
+
+    // The last few go through the SSE path, with their indices offset back into this range
+    const size_t num_tail_visible = matrix_sse_frustum_cull_aabbs(p_planes, p_bytes + i * stride, stride, n - i, &p_visible[num_visible]);
+
+    for (size_t j = 0; j < num_tail_visible; ++j) {
+        p_visible[num_visible + j] += (uint32_t)i;
+    }
+
+    return num_visible + num_tail_visible;
+}
+
+#endif
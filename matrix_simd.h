@@ -0,0 +1,40 @@
+#ifndef _H__MATRIX_SIMD
+#define _H__MATRIX_SIMD
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SSE/AVX kernels behind matrix.h; matrix.c picks between these and its scalar versions at runtime
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_SIMD_SSE 1
+#else
+#define MATRIX_SIMD_SSE 0
+#endif
+
+#if MATRIX_SIMD_SSE && (defined(__GNUC__) || defined(_MSC_VER))
+#define MATRIX_SIMD_AVX 1
+#else
+#define MATRIX_SIMD_AVX 0
+#endif
+
+#if MATRIX_SIMD_SSE
+void   matrix_sse_multiply(const float* p_m1, const float* p_m2, float* p_result);
+void   matrix_sse_multiply_vec4(const float* p_m, const float* p_v, float* p_result);
+void   matrix_sse_multiply_vec3(const float* p_m, const float* p_v, float* p_result);
+int    matrix_sse_inverse_4(const float* p_m, float* p_result);
+int    matrix_sse_inverse_affine(const float* p_m, float* p_result);
+void   matrix_sse_transform_points(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n);
+void   matrix_sse_transform_aabbs(const float* p_m, const void* p_src, size_t stride, void* p_dst, size_t n);
+size_t matrix_sse_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible);
+void   quaternion_sse_multiply(const float* p_q1, const float* p_q2, float* p_result);
+void   quaternion_sse_rotate_vec3(const float* p_q, const float* p_v, float* p_result);
+#endif
+
+#if MATRIX_SIMD_AVX
+int    matrix_avx_supported(void);
+void   matrix_avx_multiply(const float* p_m1, const float* p_m2, float* p_result);
+size_t matrix_avx_frustum_cull_aabbs(const float* p_planes, const void* p_aabbs, size_t stride, size_t n, uint32_t* p_visible);
+#endif
+
+#endif
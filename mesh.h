@@ -1,6 +1,7 @@
 #ifndef _H__MESH
 #define _H__MESH
 
+#include <stddef.h>
 #include <stdint.h>
 
 enum vertex_attribute_type {
@@ -291,63 +291,66 @@ void mesh_factory_make_uv_sphere_primitive(float r, size_t n, struct mesh_primit
     };
 }
 
-void mesh_factory_make_from_halfedge_mesh(const struct he_mesh* p_he_mesh, struct mesh_primitive* p_mesh_primitive, int b_lines) {
+void mesh_factory_make_from_halfedge_mesh(const struct he_compact_mesh* p_he_mesh, struct mesh_primitive* p_mesh_primitive, int b_lines) {
     struct darr vertices;
     darr_init(&vertices, sizeof(float) * 3);
 
-    struct he_face* p_face = p_he_mesh->p_faces;
+    const float* p_positions = p_he_mesh->p_positions;
 
     if (b_lines) {
-        while (p_face) {
-            struct he_edge* p_edge = p_face->p_edges;
-            do {
-                float* p_vertex;
-
-                p_vertex = darr_push(&vertices);
-                p_vertex[0] = p_edge->p_tail->position[0];
-                p_vertex[1] = p_edge->p_tail->position[1];
-                p_vertex[2] = p_edge->p_tail->position[2];
-                
-                p_vertex = darr_push(&vertices);
-                p_vertex[0] = p_edge->p_next->p_tail->position[0];
-                p_vertex[1] = p_edge->p_next->p_tail->position[1];
-                p_vertex[2] = p_edge->p_next->p_tail->position[2];
-
-                p_edge = p_edge->p_next;
-            } while (p_edge != p_face->p_edges);
-
-            p_face = p_face->p_next;
-        };
+        for (uint32_t e = 0; e < p_he_mesh->num_edges; ++e) {
+            const float* p_tail = &p_positions[p_he_mesh->p_edge_tails[e] * 3];
+            const float* p_head = &p_positions[p_he_mesh->p_edge_tails[p_he_mesh->p_edge_nexts[e]] * 3];
+
+            float* p_vertex;
+
+            p_vertex = darr_push(&vertices);
+            p_vertex[0] = p_tail[0];
+            p_vertex[1] = p_tail[1];
+            p_vertex[2] = p_tail[2];
+
+            p_vertex = darr_push(&vertices);
+            p_vertex[0] = p_head[0];
+            p_vertex[1] = p_head[1];
+            p_vertex[2] = p_head[2];
+        }
     } else {
-        while (p_face) {
+        for (uint32_t f = 0; f < p_he_mesh->num_faces; ++f) {
+            const uint32_t first_edge = p_he_mesh->p_face_edges[f];
+            const float* p_first = &p_positions[p_he_mesh->p_edge_tails[first_edge] * 3];
+
             size_t num_vertices = 0;
+            uint32_t prev_edge = first_edge;
 
-            struct he_edge* p_edge = p_face->p_edges;
+            uint32_t e = first_edge;
             do {
+                const float* p_tail = &p_positions[p_he_mesh->p_edge_tails[e] * 3];
+
                 float* p_vertex = darr_push(&vertices);
-                p_vertex[0] = p_edge->p_tail->position[0];
-                p_vertex[1] = p_edge->p_tail->position[1];
-                p_vertex[2] = p_edge->p_tail->position[2];
+                p_vertex[0] = p_tail[0];
+                p_vertex[1] = p_tail[1];
+                p_vertex[2] = p_tail[2];
 
                 ++num_vertices;
 
                 if (num_vertices > 3) {
+                    const float* p_prev = &p_positions[p_he_mesh->p_edge_tails[prev_edge] * 3];
+
                     p_vertex = darr_push(&vertices);
-                    p_vertex[0] = p_face->p_edges->p_tail->position[0];
-                    p_vertex[1] = p_face->p_edges->p_tail->position[1];
-                    p_vertex[2] = p_face->p_edges->p_tail->position[2];
-                    
+                    p_vertex[0] = p_first[0];
+                    p_vertex[1] = p_first[1];
+                    p_vertex[2] = p_first[2];
+
                     p_vertex = darr_push(&vertices);
-                    p_vertex[0] = p_edge->p_prev->p_tail->position[0];
-                    p_vertex[1] = p_edge->p_prev->p_tail->position[1];
-                    p_vertex[2] = p_edge->p_prev->p_tail->position[2];
+                    p_vertex[0] = p_prev[0];
+                    p_vertex[1] = p_prev[1];
+                    p_vertex[2] = p_prev[2];
                 }
 
-                p_edge = p_edge->p_next;
-            } while (p_edge != p_face->p_edges);
-
-            p_face = p_face->p_next;
-        };
+                prev_edge = e;
+                e = p_he_mesh->p_edge_nexts[e];
+            } while (e != first_edge);
+        }
     }
 
     darr_shrink(&vertices);
@@ -1,5 +1,8 @@
+#include <string.h>
+
 #include "gl_mesh.h"
 #include "gl_program.h"
+#include "gl_program_cache.h"
 #include "input.h"
 #include "mesh_id_capturer.h"
 
@@ -11,23 +14,28 @@ struct mesh_id_capturer_item {
 
 static struct gl_program g_gl_program;
 
-void mesh_id_capturer_init(struct mesh_id_capturer* p_mesh_id_capturer) {
+static void mesh_id_capturer_discard_readbacks(struct mesh_id_capturer* p_mesh_id_capturer);
+
+void mesh_id_capturer_init(struct mesh_id_capturer* p_mesh_id_capturer, struct gl_program_cache* p_gl_program_cache) {
     *p_mesh_id_capturer = (struct mesh_id_capturer){0};
-}
- 
-void mesh_id_capturer_destroy(struct mesh_id_capturer* p_mesh_id_capturer) {
-    glDeleteFramebuffers(1, &p_mesh_id_capturer->_gl_fb);
-    glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_color);
-    glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_depth_stencil);
-}
+    p_mesh_id_capturer->_b_is_stale = 1;
 
-void mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix) {
-    if (g_gl_program.gl_handle == 0) {
-        struct gl_shader gl_vertex_shader;
-        struct gl_shader gl_fragment_shader;
+    for (size_t i = 0; i < MESH_ID_CAPTURER_NUM_READBACKS; ++i) {
+        glGenBuffers(1, &p_mesh_id_capturer->_readbacks[i].gl_pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, p_mesh_id_capturer->_readbacks[i].gl_pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Every capturer shares the one program
+    if (g_gl_program.gl_handle != 0) {
+        return;
+    }
 
-        gl_shader_create(&gl_vertex_shader, GL_VERTEX_SHADER);
-        gl_shader_compile(&gl_vertex_shader,
+    const struct gl_program_source sources[] = {
+        {
+            GL_VERTEX_SHADER,
             "#version 330 core\n"
             "uniform mat4 u_projection_matrix;"
             "uniform mat4 u_view_matrix;"
@@ -35,31 +43,74 @@ void mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t
             "layout (location=0) in vec3 a_pos;"
             "void main() {"
                 "gl_Position = u_projection_matrix * u_view_matrix * u_model_matrix * vec4(a_pos, 1.0);"
-            "}");
-
-        gl_shader_create(&gl_fragment_shader, GL_FRAGMENT_SHADER);
-        gl_shader_compile(&gl_fragment_shader,
+            "}"
+        },
+        {
+            GL_FRAGMENT_SHADER,
             "#version 330 core\n"
             "uniform uint u_id;"
             "out uint f_color;"
             "void main() {"
                 "f_color = u_id;"
-            "}");
+            "}"
+        }
+    };
+
+    gl_program_cache_load(p_gl_program_cache, sources, 2, 0, &g_gl_program);
+}
+
+void mesh_id_capturer_destroy(struct mesh_id_capturer* p_mesh_id_capturer) {
+    mesh_id_capturer_discard_readbacks(p_mesh_id_capturer);
+
+    for (size_t i = 0; i < MESH_ID_CAPTURER_NUM_READBACKS; ++i) {
+        glDeleteBuffers(1, &p_mesh_id_capturer->_readbacks[i].gl_pbo);
+    }
+
+    glDeleteFramebuffers(1, &p_mesh_id_capturer->_gl_fb);
+    glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_color);
+    glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_depth_stencil);
+}
+
+int mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix, float x, float y) {
+    if (x < 0 || y < 0 || x > 1 || y > 1) {
+        // Captures still in flight are from before the cursor left, and no longer of interest
+        mesh_id_capturer_discard_readbacks(p_mesh_id_capturer);
+        p_mesh_id_capturer->_id = 0;
+        p_mesh_id_capturer->_b_is_stale = 1;
+        return 0;
+    }
+
+    GLint pixel_x = (float)framebuffer_width * x;
+    GLint pixel_y = (float)framebuffer_height * (1.0f - y);
+    pixel_x = pixel_x < (GLint)framebuffer_width ? pixel_x : (GLint)framebuffer_width - 1;
+    pixel_y = pixel_y < (GLint)framebuffer_height ? pixel_y : (GLint)framebuffer_height - 1;
+
+    const int b_is_stale =
+        p_mesh_id_capturer->_b_is_stale ||
+        p_mesh_id_capturer->_fb_size[0] != framebuffer_width ||
+        p_mesh_id_capturer->_fb_size[1] != framebuffer_height ||
+        p_mesh_id_capturer->_pixel[0] != pixel_x ||
+        p_mesh_id_capturer->_pixel[1] != pixel_y ||
+        memcmp(p_mesh_id_capturer->_matrices, p_projection_matrix, sizeof(float) * 16) != 0 ||
+        memcmp(&p_mesh_id_capturer->_matrices[16], p_view_matrix, sizeof(float) * 16) != 0;
+
+    if (!b_is_stale) {
+        return 0;
+    }
 
-        gl_program_create(&g_gl_program);
-        gl_program_attach_shader(&g_gl_program, &gl_vertex_shader);
-        gl_program_attach_shader(&g_gl_program, &gl_fragment_shader);
-        gl_program_link(&g_gl_program);
+    // Collect whatever has finished, and if the GPU is a whole ring behind, try again next frame rather than wait
+    mesh_id_capturer_query(p_mesh_id_capturer);
 
-        gl_shader_destroy(&gl_vertex_shader);
-        gl_shader_destroy(&gl_fragment_shader);
+    if (p_mesh_id_capturer->_readbacks[p_mesh_id_capturer->_next_readback].gl_fence) {
+        p_mesh_id_capturer->_b_is_stale = 1;
+        return 0;
     }
 
     if (p_mesh_id_capturer->_fb_size[0] != framebuffer_width || p_mesh_id_capturer->_fb_size[1] != framebuffer_height) {
         glDeleteFramebuffers(1, &p_mesh_id_capturer->_gl_fb);
         glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_color);
         glDeleteTextures(1, &p_mesh_id_capturer->_gl_fba_depth_stencil);
-        
+
         glGenTextures(1, &p_mesh_id_capturer->_gl_fba_color);
         glBindTexture(GL_TEXTURE_2D, p_mesh_id_capturer->_gl_fba_color);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, framebuffer_width, framebuffer_height, 0,  GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
@@ -80,47 +131,94 @@ void mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t
     } else {
         glBindFramebuffer(GL_FRAMEBUFFER, p_mesh_id_capturer->_gl_fb);
     }
-    
+
+    p_mesh_id_capturer->_pixel[0] = pixel_x;
+    p_mesh_id_capturer->_pixel[1] = pixel_y;
+    memcpy(p_mesh_id_capturer->_matrices, p_projection_matrix, sizeof(float) * 16);
+    memcpy(&p_mesh_id_capturer->_matrices[16], p_view_matrix, sizeof(float) * 16);
+    p_mesh_id_capturer->_b_is_stale = 0;
+
+    // Only the cursor's pixel is read, so it's the only one cleared or shaded
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(pixel_x, pixel_y, 1, 1);
+
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
-    glEnable(GL_DEPTH_TEST); 
+
+    glEnable(GL_DEPTH_TEST);
     glViewport(0, 0, framebuffer_width, framebuffer_height);
 
     glUseProgram(g_gl_program.gl_handle);
+    glUniformMatrix4fv(g_gl_program.uniform_locations[GL_PROGRAM_UNIFORM_projection_matrix], 1, GL_FALSE, p_projection_matrix);
+    glUniformMatrix4fv(g_gl_program.uniform_locations[GL_PROGRAM_UNIFORM_view_matrix], 1, GL_FALSE, p_view_matrix);
 
-    GLuint gl_uniform_location;
-    
-    gl_uniform_location = glGetUniformLocation(g_gl_program.gl_handle, "u_projection_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, p_projection_matrix);
-    
-    gl_uniform_location = glGetUniformLocation(g_gl_program.gl_handle, "u_view_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, p_view_matrix);
+    return 1;
 }
 
 void mesh_id_capturer_submit(struct mesh_id_capturer* p_mesh_id_capturer, const struct gl_mesh* p_gl_mesh, const float* p_transform, unsigned int id) {
-    GLuint gl_uniform_location;
-
-    gl_uniform_location = glGetUniformLocation(g_gl_program.gl_handle, "u_model_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, p_transform);
-
-    gl_uniform_location = glGetUniformLocation(g_gl_program.gl_handle, "u_id");
-    glUniform1ui(gl_uniform_location, (GLuint)id);
+    glUniformMatrix4fv(g_gl_program.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, p_transform);
+    glUniform1ui(g_gl_program.uniform_locations[GL_PROGRAM_UNIFORM_id], (GLuint)id);
 
     gl_mesh_draw(p_gl_mesh);
 }
 
-unsigned int mesh_id_capturer_query(const struct mesh_id_capturer* p_mesh_id_capturer, float x, float y) {
-    if (x < 0 || y < 0 || x > 1 || y > 1) {
-        return 0;
-    }
+void mesh_id_capturer_end(struct mesh_id_capturer* p_mesh_id_capturer) {
+    struct mesh_id_capturer_readback* p_readback = &p_mesh_id_capturer->_readbacks[p_mesh_id_capturer->_next_readback];
 
+    glDisable(GL_SCISSOR_TEST);
+
+    // Into a pack buffer the read is queued like any other command, rather than waiting for the pixel to be drawn
     glBindFramebuffer(GL_READ_FRAMEBUFFER, p_mesh_id_capturer->_gl_fb);
     glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, p_readback->gl_pbo);
+    glReadPixels(p_mesh_id_capturer->_pixel[0], p_mesh_id_capturer->_pixel[1], 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    p_readback->gl_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    p_mesh_id_capturer->_next_readback = (p_mesh_id_capturer->_next_readback + 1) % MESH_ID_CAPTURER_NUM_READBACKS;
+}
 
-    GLint pixel_x = (float)p_mesh_id_capturer->_fb_size[0] * x;
-    GLint pixel_y = (float)p_mesh_id_capturer->_fb_size[1] * (1.0f - y);
-    GLuint data;
-    glReadPixels(pixel_x, pixel_y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, &data);
-    return data;
-}
\ No newline at end of file
+void mesh_id_capturer_invalidate(struct mesh_id_capturer* p_mesh_id_capturer) {
+    p_mesh_id_capturer->_b_is_stale = 1;
+}
+
+unsigned int mesh_id_capturer_query(struct mesh_id_capturer* p_mesh_id_capturer) {
+    // Captures finish in the order they were made, oldest first from the next to be reused
+    for (size_t i = 0; i < MESH_ID_CAPTURER_NUM_READBACKS; ++i) {
+        struct mesh_id_capturer_readback* p_readback = &p_mesh_id_capturer->_readbacks[(p_mesh_id_capturer->_next_readback + i) % MESH_ID_CAPTURER_NUM_READBACKS];
+
+        if (!p_readback->gl_fence) {
+            continue;
+        }
+
+        const GLenum gl_status = glClientWaitSync(p_readback->gl_fence, 0, 0);
+
+        if (gl_status != GL_ALREADY_SIGNALED && gl_status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        glDeleteSync(p_readback->gl_fence);
+        p_readback->gl_fence = 0;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, p_readback->gl_pbo);
+        const GLuint* p_id = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLuint), GL_MAP_READ_BIT);
+
+        if (p_id) {
+            p_mesh_id_capturer->_id = *p_id;
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    return p_mesh_id_capturer->_id;
+}
+
+void mesh_id_capturer_discard_readbacks(struct mesh_id_capturer* p_mesh_id_capturer) {
+    for (size_t i = 0; i < MESH_ID_CAPTURER_NUM_READBACKS; ++i) {
+        if (p_mesh_id_capturer->_readbacks[i].gl_fence) {
+            glDeleteSync(p_mesh_id_capturer->_readbacks[i].gl_fence);
+            p_mesh_id_capturer->_readbacks[i].gl_fence = 0;
+        }
+    }
+}
@@ -5,19 +5,46 @@
 
 #include "gl.h"
 
+#define MESH_ID_CAPTURER_NUM_READBACKS 3
+
 struct gl_mesh;
+struct gl_program_cache;
+
+struct mesh_id_capturer_readback {
+    GLuint gl_pbo;
+    GLsync gl_fence; // 0 unless a capture is being read into gl_pbo
+};
 
+/* Captures the ID of the mesh under the cursor without waiting on the GPU. Each capture renders only the cursor's
+ * pixel and is read back through a ring of pixel pack buffers, so its result arrives a frame or two later. Nothing is
+ * rendered while neither the cursor nor the camera has moved. */
 struct mesh_id_capturer {
-    size_t       _fb_size[2];
-    GLuint       _gl_fb;
-    GLuint       _gl_fba_color;
-    GLuint       _gl_fba_depth_stencil;
+    size_t                           _fb_size[2];
+    GLuint                           _gl_fb;
+    GLuint                           _gl_fba_color;
+    GLuint                           _gl_fba_depth_stencil;
+    struct mesh_id_capturer_readback _readbacks[MESH_ID_CAPTURER_NUM_READBACKS];
+    size_t                           _next_readback;      // the oldest capture in flight, if any, and next to reuse
+    GLint                            _pixel[2];           // of the latest capture
+    float                            _matrices[32];       // projection and view matrices of the latest capture
+    int                              _b_is_stale;
+    unsigned int                     _id;
 };
 
-void         mesh_id_capturer_init(struct mesh_id_capturer* p_mesh_id_capturer);
+// Starts compiling the capture program in p_gl_program_cache, which must be finished before the first capture
+void         mesh_id_capturer_init(struct mesh_id_capturer* p_mesh_id_capturer, struct gl_program_cache* p_gl_program_cache);
 void         mesh_id_capturer_destroy(struct mesh_id_capturer* p_mesh_id_capturer);
-void         mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix);
+
+/* Starts a capture at the normalized cursor position x, y if anything has moved since the last one, binding the
+ * capture framebuffer. Returns 0, doing nothing, otherwise: submit and end only after it returns 1. */
+int          mesh_id_capturer_begin(struct mesh_id_capturer* p_mesh_id_capturer, size_t framebuffer_width, size_t framebuffer_height, const float* p_projection_matrix, const float* p_view_matrix, float x, float y);
 void         mesh_id_capturer_submit(struct mesh_id_capturer* p_mesh_id_capturer, const struct gl_mesh* p_gl_mesh, const float* p_transform, unsigned int id);
-unsigned int mesh_id_capturer_query(const struct mesh_id_capturer* p_mesh_id_capturer, float x, float y);
+void         mesh_id_capturer_end(struct mesh_id_capturer* p_mesh_id_capturer);
+
+// Makes the next begin capture even if nothing it checks has moved, such as when what's drawn has changed
+void         mesh_id_capturer_invalidate(struct mesh_id_capturer* p_mesh_id_capturer);
+
+// Returns the ID from the latest capture the GPU has finished, or 0 for none or a cursor outside the framebuffer
+unsigned int mesh_id_capturer_query(struct mesh_id_capturer* p_mesh_id_capturer);
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,14 @@
 #include "logging.h"
 #include "object_pool.h"
 
+// Sits in front of each block's objects; two pointers wide so the objects keep malloc's alignment
+struct object_pool_block {
+    struct object_pool_block* p_previous;
+    size_t                    capacity;
+};
+
+static int object_pool_grow(struct object_pool* p_pool, size_t capacity);
+
 void object_pool_init(struct object_pool* p_pool, size_t object_size, size_t capacity) {
     if (object_size < sizeof(void*)) {
         object_size = sizeof(void*);
@@ -11,28 +19,45 @@ void object_pool_init(struct object_pool* p_pool, size_t object_size, size_t cap
 
     *p_pool = (struct object_pool) {
         ._object_size = object_size,
-        ._capacity = capacity,
-        ._p_objects = calloc(capacity, object_size)
+        ._capacity = capacity ? capacity : 1
     };
-    p_pool->_p_next_free = p_pool->_p_objects;
 
-    for (size_t i = 0; i < capacity - 1; ++i) {
-        void* p = (unsigned char*)p_pool->_p_objects + object_size * i;
-        void* p_next = ((unsigned char*)p + object_size);
-        *((void**)p) = p_next;
-    }
+    object_pool_grow(p_pool, p_pool->_capacity);
 }
 
 void* object_pool_get(struct object_pool* p_pool) {
-    void* p = p_pool->_p_next_free;
-    if (!p) {
+    if (!p_pool->_p_next_free && !object_pool_grow(p_pool, p_pool->_capacity)) {
         cx_log(CX_LOG_ERROR, 0, "Object pool exhausted!\n");
         return 0;
     }
+
+    void* p = p_pool->_p_next_free;
     p_pool->_p_next_free = *((void**)p);
     return p;
 }
 
+size_t object_pool_get_many(struct object_pool* p_pool, size_t n, void** pp_objects) {
+    size_t num_free = 0;
+
+    for (void* p = p_pool->_p_next_free; p && num_free < n; p = *((void**)p)) {
+        ++num_free;
+    }
+
+    // Whatever the free list can't cover comes from one new block, so that part of the batch is contiguous
+    if (num_free < n && !object_pool_grow(p_pool, n - num_free > p_pool->_capacity ? n - num_free : p_pool->_capacity)) {
+        cx_log(CX_LOG_ERROR, 0, "Object pool exhausted!\n");
+        n = num_free;
+    }
+
+    // Freed objects were pushed in front of the new block, so they are handed out first
+    for (size_t i = 0; i < n; ++i) {
+        pp_objects[i] = p_pool->_p_next_free;
+        p_pool->_p_next_free = *((void**)pp_objects[i]);
+    }
+
+    return n;
+}
+
 void object_pool_return(struct object_pool* p_pool, void* p_object) {
     void* p = p_object;
     *((void**)p) = p_pool->_p_next_free;
@@ -40,6 +65,44 @@ void object_pool_return(struct object_pool* p_pool, void* p_object) {
 }
 
 void object_pool_free(struct object_pool* p_pool) {
-    free(p_pool->_p_objects);
+    struct object_pool_block* p_block = p_pool->_p_blocks;
+
+    while (p_block) {
+        struct object_pool_block* p_previous = p_block->p_previous;
+        free(p_block);
+        p_block = p_previous;
+    }
+
     *p_pool = (struct object_pool){0};
-}
\ No newline at end of file
+}
+
+int object_pool_grow(struct object_pool* p_pool, size_t capacity) {
+    struct object_pool_block* p_block = calloc(1, sizeof(struct object_pool_block) + p_pool->_object_size * capacity);
+
+    if (!p_block) {
+        return 0;
+    }
+
+    *p_block = (struct object_pool_block) {
+        .p_previous = p_pool->_p_blocks,
+        .capacity = capacity
+    };
+    p_pool->_p_blocks = p_block;
+
+    unsigned char* p_objects = (unsigned char*)(p_block + 1);
+
+    // The new objects go at the back of the free list so anything already freed is reused first
+    void** pp_tail = &p_pool->_p_next_free;
+    while (*pp_tail) {
+        pp_tail = (void**)*pp_tail;
+    }
+    *pp_tail = p_objects;
+
+    for (size_t i = 0; i < capacity - 1; ++i) {
+        void* p = p_objects + p_pool->_object_size * i;
+        void* p_next = ((unsigned char*)p + p_pool->_object_size);
+        *((void**)p) = p_next;
+    }
+
+    return 1;
+}
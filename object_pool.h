@@ -3,19 +3,21 @@
 
 #include <stdint.h>
 
+/* Hands out fixed-size objects from blocks of at least _capacity objects. When every object is taken another block
+ * is allocated, so objects never move and pointers to them stay valid until they are returned. */
 struct object_pool {
     size_t _object_size;
     size_t _capacity;
-    void*  _p_objects;
+    void*  _p_blocks;    // newest block first
     void*  _p_next_free;
-    void*  _p_allocated_head;
 };
 
-void  object_pool_init(struct object_pool* p_pool, size_t object_size, size_t capacity);
-void* object_pool_get(struct object_pool* p_pool);
-void  object_pool_return(struct object_pool* p_pool, void* p_object);
-void  object_pool_free(struct object_pool* p_pool);
+void   object_pool_init(struct object_pool* p_pool, size_t object_size, size_t capacity);
+void*  object_pool_get(struct object_pool* p_pool);
+size_t object_pool_get_many(struct object_pool* p_pool, size_t n, void** pp_objects);
+void   object_pool_return(struct object_pool* p_pool, void* p_object);
+void   object_pool_free(struct object_pool* p_pool);
 
 
 
-#endif
\ No newline at end of file
+#endif
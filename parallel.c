@@ -0,0 +1,235 @@
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "logging.h"
+#include "parallel.h"
+#include "platform.h"
+
+#ifdef PLATFORM_WINDOWS
+typedef SRWLOCK            parallel_lock;
+typedef CONDITION_VARIABLE parallel_cond;
+typedef HANDLE             parallel_thread;
+#define PARALLEL_LOCK(P_LOCK)             AcquireSRWLockExclusive(P_LOCK)
+#define PARALLEL_UNLOCK(P_LOCK)           ReleaseSRWLockExclusive(P_LOCK)
+#define PARALLEL_WAIT(P_COND, P_LOCK)     SleepConditionVariableSRW(P_COND, P_LOCK, INFINITE, 0)
+#define PARALLEL_BROADCAST(P_COND)        WakeAllConditionVariable(P_COND)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t    parallel_lock;
+typedef pthread_cond_t     parallel_cond;
+typedef pthread_t          parallel_thread;
+#define PARALLEL_LOCK(P_LOCK)             pthread_mutex_lock(P_LOCK)
+#define PARALLEL_UNLOCK(P_LOCK)           pthread_mutex_unlock(P_LOCK)
+#define PARALLEL_WAIT(P_COND, P_LOCK)     pthread_cond_wait(P_COND, P_LOCK)
+#define PARALLEL_BROADCAST(P_COND)        pthread_cond_broadcast(P_COND)
+#endif
+
+#if defined(__GNUC__)
+#define PARALLEL_FETCH_INC(P_VALUE) __sync_fetch_and_add(P_VALUE, 1)
+#else
+#define PARALLEL_FETCH_INC(P_VALUE) ((size_t)InterlockedIncrement64((volatile LONG64*)(P_VALUE)) - 1)
+#endif
+
+#define PARALLEL_MAX_THREADS 64
+#define CX_LOG_CAT_PARALLEL "parallel"
+
+static struct parallel_pool {
+    parallel_lock     lock;
+    parallel_cond     cond_work;
+    parallel_cond     cond_done;
+    parallel_thread   threads[PARALLEL_MAX_THREADS];
+    size_t            num_workers;
+    int               b_running;
+    int               b_busy;       // a loop currently owns the workers
+    unsigned int      generation;   // bumped for every loop handed to the workers
+    size_t            num_active;   // workers that haven't finished the current loop yet
+
+    parallel_for_func f_func;
+    void*             p_user_data;
+    size_t            n;
+    volatile size_t   next;
+} g_pool;
+
+static void parallel_run_loop(void);
+static void parallel_worker(void);
+static size_t parallel_hardware_threads(void);
+
+#ifdef PLATFORM_WINDOWS
+static DWORD WINAPI parallel_thread_proc(LPVOID p_arg);
+
+DWORD WINAPI parallel_thread_proc(LPVOID p_arg) {
+    parallel_worker();
+    return 0;
+}
+#else
+static void* parallel_thread_proc(void* p_arg);
+
+void* parallel_thread_proc(void* p_arg) {
+    parallel_worker();
+    return 0;
+}
+#endif
+
+int parallel_init(size_t num_threads) {
+    if (g_pool.b_running) {
+        return 1;
+    }
+
+    if (num_threads == 0) {
+        num_threads = parallel_hardware_threads();
+    }
+
+    if (num_threads > PARALLEL_MAX_THREADS) {
+        num_threads = PARALLEL_MAX_THREADS;
+    }
+
+#ifdef PLATFORM_WINDOWS
+    InitializeSRWLock(&g_pool.lock);
+    InitializeConditionVariable(&g_pool.cond_work);
+    InitializeConditionVariable(&g_pool.cond_done);
+#else
+    pthread_mutex_init(&g_pool.lock, 0);
+    pthread_cond_init(&g_pool.cond_work, 0);
+    pthread_cond_init(&g_pool.cond_done, 0);
+#endif
+
+    g_pool.b_running = 1;
+    g_pool.num_workers = 0;
+
+    // The calling thread works too, so it counts as one of the threads
+    for (size_t i = 0; i + 1 < num_threads; ++i) {
+#ifdef PLATFORM_WINDOWS
+        g_pool.threads[i] = CreateThread(0, 0, parallel_thread_proc, 0, 0, 0);
+        const int b_created = g_pool.threads[i] != 0;
+#else
+        const int b_created = pthread_create(&g_pool.threads[i], 0, parallel_thread_proc, 0) == 0;
+#endif
+        if (!b_created) {
+            cx_log_fmt(CX_LOG_WARNING, CX_LOG_CAT_PARALLEL, "Failed to create worker thread %d\n", (int)i);
+            break;
+        }
+
+        ++g_pool.num_workers;
+    }
+
+    cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_PARALLEL, "Worker pool started: %d threads\n", (int)g_pool.num_workers + 1);
+
+    return 1;
+}
+
+void parallel_shutdown(void) {
+    if (!g_pool.b_running) {
+        return;
+    }
+
+    PARALLEL_LOCK(&g_pool.lock);
+    g_pool.b_running = 0;
+    PARALLEL_BROADCAST(&g_pool.cond_work);
+    PARALLEL_UNLOCK(&g_pool.lock);
+
+    for (size_t i = 0; i < g_pool.num_workers; ++i) {
+#ifdef PLATFORM_WINDOWS
+        WaitForSingleObject(g_pool.threads[i], INFINITE);
+        CloseHandle(g_pool.threads[i]);
+#else
+        pthread_join(g_pool.threads[i], 0);
+#endif
+    }
+
+#ifndef PLATFORM_WINDOWS
+    pthread_mutex_destroy(&g_pool.lock);
+    pthread_cond_destroy(&g_pool.cond_work);
+    pthread_cond_destroy(&g_pool.cond_done);
+#endif
+
+    g_pool = (struct parallel_pool){0};
+}
+
+size_t parallel_num_threads(void) {
+    return g_pool.num_workers + 1;
+}
+
+void parallel_for(size_t n, parallel_for_func f_func, void* p_user_data) {
+    int b_serial = !g_pool.b_running || g_pool.num_workers == 0 || n < 2;
+
+    if (!b_serial) {
+        PARALLEL_LOCK(&g_pool.lock);
+        b_serial = g_pool.b_busy;
+        if (!b_serial) {
+            g_pool.b_busy = 1;
+            g_pool.f_func = f_func;
+            g_pool.p_user_data = p_user_data;
+            g_pool.n = n;
+            g_pool.next = 0;
+            g_pool.num_active = g_pool.num_workers;
+            ++g_pool.generation;
+            PARALLEL_BROADCAST(&g_pool.cond_work);
+        }
+        PARALLEL_UNLOCK(&g_pool.lock);
+    }
+
+    if (b_serial) {
+        for (size_t i = 0; i < n; ++i) {
+            f_func(i, p_user_data);
+        }
+        return;
+    }
+
+    parallel_run_loop();
+
+    PARALLEL_LOCK(&g_pool.lock);
+    while (g_pool.num_active) {
+        PARALLEL_WAIT(&g_pool.cond_done, &g_pool.lock);
+    }
+    g_pool.b_busy = 0;
+    PARALLEL_UNLOCK(&g_pool.lock);
+}
+
+void parallel_run_loop(void) {
+    for (;;) {
+        const size_t i = PARALLEL_FETCH_INC(&g_pool.next);
+        if (i >= g_pool.n) {
+            break;
+        }
+        g_pool.f_func(i, g_pool.p_user_data);
+    }
+}
+
+void parallel_worker(void) {
+    unsigned int generation = 0;
+
+    PARALLEL_LOCK(&g_pool.lock);
+    for (;;) {
+        while (g_pool.b_running && g_pool.generation == generation) {
+            PARALLEL_WAIT(&g_pool.cond_work, &g_pool.lock);
+        }
+
+        if (!g_pool.b_running) {
+            break;
+        }
+
+        generation = g_pool.generation;
+        PARALLEL_UNLOCK(&g_pool.lock);
+
+        parallel_run_loop();
+
+        PARALLEL_LOCK(&g_pool.lock);
+        if (--g_pool.num_active == 0) {
+            PARALLEL_BROADCAST(&g_pool.cond_done);
+        }
+    }
+    PARALLEL_UNLOCK(&g_pool.lock);
+}
+
+size_t parallel_hardware_threads(void) {
+#ifdef PLATFORM_WINDOWS
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return system_info.dwNumberOfProcessors;
+#else
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif
+}
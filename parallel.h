@@ -0,0 +1,16 @@
+#ifndef _H__PARALLEL
+#define _H__PARALLEL
+
+#include <stddef.h>
+
+typedef void(*parallel_for_func)(size_t index, void* p_user_data);
+
+/* Small persistent worker pool for data-parallel loops. parallel_for blocks until every index has been processed and
+ * the calling thread takes part in the work. Calls made before parallel_init, from inside a running loop, or while
+ * another thread owns the pool run serially on the calling thread. */
+int    parallel_init(size_t num_threads); // 0 = one thread per logical processor
+void   parallel_shutdown(void);
+size_t parallel_num_threads(void);
+void   parallel_for(size_t n, parallel_for_func f_func, void* p_user_data);
+
+#endif
@@ -1,10 +1,13 @@
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "logging.h"
 #include "math_utils.h"
 #include "matrix.h"
 #include "physics.h"
 #include "transform.h"
+#include "triangle_bvh.h"
 #include "vector.h"
 
 // https://github.com/IainWinter/IwEngine/blob/3e2052855fea85718b7a499a7b1a3befd49d812b/IwEngine/include/iw/physics/impl/TestCollision.h
@@ -24,11 +27,25 @@ static void physics_sphere_apply_transform(struct physics_collider* p_collider,
 static void physics_capsule_apply_transform(struct physics_collider* p_collider, const struct transform* p_t);
 static void physics_hull_apply_transform(struct physics_collider* p_collider, const struct transform* p_t);
 static void physics_plane_apply_transform(struct physics_collider* p_collider, const struct transform* p_t);
+static void physics_compound_apply_transform(struct physics_collider* p_collider, const struct transform* p_t);
+static void physics_mesh_apply_transform(struct physics_collider* p_collider, const struct transform* p_t);
 static void physics_collider_undo_transform(struct physics_collider* p_collider);
 static void physics_sphere_undo_transform(struct physics_collider* p_collider);
 static void physics_capsule_undo_transform(struct physics_collider* p_collider);
 static void physics_hull_undo_transform(struct physics_collider* p_collider);
 static void physics_plane_undo_transform(struct physics_collider* p_collider);
+static void physics_compound_undo_transform(struct physics_collider* p_collider);
+static void physics_mesh_undo_transform(struct physics_collider* p_collider);
+
+static void     physics_copy_darr(const struct darr* p_darr, struct darr* p_result);
+static uint32_t physics_compound_build_node(struct darr* p_nodes, uint32_t* p_hulls, size_t n, const float* p_hull_bounds);
+static int      physics_aabb_overlap(const float* p_min_a, const float* p_max_a, const float* p_min_b, const float* p_max_b);
+static void     physics_collision_result_flip(struct physics_collision_result* p_result);
+
+static int  physics_test_triangle_sphere_internal(const float p_triangle[3][3], const float* p_center, float radius, const float* p_side, struct physics_collision_result* p_result);
+static void physics_closest_point_on_triangle(const float* p_point, const float p_triangle[3][3], float* p_result);
+static void physics_closest_points_segment_segment(const float* p_p0, const float* p_p1, const float* p_q0, const float* p_q1, float* p_result_p, float* p_result_q);
+static void physics_closest_points_segment_triangle(const float* p_p0, const float* p_p1, const float p_triangle[3][3], float* p_result_segment, float* p_result_triangle);
 
 static int physics_test_sphere_sphere_internal(const float* p_center_a, float radius_a, const float* p_center_b, float radius_b, struct physics_collision_result* p_result);
 static int physics_test_convex_hulls(const struct physics_collider* p_a, const struct physics_collider* p_b, struct physics_collision_result* p_result);
@@ -80,9 +97,243 @@ void physics_collider_init(struct physics_collider* p_collider, enum physics_col
 			p_collider->as_plane.distance =  0;
 			break;
 		}
+
+		case PHYSICS_COLLIDER_TYPE_compound: {
+			darr_init(&p_collider->as_compound.hulls, sizeof(struct physics_hull));
+			darr_init(&p_collider->as_compound.nodes, sizeof(struct physics_aabb_node));
+			matrix_make_identity(p_collider->as_compound._world_matrix);
+			matrix_make_identity(p_collider->as_compound._inv_world_matrix);
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_mesh: {
+			p_collider->as_mesh.p_bvh = 0;
+			matrix_make_identity(p_collider->as_mesh._world_matrix);
+			matrix_make_identity(p_collider->as_mesh._inv_world_matrix);
+			break;
+		}
 	}
 }
 
+void physics_collider_free(struct physics_collider* p_collider) {
+	switch (p_collider->type) {
+		case PHYSICS_COLLIDER_TYPE_hull: {
+			darr_free(&p_collider->as_hull.verts);
+			darr_free(&p_collider->_cached.as_hull.verts);
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_compound: {
+			for (size_t i = 0; i < p_collider->as_compound.hulls._length; ++i) {
+				struct physics_hull* p_hull = darr_get(&p_collider->as_compound.hulls, i);
+				darr_free(&p_hull->verts);
+			}
+			darr_free(&p_collider->as_compound.hulls);
+			darr_free(&p_collider->as_compound.nodes);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+void physics_collider_copy(const struct physics_collider* p_collider, struct physics_collider* p_result) {
+	*p_result = *p_collider;
+	switch (p_collider->type) {
+		case PHYSICS_COLLIDER_TYPE_hull: {
+			physics_copy_darr(&p_collider->as_hull.verts, &p_result->as_hull.verts);
+			darr_init(&p_result->_cached.as_hull.verts, p_collider->_cached.as_hull.verts._element_size);
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_compound: {
+			physics_copy_darr(&p_collider->as_compound.hulls, &p_result->as_compound.hulls);
+			for (size_t i = 0; i < p_result->as_compound.hulls._length; ++i) {
+				const struct physics_hull* p_hull = darr_get(&p_collider->as_compound.hulls, i);
+				struct physics_hull* p_result_hull = darr_get(&p_result->as_compound.hulls, i);
+				physics_copy_darr(&p_hull->verts, &p_result_hull->verts);
+			}
+			physics_copy_darr(&p_collider->as_compound.nodes, &p_result->as_compound.nodes);
+			break;
+		}
+
+		default:
+			break;
+	}
+}
+
+void physics_collider_compute_aabb(const struct physics_collider* p_collider, float* p_min, float* p_max) {
+	switch (p_collider->type) {
+		case PHYSICS_COLLIDER_TYPE_sphere: {
+			for (int i = 0; i < 3; ++i) {
+				p_min[i] = p_collider->as_sphere.center[i] - p_collider->as_sphere.radius;
+				p_max[i] = p_collider->as_sphere.center[i] + p_collider->as_sphere.radius;
+			}
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_capsule: {
+			for (int i = 0; i < 3; ++i) {
+				p_min[i] = fminf(p_collider->as_capsule.p0[i], p_collider->as_capsule.p1[i]) - p_collider->as_capsule.radius;
+				p_max[i] = fmaxf(p_collider->as_capsule.p0[i], p_collider->as_capsule.p1[i]) + p_collider->as_capsule.radius;
+			}
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_hull: {
+			p_min[0] = p_min[1] = p_min[2] =  FLT_MAX;
+			p_max[0] = p_max[1] = p_max[2] = -FLT_MAX;
+			for (size_t v = 0; v < p_collider->as_hull.verts._length; ++v) {
+				const float* p_v = darr_get(&p_collider->as_hull.verts, v);
+				for (int i = 0; i < 3; ++i) {
+					p_min[i] = fminf(p_min[i], p_v[i]);
+					p_max[i] = fmaxf(p_max[i], p_v[i]);
+				}
+			}
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_plane: {
+			p_min[0] = p_min[1] = p_min[2] = -FLT_MAX;
+			p_max[0] = p_max[1] = p_max[2] =  FLT_MAX;
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_compound: {
+			if (!p_collider->as_compound.nodes._length) {
+				vec3_clr(p_min);
+				vec3_clr(p_max);
+				break;
+			}
+			const struct physics_aabb_node* p_root = darr_get(&p_collider->as_compound.nodes, 0);
+			matrix_transform_aabb(p_collider->as_compound._world_matrix, p_root->min, p_root->max, p_min, p_max);
+			break;
+		}
+
+		case PHYSICS_COLLIDER_TYPE_mesh: {
+			if (!p_collider->as_mesh.p_bvh) {
+				vec3_clr(p_min);
+				vec3_clr(p_max);
+				break;
+			}
+			matrix_transform_aabb(p_collider->as_mesh._world_matrix, p_collider->as_mesh.p_bvh->bounds_min, p_collider->as_mesh.p_bvh->bounds_max, p_min, p_max);
+			break;
+		}
+	}
+}
+
+void physics_compound_add_hull(struct physics_collider* p_collider, const float* p_vertices, size_t num_vertices) {
+	struct physics_hull* p_hull = darr_push(&p_collider->as_compound.hulls);
+	darr_init(&p_hull->verts, sizeof(float) * 3);
+	darr_set_length(&p_hull->verts, num_vertices);
+	memcpy(p_hull->verts._p_buffer, p_vertices, sizeof(float) * 3 * num_vertices);
+}
+
+void physics_compound_build_tree(struct physics_collider* p_collider) {
+	struct physics_compound* p_compound = &p_collider->as_compound;
+	const size_t num_hulls = p_compound->hulls._length;
+
+	darr_set_length(&p_compound->nodes, 0);
+
+	if (!num_hulls) {
+		return;
+	}
+
+	// Bounds (min, max) and the hull indices the build partitions in place
+	float* p_hull_bounds = malloc(sizeof(float) * 6 * num_hulls);
+	uint32_t* p_hull_indices = malloc(sizeof(uint32_t) * num_hulls);
+
+	for (size_t i = 0; i < num_hulls; ++i) {
+		const struct physics_collider hull_collider = {
+			.type = PHYSICS_COLLIDER_TYPE_hull,
+			.as_hull = *(struct physics_hull*)darr_get(&p_compound->hulls, i)
+		};
+		physics_collider_compute_aabb(&hull_collider, &p_hull_bounds[i * 6], &p_hull_bounds[i * 6 + 3]);
+		p_hull_indices[i] = (uint32_t)i;
+	}
+
+	darr_set_capacity(&p_compound->nodes, num_hulls * 2 - 1);
+	physics_compound_build_node(&p_compound->nodes, p_hull_indices, num_hulls, p_hull_bounds);
+
+	free(p_hull_bounds);
+	free(p_hull_indices);
+
+	cx_log_fmt(CX_LOG_TRACE, "physics", "Compound collider tree built (hulls=%d, nodes=%d)\n", (int)num_hulls, (int)p_compound->nodes._length);
+}
+
+void physics_copy_darr(const struct darr* p_darr, struct darr* p_result) {
+	darr_init(p_result, p_darr->_element_size);
+	if (p_darr->_length) {
+		darr_set_length(p_result, p_darr->_length);
+		memcpy(p_result->_p_buffer, p_darr->_p_buffer, p_darr->_element_size * p_darr->_length);
+	}
+}
+
+uint32_t physics_compound_build_node(struct darr* p_nodes, uint32_t* p_hulls, size_t n, const float* p_hull_bounds) {
+	const uint32_t node_index = (uint32_t)p_nodes->_length;
+
+	struct physics_aabb_node node = {
+		.min = {  FLT_MAX,  FLT_MAX,  FLT_MAX },
+		.max = { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+		.right = 0,
+		.hull = n == 1 ? p_hulls[0] : PHYSICS_AABB_NODE_INTERNAL
+	};
+
+	float centroid_min[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+	float centroid_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (size_t i = 0; i < n; ++i) {
+		const float* p_bounds = &p_hull_bounds[p_hulls[i] * 6];
+		for (int a = 0; a < 3; ++a) {
+			const float centroid = (p_bounds[a] + p_bounds[a + 3]) * 0.5f;
+			node.min[a] = fminf(node.min[a], p_bounds[a]);
+			node.max[a] = fmaxf(node.max[a], p_bounds[a + 3]);
+			centroid_min[a] = fminf(centroid_min[a], centroid);
+			centroid_max[a] = fmaxf(centroid_max[a], centroid);
+		}
+	}
+
+	*(struct physics_aabb_node*)darr_push(p_nodes) = node;
+
+	if (n == 1) {
+		return node_index;
+	}
+
+	// Split at the middle of the centroid bounds' longest axis, falling back to an even split when every centroid lands
+	// on one side
+	int axis = 0;
+	for (int a = 1; a < 3; ++a) {
+		if (centroid_max[a] - centroid_min[a] > centroid_max[axis] - centroid_min[axis]) {
+			axis = a;
+		}
+	}
+
+	const float split = (centroid_min[axis] + centroid_max[axis]) * 0.5f;
+
+	size_t num_left = 0;
+	for (size_t i = 0; i < n; ++i) {
+		const float* p_bounds = &p_hull_bounds[p_hulls[i] * 6];
+		if ((p_bounds[axis] + p_bounds[axis + 3]) * 0.5f < split) {
+			const uint32_t temp = p_hulls[i];
+			p_hulls[i] = p_hulls[num_left];
+			p_hulls[num_left] = temp;
+			++num_left;
+		}
+	}
+
+	if (num_left == 0 || num_left == n) {
+		num_left = n / 2;
+	}
+
+	physics_compound_build_node(p_nodes, p_hulls, num_left, p_hull_bounds);
+	const uint32_t right = physics_compound_build_node(p_nodes, p_hulls + num_left, n - num_left, p_hull_bounds);
+
+	((struct physics_aabb_node*)darr_get(p_nodes, node_index))->right = right;
+
+	return node_index;
+}
+
 void physics_world_init(struct physics_world* p_world) {
 	darr_init(&p_world->_objects, sizeof(struct physics_object*));
 	darr_init(&p_world->_collisions, sizeof(struct physics_collision));
@@ -142,6 +393,7 @@ void physics_world_destroy_object(struct physics_world* p_world, struct physics_
 	cx_log_fmt(CX_LOG_TRACE, "physics", "%s destroyed\n", p_object->_b_is_rigidbody ? "Rigidbody" : "Static object");
 
 	if (p_object->_p_collider) {
+		physics_collider_free(p_object->_p_collider);
 		object_pool_return(&p_world->_collider_pool, p_object->_p_collider);
 	}
 	
@@ -167,9 +419,7 @@ void physics_world_destroy_object_collider(struct physics_world* p_world, struct
 
 	cx_log_fmt(CX_LOG_TRACE, "physics", "Collider removed from %s (type=%d)\n", p_object->_b_is_rigidbody ? "rigidbody" : "static body", p_object->_p_collider->type);
 
-	if (p_object->_p_collider->type == PHYSICS_COLLIDER_TYPE_hull) {
-		darr_free(&p_object->_p_collider->as_hull.verts);
-	}
+	physics_collider_free(p_object->_p_collider);
 
 	object_pool_return(&p_world->_collider_pool, p_object->_p_collider);
 	p_object->_p_collider = 0;
@@ -236,7 +486,9 @@ void physics_collider_apply_transform(struct physics_collider* p_collider, const
 		physics_sphere_apply_transform,
 		physics_capsule_apply_transform,
 		physics_hull_apply_transform,
-		physics_plane_apply_transform
+		physics_plane_apply_transform,
+		physics_compound_apply_transform,
+		physics_mesh_apply_transform
 	};
 	func_table[p_collider->type](p_collider, p_t);
 }
@@ -257,13 +509,10 @@ void physics_capsule_apply_transform(struct physics_collider* p_collider, const
 }
 
 void physics_hull_apply_transform(struct physics_collider* p_collider, const struct transform* p_t) {
-	darr_set_length(&p_collider->_cached.as_hull.verts, p_collider->as_hull.verts._length);
-	for (size_t i = 0; i < p_collider->as_hull.verts._length; ++i) {
-		float* p_v = darr_get(&p_collider->as_hull.verts, i);
-		float* p_v_cached = darr_get(&p_collider->_cached.as_hull.verts, i);
-		vec3_set(p_v, p_v_cached);
-		matrix_multiply_vec3(p_t->world_trs_matrix, p_v, p_v);
-	}
+	struct darr* p_verts = &p_collider->as_hull.verts;
+	darr_set_length(&p_collider->_cached.as_hull.verts, p_verts->_length);
+	memcpy(p_collider->_cached.as_hull.verts._p_buffer, p_verts->_p_buffer, p_verts->_length * p_verts->_element_size);
+	matrix_transform_points(p_t->world_trs_matrix, p_verts->_p_buffer, p_verts->_element_size, p_verts->_p_buffer, p_verts->_length);
 }
 
 void physics_plane_apply_transform(struct physics_collider* p_collider, const struct transform* p_t) {
@@ -274,12 +523,26 @@ void physics_plane_apply_transform(struct physics_collider* p_collider, const st
 	p_collider->as_plane.distance += vec3_len(p_t->world_position) * signf(vec3_dot(p_collider->as_plane.normal, p_t->world_position));
 }
 
+void physics_compound_apply_transform(struct physics_collider* p_collider, const struct transform* p_t) {
+	// Child hulls stay in local space; only the ones picked by the tree query are transformed, per test
+	matrix_copy(p_t->world_trs_matrix, p_collider->as_compound._world_matrix);
+	matrix_inverse_affine(p_t->world_trs_matrix, p_collider->as_compound._inv_world_matrix);
+}
+
+void physics_mesh_apply_transform(struct physics_collider* p_collider, const struct transform* p_t) {
+	// Like compounds, triangles stay in local space and are transformed per test
+	matrix_copy(p_t->world_trs_matrix, p_collider->as_mesh._world_matrix);
+	matrix_inverse_affine(p_t->world_trs_matrix, p_collider->as_mesh._inv_world_matrix);
+}
+
 void physics_collider_undo_transform(struct physics_collider* p_collider) {
 	static void(*const func_table[])(struct physics_collider*) = {
 		physics_sphere_undo_transform,
 		physics_capsule_undo_transform,
 		physics_hull_undo_transform,
-		physics_plane_undo_transform
+		physics_plane_undo_transform,
+		physics_compound_undo_transform,
+		physics_mesh_undo_transform
 	};
 	func_table[p_collider->type](p_collider);
 }
@@ -304,6 +567,12 @@ void physics_plane_undo_transform(struct physics_collider* p_collider) {
 	p_collider->as_plane = p_collider->_cached.as_plane;
 }
 
+void physics_compound_undo_transform(struct physics_collider* p_collider) {
+}
+
+void physics_mesh_undo_transform(struct physics_collider* p_collider) {
+}
+
 void physics_world_detect_collisions(struct physics_world* p_world) {
 	for (size_t i = 0; i < p_world->_objects._length; ++i) {
 		struct physics_object* p_object = *(struct physics_object**)darr_get(&p_world->_objects, i);
@@ -347,6 +616,11 @@ void physics_world_detect_collisions_broadphase(struct physics_world* p_world) {
 				continue;
 			}
 
+			// Neither side of a static pair can move, so there's nothing for the solvers to do with it
+			if (!p_a->_b_is_rigidbody && !p_b->_b_is_rigidbody) {
+				continue;
+			}
+
 			struct physics_collision* p_collision = darr_push(&p_world->_collisions);
 			*p_collision = (struct physics_collision) {
 				.p_a = p_a,
@@ -392,6 +666,30 @@ int physics_test_collision(
 		{ 0,                                           0,                                             (void*)physics_test_collision_hull_hull,    (void*)physics_test_collision_hull_plane    }
 	};
 
+	if (p_a->type == PHYSICS_COLLIDER_TYPE_compound) {
+		return physics_test_collision_compound(p_a, p_b, p_result);
+	}
+
+	if (p_b->type == PHYSICS_COLLIDER_TYPE_compound) {
+		const int b_has_collision = physics_test_collision_compound(p_b, p_a, p_result);
+		if (b_has_collision) {
+			physics_collision_result_flip(p_result);
+		}
+		return b_has_collision;
+	}
+
+	if (p_a->type == PHYSICS_COLLIDER_TYPE_mesh) {
+		return physics_test_collision_mesh(p_a, p_b, p_result);
+	}
+
+	if (p_b->type == PHYSICS_COLLIDER_TYPE_mesh) {
+		const int b_has_collision = physics_test_collision_mesh(p_b, p_a, p_result);
+		if (b_has_collision) {
+			physics_collision_result_flip(p_result);
+		}
+		return b_has_collision;
+	}
+
 	if (p_a->type == PHYSICS_COLLIDER_TYPE_plane && p_b->type == PHYSICS_COLLIDER_TYPE_plane) {
 		*p_result = (struct physics_collision_result){0};
 		return 0;
@@ -409,16 +707,20 @@ int physics_test_collision(
 
 	const int b_has_collision = test_func_table[p_a->type][p_b->type](p_a, p_b, p_result);
 	if (b_has_collision && b_swap) {
-		float v_temp[3];
-		vec3_set(p_result->a, v_temp);
-		vec3_set(p_result->b, p_result->a);
-		vec3_set(v_temp, p_result->b);
-		vec3_inv(p_result->ab_normal, p_result->ab_normal);
+		physics_collision_result_flip(p_result);
 	}
 
 	return b_has_collision;
 }
 
+void physics_collision_result_flip(struct physics_collision_result* p_result) {
+	float v_temp[3];
+	vec3_set(p_result->a, v_temp);
+	vec3_set(p_result->b, p_result->a);
+	vec3_set(v_temp, p_result->b);
+	vec3_inv(p_result->ab_normal, p_result->ab_normal);
+}
+
 int physics_test_sphere_sphere_internal(const float* p_center_a, float radius_a, const float* p_center_b, float radius_b, struct physics_collision_result* p_result) {
 	float ab[3];
 	vec3_sub(p_center_b, p_center_a, ab);
@@ -616,6 +918,422 @@ int physics_test_collision_hull_plane(
 	return 1;
 }
 
+int physics_test_collision_compound(
+	const struct physics_collider* p_a,
+	const struct physics_collider* p_b,
+	struct physics_collision_result* p_result) {
+	const struct physics_compound* p_compound = &p_a->as_compound;
+
+	*p_result = (struct physics_collision_result){0};
+
+	if (!p_compound->nodes._length) {
+		return 0;
+	}
+
+	// Bring the other collider's world space AABB into the compound's local space to query the tree
+	float query_min[3];
+	float query_max[3];
+	physics_collider_compute_aabb(p_b, query_min, query_max);
+
+	if (p_b->type != PHYSICS_COLLIDER_TYPE_plane) {
+		matrix_transform_aabb(p_compound->_inv_world_matrix, query_min, query_max, query_min, query_max);
+	}
+
+	struct physics_collider world_hull = { .type = PHYSICS_COLLIDER_TYPE_hull };
+	darr_init(&world_hull.as_hull.verts, sizeof(float) * 3);
+
+	int b_has_collision = 0;
+
+	uint32_t stack[64];
+	size_t stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size) {
+		const uint32_t node_index = stack[--stack_size];
+		const struct physics_aabb_node* p_node = darr_get(&p_compound->nodes, node_index);
+
+		if (!physics_aabb_overlap(p_node->min, p_node->max, query_min, query_max)) {
+			continue;
+		}
+
+		if (p_node->hull == PHYSICS_AABB_NODE_INTERNAL) {
+			if (stack_size + 2 > sizeof(stack) / sizeof(stack[0])) {
+				cx_log(CX_LOG_ERROR, "physics", "Compound collider tree too deep\n");
+				break;
+			}
+			stack[stack_size++] = p_node->right;
+			stack[stack_size++] = node_index + 1;
+			continue;
+		}
+
+		const struct physics_hull* p_hull = darr_get(&p_compound->hulls, p_node->hull);
+		darr_set_length(&world_hull.as_hull.verts, p_hull->verts._length);
+		matrix_transform_points(p_compound->_world_matrix, p_hull->verts._p_buffer, p_hull->verts._element_size, world_hull.as_hull.verts._p_buffer, p_hull->verts._length);
+
+		// Keep the deepest contact across all touching hulls
+		struct physics_collision_result hull_result;
+		if (physics_test_collision(&world_hull, p_b, &hull_result) && (!b_has_collision || hull_result.depth > p_result->depth)) {
+			*p_result = hull_result;
+			b_has_collision = 1;
+		}
+	}
+
+	darr_free(&world_hull.as_hull.verts);
+
+	return b_has_collision;
+}
+
+int physics_test_collision_mesh(
+	const struct physics_collider* p_a,
+	const struct physics_collider* p_b,
+	struct physics_collision_result* p_result) {
+	const struct physics_mesh* p_mesh = &p_a->as_mesh;
+
+	*p_result = (struct physics_collision_result){0};
+
+	// Static meshes only collide with convex shapes
+	if (!p_mesh->p_bvh || p_b->type == PHYSICS_COLLIDER_TYPE_mesh || p_b->type == PHYSICS_COLLIDER_TYPE_plane) {
+		return 0;
+	}
+
+	float query_min[3];
+	float query_max[3];
+	physics_collider_compute_aabb(p_b, query_min, query_max);
+	matrix_transform_aabb(p_mesh->_inv_world_matrix, query_min, query_max, query_min, query_max);
+
+	struct darr triangles;
+	darr_init(&triangles, sizeof(uint32_t));
+	triangle_bvh_query_aabb(p_mesh->p_bvh, query_min, query_max, &triangles);
+
+	struct physics_collider triangle_hull = { .type = PHYSICS_COLLIDER_TYPE_hull };
+	if (p_b->type == PHYSICS_COLLIDER_TYPE_hull) {
+		darr_init(&triangle_hull.as_hull.verts, sizeof(float) * 3);
+		darr_set_length(&triangle_hull.as_hull.verts, 3);
+	}
+
+	int b_has_collision = 0;
+
+	for (size_t i = 0; i < triangles._length; ++i) {
+		float triangle[3][3];
+		triangle_bvh_get_triangle(p_mesh->p_bvh, *(uint32_t*)darr_get(&triangles, i), triangle[0], triangle[1], triangle[2]);
+
+		matrix_transform_points(p_mesh->_world_matrix, triangle, 0, triangle, 3);
+
+		struct physics_collision_result triangle_result;
+		int b_triangle_collision = 0;
+
+		switch (p_b->type) {
+			case PHYSICS_COLLIDER_TYPE_sphere: {
+				b_triangle_collision = physics_test_triangle_sphere_internal(triangle, p_b->as_sphere.center, p_b->as_sphere.radius, p_b->as_sphere.center, &triangle_result);
+				break;
+			}
+
+			case PHYSICS_COLLIDER_TYPE_capsule: {
+				float segment_point[3];
+				float triangle_point[3];
+				float capsule_center[3];
+				physics_closest_points_segment_triangle(p_b->as_capsule.p0, p_b->as_capsule.p1, triangle, segment_point, triangle_point);
+				vec3_add(p_b->as_capsule.p0, p_b->as_capsule.p1, capsule_center);
+				vec3_mul_s(capsule_center, 0.5f, capsule_center);
+				b_triangle_collision = physics_test_triangle_sphere_internal(triangle, segment_point, p_b->as_capsule.radius, capsule_center, &triangle_result);
+				break;
+			}
+
+			case PHYSICS_COLLIDER_TYPE_hull: {
+				memcpy(triangle_hull.as_hull.verts._p_buffer, triangle, sizeof(triangle));
+				b_triangle_collision = physics_test_collision(&triangle_hull, p_b, &triangle_result);
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		// Keep the deepest contact across all touching triangles
+		if (b_triangle_collision && (!b_has_collision || triangle_result.depth > p_result->depth)) {
+			*p_result = triangle_result;
+			b_has_collision = 1;
+		}
+	}
+
+	if (p_b->type == PHYSICS_COLLIDER_TYPE_hull) {
+		darr_free(&triangle_hull.as_hull.verts);
+	}
+
+	darr_free(&triangles);
+
+	return b_has_collision;
+}
+
+int physics_mesh_raycast(const struct physics_collider* p_collider, const float* p_origin, const float* p_dir, float max_distance, struct physics_raycast_hit* p_hit) {
+	// Uses the transform from the last physics step. The ray is moved into mesh space without normalising the direction,
+	// so the hit parameter is the same in both spaces.
+	const struct physics_mesh* p_mesh = &p_collider->as_mesh;
+
+	if (p_collider->type != PHYSICS_COLLIDER_TYPE_mesh || !p_mesh->p_bvh) {
+		return 0;
+	}
+
+	const float dir_len = vec3_len(p_dir);
+
+	if (dir_len <= 0) {
+		return 0;
+	}
+
+	float local_origin[3];
+	float local_dir[3];
+	matrix_multiply_vec3(p_mesh->_inv_world_matrix, p_origin, local_origin);
+	for (int i = 0; i < 3; ++i) {
+		local_dir[i] = (p_mesh->_inv_world_matrix[i] * p_dir[0] + p_mesh->_inv_world_matrix[4 + i] * p_dir[1] + p_mesh->_inv_world_matrix[8 + i] * p_dir[2]) / dir_len;
+	}
+
+	struct triangle_bvh_hit hit;
+	if (!triangle_bvh_raycast(p_mesh->p_bvh, local_origin, local_dir, max_distance, &hit)) {
+		return 0;
+	}
+
+	p_hit->distance = hit.t;
+	vec3_mul_s(p_dir, hit.t / dir_len, p_hit->point);
+	vec3_add(p_hit->point, p_origin, p_hit->point);
+
+	// Normals transform by the inverse transpose
+	for (int i = 0; i < 3; ++i) {
+		p_hit->normal[i] = p_mesh->_inv_world_matrix[i * 4] * hit.normal[0] + p_mesh->_inv_world_matrix[i * 4 + 1] * hit.normal[1] + p_mesh->_inv_world_matrix[i * 4 + 2] * hit.normal[2];
+	}
+	vec3_norm(p_hit->normal, p_hit->normal);
+
+	// Face the normal against the ray, since triangles are double sided
+	if (vec3_dot(p_hit->normal, p_dir) > 0) {
+		vec3_inv(p_hit->normal, p_hit->normal);
+	}
+
+	return 1;
+}
+
+int physics_test_triangle_sphere_internal(const float p_triangle[3][3], const float* p_center, float radius, const float* p_side, struct physics_collision_result* p_result) {
+	float closest[3];
+	physics_closest_point_on_triangle(p_center, p_triangle, closest);
+
+	float ab[3];
+	vec3_sub(p_center, closest, ab);
+
+	const float d_sq = vec3_dot(ab, ab);
+
+	if (d_sq > radius * radius) {
+		*p_result = (struct physics_collision_result){0};
+		return 0;
+	}
+
+	const float d = sqrtf(d_sq);
+
+	if (d > 1e-6f) {
+		vec3_div_s(ab, d, p_result->ab_normal);
+	} else {
+		// Centre on the triangle: push out along the face normal, towards p_side
+		float e1[3];
+		float e2[3];
+		float to_side[3];
+		vec3_sub(p_triangle[1], p_triangle[0], e1);
+		vec3_sub(p_triangle[2], p_triangle[0], e2);
+		vec3_cross(e1, e2, p_result->ab_normal);
+		vec3_norm(p_result->ab_normal, p_result->ab_normal);
+		vec3_sub(p_side, p_triangle[0], to_side);
+		if (vec3_dot(to_side, p_result->ab_normal) < 0) {
+			vec3_inv(p_result->ab_normal, p_result->ab_normal);
+		}
+	}
+
+	p_result->depth = radius - d;
+	vec3_set(closest, p_result->a);
+	vec3_mul_s(p_result->ab_normal, -radius, p_result->b);
+	vec3_add(p_result->b, p_center, p_result->b);
+
+	return 1;
+}
+
+void physics_closest_point_on_triangle(const float* p_point, const float p_triangle[3][3], float* p_result) {
+	// Voronoi region classification (Ericson, Real-Time Collision Detection 5.1.5)
+	const float* a = p_triangle[0];
+	const float* b = p_triangle[1];
+	const float* c = p_triangle[2];
+
+	float ab[3];
+	float ac[3];
+	float ap[3];
+	float bp[3];
+	float cp[3];
+	vec3_sub(b, a, ab);
+	vec3_sub(c, a, ac);
+	vec3_sub(p_point, a, ap);
+
+	const float d1 = vec3_dot(ab, ap);
+	const float d2 = vec3_dot(ac, ap);
+	if (d1 <= 0 && d2 <= 0) {
+		vec3_set(a, p_result);
+		return;
+	}
+
+	vec3_sub(p_point, b, bp);
+	const float d3 = vec3_dot(ab, bp);
+	const float d4 = vec3_dot(ac, bp);
+	if (d3 >= 0 && d4 <= d3) {
+		vec3_set(b, p_result);
+		return;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+		vec3_mul_s(ab, d1 / (d1 - d3), p_result);
+		vec3_add(p_result, a, p_result);
+		return;
+	}
+
+	vec3_sub(p_point, c, cp);
+	const float d5 = vec3_dot(ab, cp);
+	const float d6 = vec3_dot(ac, cp);
+	if (d6 >= 0 && d5 <= d6) {
+		vec3_set(c, p_result);
+		return;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+		vec3_mul_s(ac, d2 / (d2 - d6), p_result);
+		vec3_add(p_result, a, p_result);
+		return;
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+		float bc[3];
+		vec3_sub(c, b, bc);
+		vec3_mul_s(bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)), p_result);
+		vec3_add(p_result, b, p_result);
+		return;
+	}
+
+	const float denom = 1.0f / (va + vb + vc);
+	float temp[3];
+	vec3_mul_s(ab, vb * denom, p_result);
+	vec3_mul_s(ac, vc * denom, temp);
+	vec3_add(p_result, temp, p_result);
+	vec3_add(p_result, a, p_result);
+}
+
+void physics_closest_points_segment_segment(const float* p_p0, const float* p_p1, const float* p_q0, const float* p_q1, float* p_result_p, float* p_result_q) {
+	// Ericson, Real-Time Collision Detection 5.1.9
+	float d1[3];
+	float d2[3];
+	float r[3];
+	vec3_sub(p_p1, p_p0, d1);
+	vec3_sub(p_q1, p_q0, d2);
+	vec3_sub(p_p0, p_q0, r);
+
+	const float a = vec3_dot(d1, d1);
+	const float e = vec3_dot(d2, d2);
+	const float f = vec3_dot(d2, r);
+	const float epsilon = 1e-12f;
+
+	float s = 0;
+	float t = 0;
+
+	if (a <= epsilon && e <= epsilon) {
+		s = t = 0;
+	} else if (a <= epsilon) {
+		t = fminf(fmaxf(f / e, 0), 1);
+	} else {
+		const float c = vec3_dot(d1, r);
+		if (e <= epsilon) {
+			s = fminf(fmaxf(-c / a, 0), 1);
+		} else {
+			const float b = vec3_dot(d1, d2);
+			const float denom = a * e - b * b;
+
+			s = denom > epsilon ? fminf(fmaxf((b * f - c * e) / denom, 0), 1) : 0;
+			t = (b * s + f) / e;
+
+			if (t < 0) {
+				t = 0;
+				s = fminf(fmaxf(-c / a, 0), 1);
+			} else if (t > 1) {
+				t = 1;
+				s = fminf(fmaxf((b - c) / a, 0), 1);
+			}
+		}
+	}
+
+	vec3_mul_s(d1, s, p_result_p);
+	vec3_add(p_result_p, p_p0, p_result_p);
+	vec3_mul_s(d2, t, p_result_q);
+	vec3_add(p_result_q, p_q0, p_result_q);
+}
+
+void physics_closest_points_segment_triangle(const float* p_p0, const float* p_p1, const float p_triangle[3][3], float* p_result_segment, float* p_result_triangle) {
+	// A segment crossing the triangle touches it at the crossing point
+	float e1[3];
+	float e2[3];
+	float dir[3];
+	float h[3];
+	float s[3];
+	float q[3];
+	vec3_sub(p_triangle[1], p_triangle[0], e1);
+	vec3_sub(p_triangle[2], p_triangle[0], e2);
+	vec3_sub(p_p1, p_p0, dir);
+	vec3_cross(dir, e2, h);
+
+	const float det = vec3_dot(e1, h);
+
+	if (fabsf(det) > 1e-12f) {
+		vec3_sub(p_p0, p_triangle[0], s);
+		vec3_cross(s, e1, q);
+
+		const float u = vec3_dot(s, h) / det;
+		const float v = vec3_dot(dir, q) / det;
+		const float t = vec3_dot(e2, q) / det;
+
+		if (u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t <= 1) {
+			vec3_mul_s(dir, t, p_result_segment);
+			vec3_add(p_result_segment, p_p0, p_result_segment);
+			vec3_set(p_result_segment, p_result_triangle);
+			return;
+		}
+	}
+
+	// Otherwise the closest pair involves a segment endpoint or a triangle edge
+	float best_dist_sq = INFINITY;
+	float segment_point[3];
+	float triangle_point[3];
+
+	for (int i = 0; i < 2; ++i) {
+		const float* p_end = i ? p_p1 : p_p0;
+		physics_closest_point_on_triangle(p_end, p_triangle, triangle_point);
+
+		const float dist_sq = vec3_dist_sq(p_end, triangle_point);
+		if (dist_sq < best_dist_sq) {
+			best_dist_sq = dist_sq;
+			vec3_set(p_end, p_result_segment);
+			vec3_set(triangle_point, p_result_triangle);
+		}
+	}
+
+	for (int i = 0; i < 3; ++i) {
+		physics_closest_points_segment_segment(p_p0, p_p1, p_triangle[i], p_triangle[(i + 1) % 3], segment_point, triangle_point);
+
+		const float dist_sq = vec3_dist_sq(segment_point, triangle_point);
+		if (dist_sq < best_dist_sq) {
+			best_dist_sq = dist_sq;
+			vec3_set(segment_point, p_result_segment);
+			vec3_set(triangle_point, p_result_triangle);
+		}
+	}
+}
+
+int physics_aabb_overlap(const float* p_min_a, const float* p_max_a, const float* p_min_b, const float* p_max_b) {
+	return p_min_a[0] <= p_max_b[0] && p_max_a[0] >= p_min_b[0]
+		&& p_min_a[1] <= p_max_b[1] && p_max_a[1] >= p_min_b[1]
+		&& p_min_a[2] <= p_max_b[2] && p_max_a[2] >= p_min_b[2];
+}
+
 // SOLVERS
 
 void physics_collision_solver_impulse(const struct physics_collision* p_collisions, size_t n, float delta_time) {
@@ -2,6 +2,7 @@
 #define _H__PHYSICS
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "darr.h"
 #include "object_pool.h"
@@ -41,9 +42,13 @@ enum physics_collider_type {
     PHYSICS_COLLIDER_TYPE_sphere,
     PHYSICS_COLLIDER_TYPE_capsule,
     PHYSICS_COLLIDER_TYPE_hull,
-    PHYSICS_COLLIDER_TYPE_plane
+    PHYSICS_COLLIDER_TYPE_plane,
+    PHYSICS_COLLIDER_TYPE_compound,
+    PHYSICS_COLLIDER_TYPE_mesh
 };
 
+struct triangle_bvh;
+
 struct physics_sphere {
     float center[3];
     float radius;
@@ -64,13 +69,48 @@ struct physics_plane {
     float distance;
 };
 
+// Node of a compound collider's local AABB tree. Nodes are stored depth-first, so an internal node's left child
+// directly follows it and only the right child needs an index.
+struct physics_aabb_node {
+    float    min[3];
+    float    max[3];
+    uint32_t right;
+    uint32_t hull; // index into the compound's hulls for leaves, PHYSICS_AABB_NODE_INTERNAL otherwise
+};
+
+#define PHYSICS_AABB_NODE_INTERNAL UINT32_MAX
+
+// Set of convex hulls sharing one transform, e.g. the output of a convex decomposition of concave level geometry.
+// Only the hulls whose local AABB overlaps the other collider are transformed and tested.
+struct physics_compound {
+    struct darr hulls; // struct physics_hull, vertices in local space
+    struct darr nodes; // struct physics_aabb_node
+    float       _world_matrix[16];
+    float       _inv_world_matrix[16];
+};
+
+// Static triangle mesh, e.g. level geometry. The BVH is shared and not owned by the collider.
+struct physics_mesh {
+    const struct triangle_bvh* p_bvh;
+    float                      _world_matrix[16];
+    float                      _inv_world_matrix[16];
+};
+
+struct physics_raycast_hit {
+    float point[3];
+    float normal[3];
+    float distance;
+};
+
 struct physics_collider {
     enum physics_collider_type type;
     union {
-        struct physics_sphere  as_sphere;
-        struct physics_capsule as_capsule;
-        struct physics_hull    as_hull;
-        struct physics_plane   as_plane;
+        struct physics_sphere   as_sphere;
+        struct physics_capsule  as_capsule;
+        struct physics_hull     as_hull;
+        struct physics_plane    as_plane;
+        struct physics_compound as_compound;
+        struct physics_mesh     as_mesh;
     };
     union {
         struct physics_sphere  as_sphere;
@@ -81,6 +121,12 @@ struct physics_collider {
 };
 
 void physics_collider_init(struct physics_collider* p_collider, enum physics_collider_type collider_type);
+void physics_collider_free(struct physics_collider* p_collider);
+void physics_collider_copy(const struct physics_collider* p_collider, struct physics_collider* p_result); // p_result must not own anything yet
+void physics_collider_compute_aabb(const struct physics_collider* p_collider, float* p_min, float* p_max);
+void physics_compound_add_hull(struct physics_collider* p_collider, const float* p_vertices, size_t num_vertices);
+void physics_compound_build_tree(struct physics_collider* p_collider);
+int  physics_mesh_raycast(const struct physics_collider* p_collider, const float* p_origin, const float* p_dir, float max_distance, struct physics_raycast_hit* p_hit);
 
 typedef void(*physics_collision_solver_func)(const struct physics_collision* p_collisions, size_t n, float delta_time);
 
@@ -151,6 +197,16 @@ int physics_test_collision_hull_plane(
     const struct physics_collider* p_a,
     const struct physics_collider* p_b,
     struct physics_collision_result* p_result);
+
+int physics_test_collision_compound(
+    const struct physics_collider* p_a,
+    const struct physics_collider* p_b,
+    struct physics_collision_result* p_result);
+
+int physics_test_collision_mesh(
+    const struct physics_collider* p_a,
+    const struct physics_collider* p_b,
+    struct physics_collision_result* p_result);
     
 void physics_collision_solver_impulse(const struct physics_collision* p_collisions, size_t n, float delta_time);
 void physics_collision_solver_smooth_positions(const struct physics_collision* p_collisions, size_t n, float delta_time);
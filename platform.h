@@ -9,7 +9,7 @@
 #define PLATFORM_WINDOWS 1
 #endif
 
-#if PLATFORM_WINDOWS
+#ifdef PLATFORM_WINDOWS
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
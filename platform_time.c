@@ -0,0 +1,34 @@
+#if defined(__linux__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "platform.h"
+#include "platform_time.h"
+
+#ifdef PLATFORM_WINDOWS
+
+double platform_time_seconds(void) {
+    static LARGE_INTEGER frequency;
+
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+#else
+
+#include <time.h>
+
+double platform_time_seconds(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+#endif
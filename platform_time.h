@@ -0,0 +1,7 @@
+#ifndef _H__PLATFORM_TIME
+#define _H__PLATFORM_TIME
+
+// Seconds on a monotonic wall clock, from an arbitrary start. Unlike clock(), it doesn't count time on other threads.
+double platform_time_seconds(void);
+
+#endif
@@ -2,7 +2,7 @@
 #include "platform_window.h"
 #include "vector.h"
 
-#if PLATFORM_WINDOWS
+#ifdef PLATFORM_WINDOWS
 
 static LRESULT CALLBACK wnd_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
 enum key                win32_vk_to_key(WORD vk);
@@ -98,6 +98,48 @@ void platform_window_get_mouse_client_coords(const struct platform_window* p_pla
     *p_y = p_platform_window->_mouse_pos[1];
 }
 
+#elif defined(PLATFORM_LINUX)
+
+// Headless: the window is just a size, always open until it's destroyed, and never has any input
+
+enum error platform_window_create(int width, int height, const char* s_title, struct platform_window* p_platform_window, void(*p_callback_on_created)(struct platform_window*, void*), void* p_callback_on_created_user_ptr) {
+    *p_platform_window = (struct platform_window) {
+        ._size = { width ? (unsigned int)width : 800, height ? (unsigned int)height : 600 },
+        ._b_is_open = 1,
+        ._p_callback_on_created = p_callback_on_created,
+        ._p_callback_on_created_user_ptr = p_callback_on_created_user_ptr
+    };
+
+    if (p_callback_on_created) {
+        p_callback_on_created(p_platform_window, p_callback_on_created_user_ptr);
+    }
+
+    return ERROR_OK;
+}
+
+void platform_window_destroy(struct platform_window* p_platform_window) {
+    *p_platform_window = (struct platform_window){0};
+}
+
+void platform_window_poll(struct platform_window* p_platform_window) {
+}
+
+int platform_window_is_open(const struct platform_window* p_platform_window) {
+    return p_platform_window->_b_is_open;
+}
+
+void platform_window_size(const struct platform_window* p_platform_window, unsigned int* p_width, unsigned int* p_height) {
+    *p_width = p_platform_window->_size[0];
+    *p_height = p_platform_window->_size[1];
+}
+
+void platform_window_get_mouse_client_coords(const struct platform_window* p_platform_window, int* p_x, int* p_y) {
+    *p_x = 0;
+    *p_y = 0;
+}
+
+#endif
+
 void platform_window_normalize_client_coords(const struct platform_window* p_platform_window, int client_x, int client_y, float* p_x, float* p_y) {
     unsigned int width, height;
     platform_window_size(p_platform_window, &width, &height);
@@ -170,6 +212,8 @@ void platform_window_set_on_char_callback(struct platform_window* p_platform_win
     p_platform_window->_p_callback_on_char_user_ptr = p_user_ptr;
 }
 
+#ifdef PLATFORM_WINDOWS
+
 LRESULT CALLBACK wnd_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     LRESULT result = 0;
 
@@ -7,11 +7,14 @@
 #include "platform.h"
 
 struct platform_window {
-#if PLATFORM_WINDOWS
+#ifdef PLATFORM_WINDOWS
     HWND  _hwnd;
     HDC   _hdc;
     SHORT _mouse_pos[2];
     SHORT _mouse_pos_old[2];
+#elif defined(PLATFORM_LINUX)
+    unsigned int _size[2]; // there's no windowing on Linux, only a size for the GL context's offscreen surface
+    int          _b_is_open;
 #endif
     void(*_p_callback_on_created)(struct platform_window*, void*);
     void* _p_callback_on_created_user_ptr;
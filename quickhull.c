@@ -1,9 +1,15 @@
 /* Quickhull algorithm implementation for generation of convex hulls from a point-cloud.
  * see: https://dpd.cs.princeton.edu/Papers/BarberDobkinHuhdanpaa.pdf
- * see also: https://media.steampowered.com/apps/valve/2014/DirkGregorius_ImplementingQuickHull.pdf */
+ * see also: https://media.steampowered.com/apps/valve/2014/DirkGregorius_ImplementingQuickHull.pdf
+ *
+ * Conflict points are tracked per face as contiguous arrays of indices into the input point cloud rather than as linked
+ * vertices, so only points that actually become part of the hull are turned into half-edge vertices. Each face caches its
+ * plane and the furthest of its conflict points, which lets point-plane distances be evaluated in batches and the next
+ * eye point be picked without revisiting every conflict point. */
 
 #include <float.h>
 #include <malloc.h>
+#include <string.h>
 
 #include "logging.h"
 #include "math_utils.h"
@@ -12,8 +18,23 @@
 #include "static_mesh.h"
 #include "vector.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define QH_SSE 1
+#else
+#define QH_SSE 0
+#endif
+
 #define QH_EPSILON_SCALE 1000
 
+// Discard points inside the octahedron spanned by the six axis-extreme points before building the hull (Akl-Toussaint heuristic)
+#ifndef QH_AKL_TOUSSAINT
+#define QH_AKL_TOUSSAINT 1
+#endif
+
+// Node capacity of the first vertex block. Edge and face blocks are scaled from it; each subsequent block doubles in size.
+#define QH_INITIAL_BLOCK_VERTICES 64
+
 #define CX_LOG_CAT_QH "quickhull"
 
 #define QH_DEBUG_LOG_EDGE(P_EDGE) CX_DBG_LOG_FMT(QH_LOG_CAT, "\t\tHalf-edge (%p) tail=[%f, %f, %f], head=[%f, %f, %f], p_face=%p, p_prev=%p, p_next=%p, p_twin=%p\n",\
@@ -22,18 +43,14 @@
 				P_EDGE->p_face, P_EDGE->p_prev, P_EDGE->p_next, P_EDGE->p_twin);\
 
 #define QH_DEBUG_LOG_FACE(P_FACE) {\
-		CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tFACE (%p) - Processed: %d, p_prev=%p, p_next=%p\n", P_FACE, P_FACE->b_qh_processed, P_FACE->p_prev, P_FACE->p_next);\
+		CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tFACE (%p) - Processed: %d, p_prev=%p, p_next=%p, conflicts=%d, furthest_dist=%f\n",\
+			P_FACE, P_FACE->b_qh_processed, P_FACE->p_prev, P_FACE->p_next, P_FACE->qh_conflicts._length, P_FACE->qh_furthest_dist);\
 		struct he_edge* p_edge_debug = P_FACE->p_edges;\
 		do {\
 			QH_DEBUG_LOG_EDGE(p_edge_debug);\
 			p_edge_debug = p_edge_debug->p_next;\
 		} while(p_edge_debug != P_FACE->p_edges);\
-		struct he_vertex* p_vertex_debug = P_FACE->p_qh_conflict_list;\
-		while (p_vertex_debug) {\
-			CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\t\tConflict Vertex (%p) [%f, %f, %f], p_prev=%p, p_next=%p\n",\
-				p_vertex_debug, p_vertex_debug->position[0], p_vertex_debug->position[1], p_vertex_debug->position[2], p_vertex_debug->p_prev, p_vertex_debug->p_next);\
-			p_vertex_debug = p_vertex_debug->p_next;\
-		} }
+		}
 
 #define QH_DEBUG_LOG_HULL(P_HULL, NOTE) {\
 		CX_DBG_LOG(CX_LOG_CAT_QH, "HULL FACES ("NOTE"):\n");\
@@ -51,36 +68,55 @@ struct qh_freelist_node {
 	struct qh_freelist_node* p_next;
 };
 
+struct qh_context {
+	struct he_mesh* p_hull;
+	const float*    p_points;
+	float           threshold;
+
+	size_t vertex_block_size;
+	size_t edge_block_size;
+	size_t face_block_size;
+
+	struct darr orphans;   // uint32_t point indices waiting to be assigned to a face
+	struct darr distances; // float scratch buffer for batched plane distances
+};
+
 static void                     qh_freelist_init(struct qh_freelist_node* p_head, size_t node_size, size_t n);
 static struct qh_freelist_node* qh_freelist_get(struct qh_freelist_node** pp_list);
 static void                     qh_freelist_set_head(struct qh_freelist_node** pp_list, struct qh_freelist_node* p_node);
 static void                     qh_freelist_erase(struct qh_freelist_node** pp_list, struct qh_freelist_node* p_node);
-static void                     qh_freelist_append(struct qh_freelist_node** pp_list, struct qh_freelist_node* p_node);
+static void*                    qh_alloc_node(struct qh_context* p_ctx, struct qh_freelist_node** pp_list, size_t node_size, size_t* p_block_size);
 
 static void  qh_compute_triangle_normal(const float* p_a, const float* p_b, const float* p_c, float* p_result);
-static float qh_face_vertex_dist_sq(const struct he_face* p_face, const struct he_vertex* p_vertex);
+static void  qh_compute_plane_distances(const float* p_plane, const float* p_points, const uint32_t* p_indices, size_t n, float* p_result);
 static int   qh_is_point_above_abc_plane(const float* p_a, const float* p_b, const float* p_c, const float* p_point, float threshold);
 static int   qh_is_point_above_face_plane(const struct he_face* p_face, const float* p_point, float threshold);
 static void  qh_compute_face_center(const struct he_face* p_face, float* p_result);
 static int   qh_edge_is_convex(const struct he_edge* p_edge, float threshold);
 
-static void qh_purge_duplicate_input_points(float* p_point_cloud, size_t* p_num_points);
-static void qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points, struct he_mesh* p_hull, struct he_vertex** pp_vertices, float* p_threshold);
-static void qh_find_initial_hull_half_edge_pairs(struct he_mesh* p_hull);
-
-static struct he_face* qh_construct_new_face(struct he_mesh* p_hull, struct he_vertex* p_fa, struct he_vertex* p_fb, struct he_vertex* p_fc);
-static void            qh_merge_edge_faces(struct he_mesh* p_hull, struct he_edge* p_edge);
-static void            qh_join_edges(struct he_edge* p_edge_head, struct he_edge* p_edge_tail);
-static void            qh_twin_edges(struct he_edge* p_edge_a, struct he_edge* p_edge_b);
-static void            qh_delete_hull_face(struct he_mesh* p_hull, struct he_face* p_face);
-
-static struct he_vertex* qh_next_conflict_vertex(struct he_mesh* p_hull, struct he_face** pp_face);
-static void              qh_find_horizon(struct he_edge* p_edge, const struct he_vertex* p_eye, struct he_edge** pp_horizon_start);
-static void              qh_construct_horizon_faces(struct he_mesh* p_hull, struct he_edge* p_horizon_start, struct he_vertex* p_eye, float threshold);
-static void              qh_distribute_conflict_vertices(struct he_mesh* p_hull, struct he_face* p_faces, struct he_vertex* p_vertices, float threshold);
-static void              qh_merge_coplanars(struct he_mesh* p_hull, float threshold);
-static void              qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, struct he_edge* p_edge_o);
-static void              qh_rebuild_face_plane(struct he_face* p_face);
+static void   qh_purge_duplicate_input_points(float* p_point_cloud, size_t* p_num_points);
+static void   qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points, size_t* p_extremes, size_t* p_initial_indices, float* p_threshold);
+static void   qh_collect_candidate_points(struct qh_context* p_ctx, size_t num_points, const size_t* p_extremes, const size_t* p_initial_indices);
+static size_t qh_prune_interior_points(struct qh_context* p_ctx, const size_t* p_extremes);
+static void   qh_find_initial_hull_half_edge_pairs(struct he_mesh* p_hull);
+
+static struct he_vertex* qh_construct_vertex(struct qh_context* p_ctx, const float* p_position);
+static struct he_face*   qh_construct_new_face(struct qh_context* p_ctx, struct he_vertex* p_fa, struct he_vertex* p_fb, struct he_vertex* p_fc);
+static void              qh_merge_edge_faces(struct qh_context* p_ctx, struct he_edge* p_edge);
+static void              qh_join_edges(struct he_edge* p_edge_head, struct he_edge* p_edge_tail);
+static void              qh_twin_edges(struct he_edge* p_edge_a, struct he_edge* p_edge_b);
+static void              qh_delete_hull_face(struct he_mesh* p_hull, struct he_face* p_face);
+static void              qh_append_conflicts(struct he_face* p_face, struct he_face* p_face_other);
+
+static int  qh_next_conflict_point(struct qh_context* p_ctx, struct he_face** pp_face, uint32_t* p_point_index);
+static void qh_find_horizon(struct he_edge* p_edge, const struct he_vertex* p_eye, struct he_edge** pp_horizon_start);
+static void qh_construct_horizon_faces(struct qh_context* p_ctx, struct he_edge* p_horizon_start, struct he_vertex* p_eye);
+static void qh_distribute_conflict_points(struct qh_context* p_ctx, struct he_face* p_faces, struct darr* p_indices);
+static void qh_update_furthest_conflict(struct qh_context* p_ctx, struct he_face* p_face);
+static void qh_merge_coplanars(struct qh_context* p_ctx);
+static void qh_fix_topology_errors(struct qh_context* p_ctx, struct he_edge* p_edge_i, struct he_edge* p_edge_o);
+static void qh_update_face_plane(struct he_face* p_face);
+static void qh_rebuild_face_plane(struct qh_context* p_ctx, struct he_face* p_face);
 
 void qh_freelist_init(struct qh_freelist_node* p_head, size_t node_size, size_t n) {
 	struct qh_freelist_node* p_node = p_head;
@@ -103,12 +139,12 @@ struct qh_freelist_node* qh_freelist_get(struct qh_freelist_node** pp_list) {
 	}
 
 	struct qh_freelist_node* r = *pp_list;
-	
+
 	*pp_list = r->p_next;
 	if (*pp_list) {
 		(*pp_list)->p_prev = 0;
 	}
-	
+
 	r->p_next = 0;
 	return r;
 }
@@ -120,7 +156,7 @@ void qh_freelist_set_head(struct qh_freelist_node** pp_list, struct qh_freelist_
 	if (p_node->p_next) {
 		p_node->p_next->p_prev = p_node;
 	}
-	
+
 	*pp_list = p_node;
 }
 
@@ -130,7 +166,7 @@ void qh_freelist_erase(struct qh_freelist_node** pp_list, struct qh_freelist_nod
 	} else {
 		*pp_list = p_node->p_next;
 	}
-	
+
 	if (p_node->p_next) {
 		p_node->p_next->p_prev = p_node->p_prev;
 	}
@@ -139,21 +175,20 @@ void qh_freelist_erase(struct qh_freelist_node** pp_list, struct qh_freelist_nod
 	p_node->p_next = 0;
 }
 
-void qh_freelist_append(struct qh_freelist_node** pp_list, struct qh_freelist_node* p_node) {
-	if (!p_node) {
-		return;
-	}
+void* qh_alloc_node(struct qh_context* p_ctx, struct qh_freelist_node** pp_list, size_t node_size, size_t* p_block_size) {
+	if (!*pp_list) {
+		// Out of nodes; chain a new block onto the hull buffer. Nodes never move, so existing pointers stay valid.
+		void** p_block = malloc(sizeof(void*) + node_size * *p_block_size);
+		*p_block = p_ctx->p_hull->p_buffer;
+		p_ctx->p_hull->p_buffer = p_block;
 
-	if (*pp_list) {
-		struct qh_freelist_node* p_n = *pp_list;
-		while (p_n->p_next) {
-			p_n = p_n->p_next;
-		}
-		p_n->p_next = p_node;
-		p_node->p_prev = p_n;
-	} else {
-		*pp_list = p_node;
+		qh_freelist_init((struct qh_freelist_node*)(p_block + 1), node_size, *p_block_size);
+		*pp_list = (struct qh_freelist_node*)(p_block + 1);
+
+		*p_block_size *= 2;
 	}
+
+	return qh_freelist_get(pp_list);
 }
 
 void qh_compute_triangle_normal(const float* p_a, const float* p_b, const float* p_c, float* p_result) {
@@ -166,66 +201,46 @@ void qh_compute_triangle_normal(const float* p_a, const float* p_b, const float*
 	vec3_norm(p_result, p_result);
 }
 
-float qh_face_vertex_dist_sq(const struct he_face* p_face, const struct he_vertex* p_vertex) {
-	// todo: we might be able to get away with not normalizing the normal here since we only want dist_sq
-
-	float normal[3];
-	qh_compute_triangle_normal(
-		p_face->p_edges->p_tail->position,
-		p_face->p_edges->p_next->p_tail->position,
-		p_face->p_edges->p_next->p_next->p_tail->position,
-		normal);
-
-	struct he_edge* p_edge = p_face->p_edges;
-	do {	
-		float av[3];
-		vec3_sub(p_vertex->position, p_edge->p_tail->position, av);
-
-		float edge_segment[3];
-		vec3_sub(p_edge->p_next->p_tail->position, p_edge->p_tail->position, edge_segment);
-
-		float cross[3];
-		vec3_cross(edge_segment, av, cross);
-
-		if (vec3_dot(cross, normal) < 0) {
-			// Vertex projection lays outside polygon. Compute closest edge distance.
-
-			float min_edge_dist_sq = FLT_MAX;
-
-			p_edge = p_face->p_edges;
-			do {
-				const float edge_dist_sq = segment_point_dist_sq(p_edge->p_tail->position, p_edge->p_next->p_tail->position, p_vertex->position);
-				if (edge_dist_sq < min_edge_dist_sq) {
-					min_edge_dist_sq = edge_dist_sq;
-				}
-				p_edge = p_edge->p_next;
-			} while(p_edge != p_face->p_edges);
-
-			return min_edge_dist_sq;
-		}
+void qh_compute_plane_distances(const float* p_plane, const float* p_points, const uint32_t* p_indices, size_t n, float* p_result) {
+	size_t i = 0;
 
-		p_edge = p_edge->p_next;
-	} while(p_edge != p_face->p_edges);
+#if QH_SSE
+	const __m128 nx = _mm_set1_ps(p_plane[0]);
+	const __m128 ny = _mm_set1_ps(p_plane[1]);
+	const __m128 nz = _mm_set1_ps(p_plane[2]);
+	const __m128 d  = _mm_set1_ps(p_plane[3]);
 
-	// Vertex projection lays inside polygon bounds. Return vertex distance to polygon plane.
+	for (; i + 4 <= n; i += 4) {
+		const float* p0 = &p_points[(size_t)p_indices[i + 0] * 3];
+		const float* p1 = &p_points[(size_t)p_indices[i + 1] * 3];
+		const float* p2 = &p_points[(size_t)p_indices[i + 2] * 3];
+		const float* p3 = &p_points[(size_t)p_indices[i + 3] * 3];
 
-	float point_to_plane[3];
-	vec3_sub(p_vertex->position, p_face->p_edges->p_tail->position, point_to_plane);
+		const __m128 x = _mm_set_ps(p3[0], p2[0], p1[0], p0[0]);
+		const __m128 y = _mm_set_ps(p3[1], p2[1], p1[1], p0[1]);
+		const __m128 z = _mm_set_ps(p3[2], p2[2], p1[2], p0[2]);
 
-	const float divisor = vec3_dot(normal, normal);
-	const float d = vec3_dot(point_to_plane, normal) / divisor;
+		const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)), _mm_add_ps(_mm_mul_ps(z, nz), d));
+		_mm_storeu_ps(&p_result[i], dist);
+	}
+#endif
 
-	return d * d;
+	for (; i < n; ++i) {
+		const float* p = &p_points[(size_t)p_indices[i] * 3];
+		p_result[i] = p_plane[0] * p[0] + p_plane[1] * p[1] + p_plane[2] * p[2] + p_plane[3];
+	}
 }
 
-void qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points, struct he_mesh* p_hull, struct he_vertex** pp_vertices, float* p_threshold) {
+void qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points, size_t* p_extremes, size_t* p_initial_indices, float* p_threshold) {
 	// Find the six extreme points of the point cloud (-X, +X, -Y, +Y, -Z, +Z)
 
-	size_t extremes[6] = {0};
+	size_t* extremes = p_extremes;
+	for (size_t i = 0; i < 6; ++i) {
+		extremes[i] = 0;
+	}
 
 	for (size_t i = 0; i < num_points; ++i) {
 		const float* p = &p_point_cloud[i * 3];
-		vec3_set(p, p_hull->p_free_vertices[i].position);
 		if (p[0] < p_point_cloud[extremes[0] * 3 + 0]) {
 			extremes[0] = i;
 		}
@@ -249,16 +264,11 @@ void qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points
 	*p_threshold = FLT_EPSILON * QH_EPSILON_SCALE * 3 * (
 		fmaxf(fabsf(p_point_cloud[extremes[0] * 3 + 0]), fabsf(p_point_cloud[extremes[1] * 3 + 0])) +
 		fmaxf(fabsf(p_point_cloud[extremes[2] * 3 + 1]), fabsf(p_point_cloud[extremes[3] * 3 + 1])) +
-		fmaxf(fabsf(p_point_cloud[extremes[4] * 3 + 2]), fabsf(p_point_cloud[extremes[1] * 5 + 2])));
-
-	// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Point cloud extremes:\n\tx_axis=([%f, %f, %f], [%f, %f, %f])\n\ty_axis=([%f, %f, %f], [%f, %f, %f])\n\tz_axis=([%f, %f, %f], [%f, %f, %f])\n"
-	// 	, p_point_cloud[extremes[0] * 3 + 0], p_point_cloud[extremes[0] * 3 + 1], p_point_cloud[extremes[0] * 3 + 2], p_point_cloud[extremes[1] * 3 + 0], p_point_cloud[extremes[1] * 3 + 1], p_point_cloud[extremes[1] * 3 + 2]
-	// 	, p_point_cloud[extremes[2] * 3 + 0], p_point_cloud[extremes[2] * 3 + 1], p_point_cloud[extremes[2] * 3 + 2], p_point_cloud[extremes[3] * 3 + 0], p_point_cloud[extremes[3] * 3 + 1], p_point_cloud[extremes[3] * 3 + 2]
-	// 	, p_point_cloud[extremes[4] * 3 + 0], p_point_cloud[extremes[4] * 3 + 1], p_point_cloud[extremes[4] * 3 + 2], p_point_cloud[extremes[5] * 3 + 0], p_point_cloud[extremes[5] * 3 + 1], p_point_cloud[extremes[5] * 3 + 2]);
+		fmaxf(fabsf(p_point_cloud[extremes[4] * 3 + 2]), fabsf(p_point_cloud[extremes[5] * 3 + 2])));
 
 	// Pick the two opposing vertices that are farthest apart to be the first two points of our tetrahedron
 
-	size_t iv[4];
+	size_t* iv = p_initial_indices;
 
 	float max;
 
@@ -287,61 +297,125 @@ void qh_find_initial_hull_vertices(const float* p_point_cloud, size_t num_points
 			max = d;
 			iv[2] = i;
 		}
-		// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Segment: [%f, %f, %f]->[%f, %f, %f], Point: [%f, %f, %f], distance: %f\n"
-		// 	, p_point_cloud[iv[0] * 3], p_point_cloud[iv[0] * 3 + 1], p_point_cloud[iv[0] * 3 + 2]
-		// 	, p_point_cloud[iv[1] * 3], p_point_cloud[iv[1] * 3 + 1], p_point_cloud[iv[1] * 3 + 2]
-		// 	, p[0], p[1], p[2]
-		// 	, sqrtf(d));
 	}
 
+	// Finally, pick the vertex farthest away from the triangle's plane
+
+	float normal[3];
+	qh_compute_triangle_normal(&p_point_cloud[iv[0] * 3], &p_point_cloud[iv[1] * 3], &p_point_cloud[iv[2] * 3], normal);
+
 	max = -FLT_MAX;
 	for (size_t i = 0; i < num_points; ++i) {
 		if (i == iv[0] || i == iv[1] || i == iv[2]) {
 			continue;
 		}
 
-		const float* p = &p_point_cloud[i * 3];
-
-		float normal[3];
-
-		float tmp[3];
-
-		vec3_sub(&p_point_cloud[iv[1] * 3], &p_point_cloud[iv[0] * 3], tmp);
-		vec3_sub(&p_point_cloud[iv[2] * 3], &p_point_cloud[iv[0] * 3], normal);
-		vec3_cross(tmp, normal, normal);
-		vec3_norm(normal, normal);
-
 		float point_to_plane[3];
-		vec3_sub(p, &p_point_cloud[iv[0] * 3], point_to_plane);
+		vec3_sub(&p_point_cloud[i * 3], &p_point_cloud[iv[0] * 3], point_to_plane);
 
-		const float divisor = vec3_dot(normal, normal);
-		const float d = vec3_dot(point_to_plane, normal) / divisor;
+		const float d = vec3_dot(point_to_plane, normal);
 		const float d_sq = d * d;
 		if (d_sq > max) {
 			max = d_sq;
-			iv[3] = i;  
+			iv[3] = i;
 		}
 	}
+}
 
-	pp_vertices[0] = &p_hull->p_free_vertices[iv[0]];
-	pp_vertices[1] = &p_hull->p_free_vertices[iv[1]];
-	pp_vertices[2] = &p_hull->p_free_vertices[iv[2]];
-	pp_vertices[3] = &p_hull->p_free_vertices[iv[3]];
+void qh_collect_candidate_points(struct qh_context* p_ctx, size_t num_points, const size_t* p_extremes, const size_t* p_initial_indices) {
+	darr_set_length(&p_ctx->orphans, num_points);
 
-	for (size_t i = 0; i < 4; ++i) {
-		if (pp_vertices[i]->p_prev) {
-			pp_vertices[i]->p_prev->p_next = pp_vertices[i]->p_next;
-		} else {
-			p_hull->p_free_vertices = pp_vertices[i]->p_next;
+	uint32_t* p_indices = p_ctx->orphans._p_buffer;
+	size_t n = 0;
+
+	for (size_t i = 0; i < num_points; ++i) {
+		if (i != p_initial_indices[0] && i != p_initial_indices[1] && i != p_initial_indices[2] && i != p_initial_indices[3]) {
+			p_indices[n++] = (uint32_t)i;
 		}
-		
-		if (pp_vertices[i]->p_next) {
-			pp_vertices[i]->p_next->p_prev = pp_vertices[i]->p_prev;
+	}
+
+	darr_set_length(&p_ctx->orphans, n);
+
+#if QH_AKL_TOUSSAINT
+	const size_t num_pruned = qh_prune_interior_points(p_ctx, p_extremes);
+	CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Pruned %u interior points\n", (unsigned int)num_pruned);
+	(void)num_pruned; // only logged in debug builds
+#endif
+}
+
+size_t qh_prune_interior_points(struct qh_context* p_ctx, const size_t* p_extremes) {
+	// Each octant of the octahedron spanned by the six extreme points contributes one face (-X/+X, -Y/+Y, -Z/+Z).
+	// Any point strictly below all eight face planes lies inside the hull of the extremes and cannot be a hull vertex.
+
+	float planes[8][4];
+
+	float centroid[3] = {0};
+	for (size_t i = 0; i < 6; ++i) {
+		vec3_add(centroid, &p_ctx->p_points[p_extremes[i] * 3], centroid);
+	}
+	vec3_div_s(centroid, 6, centroid);
+
+	for (size_t i = 0; i < 8; ++i) {
+		const float* p_x = &p_ctx->p_points[p_extremes[0 + ((i >> 0) & 1)] * 3];
+		const float* p_y = &p_ctx->p_points[p_extremes[2 + ((i >> 1) & 1)] * 3];
+		const float* p_z = &p_ctx->p_points[p_extremes[4 + ((i >> 2) & 1)] * 3];
+
+		float* p_plane = planes[i];
+
+		float ab[3], ac[3];
+		vec3_sub(p_y, p_x, ab);
+		vec3_sub(p_z, p_x, ac);
+		vec3_cross(ab, ac, p_plane);
+
+		const float len = vec3_len(p_plane);
+		if (len <= p_ctx->threshold) {
+			// Extremes are shared or collinear; the octahedron is degenerate and cannot be used
+			return 0;
 		}
 
-		pp_vertices[i]->p_prev =
-		pp_vertices[i]->p_next = 0;
+		vec3_div_s(p_plane, len, p_plane);
+		p_plane[3] = -vec3_dot(p_plane, p_x);
+
+		if (vec3_dot(p_plane, centroid) + p_plane[3] > 0) {
+			vec3_mul_s(p_plane, -1, p_plane);
+			p_plane[3] = -p_plane[3];
+		}
+
+		// Only a convex octahedron bounds a region inside the hull
+		for (size_t j = 0; j < 6; ++j) {
+			if (vec3_dot(p_plane, &p_ctx->p_points[p_extremes[j] * 3]) + p_plane[3] > p_ctx->threshold) {
+				return 0;
+			}
+		}
+	}
+
+	// Partition the candidates so that [0, num_inside) holds points that are still below every plane tested so far
+
+	uint32_t* p_indices = p_ctx->orphans._p_buffer;
+	const size_t n = p_ctx->orphans._length;
+	size_t num_inside = n;
+
+	darr_set_length(&p_ctx->distances, n);
+	float* p_distances = p_ctx->distances._p_buffer;
+
+	for (size_t i = 0; i < 8 && num_inside; ++i) {
+		qh_compute_plane_distances(planes[i], p_ctx->p_points, p_indices, num_inside, p_distances);
+
+		size_t m = 0;
+		for (size_t j = 0; j < num_inside; ++j) {
+			if (p_distances[j] < -p_ctx->threshold) {
+				const uint32_t tmp = p_indices[m];
+				p_indices[m++] = p_indices[j];
+				p_indices[j] = tmp;
+			}
+		}
+		num_inside = m;
 	}
+
+	memmove(p_indices, p_indices + num_inside, (n - num_inside) * sizeof(uint32_t));
+	darr_set_length(&p_ctx->orphans, n - num_inside);
+
+	return num_inside;
 }
 
 void qh_join_edges(struct he_edge* p_edge_head, struct he_edge* p_edge_tail) {
@@ -349,18 +423,23 @@ void qh_join_edges(struct he_edge* p_edge_head, struct he_edge* p_edge_tail) {
 	p_edge_tail->p_next = p_edge_head;
 }
 
-struct he_face* qh_construct_new_face(struct he_mesh* p_hull, struct he_vertex* p_fa, struct he_vertex* p_fb, struct he_vertex* p_fc) {
-	// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "New face: [%f, %f, %f]->[%f, %f, %f]->[%f, %f, %f]\n"
-	// 	, p_fa->position[0], p_fa->position[1], p_fa->position[2]
-	// 	, p_fb->position[0], p_fb->position[1], p_fb->position[2]
-	// 	, p_fc->position[0], p_fc->position[1], p_fc->position[2]);
+struct he_vertex* qh_construct_vertex(struct qh_context* p_ctx, const float* p_position) {
+	struct he_vertex* p_vertex = qh_alloc_node(p_ctx, (struct qh_freelist_node**)&p_ctx->p_hull->p_free_vertices, sizeof(struct he_vertex), &p_ctx->vertex_block_size);
+	vec3_set(p_position, p_vertex->position);
+	return p_vertex;
+}
+
+struct he_face* qh_construct_new_face(struct qh_context* p_ctx, struct he_vertex* p_fa, struct he_vertex* p_fb, struct he_vertex* p_fc) {
+	struct he_mesh* p_hull = p_ctx->p_hull;
 
-	struct he_face* p_face = (struct he_face*)qh_freelist_get((struct qh_freelist_node**)&p_hull->p_free_faces);
-	*p_face = (struct he_face){0};
+	struct he_face* p_face = qh_alloc_node(p_ctx, (struct qh_freelist_node**)&p_hull->p_free_faces, sizeof(struct he_face), &p_ctx->face_block_size);
+	*p_face = (struct he_face){ .b_qh_new = 1 };
+	darr_init(&p_face->qh_conflicts, sizeof(uint32_t));
 
-	qh_freelist_set_head((struct qh_freelist_node**)&p_face->p_edges, qh_freelist_get((struct qh_freelist_node**)&p_hull->p_free_edges));
-	qh_freelist_set_head((struct qh_freelist_node**)&p_face->p_edges, qh_freelist_get((struct qh_freelist_node**)&p_hull->p_free_edges));
-	qh_freelist_set_head((struct qh_freelist_node**)&p_face->p_edges, qh_freelist_get((struct qh_freelist_node**)&p_hull->p_free_edges));
+	for (size_t i = 0; i < 3; ++i) {
+		qh_freelist_set_head((struct qh_freelist_node**)&p_face->p_edges,
+			qh_alloc_node(p_ctx, (struct qh_freelist_node**)&p_hull->p_free_edges, sizeof(struct he_edge), &p_ctx->edge_block_size));
+	}
 
 	qh_join_edges(p_face->p_edges, p_face->p_edges->p_next->p_next);
 
@@ -376,7 +455,9 @@ struct he_face* qh_construct_new_face(struct he_mesh* p_hull, struct he_vertex*
 
 		p_edge = p_edge->p_next;
 	} while(p_edge != p_face->p_edges);
-	
+
+	qh_update_face_plane(p_face);
+
 	return p_face;
 }
 
@@ -415,82 +496,96 @@ void qh_find_initial_hull_half_edge_pairs(struct he_mesh* p_hull) {
 	}
 }
 
-void qh_distribute_conflict_vertices(struct he_mesh* p_hull, struct he_face* p_faces, struct he_vertex* p_vertices, float threshold) {
-	struct he_vertex* p_vertex = p_vertices;
-	while (p_vertex) {
-		struct he_face* p_closest_face = 0;
-		float closest_face_dist_sq = FLT_MAX;
+void qh_distribute_conflict_points(struct qh_context* p_ctx, struct he_face* p_faces, struct darr* p_indices) {
+	// Each point is assigned to the first face it is in front of. Points that are behind every new face lie inside the
+	// hull and are dropped.
+
+	uint32_t* p_points = p_indices->_p_buffer;
+	size_t n = p_indices->_length;
 
-		struct he_face* p_face = p_faces;
-		while (p_face) {
-			if (qh_is_point_above_face_plane(p_face, p_vertex->position, -threshold)) {
-				const float face_dist_sq = qh_face_vertex_dist_sq(p_face, p_vertex);
+	darr_set_length(&p_ctx->distances, n);
+	float* p_distances = p_ctx->distances._p_buffer;
 
-				if (face_dist_sq < closest_face_dist_sq) {
-					closest_face_dist_sq = face_dist_sq;
-					p_closest_face = p_face;
+	struct he_face* p_face = p_faces;
+	while (p_face && n) {
+		qh_compute_plane_distances(p_face->qh_plane, p_ctx->p_points, p_points, n, p_distances);
+
+		size_t m = 0;
+		for (size_t i = 0; i < n; ++i) {
+			if (p_distances[i] > p_ctx->threshold) {
+				if (p_distances[i] > p_face->qh_furthest_dist) {
+					p_face->qh_furthest_dist = p_distances[i];
+					p_face->qh_furthest_conflict = (uint32_t)p_face->qh_conflicts._length;
 				}
+				*(uint32_t*)darr_push(&p_face->qh_conflicts) = p_points[i];
+			} else {
+				p_points[m++] = p_points[i];
 			}
-
-			p_face = p_face->p_next;
 		}
+		n = m;
 
 #if QH_DEBUG
-		if (p_closest_face) {
-			CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tConflict vertex (%p) moved to face (%p) conflict list\n", p_vertex, p_closest_face);
-		} else {
-			CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tConflict vertex (%p) freed\n", p_vertex);
-		}
+		CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tFace (%p) received %d conflict points\n", p_face, p_face->qh_conflicts._length);
 #endif
-		
-		struct he_vertex* p_next = p_vertex->p_next;
 
-		if (p_closest_face) {
-			if (p_vertices == p_hull->p_free_vertices) {
-				qh_freelist_erase((struct qh_freelist_node**)&p_hull->p_free_vertices, (struct qh_freelist_node*)p_vertex);
-			}
-			qh_freelist_set_head((struct qh_freelist_node**)&p_closest_face->p_qh_conflict_list, (struct qh_freelist_node*)p_vertex);
-		} else if (p_vertices != p_hull->p_free_vertices) {
-			qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_vertices, (struct qh_freelist_node*)p_vertex);
+		p_face = p_face->p_next;
+	}
+
+	darr_set_length(p_indices, 0);
+}
+
+void qh_update_furthest_conflict(struct qh_context* p_ctx, struct he_face* p_face) {
+	p_face->qh_furthest_dist = 0;
+	p_face->qh_furthest_conflict = 0;
+
+	const size_t n = p_face->qh_conflicts._length;
+	if (n == 0) {
+		return;
+	}
+
+	darr_set_length(&p_ctx->distances, n);
+	float* p_distances = p_ctx->distances._p_buffer;
+
+	qh_compute_plane_distances(p_face->qh_plane, p_ctx->p_points, p_face->qh_conflicts._p_buffer, n, p_distances);
+
+	for (size_t i = 0; i < n; ++i) {
+		if (p_distances[i] > p_face->qh_furthest_dist) {
+			p_face->qh_furthest_dist = p_distances[i];
+			p_face->qh_furthest_conflict = (uint32_t)i;
 		}
-		
-		p_vertex = p_next;
 	}
 }
 
-struct he_vertex* qh_next_conflict_vertex(struct he_mesh* p_hull, struct he_face** pp_face) {
-	struct he_vertex* p_conflict_vertex = 0;
-	float dist_sq = -FLT_MAX;
+int qh_next_conflict_point(struct qh_context* p_ctx, struct he_face** pp_face, uint32_t* p_point_index) {
+	struct he_face* p_furthest_face = 0;
+	float dist = p_ctx->threshold;
 
-	struct he_face* p_face = p_hull->p_faces;
+	struct he_face* p_face = p_ctx->p_hull->p_faces;
 	while (p_face) {
-		if (p_face->p_qh_conflict_list) {
-			struct he_vertex* p_vertex = p_face->p_qh_conflict_list;
-			while (p_vertex) {
-				const float vertex_dist_sq = qh_face_vertex_dist_sq(p_face, p_vertex);
-
-				if (vertex_dist_sq > dist_sq) {
-					*pp_face = p_face;
-					p_conflict_vertex = p_vertex;
-					dist_sq = vertex_dist_sq;
-				}
-
-				p_vertex = p_vertex->p_next;
-			}
+		if (p_face->qh_conflicts._length && p_face->qh_furthest_dist > dist) {
+			p_furthest_face = p_face;
+			dist = p_face->qh_furthest_dist;
 		}
 
 		p_face = p_face->p_next;
 	}
 
-	if (p_conflict_vertex) {
-		qh_freelist_erase((struct qh_freelist_node**)&(*pp_face)->p_qh_conflict_list, (struct qh_freelist_node*)p_conflict_vertex);
+	if (!p_furthest_face) {
+		return 0;
 	}
 
+	*pp_face = p_furthest_face;
+	*p_point_index = *(uint32_t*)darr_get(&p_furthest_face->qh_conflicts, p_furthest_face->qh_furthest_conflict);
+
+	// The face is visible from the eye point and will be deleted along with its conflict list, so the cached furthest
+	// point does not need to be recomputed here
+	darr_remove(&p_furthest_face->qh_conflicts, p_furthest_face->qh_furthest_conflict);
+
 #if QH_DEBUG
-	CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "NEXT CONFLICT VERTEX: (%p) face=(%p)\n", p_conflict_vertex, *pp_face);
+	CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "NEXT CONFLICT POINT: (%d) face=(%p)\n", *p_point_index, *pp_face);
 #endif
 
-	return p_conflict_vertex;
+	return 1;
 }
 
 // todo: unmake recursive?
@@ -520,23 +615,11 @@ int qh_is_point_above_abc_plane(const float* p_a, const float* p_b, const float*
 	float rel_point[3];
 	vec3_sub(p_point, p_a, rel_point);
 
-	// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "qh_is_point_above_abc_plane:\n\tabc=([%f, %f, %f], [%f, %f, %f], [%f, %f, %f])\n\tpoint=[%f, %f, %f], normal=[%f, %f, %f]\n\trel_point=[%f, %f, %f], threshold=%f, rel_point.normal=%f\n"
-	// 	, p_a[0], p_a[1], p_a[2]
-	// 	, p_b[0], p_b[1], p_b[2]
-	// 	, p_c[0], p_c[1], p_c[2]
-	// 	, p_point[0], p_point[1], p_point[2]
-	// 	, normal[0], normal[1], normal[2]
-	// 	, rel_point[0], rel_point[1], rel_point[2], -threshold, vec3_dot(rel_point, normal));
-	
 	return vec3_dot(rel_point, normal) > -threshold;
 }
 
 int qh_is_point_above_face_plane(const struct he_face* p_face, const float* p_point, float threshold) {
-	return qh_is_point_above_abc_plane(
-		p_face->p_edges->p_tail->position,
-		p_face->p_edges->p_next->p_tail->position,
-		p_face->p_edges->p_next->p_next->p_tail->position,
-		p_point, threshold);
+	return vec3_dot(p_face->qh_plane, p_point) + p_face->qh_plane[3] > -threshold;
 }
 
 void qh_compute_face_center(const struct he_face* p_face, float* p_result) {
@@ -571,16 +654,31 @@ int qh_edge_is_convex(const struct he_edge* p_edge, float threshold) {
 }
 
 void qh_delete_hull_face(struct he_mesh* p_hull, struct he_face* p_face) {
+	darr_free(&p_face->qh_conflicts);
 	qh_freelist_erase((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)p_face);
 	qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_faces, (struct qh_freelist_node*)p_face);
 }
 
+void qh_append_conflicts(struct he_face* p_face, struct he_face* p_face_other) {
+	const size_t offset = p_face->qh_conflicts._length;
+	const size_t n = p_face_other->qh_conflicts._length;
+
+	if (n == 0) {
+		return;
+	}
+
+	darr_set_length(&p_face->qh_conflicts, offset + n);
+	memcpy(darr_get(&p_face->qh_conflicts, offset), p_face_other->qh_conflicts._p_buffer, n * sizeof(uint32_t));
+	darr_set_length(&p_face_other->qh_conflicts, 0);
+}
+
 void qh_twin_edges(struct he_edge* p_edge_a, struct he_edge* p_edge_b) {
 	p_edge_a->p_twin = p_edge_b;
 	p_edge_b->p_twin = p_edge_a;
 }
 
-void qh_merge_edge_faces(struct he_mesh* p_hull, struct he_edge* p_edge) {
+void qh_merge_edge_faces(struct qh_context* p_ctx, struct he_edge* p_edge) {
+	struct he_mesh* p_hull = p_ctx->p_hull;
 	struct he_face* p_face = p_edge->p_face;
 	struct he_edge* p_edge2 = p_edge->p_twin;
 	struct he_face* p_face2 = p_edge2->p_face;
@@ -599,7 +697,7 @@ void qh_merge_edge_faces(struct he_mesh* p_hull, struct he_edge* p_edge) {
 	qh_join_edges(p_edge->p_next, p_edge2->p_prev);
 	qh_join_edges(p_edge2->p_next, p_edge->p_prev);
 
-	qh_freelist_append((struct qh_freelist_node**)&p_face->p_qh_conflict_list, (struct qh_freelist_node*)p_face2->p_qh_conflict_list);
+	qh_append_conflicts(p_face, p_face2);
 
 	if (p_edge == p_face->p_edges) {
 		p_face->p_edges = p_edge->p_prev->p_next;
@@ -609,8 +707,8 @@ void qh_merge_edge_faces(struct he_mesh* p_hull, struct he_edge* p_edge) {
 	qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_edges, (struct qh_freelist_node*)p_edge2);
 
 	qh_delete_hull_face(p_hull, p_face2);
-	
-	qh_rebuild_face_plane(p_face);
+
+	qh_rebuild_face_plane(p_ctx, p_face);
 
 #if QH_DEBUG
 	CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tFace post-merge:\n", p_face);
@@ -618,11 +716,12 @@ void qh_merge_edge_faces(struct he_mesh* p_hull, struct he_edge* p_edge) {
 #endif
 }
 
-void qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, struct he_edge* p_edge_o) {
+void qh_fix_topology_errors(struct qh_context* p_ctx, struct he_edge* p_edge_i, struct he_edge* p_edge_o) {
 	if (p_edge_i->p_twin->p_face != p_edge_o->p_twin->p_face) {
 		return;
 	}
 
+	struct he_mesh* p_hull = p_ctx->p_hull;
 	struct he_face* p_face = p_edge_o->p_face;
 
 	if (p_edge_o->p_twin->p_prev == p_edge_i->p_twin->p_next) {
@@ -636,13 +735,13 @@ void qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, st
 
 		qh_join_edges(p_outer_edge, p_edge_i->p_prev);
 		qh_join_edges(p_edge_o->p_next, p_outer_edge);
-		
-		qh_freelist_append((struct qh_freelist_node**)&p_face->p_qh_conflict_list, (struct qh_freelist_node*)p_outer_edge->p_face->p_qh_conflict_list);
-		
+
+		qh_append_conflicts(p_face, p_outer_edge->p_face);
+
 		if (p_outer_edge_prev_old->p_twin->p_face->p_edges == p_outer_edge_prev_old->p_twin) {
 			p_outer_edge_prev_old->p_twin->p_face->p_edges  = p_outer_edge;
 		}
-		
+
 		if (p_outer_edge_next_old->p_twin->p_face->p_edges == p_outer_edge_next_old->p_twin) {
 			p_outer_edge_next_old->p_twin->p_face->p_edges = p_outer_edge;
 		}
@@ -657,10 +756,10 @@ void qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, st
 
 		p_outer_edge->p_face = p_face;
 
-		qh_rebuild_face_plane(p_face);
-				
-		qh_fix_topology_errors(p_hull, p_outer_edge, p_outer_edge->p_next);
-		qh_fix_topology_errors(p_hull, p_outer_edge->p_prev, p_outer_edge);
+		qh_rebuild_face_plane(p_ctx, p_face);
+
+		qh_fix_topology_errors(p_ctx, p_outer_edge, p_outer_edge->p_next);
+		qh_fix_topology_errors(p_ctx, p_outer_edge->p_prev, p_outer_edge);
 	} else {
 #if QH_DEBUG
 		CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Topological error! Ingoing (%p) and outgoing (%p) merge edges pointing to same face (%p) (error 2)\n", p_edge_i, p_edge_o, p_edge_o->p_twin->p_face);
@@ -686,6 +785,9 @@ void qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, st
 		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_vertices, (struct qh_freelist_node*)p_edge_r1->p_tail);
 		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_edges, (struct qh_freelist_node*)p_edge_r1);
 		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_free_edges, (struct qh_freelist_node*)p_edge_r2);
+
+		qh_update_face_plane(p_edge_s1->p_face);
+		qh_update_face_plane(p_edge_s2->p_face);
 	}
 
 #if QH_DEBUG
@@ -693,11 +795,14 @@ void qh_fix_topology_errors(struct he_mesh* p_hull, struct he_edge* p_edge_i, st
 #endif
 }
 
-void qh_rebuild_face_plane(struct he_face* p_face) {
-	float plane[4] = {0};
+void qh_update_face_plane(struct he_face* p_face) {
+	// Newell's method; exact for triangles and robust for the slightly non-planar polygons left behind by merging
+	float* plane = p_face->qh_plane;
 	float sum[3] = {0};
 	size_t num_vertices = 0;
-	
+
+	vec3_set_s(0, plane);
+
 	struct he_edge* p_edge = p_face->p_edges;
 	do {
 		const float* p_p1 = p_edge->p_tail->position;
@@ -706,41 +811,48 @@ void qh_rebuild_face_plane(struct he_face* p_face) {
 		plane[0] += (p_p1[1] - p_p2[1]) * (p_p1[2] + p_p2[2]);
 		plane[1] += (p_p1[2] - p_p2[2]) * (p_p1[0] + p_p2[0]);
 		plane[2] += (p_p1[0] - p_p2[0]) * (p_p1[1] + p_p2[1]);
-		
+
 		vec3_add(sum, p_p1, sum);
-		
+
 		++num_vertices;
-		
+
 		p_edge = p_edge->p_next;
 	} while(p_edge != p_face->p_edges);
-	
+
 	const float len = vec3_len(plane);
-	
+
 	plane[3] = -vec3_dot(sum, plane) / (len * num_vertices);
 
 	vec3_div_s(plane, len, plane);
+}
 
-	float original_normal[3];
-	qh_compute_triangle_normal(p_face->p_edges->p_tail->position, p_face->p_edges->p_next->p_tail->position, p_face->p_edges->p_next->p_next->p_tail->position, original_normal);
+void qh_rebuild_face_plane(struct qh_context* p_ctx, struct he_face* p_face) {
+	qh_update_face_plane(p_face);
 
-	// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Rebuilding face plane: original_normal=[%f, %f, %f], new_plane=([%f, %f, %f], %f)\n", original_normal[0], original_normal[1], original_normal[2], plane[0], plane[1], plane[2], plane[3]);
-	
-	p_edge = p_face->p_edges;
-	do {		
+	const float* plane = p_face->qh_plane;
+
+	struct he_edge* p_edge = p_face->p_edges;
+	do {
 		float offset[3];
 		vec3_mul_s(plane, vec3_dot(plane, p_edge->p_tail->position) + plane[3], offset);
 
-		// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tOld vertex position=[%f, %f, %f]\n", p_edge->p_tail->position[0], p_edge->p_tail->position[1], p_edge->p_tail->position[2]);
-
 		vec3_sub(p_edge->p_tail->position, offset, p_edge->p_tail->position);
 
-		// CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\tNew vertex position=[%f, %f, %f]\n", p_edge->p_tail->position[0], p_edge->p_tail->position[1], p_edge->p_tail->position[2]);
+		p_edge = p_edge->p_next;
+	} while(p_edge != p_face->p_edges);
+
+	// Projecting the vertices nudges the neighbouring faces too; keep their cached planes in sync
 
+	p_edge = p_face->p_edges;
+	do {
+		qh_update_face_plane(p_edge->p_twin->p_face);
 		p_edge = p_edge->p_next;
 	} while(p_edge != p_face->p_edges);
+
+	qh_update_furthest_conflict(p_ctx, p_face);
 }
 
-void qh_construct_horizon_faces(struct he_mesh* p_hull, struct he_edge* p_horizon_start, struct he_vertex* p_eye, float threshold) {
+void qh_construct_horizon_faces(struct qh_context* p_ctx, struct he_edge* p_horizon_start, struct he_vertex* p_eye) {
 #if QH_DEBUG
 	CX_DBG_LOG(CX_LOG_CAT_QH, "HORIZON EDGES:\n");
 	struct he_edge* p_temp_horizon_edge = p_horizon_start;
@@ -750,11 +862,13 @@ void qh_construct_horizon_faces(struct he_mesh* p_hull, struct he_edge* p_horizo
 	}
 #endif
 
+	struct he_mesh* p_hull = p_ctx->p_hull;
+
 	struct he_face* p_new_faces = 0;
 
 	struct he_edge* p_horizon_edge = p_horizon_start;
-	
-	qh_freelist_set_head((struct qh_freelist_node**)&p_new_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, p_horizon_edge->p_tail, p_horizon_edge->p_next->p_tail, p_eye));
+
+	qh_freelist_set_head((struct qh_freelist_node**)&p_new_faces, (struct qh_freelist_node*)qh_construct_new_face(p_ctx, p_horizon_edge->p_tail, p_horizon_edge->p_next->p_tail, p_eye));
 
 	qh_twin_edges(p_horizon_edge->p_twin, p_new_faces->p_edges);
 
@@ -763,32 +877,33 @@ void qh_construct_horizon_faces(struct he_mesh* p_hull, struct he_edge* p_horizo
 	struct he_face* p_new_faces_back = p_new_faces;
 
 	while (p_horizon_edge) {
-		qh_freelist_set_head((struct qh_freelist_node**)&p_new_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, p_horizon_edge->p_tail, p_horizon_edge->p_next->p_tail, p_eye));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_new_faces, (struct qh_freelist_node*)qh_construct_new_face(p_ctx, p_horizon_edge->p_tail, p_horizon_edge->p_next->p_tail, p_eye));
 
 		qh_twin_edges(p_horizon_edge->p_twin, p_new_faces->p_edges);
 		qh_twin_edges(p_new_faces->p_edges->p_next, p_new_faces->p_next->p_edges->p_next->p_next);
-		
+
 		p_horizon_edge = p_horizon_edge->p_qh_horizon_next;
 	}
 
 	qh_twin_edges(p_new_faces_back->p_edges->p_next, p_new_faces->p_edges->p_next->p_next);
 
+	// Gather the conflict points of every visible face into one batch, then delete the faces
+
 	struct he_face* p_face = p_hull->p_faces;
 	while (p_face) {
 		struct he_face* p_next = p_face->p_next;
 
 		if (p_face->b_qh_processed) {
 #if QH_DEBUG
-			CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Deleting redundant face (%p) and redistributing conflict vertices:\n", p_face);
-			struct he_vertex* p_vertex_debug = p_face->p_qh_conflict_list;
-			while (p_vertex_debug) {
-				CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "\t\tConflict Vertex (%p) [%f, %f, %f], p_prev=%p, p_next=%p\n",
-				p_vertex_debug, p_vertex_debug->position[0], p_vertex_debug->position[1], p_vertex_debug->position[2], p_vertex_debug->p_prev, p_vertex_debug->p_next);
-				p_vertex_debug = p_vertex_debug->p_next;
-			}
+			CX_DBG_LOG_FMT(CX_LOG_CAT_QH, "Deleting redundant face (%p) and redistributing %d conflict points\n", p_face, p_face->qh_conflicts._length);
 #endif
 
-			qh_distribute_conflict_vertices(p_hull, p_new_faces, p_face->p_qh_conflict_list, threshold);
+			const size_t offset = p_ctx->orphans._length;
+			const size_t n = p_face->qh_conflicts._length;
+			if (n) {
+				darr_set_length(&p_ctx->orphans, offset + n);
+				memcpy(darr_get(&p_ctx->orphans, offset), p_face->qh_conflicts._p_buffer, n * sizeof(uint32_t));
+			}
 
 			struct he_edge* p_edge = p_face->p_edges;
 			do {
@@ -802,55 +917,54 @@ void qh_construct_horizon_faces(struct he_mesh* p_hull, struct he_edge* p_horizo
 
 		p_face = p_next;
 	}
-	
+
+	qh_distribute_conflict_points(p_ctx, p_new_faces, &p_ctx->orphans);
+
 	p_hull->p_faces->p_prev = p_new_faces_back;
 	p_new_faces_back->p_next = p_hull->p_faces;
-	
+
 	p_hull->p_faces = p_new_faces;
-	
+
 #if QH_DEBUG
 	QH_DEBUG_LOG_HULL(p_hull, "Post-horizon-construction");
 #endif
 }
 
-void qh_merge_coplanars(struct he_mesh* p_hull, float threshold) {
-	struct he_face* p_face = p_hull->p_faces;
-	while (p_face) {
+void qh_merge_coplanars(struct qh_context* p_ctx) {
+	// Only the cone of faces built around the latest eye point can have introduced non-convex edges. New faces sit at the
+	// head of the face list and keep their flag through merges, so the scan stops at the first face from an older pass.
+	struct he_face* p_face = p_ctx->p_hull->p_faces;
+	while (p_face && p_face->b_qh_new) {
 		struct he_face* p_next = p_face->p_next;
 		struct he_edge* p_edge = p_face->p_edges;
 		do {
-			
-			if (qh_edge_is_convex(p_edge, threshold)) {
-				// CX_DBG_LOG(CX_LOG_CAT_QH, "EDGE IS CONVEX\n");
-				// QH_DEBUG_LOG_FACE(p_edge->p_face);
-				// QH_DEBUG_LOG_FACE(p_edge->p_twin->p_face);
+
+			if (qh_edge_is_convex(p_edge, p_ctx->threshold)) {
 				p_edge = p_edge->p_next;
 				continue;
 			}
-			
-			// CX_DBG_LOG(CX_LOG_CAT_QH, "EDGE IS NON-CONVEX\n");
-			// QH_DEBUG_LOG_FACE(p_edge->p_face);
-			// QH_DEBUG_LOG_FACE(p_edge->p_twin->p_face);
-			
+
 			struct he_edge* p_edge1_i = p_edge->p_twin->p_prev;
 			struct he_edge* p_edge1_o = p_edge->p_next;
 			struct he_edge* p_edge2_i = p_edge->p_prev;
 			struct he_edge* p_edge2_o = p_edge->p_twin->p_next;
-			
-			qh_merge_edge_faces(p_hull, p_edge);
 
-			qh_fix_topology_errors(p_hull, p_edge1_i, p_edge1_o);
-			qh_fix_topology_errors(p_hull, p_edge2_i, p_edge2_o);
-			
-			p_next = p_hull->p_faces;
+			qh_merge_edge_faces(p_ctx, p_edge);
+
+			qh_fix_topology_errors(p_ctx, p_edge1_i, p_edge1_o);
+			qh_fix_topology_errors(p_ctx, p_edge2_i, p_edge2_o);
+
+			p_next = p_ctx->p_hull->p_faces;
 			break;
 		} while(p_edge != p_face->p_edges);
 		p_face = p_next;
 	}
-	
-#if QH_DEBUG
-	//QH_DEBUG_LOG_HULL(p_hull, "Post-merge");
-#endif
+
+	p_face = p_ctx->p_hull->p_faces;
+	while (p_face && p_face->b_qh_new) {
+		p_face->b_qh_new = 0;
+		p_face = p_face->p_next;
+	}
 }
 
 static int qh_sort_cmp(const float* p_a, const float* p_b) {
@@ -902,32 +1016,40 @@ void qh_purge_duplicate_input_points(float* p_point_cloud, size_t* p_num_points)
 }
 
 void quickhull(float* p_point_cloud, size_t num_points, struct he_mesh* p_hull) {
+	*p_hull = (struct he_mesh){0};
+
 	qh_purge_duplicate_input_points(p_point_cloud, &num_points);
-	
-	const size_t max_edges = (3 * num_points - 6) * 4;
-	const size_t max_faces = (2 * num_points - 4) * 2;
-	const size_t size_chunk0 = sizeof(struct he_vertex) * num_points;
-	const size_t size_chunk1 = sizeof(struct he_edge) * max_edges;
-	const size_t size_chunk2 = sizeof(struct he_face) * max_faces;
-	
-	cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_QH, "Generating convex hull for point cloud: num_points=%d, max_edges=%d, max_faces=%d\n", num_points, max_edges, max_faces);
 
-	*p_hull = (struct he_mesh){0};
+	if (num_points < 4) {
+		cx_log_fmt(CX_LOG_ERROR, CX_LOG_CAT_QH, "Cannot generate convex hull from fewer than 4 unique points (%d)\n", num_points);
+		return;
+	}
 
-	p_hull->p_buffer = calloc(1, size_chunk0 + size_chunk1 + size_chunk2);
+	// Node blocks start small and grow on demand. The hull's complexity tends to be a small fraction of the input size,
+	// so an Euler-bound allocation over every input point would mostly go untouched.
+	const size_t initial_vertices = num_points < QH_INITIAL_BLOCK_VERTICES ? num_points : QH_INITIAL_BLOCK_VERTICES;
 
-	p_hull->p_free_vertices = p_hull->p_buffer;
-	p_hull->p_free_edges = (void*)((char*)p_hull->p_free_vertices + size_chunk0);
-	p_hull->p_free_faces = (void*)((char*)p_hull->p_free_edges + size_chunk1);
+	struct qh_context ctx = {
+		.p_hull            = p_hull,
+		.p_points          = p_point_cloud,
+		.vertex_block_size = initial_vertices,
+		.edge_block_size   = (3 * initial_vertices - 6) * 2,
+		.face_block_size   = 2 * initial_vertices - 4
+	};
+	darr_init(&ctx.orphans, sizeof(uint32_t));
+	darr_init(&ctx.distances, sizeof(float));
 
-	qh_freelist_init((struct qh_freelist_node*)p_hull->p_free_vertices, sizeof(*p_hull->p_free_vertices), num_points);
-	qh_freelist_init((struct qh_freelist_node*)p_hull->p_free_edges, sizeof(*p_hull->p_free_edges), max_edges);
-	qh_freelist_init((struct qh_freelist_node*)p_hull->p_free_faces, sizeof(*p_hull->p_free_faces), max_faces);
+	cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_QH, "Generating convex hull for point cloud: num_points=%d\n", num_points);
 
-	struct he_vertex* initial_hull_vertices[4];
-	float threshold;
+	size_t extremes[6];
+	size_t initial_indices[4];
+
+	qh_find_initial_hull_vertices(p_point_cloud, num_points, extremes, initial_indices, &ctx.threshold);
 
-	qh_find_initial_hull_vertices(p_point_cloud, num_points, p_hull, initial_hull_vertices, &threshold);
+	struct he_vertex* initial_hull_vertices[4];
+	for (size_t i = 0; i < 4; ++i) {
+		initial_hull_vertices[i] = qh_construct_vertex(&ctx, &p_point_cloud[initial_indices[i] * 3]);
+	}
 
 	const int b_is_acb = qh_is_point_above_abc_plane(
 		initial_hull_vertices[0]->position,
@@ -936,51 +1058,56 @@ void quickhull(float* p_point_cloud, size_t num_points, struct he_mesh* p_hull)
 		initial_hull_vertices[3]->position, 0);
 
 	if (b_is_acb) {
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[2], initial_hull_vertices[1]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[3], initial_hull_vertices[2]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[1], initial_hull_vertices[3]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[1], initial_hull_vertices[2], initial_hull_vertices[3]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[2], initial_hull_vertices[1]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[3], initial_hull_vertices[2]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[1], initial_hull_vertices[3]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[1], initial_hull_vertices[2], initial_hull_vertices[3]));
 	} else {
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[1], initial_hull_vertices[2]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[2], initial_hull_vertices[3]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[0], initial_hull_vertices[3], initial_hull_vertices[1]));
-		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(p_hull, initial_hull_vertices[1], initial_hull_vertices[3], initial_hull_vertices[2]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[1], initial_hull_vertices[2]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[2], initial_hull_vertices[3]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[0], initial_hull_vertices[3], initial_hull_vertices[1]));
+		qh_freelist_set_head((struct qh_freelist_node**)&p_hull->p_faces, (struct qh_freelist_node*)qh_construct_new_face(&ctx, initial_hull_vertices[1], initial_hull_vertices[3], initial_hull_vertices[2]));
 	}
 
 	qh_find_initial_hull_half_edge_pairs(p_hull);
 
-	qh_distribute_conflict_vertices(p_hull, p_hull->p_faces, p_hull->p_free_vertices, threshold);
+	qh_collect_candidate_points(&ctx, num_points, extremes, initial_indices);
+
+	qh_distribute_conflict_points(&ctx, p_hull->p_faces, &ctx.orphans);
 
 #if QH_DEBUG
 	QH_DEBUG_LOG_HULL(p_hull, "Initial hull");
 #endif
 
 	size_t i = 0;
-	
+
 	struct he_face* p_conflict_face = 0;
-	struct he_vertex* p_conflict_vertex = qh_next_conflict_vertex(p_hull, &p_conflict_face);
-	while (p_conflict_vertex) {
-#if QH_DEBUG
-		// if (i == 2) {
-		// 	break;
-		// }
-#endif
+	uint32_t conflict_point_index;
+	while (qh_next_conflict_point(&ctx, &p_conflict_face, &conflict_point_index)) {
+		struct he_vertex* p_eye = qh_construct_vertex(&ctx, &p_point_cloud[(size_t)conflict_point_index * 3]);
 
 		struct he_edge* p_horizon_start = 0;
-		qh_find_horizon(p_conflict_face->p_edges, p_conflict_vertex, &p_horizon_start);
-		
-		qh_construct_horizon_faces(p_hull, p_horizon_start, p_conflict_vertex, threshold);
+		qh_find_horizon(p_conflict_face->p_edges, p_eye, &p_horizon_start);
+
+		qh_construct_horizon_faces(&ctx, p_horizon_start, p_eye);
 
-		qh_merge_coplanars(p_hull, threshold);
+		qh_merge_coplanars(&ctx);
 
 		++i;
-		
-		p_conflict_vertex = qh_next_conflict_vertex(p_hull, &p_conflict_face);
-		
-		// QH_DEBUG_LOG_HULL(p_hull, "Post-next-conflict-vertex");
 	}
-	
-	cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_QH, "Completed in %d steps. Epsilon=%f\n", i, threshold);
+
+	// Release whatever conflict storage is left on the final faces
+
+	struct he_face* p_face = p_hull->p_faces;
+	while (p_face) {
+		darr_free(&p_face->qh_conflicts);
+		p_face = p_face->p_next;
+	}
+
+	darr_free(&ctx.orphans);
+	darr_free(&ctx.distances);
+
+	cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_QH, "Completed in %d steps. Epsilon=%f\n", i, ctx.threshold);
 }
 
 void quickhull_static_mesh(const struct static_mesh* p_static_mesh, struct he_mesh* p_result) {
@@ -993,6 +1120,8 @@ void quickhull_static_mesh(const struct static_mesh* p_static_mesh, struct he_me
 
 	float* point_cloud_points = malloc(num_vertices * sizeof(float) * 3);
 
+	size_t num_points = 0;
+
 	for (size_t i = 0; i < p_static_mesh->num_primitives; ++i) {
 		const struct mesh_primitive* p_primitive = &p_static_mesh->p_primitives[i];
 
@@ -1014,16 +1143,16 @@ void quickhull_static_mesh(const struct static_mesh* p_static_mesh, struct he_me
 
 		for (size_t v = 0; v < p_primitive->vertex_count; ++v) {
 			const float* p_v = (float*)((char*)p_position_buffer->p_bytes + p_position_attribute->layout.offset + (p_position_attribute->layout.stride * v));
-			vec3_set(p_v, &point_cloud_points[v * 3]);
+			vec3_set(p_v, &point_cloud_points[num_points * 3]);
+			++num_points;
 		}
 	}
 
-	quickhull(point_cloud_points, num_vertices, p_result);
+	quickhull(point_cloud_points, num_points, p_result);
 
 	free(point_cloud_points);
 }
 
 void quickhull_free(struct he_mesh* p_mesh) {
-	free(p_mesh->p_buffer);
-	*p_mesh = (struct he_mesh){0};
-}
\ No newline at end of file
+	half_edge_free(p_mesh);
+}
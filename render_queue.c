@@ -0,0 +1,280 @@
+#include <string.h>
+
+#include "render_queue.h"
+
+#define RENDER_QUEUE_RADIX_BITS   8
+#define RENDER_QUEUE_RADIX_SIZE   (1 << RENDER_QUEUE_RADIX_BITS)
+#define RENDER_QUEUE_RADIX_PASSES (64 / RENDER_QUEUE_RADIX_BITS)
+
+// Sorting these rather than the items themselves moves 16 bytes per item per pass instead of the whole item
+struct render_queue_entry {
+    uint64_t key;
+    uint32_t item;
+};
+
+static uint64_t render_queue_key_field(uint32_t value, uint32_t bits);
+static uint32_t render_queue_depth_bits(float depth);
+static int      render_queue_same_state(const struct render_item* p_item0, const struct render_item* p_item1);
+static size_t   render_queue_count_instances(const struct render_queue* p_queue, size_t entry);
+
+uint64_t render_queue_make_key(uint32_t pass, uint32_t program, uint32_t texture, float depth) {
+    uint64_t key = render_queue_key_field(pass, RENDER_QUEUE_KEY_PASS_BITS);
+    key = (key << RENDER_QUEUE_KEY_PROGRAM_BITS) | render_queue_key_field(program, RENDER_QUEUE_KEY_PROGRAM_BITS);
+    key = (key << RENDER_QUEUE_KEY_TEXTURE_BITS) | render_queue_key_field(texture, RENDER_QUEUE_KEY_TEXTURE_BITS);
+    key = (key << RENDER_QUEUE_KEY_DEPTH_BITS) | render_queue_depth_bits(depth);
+    return key;
+}
+
+uint64_t render_queue_make_batch_key(uint32_t pass, uint32_t program, uint32_t texture, uint32_t batch) {
+    return (render_queue_make_key(pass, program, texture, 0) & ~render_queue_key_field(UINT32_MAX, RENDER_QUEUE_KEY_DEPTH_BITS)) | batch;
+}
+
+void render_queue_init(struct render_queue* p_queue) {
+    darr_init(&p_queue->_items, sizeof(struct render_item));
+    darr_init(&p_queue->_entries, sizeof(struct render_queue_entry));
+    darr_init(&p_queue->_scratch, sizeof(struct render_queue_entry));
+    darr_init(&p_queue->commands, sizeof(struct render_command));
+    darr_init(&p_queue->instance_matrices, sizeof(float) * 16);
+    darr_init(&p_queue->multi_draw_meshes, sizeof(const void*));
+}
+
+void render_queue_free(struct render_queue* p_queue) {
+    darr_free(&p_queue->_items);
+    darr_free(&p_queue->_entries);
+    darr_free(&p_queue->_scratch);
+    darr_free(&p_queue->commands);
+    darr_free(&p_queue->instance_matrices);
+    darr_free(&p_queue->multi_draw_meshes);
+}
+
+void render_queue_clear(struct render_queue* p_queue) {
+    p_queue->_items._length = 0;
+    p_queue->_entries._length = 0;
+    p_queue->commands._length = 0;
+    p_queue->instance_matrices._length = 0;
+    p_queue->multi_draw_meshes._length = 0;
+}
+
+struct render_item* render_queue_push(struct render_queue* p_queue) {
+    struct render_item* p_item = darr_push(&p_queue->_items);
+    *p_item = (struct render_item){0};
+    return p_item;
+}
+
+size_t render_queue_length(const struct render_queue* p_queue) {
+    return p_queue->_items._length;
+}
+
+void render_queue_sort(struct render_queue* p_queue) {
+    const size_t n = p_queue->_items._length;
+    const struct render_item* p_items = p_queue->_items._p_buffer;
+
+    darr_set_length(&p_queue->_entries, n);
+    darr_set_length(&p_queue->_scratch, n);
+
+    struct render_queue_entry* p_src = p_queue->_entries._p_buffer;
+    struct render_queue_entry* p_dst = p_queue->_scratch._p_buffer;
+
+    // Every pass's histogram comes from one read of the keys
+    size_t counts[RENDER_QUEUE_RADIX_PASSES][RENDER_QUEUE_RADIX_SIZE] = {{0}};
+
+    for (size_t i = 0; i < n; ++i) {
+        p_src[i] = (struct render_queue_entry) {
+            .key = p_items[i].key,
+            .item = (uint32_t)i
+        };
+
+        for (size_t pass = 0; pass < RENDER_QUEUE_RADIX_PASSES; ++pass) {
+            ++counts[pass][(p_items[i].key >> (pass * RENDER_QUEUE_RADIX_BITS)) & (RENDER_QUEUE_RADIX_SIZE - 1)];
+        }
+    }
+
+    for (size_t pass = 0; pass < RENDER_QUEUE_RADIX_PASSES && n; ++pass) {
+        const size_t shift = pass * RENDER_QUEUE_RADIX_BITS;
+        size_t* p_counts = counts[pass];
+
+        // Digits every key shares, such as an unused pass field, need no pass at all
+        if (p_counts[(p_src[0].key >> shift) & (RENDER_QUEUE_RADIX_SIZE - 1)] == n) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < RENDER_QUEUE_RADIX_SIZE; ++digit) {
+            const size_t count = p_counts[digit];
+            p_counts[digit] = offset;
+            offset += count;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            p_dst[p_counts[(p_src[i].key >> shift) & (RENDER_QUEUE_RADIX_SIZE - 1)]++] = p_src[i];
+        }
+
+        struct render_queue_entry* p_swap = p_src;
+        p_src = p_dst;
+        p_dst = p_swap;
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (p_src != p_queue->_entries._p_buffer) {
+        const struct darr swap = p_queue->_entries;
+        p_queue->_entries = p_queue->_scratch;
+        p_queue->_scratch = swap;
+    }
+}
+
+void render_queue_build_commands(struct render_queue* p_queue) {
+    const struct render_item* p_items = p_queue->_items._p_buffer;
+    const struct render_queue_entry* p_entries = p_queue->_entries._p_buffer;
+    const size_t n = p_queue->_entries._length;
+
+    uint32_t program = RENDER_QUEUE_NONE;
+    uint32_t texture = RENDER_QUEUE_NONE;
+    float color[3] = {0};
+    int b_color_set = 0;
+
+    p_queue->commands._length = 0;
+    p_queue->instance_matrices._length = 0;
+    p_queue->multi_draw_meshes._length = 0;
+
+    for (size_t i = 0; i < n;) {
+        const struct render_item* p_item = &p_items[p_entries[i].item];
+        struct render_command* p_command;
+
+        const size_t num_instances = render_queue_count_instances(p_queue, i);
+
+        // Items that won't be instanced can still share one call with their neighbours that won't be either
+        size_t num_draws = 1;
+        if (num_instances == 1) {
+            while (i + num_draws < n) {
+                const struct render_item* p_next = &p_items[p_entries[i + num_draws].item];
+
+                if (!render_queue_same_state(p_item, p_next) || p_next->p_model_matrix != p_item->p_model_matrix || render_queue_count_instances(p_queue, i + num_draws) > 1) {
+                    break;
+                }
+
+                ++num_draws;
+            }
+        }
+
+        const uint32_t item_program = num_instances > 1 ? p_item->instanced_program : p_item->program;
+
+        if (item_program != program) {
+            p_command = darr_push(&p_queue->commands);
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_program,
+                .as_program = item_program
+            };
+            program = item_program;
+
+            // Uniforms belong to the program, so the new one hasn't seen this color yet
+            b_color_set = 0;
+        }
+
+        if (p_item->texture != texture) {
+            p_command = darr_push(&p_queue->commands);
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_texture,
+                .as_texture = p_item->texture
+            };
+            texture = p_item->texture;
+        }
+
+        if (!b_color_set || memcmp(color, p_item->color, sizeof(color)) != 0) {
+            p_command = darr_push(&p_queue->commands);
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_color,
+                .as_color = { p_item->color[0], p_item->color[1], p_item->color[2] }
+            };
+            memcpy(color, p_item->color, sizeof(color));
+            b_color_set = 1;
+        }
+
+        p_command = darr_push(&p_queue->commands);
+
+        if (num_instances > 1) {
+            const size_t first_instance = p_queue->instance_matrices._length;
+            darr_set_length(&p_queue->instance_matrices, first_instance + num_instances);
+
+            float* p_matrices = darr_get(&p_queue->instance_matrices, first_instance);
+            for (size_t j = 0; j < num_instances; ++j) {
+                memcpy(&p_matrices[j * 16], p_items[p_entries[i + j].item].p_model_matrix, sizeof(float) * 16);
+            }
+
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_draw_instanced,
+                .as_draw_instanced = {
+                    .p_mesh = p_item->p_mesh,
+                    .first_instance = (uint32_t)first_instance,
+                    .num_instances = (uint32_t)num_instances
+                }
+            };
+        } else if (num_draws > 1) {
+            const size_t first_mesh = p_queue->multi_draw_meshes._length;
+            darr_set_length(&p_queue->multi_draw_meshes, first_mesh + num_draws);
+
+            const void** pp_meshes = darr_get(&p_queue->multi_draw_meshes, first_mesh);
+            for (size_t j = 0; j < num_draws; ++j) {
+                pp_meshes[j] = p_items[p_entries[i + j].item].p_mesh;
+            }
+
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_draw_multi,
+                .as_draw_multi = {
+                    .p_model_matrix = p_item->p_model_matrix,
+                    .first_mesh = (uint32_t)first_mesh,
+                    .num_meshes = (uint32_t)num_draws
+                }
+            };
+        } else {
+            *p_command = (struct render_command) {
+                .type = RENDER_COMMAND_TYPE_draw,
+                .as_draw = {
+                    .p_mesh = p_item->p_mesh,
+                    .p_model_matrix = p_item->p_model_matrix
+                }
+            };
+        }
+
+        i += num_instances > 1 ? num_instances : num_draws;
+    }
+}
+
+uint64_t render_queue_key_field(uint32_t value, uint32_t bits) {
+    return (uint64_t)value & ((UINT64_C(1) << bits) - 1);
+}
+
+uint32_t render_queue_depth_bits(float depth) {
+    // Non-negative IEEE floats order the same as their bit patterns
+    uint32_t bits;
+    depth = depth > 0 ? depth : 0;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+int render_queue_same_state(const struct render_item* p_item0, const struct render_item* p_item1) {
+    return p_item0->program == p_item1->program
+        && p_item0->instanced_program == p_item1->instanced_program
+        && p_item0->texture == p_item1->texture
+        && memcmp(p_item0->color, p_item1->color, sizeof(p_item0->color)) == 0;
+}
+
+size_t render_queue_count_instances(const struct render_queue* p_queue, size_t entry) {
+    const struct render_item* p_items = p_queue->_items._p_buffer;
+    const struct render_queue_entry* p_entries = p_queue->_entries._p_buffer;
+    const struct render_item* p_item = &p_items[p_entries[entry].item];
+
+    size_t num_instances = 1;
+    if (p_item->instanced_program) {
+        while (entry + num_instances < p_queue->_entries._length) {
+            const struct render_item* p_next = &p_items[p_entries[entry + num_instances].item];
+
+            if (p_next->p_mesh != p_item->p_mesh || !render_queue_same_state(p_item, p_next)) {
+                break;
+            }
+
+            ++num_instances;
+        }
+    }
+
+    return num_instances;
+}
@@ -0,0 +1,89 @@
+#ifndef _H__RENDER_QUEUE
+#define _H__RENDER_QUEUE
+
+#include <stdint.h>
+
+#include "darr.h"
+
+#define RENDER_QUEUE_NONE UINT32_MAX
+
+/* Sort key layout, most significant first, so a sorted queue groups draws by pass, then program, then texture, and
+ * draws each group front to back. Batch keys put a batch id where the depth goes instead, so items that can be
+ * instanced together end up next to each other. Fields wider than their bits only lose grouping, never correctness,
+ * as state is compared by value when the commands are built. */
+#define RENDER_QUEUE_KEY_PASS_BITS    4
+#define RENDER_QUEUE_KEY_PROGRAM_BITS 12
+#define RENDER_QUEUE_KEY_TEXTURE_BITS 16
+#define RENDER_QUEUE_KEY_DEPTH_BITS   32
+
+/* What a system wants drawn. Handles are backend objects (GL names for gl_render_queue) and p_mesh a backend mesh.
+ * Items with an instanced program that end up next to each other with the same mesh and state are drawn as one
+ * instanced batch through that program instead. Otherwise, neighbours with the same state and model matrix, such as
+ * the primitives of one mesh, are handed to the backend together so it can multi-draw them. */
+struct render_item {
+    uint64_t     key;
+    uint32_t     program;
+    uint32_t     instanced_program; // variant taking the model matrix per instance, or 0 to always draw singly
+    uint32_t     texture;
+    float        color[3];
+    const float* p_model_matrix;
+    const void*  p_mesh;
+};
+
+enum render_command_type {
+    RENDER_COMMAND_TYPE_program,
+    RENDER_COMMAND_TYPE_texture,
+    RENDER_COMMAND_TYPE_color,
+    RENDER_COMMAND_TYPE_draw,
+    RENDER_COMMAND_TYPE_draw_instanced,
+    RENDER_COMMAND_TYPE_draw_multi
+};
+
+struct render_command {
+    enum render_command_type type;
+    union {
+        uint32_t as_program;
+        uint32_t as_texture;
+        float    as_color[3];
+        struct {
+            const void*  p_mesh;
+            const float* p_model_matrix;
+        } as_draw;
+        struct {
+            const void* p_mesh;
+            uint32_t    first_instance; // into render_queue.instance_matrices
+            uint32_t    num_instances;
+        } as_draw_instanced;
+        struct {
+            const float* p_model_matrix;
+            uint32_t     first_mesh; // into render_queue.multi_draw_meshes
+            uint32_t     num_meshes;
+        } as_draw_multi;
+    };
+};
+
+struct render_queue {
+    struct darr _items;            // struct render_item
+    struct darr _entries;          // struct render_queue_entry, the sorted order
+    struct darr _scratch;          // struct render_queue_entry
+    struct darr commands;          // struct render_command, from the latest render_queue_build_commands
+    struct darr instance_matrices; // float[16] per instance of the draw_instanced commands
+    struct darr multi_draw_meshes; // const void*, the meshes of the draw_multi commands
+};
+
+uint64_t render_queue_make_key(uint32_t pass, uint32_t program, uint32_t texture, float depth); // depth >= 0
+uint64_t render_queue_make_batch_key(uint32_t pass, uint32_t program, uint32_t texture, uint32_t batch); // groups by batch, e.g. mesh, instead of depth
+
+void                render_queue_init(struct render_queue* p_queue);
+void                render_queue_free(struct render_queue* p_queue);
+void                render_queue_clear(struct render_queue* p_queue);
+struct render_item* render_queue_push(struct render_queue* p_queue); // valid until the next push
+size_t              render_queue_length(const struct render_queue* p_queue);
+
+// Radix sorts the items by key, keeping push order among equal keys
+void render_queue_sort(struct render_queue* p_queue);
+
+// Turns the items, as of the latest render_queue_sort, into commands without binds and uploads that change nothing
+void render_queue_build_commands(struct render_queue* p_queue);
+
+#endif
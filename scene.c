@@ -1,77 +1,591 @@
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "hashtable.h"
 #include "logging.h"
 #include "matrix.h"
 #include "scene.h"
+#include "serialization.h"
+#include "static_mesh.h"
+
+#define SCENE_FILE_VERSION 1
+#define SCENE_FILE_NONE    UINT32_MAX
+
+/* Serialized scenes are a small header followed by one block: the ids of every asset the scene references, then one
+ * record per entity. Records are in depth order so a parent is always created before its children, and refer to
+ * parents and assets by index so loading is a single pass with no lookups per entity. */
+struct scene_file_entity {
+    float    position[3];
+    float    rotation[4];
+    float    scale[3];
+    uint32_t parent_index;
+    uint32_t mesh_index; // into the asset id table
+};
+
+static void     scene_release_entity(struct scene* p_scene, struct scene_entity* p_entity);
+static uint32_t scene_entity_depth(const struct scene_entity* p_entity);
+
+static const size_t g_scene_component_sizes[SCENE_COMPONENT_count] = {
+    [SCENE_COMPONENT_mesh]           = sizeof(asset_handle),
+    [SCENE_COMPONENT_physics_object] = sizeof(struct physics_object*),
+    [SCENE_COMPONENT_bounds]         = sizeof(struct scene_bounds)
+};
 
 void scene_init(struct scene* p_scene) {
     *p_scene = (struct scene){0};
     object_pool_init(&p_scene->_entity_pool, sizeof(struct scene_entity), 1024);
-    darr_init(&p_scene->_entities, sizeof(struct scene_entity*));
+    darr_init(&p_scene->_entity_slots, sizeof(struct scene_entity_slot));
+    darr_init(&p_scene->_free_entity_slots, sizeof(uint32_t));
+    transform_hierarchy_init(&p_scene->_transform_hierarchy);
+    spatial_index_init(&p_scene->spatial_index, SCENE_SPATIAL_INDEX_CELL_SIZE);
+
+    for (size_t i = 0; i < SCENE_COMPONENT_count; ++i) {
+        sparse_set_init(&p_scene->_components[i], g_scene_component_sizes[i]);
+    }
 
     cx_log(CX_LOG_TRACE, "scene", "Scene initialised\n");
 }
 
 void scene_destroy(struct scene* p_scene) {
     object_pool_free(&p_scene->_entity_pool);
-    darr_free(&p_scene->_entities);
+    darr_free(&p_scene->_entity_slots);
+    darr_free(&p_scene->_free_entity_slots);
+    transform_hierarchy_free(&p_scene->_transform_hierarchy);
+    spatial_index_free(&p_scene->spatial_index);
+
+    for (size_t i = 0; i < SCENE_COMPONENT_count; ++i) {
+        sparse_set_free(&p_scene->_components[i]);
+    }
 }
 
 struct scene_entity* scene_new_entity(struct scene* p_scene) {
-    struct scene_entity* p_new_entity = object_pool_get(&p_scene->_entity_pool);
+    struct scene_entity* p_new_entity;
+    return scene_new_entities(p_scene, 1, &p_new_entity) ? p_new_entity : 0;
+}
+
+size_t scene_new_entities(struct scene* p_scene, size_t n, struct scene_entity** pp_entities) {
+    const size_t num_free_slots = p_scene->_free_entity_slots._length;
+    const size_t num_unused_ids = (size_t)SCENE_ENTITY_INDEX_MASK + 1 - p_scene->_entity_slots._length;
+
+    if (n > num_free_slots + num_unused_ids) {
+        cx_log(CX_LOG_ERROR, "scene", "Out of entity ids\n");
+        n = num_free_slots + num_unused_ids;
+    }
+
+    n = object_pool_get_many(&p_scene->_entity_pool, n, (void**)pp_entities);
 
-    if (!p_new_entity) {
+    if (n == 0) {
         return 0;
     }
 
-    *p_new_entity = (struct scene_entity) {
-        ._id = p_scene->_next_entity_id
-    };
+    // Reserving exactly would realloc on every single spawn, so grow at least geometrically
+    const size_t slots_capacity = p_scene->_entity_slots._capacity;
+    if (n > num_free_slots && slots_capacity < p_scene->_entity_slots._length + n - num_free_slots) {
+        const size_t required = p_scene->_entity_slots._length + n - num_free_slots;
+        darr_set_capacity(&p_scene->_entity_slots, required > slots_capacity * 2 ? required : slots_capacity * 2);
+    }
+    transform_hierarchy_reserve(&p_scene->_transform_hierarchy, p_scene->_transform_hierarchy._transforms._length + n);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t index;
+
+        if (p_scene->_free_entity_slots._length) {
+            index = *(uint32_t*)darr_get(&p_scene->_free_entity_slots, p_scene->_free_entity_slots._length - 1);
+            darr_remove_back(&p_scene->_free_entity_slots);
+        } else {
+            index = (uint32_t)p_scene->_entity_slots._length;
+            *(struct scene_entity_slot*)darr_push(&p_scene->_entity_slots) = (struct scene_entity_slot) {
+                .generation = 1
+            };
+        }
+
+        struct scene_entity_slot* p_slot = darr_get(&p_scene->_entity_slots, index);
+        p_slot->p_entity = pp_entities[i];
+
+        *pp_entities[i] = (struct scene_entity) {
+            ._id = (p_slot->generation << SCENE_ENTITY_INDEX_BITS) | index
+        };
+
+        transform_make_identity(&pp_entities[i]->transform);
+        transform_hierarchy_add(&p_scene->_transform_hierarchy, &pp_entities[i]->transform);
+    }
+
+    p_scene->_num_entities += n;
 
-    transform_make_identity(&p_new_entity->transform);
-    
     struct scene_entity_event_data e = {
         .p_scene = p_scene,
-        .p_entity = p_new_entity
+        .pp_entities = pp_entities,
+        .num_entities = n
     };
     event_broadcast(&p_scene->on_new_entity, &e);
 
-    struct scene_entity** pp_new_entity = darr_push(&p_scene->_entities);
-    *pp_new_entity = p_new_entity;
-    
-    ++p_scene->_next_entity_id;
-    
-    cx_log_fmt(CX_LOG_TRACE, "scene", "Entity created (id=%u)\n", p_new_entity->_id);
+    if (n == 1) {
+        cx_log_fmt(CX_LOG_TRACE, "scene", "Entity created (id=%u)\n", pp_entities[0]->_id);
+    } else {
+        cx_log_fmt(CX_LOG_TRACE, "scene", "Entities created (count=%u)\n", (unsigned int)n);
+    }
 
-    return p_new_entity;
+    return n;
 }
 
 void scene_destroy_entity(struct scene* p_scene, struct scene_entity* p_entity) {
     struct scene_entity_event_data e = {
         .p_scene = p_scene,
-        .p_entity = p_entity
+        .pp_entities = &p_entity,
+        .num_entities = 1
     };
-    event_broadcast(&p_scene->on_new_entity, &e);
+    event_broadcast(&p_scene->on_remove_entity, &e);
 
     cx_log_fmt(CX_LOG_TRACE, "scene", "Entity destroyed (id=%u)\n", p_entity->_id);
 
-    object_pool_return(&p_scene->_entity_pool, p_entity);
+    scene_release_entity(p_scene, p_entity);
+}
+
+void scene_destroy_entities(struct scene* p_scene, const scene_entity_id* p_entity_ids, size_t n) {
+    struct scene_entity** pp_entities = malloc(sizeof(struct scene_entity*) * (n ? n : 1));
+    size_t num_entities = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        struct scene_entity* p_entity = scene_get_entity(p_scene, p_entity_ids[i]);
+
+        if (p_entity) {
+            pp_entities[num_entities++] = p_entity;
+        }
+    }
+
+    if (num_entities) {
+        struct scene_entity_event_data e = {
+            .p_scene = p_scene,
+            .pp_entities = pp_entities,
+            .num_entities = num_entities
+        };
+        event_broadcast(&p_scene->on_remove_entity, &e);
+
+        cx_log_fmt(CX_LOG_TRACE, "scene", "Entities destroyed (count=%u)\n", (unsigned int)num_entities);
+    }
+
+    // Both free lists are last in, first out, so releasing back to front has the next batch spawned reuse the same
+    // slots and pool storage in the same order
+    for (size_t i = num_entities; i-- > 0;) {
+        scene_release_entity(p_scene, pp_entities[i]);
+    }
+
+    free(pp_entities);
+}
+
+struct scene_entity* scene_get_entity(const struct scene* p_scene, scene_entity_id entity_id) {
+    const uint32_t index = entity_id & SCENE_ENTITY_INDEX_MASK;
+
+    if (index >= p_scene->_entity_slots._length) {
+        return 0;
+    }
+
+    const struct scene_entity_slot* p_slot = darr_get(&p_scene->_entity_slots, index);
+    return p_slot->generation == entity_id >> SCENE_ENTITY_INDEX_BITS ? p_slot->p_entity : 0;
+}
+
+void scene_update_transforms(struct scene* p_scene) {
+    transform_hierarchy_update(&p_scene->_transform_hierarchy);
+
+    // Only bounds whose transform was just recomputed, or that were set since the last update, move in the index
+    const struct sparse_set* p_bounds_set = &p_scene->_components[SCENE_COMPONENT_bounds];
+    const struct scene_entity_slot* p_slots = p_scene->_entity_slots._p_buffer;
+
+    for (size_t i = 0; i < sparse_set_length(p_bounds_set); ++i) {
+        struct scene_bounds* p_bounds = sparse_set_at(p_bounds_set, i);
+        const struct transform* p_transform = &p_slots[sparse_set_key_at(p_bounds_set, i)].p_entity->transform;
+
+        if (!p_bounds->_b_dirty && !p_transform->_b_changed) {
+            continue;
+        }
+
+        matrix_transform_aabb(p_transform->world_trs_matrix, p_bounds->local_min, p_bounds->local_max, p_bounds->world_min, p_bounds->world_max);
+        spatial_index_update(&p_scene->spatial_index, p_bounds->_spatial_item, p_bounds->world_min, p_bounds->world_max);
+        p_bounds->_b_dirty = 0;
+    }
+}
+
+void scene_set_entity_bounds(struct scene* p_scene, scene_entity_id entity_id, const float* p_local_min, const float* p_local_max) {
+    const struct scene_entity* p_entity = scene_get_entity(p_scene, entity_id);
+
+    if (!p_entity) {
+        return;
+    }
+
+    struct scene_bounds* p_bounds = sparse_set_get(&p_scene->_components[SCENE_COMPONENT_bounds], entity_id & SCENE_ENTITY_INDEX_MASK);
+    const int b_new = !p_bounds;
+
+    if (b_new) {
+        p_bounds = sparse_set_insert(&p_scene->_components[SCENE_COMPONENT_bounds], entity_id & SCENE_ENTITY_INDEX_MASK);
+    }
+
+    memcpy(p_bounds->local_min, p_local_min, sizeof(p_bounds->local_min));
+    memcpy(p_bounds->local_max, p_local_max, sizeof(p_bounds->local_max));
+
+    // The world matrix may be a frame behind, so index with it for now and refresh on the next update
+    matrix_transform_aabb(p_entity->transform.world_trs_matrix, p_bounds->local_min, p_bounds->local_max, p_bounds->world_min, p_bounds->world_max);
+    p_bounds->_b_dirty = 1;
+
+    if (b_new) {
+        p_bounds->_spatial_item = spatial_index_insert(&p_scene->spatial_index, p_bounds->world_min, p_bounds->world_max, entity_id);
+    } else {
+        spatial_index_update(&p_scene->spatial_index, p_bounds->_spatial_item, p_bounds->world_min, p_bounds->world_max);
+    }
+}
+
+void scene_set_entity_mesh(struct scene* p_scene, scene_entity_id entity_id, asset_handle p_mesh) {
+    asset_handle* pp_mesh = scene_add_component(p_scene, entity_id, SCENE_COMPONENT_mesh);
+
+    if (!pp_mesh) {
+        return;
+    }
+
+    *pp_mesh = p_mesh;
+
+    float bounds_min[3];
+    float bounds_max[3];
+
+    if (p_mesh->_asset._p_data && static_mesh_compute_bounds(p_mesh->_asset._p_data, bounds_min, bounds_max)) {
+        scene_set_entity_bounds(p_scene, entity_id, bounds_min, bounds_max);
+    }
+}
+
+void scene_cull(const struct scene* p_scene, const float* p_planes, struct darr* p_visible, struct scene_cull_stats* p_stats) {
+    const struct sparse_set* p_bounds_set = &p_scene->_components[SCENE_COMPONENT_bounds];
+    const struct scene_entity_slot* p_slots = p_scene->_entity_slots._p_buffer;
+    const size_t num_bounds = sparse_set_length(p_bounds_set);
+
+    // The spatial index's values are entity ids, and it skips whole loose cells outside the frustum
+    darr_set_length(p_visible, 0);
+    spatial_index_query_frustum(&p_scene->spatial_index, p_planes, p_visible);
+    const size_t num_visible = p_visible->_length;
 
-    for (size_t i = 0; i < p_scene->_entities._length; ++i) {
-        struct scene_entity** pp_entity = darr_get(&p_scene->_entities, i);
-        if (*pp_entity == p_entity) {
-            darr_remove(&p_scene->_entities, i);
-            break;
+    // A mesh added without bounds, or before its primitives were loaded, can't be culled, but is still drawn
+    const struct sparse_set* p_mesh_set = &p_scene->_components[SCENE_COMPONENT_mesh];
+    size_t num_unbounded = 0;
+
+    for (size_t i = 0; i < sparse_set_length(p_mesh_set); ++i) {
+        const uint32_t index = sparse_set_key_at(p_mesh_set, i);
+
+        if (!sparse_set_get(p_bounds_set, index)) {
+            *(scene_entity_id*)darr_push(p_visible) = p_slots[index].p_entity->_id;
+            ++num_unbounded;
         }
     }
+
+    if (p_stats) {
+        *p_stats = (struct scene_cull_stats) {
+            .num_tested = num_bounds,
+            .num_visible = num_visible + num_unbounded,
+            .num_culled = num_bounds - num_visible,
+            .num_unbounded = num_unbounded
+        };
+    }
+}
+
+void* scene_add_component(struct scene* p_scene, scene_entity_id entity_id, enum scene_component component) {
+    if (!scene_get_entity(p_scene, entity_id)) {
+        cx_log_fmt(CX_LOG_ERROR, "scene", "Cannot add component to unknown entity (id=%u)\n", entity_id);
+        return 0;
+    }
+
+    return sparse_set_insert(&p_scene->_components[component], entity_id & SCENE_ENTITY_INDEX_MASK);
 }
 
-struct scene_entity* scene_get_entity(struct scene* p_scene, size_t entity_id) {
-    for (size_t i = 0; i < p_scene->_entities._length; ++i) {
-        struct scene_entity** pp_entity = darr_get(&p_scene->_entities, i);
-        if ((*pp_entity)->_id == entity_id) {
-            return *pp_entity;
+void scene_remove_component(struct scene* p_scene, scene_entity_id entity_id, enum scene_component component) {
+    if (!scene_get_entity(p_scene, entity_id)) {
+        return;
+    }
+
+    if (component == SCENE_COMPONENT_bounds) {
+        const struct scene_bounds* p_bounds = sparse_set_get(&p_scene->_components[component], entity_id & SCENE_ENTITY_INDEX_MASK);
+
+        if (p_bounds) {
+            spatial_index_remove(&p_scene->spatial_index, p_bounds->_spatial_item);
         }
     }
+
+    sparse_set_remove(&p_scene->_components[component], entity_id & SCENE_ENTITY_INDEX_MASK);
+}
+
+void* scene_get_component(const struct scene* p_scene, scene_entity_id entity_id, enum scene_component component) {
+    if (!scene_get_entity(p_scene, entity_id)) {
+        return 0;
+    }
+
+    return sparse_set_get(&p_scene->_components[component], entity_id & SCENE_ENTITY_INDEX_MASK);
+}
+
+void scene_query_init(struct scene_query* p_query, struct scene* p_scene, uint32_t component_mask) {
+    *p_query = (struct scene_query) {
+        ._p_scene = p_scene,
+        ._component_mask = component_mask
+    };
+
+    size_t min_length = SIZE_MAX;
+
+    for (size_t i = 0; i < SCENE_COMPONENT_count; ++i) {
+        if ((component_mask & SCENE_COMPONENT_BIT(i)) && sparse_set_length(&p_scene->_components[i]) < min_length) {
+            min_length = sparse_set_length(&p_scene->_components[i]);
+            p_query->_driver = (enum scene_component)i;
+        }
+    }
+}
+
+int scene_query_next(struct scene_query* p_query) {
+    if (!p_query->_component_mask) {
+        return 0;
+    }
+
+    const struct scene* p_scene = p_query->_p_scene;
+    const struct sparse_set* p_driver = &p_scene->_components[p_query->_driver];
+    const uint32_t other_components = p_query->_component_mask & ~SCENE_COMPONENT_BIT(p_query->_driver);
+
+    while (p_query->_index < sparse_set_length(p_driver)) {
+        const uint32_t index = sparse_set_key_at(p_driver, p_query->_index++);
+
+        size_t i = 0;
+        while (i < SCENE_COMPONENT_count && (!(other_components & SCENE_COMPONENT_BIT(i)) || sparse_set_contains(&p_scene->_components[i], index))) {
+            ++i;
+        }
+
+        if (i == SCENE_COMPONENT_count) {
+            p_query->p_entity = ((const struct scene_entity_slot*)darr_get(&p_scene->_entity_slots, index))->p_entity;
+            p_query->entity_id = p_query->p_entity->_id;
+            return 1;
+        }
+    }
+
+    p_query->entity_id = SCENE_ENTITY_ID_NULL;
+    p_query->p_entity = 0;
     return 0;
-}
\ No newline at end of file
+}
+
+void* scene_query_get(const struct scene_query* p_query, enum scene_component component) {
+    if (component == p_query->_driver) {
+        return sparse_set_at(&p_query->_p_scene->_components[component], p_query->_index - 1);
+    }
+
+    return sparse_set_get(&p_query->_p_scene->_components[component], p_query->p_entity->_id & SCENE_ENTITY_INDEX_MASK);
+}
+
+void scene_release_entity(struct scene* p_scene, struct scene_entity* p_entity) {
+    const uint32_t index = p_entity->_id & SCENE_ENTITY_INDEX_MASK;
+    const struct scene_bounds* p_bounds = sparse_set_get(&p_scene->_components[SCENE_COMPONENT_bounds], index);
+
+    if (p_bounds) {
+        spatial_index_remove(&p_scene->spatial_index, p_bounds->_spatial_item);
+    }
+
+    for (size_t i = 0; i < SCENE_COMPONENT_count; ++i) {
+        sparse_set_remove(&p_scene->_components[i], index);
+    }
+
+    struct scene_entity_slot* p_slot = darr_get(&p_scene->_entity_slots, index);
+    p_slot->p_entity = 0;
+    p_slot->generation = (p_slot->generation & SCENE_ENTITY_GENERATION_MASK) % SCENE_ENTITY_GENERATION_MASK + 1;
+    *(uint32_t*)darr_push(&p_scene->_free_entity_slots) = index;
+
+    transform_hierarchy_remove(&p_scene->_transform_hierarchy, &p_entity->transform);
+    object_pool_return(&p_scene->_entity_pool, p_entity);
+    --p_scene->_num_entities;
+}
+
+int scene_serialize(FILE* p_file, const void* p_scene) {
+    const struct scene* p_src = p_scene;
+    const size_t num_slots = p_src->_entity_slots._length;
+    const struct scene_entity_slot* p_slots = p_src->_entity_slots._p_buffer;
+
+    // Order the entities by depth with a counting sort, so every parent is written before its children
+    uint32_t* p_depths = malloc(sizeof(uint32_t) * (num_slots ? num_slots : 1));
+    uint32_t* p_record_indices = malloc(sizeof(uint32_t) * (num_slots ? num_slots : 1));
+    struct darr depth_counts;
+    darr_init(&depth_counts, sizeof(uint32_t));
+
+    // Parents are found by their transform's address, which only this scene's entities are keyed by
+    struct hashtable slot_indices;
+    hashtable_init(&slot_indices, sizeof(uint32_t));
+
+    for (size_t i = 0; i < num_slots; ++i) {
+        if (!p_slots[i].p_entity) {
+            continue;
+        }
+
+        const struct transform* p_transform = &p_slots[i].p_entity->transform;
+        uint32_t* p_slot_index = hashtable_add(&slot_indices, &p_transform, sizeof(p_transform));
+
+        if (p_slot_index) {
+            *p_slot_index = (uint32_t)i;
+        }
+
+        p_depths[i] = scene_entity_depth(p_slots[i].p_entity);
+
+        if (p_depths[i] + 1 >= depth_counts._length) {
+            const size_t old_length = depth_counts._length;
+            darr_set_length(&depth_counts, p_depths[i] + 2);
+            memset(darr_get(&depth_counts, old_length), 0, sizeof(uint32_t) * (depth_counts._length - old_length));
+        }
+
+        ++*(uint32_t*)darr_get(&depth_counts, p_depths[i] + 1);
+    }
+
+    uint32_t* p_depth_offsets = depth_counts._p_buffer;
+    for (size_t i = 1; i < depth_counts._length; ++i) {
+        p_depth_offsets[i] += p_depth_offsets[i - 1];
+    }
+
+    struct scene_file_entity* p_records = malloc(sizeof(struct scene_file_entity) * (p_src->_num_entities ? p_src->_num_entities : 1));
+
+    for (size_t i = 0; i < num_slots; ++i) {
+        if (p_slots[i].p_entity) {
+            p_record_indices[i] = p_depth_offsets[p_depths[i]]++;
+        }
+    }
+
+    // Mesh references become indices into a table of unique asset ids
+    struct hashtable asset_indices;
+    hashtable_init(&asset_indices, sizeof(uint32_t));
+    struct darr asset_ids;
+    darr_init(&asset_ids, sizeof(asset_id));
+
+    for (size_t i = 0; i < num_slots; ++i) {
+        const struct scene_entity* p_entity = p_slots[i].p_entity;
+
+        if (!p_entity) {
+            continue;
+        }
+
+        struct scene_file_entity* p_record = &p_records[p_record_indices[i]];
+        memcpy(p_record->position, p_entity->transform.position, sizeof(p_record->position));
+        memcpy(p_record->rotation, p_entity->transform.rotation, sizeof(p_record->rotation));
+        memcpy(p_record->scale, p_entity->transform.scale, sizeof(p_record->scale));
+        p_record->parent_index = SCENE_FILE_NONE;
+        p_record->mesh_index = SCENE_FILE_NONE;
+
+        // Parents outside this scene can't be referred to, so those entities are saved as roots
+        if (p_entity->transform.p_local_transform) {
+            const struct transform* p_parent_transform = p_entity->transform.p_local_transform;
+            const uint32_t* p_parent_slot = hashtable_find(&slot_indices, &p_parent_transform, sizeof(p_parent_transform));
+
+            if (p_parent_slot) {
+                p_record->parent_index = p_record_indices[*p_parent_slot];
+            }
+        }
+
+        const asset_handle* pp_mesh = sparse_set_get(&p_src->_components[SCENE_COMPONENT_mesh], (uint32_t)i);
+
+        if (pp_mesh && *pp_mesh) {
+            const asset_id id = (*pp_mesh)->_asset._id;
+            uint32_t* p_asset_index = hashtable_i_find(&asset_indices, id);
+
+            if (!p_asset_index) {
+                p_asset_index = hashtable_i_add(&asset_indices, id);
+                *p_asset_index = (uint32_t)asset_ids._length;
+                *(asset_id*)darr_push(&asset_ids) = id;
+            }
+
+            p_record->mesh_index = *p_asset_index;
+        }
+    }
+
+    serialize_uint32(p_file, SCENE_FILE_VERSION);
+    serialize_uint32(p_file, (uint32_t)asset_ids._length);
+    serialize_uint32(p_file, (uint32_t)p_src->_num_entities);
+
+    // A scene with no meshes has no asset ids, and so no buffer for them
+    if (asset_ids._length) {
+        serialize_bytes(p_file, asset_ids._p_buffer, sizeof(asset_id) * asset_ids._length);
+    }
+
+    serialize_bytes(p_file, p_records, sizeof(struct scene_file_entity) * p_src->_num_entities);
+
+    free(p_depths);
+    free(p_record_indices);
+    free(p_records);
+    darr_free(&depth_counts);
+    darr_free(&asset_ids);
+    hashtable_free(&asset_indices);
+    hashtable_free(&slot_indices);
+
+    return !ferror(p_file);
+}
+
+int scene_deserialize(FILE* p_file, void* p_scene) {
+    struct scene* p_dst = p_scene;
+    scene_init(p_dst);
+
+    uint32_t version = 0;
+    uint32_t num_assets = 0;
+    uint32_t num_entities = 0;
+    deserialize_uint32(p_file, &version);
+    deserialize_uint32(p_file, &num_assets);
+    deserialize_uint32(p_file, &num_entities);
+
+    if (ferror(p_file) || feof(p_file) || version != SCENE_FILE_VERSION) {
+        cx_log_fmt(CX_LOG_ERROR, "scene", "Failed to deserialize scene: bad header (version=%u)\n", version);
+        return 0;
+    }
+
+    // One read for the whole body, which is used in place
+    const size_t asset_ids_size = sizeof(asset_id) * num_assets;
+    unsigned char* p_block = malloc(asset_ids_size + sizeof(struct scene_file_entity) * num_entities + 1);
+    deserialize_bytes(p_file, p_block, asset_ids_size + sizeof(struct scene_file_entity) * num_entities);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, "scene", "Failed to deserialize scene: unexpected end of file\n");
+        free(p_block);
+        return 0;
+    }
+
+    const asset_id* p_asset_ids = (const asset_id*)p_block;
+    const struct scene_file_entity* p_records = (const struct scene_file_entity*)(p_block + asset_ids_size);
+
+    // Handles are resolved once per referenced asset rather than once per entity
+    asset_handle* p_asset_handles = malloc(sizeof(asset_handle) * (num_assets ? num_assets : 1));
+    for (uint32_t i = 0; i < num_assets; ++i) {
+        p_asset_handles[i] = asset_directory_find(p_asset_ids[i]);
+
+        if (!p_asset_handles[i]) {
+            cx_log_fmt(CX_LOG_WARNING, "scene", "Scene references missing asset (id=%x)\n", p_asset_ids[i]);
+        }
+    }
+
+    struct scene_entity** pp_entities = malloc(sizeof(struct scene_entity*) * (num_entities ? num_entities : 1));
+    const int b_result = scene_new_entities(p_dst, num_entities, pp_entities) == num_entities;
+
+    for (uint32_t i = 0; b_result && i < num_entities; ++i) {
+        const struct scene_file_entity* p_record = &p_records[i];
+        struct transform* p_transform = &pp_entities[i]->transform;
+
+        memcpy(p_transform->position, p_record->position, sizeof(p_record->position));
+        memcpy(p_transform->rotation, p_record->rotation, sizeof(p_record->rotation));
+        memcpy(p_transform->scale, p_record->scale, sizeof(p_record->scale));
+
+        if (p_record->parent_index < i) {
+            p_transform->p_local_transform = &pp_entities[p_record->parent_index]->transform;
+        }
+
+        if (p_record->mesh_index < num_assets && p_asset_handles[p_record->mesh_index]) {
+            scene_set_entity_mesh(p_dst, pp_entities[i]->_id, p_asset_handles[p_record->mesh_index]);
+        }
+    }
+
+    if (!b_result) {
+        cx_log(CX_LOG_ERROR, "scene", "Failed to deserialize scene: couldn't create its entities\n");
+    }
+
+    free(pp_entities);
+    free(p_asset_handles);
+    free(p_block);
+
+    return b_result;
+}
+
+uint32_t scene_entity_depth(const struct scene_entity* p_entity) {
+    uint32_t depth = 0;
+    for (const struct transform* p_transform = p_entity->transform.p_local_transform; p_transform; p_transform = p_transform->p_local_transform) {
+        ++depth;
+    }
+    return depth;
+}
@@ -5,39 +5,122 @@
 #include "darr.h"
 #include "event.h"
 #include "object_pool.h"
+#include "spatial_index.h"
+#include "sparse_set.h"
 #include "transform.h"
 #include "physics.h"
 
 #define ASSET_TYPE_SCENE 5
 
+#define SCENE_SPATIAL_INDEX_CELL_SIZE 4.0f
+
+/* Entity ids are stable handles: the low bits index the scene's entity slots and the high bits hold a generation
+ * that is bumped whenever the slot is reused, so an id kept past its entity's destruction never resolves to a new
+ * entity. 0 is never a valid id. The top bit is left clear so ids survive being offset for picking. */
+#define SCENE_ENTITY_ID_NULL         0
+#define SCENE_ENTITY_INDEX_BITS      24
+#define SCENE_ENTITY_INDEX_MASK      ((1u << SCENE_ENTITY_INDEX_BITS) - 1)
+#define SCENE_ENTITY_GENERATION_MASK 0x7Fu
+
+typedef uint32_t scene_entity_id;
+
 struct texture;
 struct static_mesh;
 
+// Every entity has a transform. It lives in the pooled entity rather than a component array because physics objects
+// and the transform hierarchy hold pointers to it.
 struct scene_entity {
-    size_t                   _id;
-    struct transform         transform;
-    asset_handle             p_mesh;
-    struct physics_object*   p_physics_object;
+    scene_entity_id  _id;
+    struct transform transform;
+};
 
+/* Optional components, each stored densely in its own sparse set keyed by entity index:
+ *  - SCENE_COMPONENT_mesh:           asset_handle of a static mesh
+ *  - SCENE_COMPONENT_physics_object: struct physics_object*
+ *  - SCENE_COMPONENT_bounds:         struct scene_bounds, set through scene_set_entity_bounds */
+enum scene_component {
+    SCENE_COMPONENT_mesh,
+    SCENE_COMPONENT_physics_object,
+    SCENE_COMPONENT_bounds,
+    SCENE_COMPONENT_count
 };
 
-struct scene_entity_event_data {
-    struct scene*        p_scene;
+// Entities with bounds are kept in the scene's spatial index, refreshed by scene_update_transforms when they move
+struct scene_bounds {
+    float    local_min[3];
+    float    local_max[3];
+    float    world_min[3];
+    float    world_max[3];
+    uint32_t _spatial_item;
+    int      _b_dirty;
+};
+
+#define SCENE_COMPONENT_BIT(component) (1u << (component))
+
+struct scene_entity_slot {
     struct scene_entity* p_entity;
+    uint32_t             generation;
+};
+
+// Entity events are broadcast once per call with every entity it affected
+struct scene_entity_event_data {
+    struct scene*               p_scene;
+    struct scene_entity* const* pp_entities;
+    size_t                      num_entities;
 };
 
 struct scene {
-    struct object_pool   _entity_pool;
-    struct darr          _entities;
-    size_t               _next_entity_id;
-    struct event         on_new_entity;
-    struct event         on_remove_entity;
+    struct object_pool         _entity_pool;
+    struct darr                _entity_slots;      // struct scene_entity_slot, indexed by entity id index
+    struct darr                _free_entity_slots; // uint32_t
+    size_t                     _num_entities;
+    struct sparse_set          _components[SCENE_COMPONENT_count];
+    struct transform_hierarchy _transform_hierarchy;
+    struct spatial_index       spatial_index;         // values are scene_entity_ids
+    struct event               on_new_entity;
+    struct event               on_remove_entity;
+};
+
+/* Iterates the entities that have every component in a mask, walking the densest-packed array of the smallest set
+ * in the mask. Adding or removing components in the mask during iteration is not allowed. */
+struct scene_query {
+    struct scene*        _p_scene;
+    uint32_t             _component_mask;
+    enum scene_component _driver;
+    size_t               _index;
+    scene_entity_id      entity_id;
+    struct scene_entity* p_entity;
+};
+
+// What scene_cull did, for logging
+struct scene_cull_stats {
+    size_t num_tested;
+    size_t num_visible;
+    size_t num_culled;
+    size_t num_unbounded; // mesh entities without bounds, which are never culled and count as visible
 };
 
 void                 scene_init(struct scene* p_scene);
+int                  scene_serialize(FILE* p_file, const void* p_scene);
+int                  scene_deserialize(FILE* p_file, void* p_scene);
 void                 scene_destroy(struct scene* p_scene);
 struct scene_entity* scene_new_entity(struct scene* p_scene);
+size_t               scene_new_entities(struct scene* p_scene, size_t n, struct scene_entity** pp_entities); // returns how many were created
 void                 scene_destroy_entity(struct scene* p_scene, struct scene_entity* p_entity);
-struct scene_entity* scene_get_entity(struct scene* p_scene, size_t entity_id);
+void                 scene_destroy_entities(struct scene* p_scene, const scene_entity_id* p_entity_ids, size_t n); // distinct ids; stale ones are skipped
+struct scene_entity* scene_get_entity(const struct scene* p_scene, scene_entity_id entity_id);
+void                 scene_update_transforms(struct scene* p_scene);
+void                 scene_set_entity_bounds(struct scene* p_scene, scene_entity_id entity_id, const float* p_local_min, const float* p_local_max);
+void                 scene_set_entity_mesh(struct scene* p_scene, scene_entity_id entity_id, asset_handle p_mesh); // also sets bounds if the mesh is loaded
+void                 scene_cull(const struct scene* p_scene, const float* p_planes, struct darr* p_visible, struct scene_cull_stats* p_stats); // p_visible (scene_entity_id) gets the entities whose bounds touch the frustum, and mesh entities without bounds
+
+// Component pointers are only valid until the next add or remove of that component type.
+void* scene_add_component(struct scene* p_scene, scene_entity_id entity_id, enum scene_component component);
+void  scene_remove_component(struct scene* p_scene, scene_entity_id entity_id, enum scene_component component);
+void* scene_get_component(const struct scene* p_scene, scene_entity_id entity_id, enum scene_component component);
+
+void  scene_query_init(struct scene_query* p_query, struct scene* p_scene, uint32_t component_mask);
+int   scene_query_next(struct scene_query* p_query);
+void* scene_query_get(const struct scene_query* p_query, enum scene_component component);
 
-#endif
\ No newline at end of file
+#endif
@@ -29,13 +29,8 @@ void debug_draw_skeleton(const struct skeleton* p_skeleton, const float* p_proje
 
     glUseProgram(g_rendering.gl_program.gl_handle);
 
-    GLuint gl_uniform_location;
-    
-    gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_projection_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, p_projection_matrix);
-    
-    gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_view_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, p_view_matrix);
+    glUniformMatrix4fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_projection_matrix], 1, GL_FALSE, p_projection_matrix);
+    glUniformMatrix4fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_view_matrix], 1, GL_FALSE, p_view_matrix);
 
     for (size_t i = 0; i < p_skeleton->num_root_joints; ++i) {
         const struct skeleton_joint* p_root_joint = &p_skeleton->p_joints[p_skeleton->p_root_joints_indices[i]];
@@ -161,11 +156,8 @@ void debug_draw_skeleton_joint(const float* p_transform, const float* p_color) {
     matrix_make_scale(inverse_scale_x, inverse_scale_y, inverse_scale_z, fixed_scale_transform);
     matrix_multiply(p_transform, fixed_scale_transform, fixed_scale_transform);
 
-    GLuint gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_model_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, fixed_scale_transform);
-    
-    gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_color");
-    glUniform3fv(gl_uniform_location, 1, p_color);
+    glUniformMatrix4fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, fixed_scale_transform);
+    glUniform3fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, p_color);
 
     gl_mesh_draw(&g_rendering.gl_joint_mesh);
 }
@@ -213,11 +205,8 @@ void debug_draw_skeleton_bone(const float* p_transform_a, const float* p_transfo
     matrix_make_translation(p_transform_a[12], p_transform_a[13], p_transform_a[14], m_t);
     matrix_multiply(m_t, m_trs, m_trs);
 
-    GLuint gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_model_matrix");
-    glUniformMatrix4fv(gl_uniform_location, 1, GL_FALSE, m_trs);
-    
-    gl_uniform_location = glGetUniformLocation(g_rendering.gl_program.gl_handle, "u_color");
-    glUniform3fv(gl_uniform_location, 1, p_color);
+    glUniformMatrix4fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_model_matrix], 1, GL_FALSE, m_trs);
+    glUniform3fv(g_rendering.gl_program.uniform_locations[GL_PROGRAM_UNIFORM_color], 1, p_color);
 
     gl_mesh_draw(&g_rendering.gl_bone_mesh);
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <string.h>
+
+#include "sparse_set.h"
+
+static uint32_t sparse_set_dense_index(const struct sparse_set* p_set, uint32_t key);
+
+void sparse_set_init(struct sparse_set* p_set, size_t element_size) {
+    darr_init(&p_set->_sparse, sizeof(uint32_t));
+    darr_init(&p_set->_keys, sizeof(uint32_t));
+    darr_init(&p_set->_dense, element_size);
+}
+
+void sparse_set_free(struct sparse_set* p_set) {
+    darr_free(&p_set->_sparse);
+    darr_free(&p_set->_keys);
+    darr_free(&p_set->_dense);
+}
+
+void* sparse_set_insert(struct sparse_set* p_set, uint32_t key) {
+    const uint32_t existing_index = sparse_set_dense_index(p_set, key);
+
+    if (existing_index != SPARSE_SET_INVALID) {
+        return darr_get(&p_set->_dense, existing_index);
+    }
+
+    if (key >= p_set->_sparse._length) {
+        const size_t old_length = p_set->_sparse._length;
+        size_t new_capacity = p_set->_sparse._capacity ? p_set->_sparse._capacity : 64;
+
+        while (new_capacity <= key) {
+            new_capacity *= 2;
+        }
+
+        darr_set_capacity(&p_set->_sparse, new_capacity);
+        darr_set_length(&p_set->_sparse, (size_t)key + 1);
+        memset(darr_get(&p_set->_sparse, old_length), 0xFF, (p_set->_sparse._length - old_length) * sizeof(uint32_t));
+    }
+
+    *(uint32_t*)darr_get(&p_set->_sparse, key) = (uint32_t)p_set->_dense._length;
+    *(uint32_t*)darr_push(&p_set->_keys) = key;
+
+    void* p_element = darr_push(&p_set->_dense);
+    memset(p_element, 0, p_set->_dense._element_size);
+
+    return p_element;
+}
+
+void sparse_set_remove(struct sparse_set* p_set, uint32_t key) {
+    const uint32_t index = sparse_set_dense_index(p_set, key);
+
+    if (index == SPARSE_SET_INVALID) {
+        return;
+    }
+
+    const uint32_t last_key = *(uint32_t*)darr_get(&p_set->_keys, p_set->_keys._length - 1);
+    *(uint32_t*)darr_get(&p_set->_sparse, last_key) = index;
+    *(uint32_t*)darr_get(&p_set->_sparse, key) = SPARSE_SET_INVALID;
+
+    // darr_remove moves the back element into the hole, which is exactly the swap the sparse entries now describe
+    darr_remove(&p_set->_keys, index);
+    darr_remove(&p_set->_dense, index);
+}
+
+void* sparse_set_get(const struct sparse_set* p_set, uint32_t key) {
+    const uint32_t index = sparse_set_dense_index(p_set, key);
+    return index == SPARSE_SET_INVALID ? 0 : darr_get(&p_set->_dense, index);
+}
+
+int sparse_set_contains(const struct sparse_set* p_set, uint32_t key) {
+    return sparse_set_dense_index(p_set, key) != SPARSE_SET_INVALID;
+}
+
+size_t sparse_set_length(const struct sparse_set* p_set) {
+    return p_set->_dense._length;
+}
+
+uint32_t sparse_set_key_at(const struct sparse_set* p_set, size_t index) {
+    return *(uint32_t*)darr_get(&p_set->_keys, index);
+}
+
+void* sparse_set_at(const struct sparse_set* p_set, size_t index) {
+    return darr_get(&p_set->_dense, index);
+}
+
+void sparse_set_clear(struct sparse_set* p_set) {
+    if (p_set->_sparse._length) {
+        memset(p_set->_sparse._p_buffer, 0xFF, p_set->_sparse._length * sizeof(uint32_t));
+    }
+
+    darr_set_length(&p_set->_keys, 0);
+    darr_set_length(&p_set->_dense, 0);
+}
+
+uint32_t sparse_set_dense_index(const struct sparse_set* p_set, uint32_t key) {
+    if (key >= p_set->_sparse._length) {
+        return SPARSE_SET_INVALID;
+    }
+
+    return *(const uint32_t*)darr_get(&p_set->_sparse, key);
+}
@@ -0,0 +1,29 @@
+#ifndef _H__SPARSE_SET
+#define _H__SPARSE_SET
+
+#include <stdint.h>
+
+#include "darr.h"
+
+#define SPARSE_SET_INVALID UINT32_MAX
+
+/* Maps small integer keys to elements kept tightly packed in insertion order. Removal swaps the last element into
+ * the hole, so pointers returned by insert/get/at are only valid until the next insert or remove. */
+struct sparse_set {
+    struct darr _sparse; // uint32_t dense index per key, SPARSE_SET_INVALID when absent
+    struct darr _keys;   // uint32_t key per dense element
+    struct darr _dense;
+};
+
+void     sparse_set_init(struct sparse_set* p_set, size_t element_size);
+void     sparse_set_free(struct sparse_set* p_set);
+void*    sparse_set_insert(struct sparse_set* p_set, uint32_t key); // zeroed if new
+void     sparse_set_remove(struct sparse_set* p_set, uint32_t key);
+void*    sparse_set_get(const struct sparse_set* p_set, uint32_t key);
+int      sparse_set_contains(const struct sparse_set* p_set, uint32_t key);
+size_t   sparse_set_length(const struct sparse_set* p_set);
+uint32_t sparse_set_key_at(const struct sparse_set* p_set, size_t index);
+void*    sparse_set_at(const struct sparse_set* p_set, size_t index);
+void     sparse_set_clear(struct sparse_set* p_set);
+
+#endif
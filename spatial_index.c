@@ -0,0 +1,531 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+#include "spatial_index.h"
+
+#define SPATIAL_INDEX_COORD_MAX (1 << 30)
+#define SPATIAL_INDEX_MIN_SLOTS 64
+#define SPATIAL_INDEX_CELL_BATCH 64 // loose cells frustum culled at a time
+
+struct spatial_index_cell_key {
+    int32_t  coords[3];
+    uint32_t level;
+};
+
+struct spatial_index_slot {
+    struct spatial_index_cell_key key;
+    uint32_t                      cell;     // SPATIAL_INDEX_NONE when empty
+};
+
+struct spatial_index_cell {
+    struct spatial_index_cell_key key;
+    uint32_t                      first_item;
+    uint32_t                      level_list_index;
+};
+
+enum spatial_index_shape {
+    SPATIAL_INDEX_SHAPE_aabb,
+    SPATIAL_INDEX_SHAPE_sphere,
+    SPATIAL_INDEX_SHAPE_frustum
+};
+
+struct spatial_index_query {
+    enum spatial_index_shape shape;
+    float                    min[3];    // bounds of the query, unused for frustums
+    float                    max[3];
+    const float*             p_center;
+    float                    radius;
+    const float*             p_planes;
+};
+
+static uint32_t spatial_index_hash(const struct spatial_index_cell_key* p_key);
+static int      spatial_index_key_equals(const struct spatial_index_cell_key* p_key0, const struct spatial_index_cell_key* p_key1);
+static uint32_t spatial_index_lookup(const struct spatial_index* p_index, const struct spatial_index_cell_key* p_key);
+static void     spatial_index_add_slot(struct spatial_index* p_index, uint32_t cell);
+static void     spatial_index_remove_slot(struct spatial_index* p_index, uint32_t cell);
+static void     spatial_index_find_cell(const struct spatial_index* p_index, const float* p_min, const float* p_max, struct spatial_index_cell_key* p_result);
+static void     spatial_index_link(struct spatial_index* p_index, uint32_t item);
+static void     spatial_index_unlink(struct spatial_index* p_index, uint32_t item);
+static void     spatial_index_query(const struct spatial_index* p_index, const struct spatial_index_query* p_query, struct darr* p_results);
+static void     spatial_index_query_cell(const struct spatial_index* p_index, const struct spatial_index_query* p_query, uint32_t cell, struct darr* p_results);
+static int      spatial_index_test(const struct spatial_index_query* p_query, const float* p_min, const float* p_max);
+static float    spatial_index_level_cell_size(const struct spatial_index* p_index, uint32_t level);
+static int32_t  spatial_index_coord(float x, float cell_size);
+
+void spatial_index_init(struct spatial_index* p_index, float cell_size) {
+    *p_index = (struct spatial_index) {
+        ._cell_size = cell_size > 0 ? cell_size : 1
+    };
+
+    darr_init(&p_index->_items, sizeof(struct spatial_index_item));
+    darr_init(&p_index->_free_items, sizeof(uint32_t));
+    darr_init(&p_index->_cells, sizeof(struct spatial_index_cell));
+    darr_init(&p_index->_free_cells, sizeof(uint32_t));
+    darr_init(&p_index->_oversized_items, sizeof(uint32_t));
+
+    for (size_t i = 0; i < SPATIAL_INDEX_LEVELS; ++i) {
+        darr_init(&p_index->_level_cells[i], sizeof(uint32_t));
+    }
+}
+
+void spatial_index_free(struct spatial_index* p_index) {
+    darr_free(&p_index->_items);
+    darr_free(&p_index->_free_items);
+    darr_free(&p_index->_cells);
+    darr_free(&p_index->_free_cells);
+    darr_free(&p_index->_oversized_items);
+    free(p_index->_p_cell_slots);
+
+    for (size_t i = 0; i < SPATIAL_INDEX_LEVELS; ++i) {
+        darr_free(&p_index->_level_cells[i]);
+    }
+}
+
+uint32_t spatial_index_insert(struct spatial_index* p_index, const float* p_min, const float* p_max, uint32_t value) {
+    uint32_t item;
+
+    if (p_index->_free_items._length) {
+        item = *(uint32_t*)darr_get(&p_index->_free_items, p_index->_free_items._length - 1);
+        darr_remove_back(&p_index->_free_items);
+    } else {
+        item = (uint32_t)p_index->_items._length;
+        darr_push(&p_index->_items);
+    }
+
+    struct spatial_index_item* p_item = darr_get(&p_index->_items, item);
+    *p_item = (struct spatial_index_item) {
+        .min = { p_min[0], p_min[1], p_min[2] },
+        .max = { p_max[0], p_max[1], p_max[2] },
+        .value = value
+    };
+
+    spatial_index_link(p_index, item);
+
+    return item;
+}
+
+void spatial_index_update(struct spatial_index* p_index, uint32_t item, const float* p_min, const float* p_max) {
+    struct spatial_index_item* p_item = darr_get(&p_index->_items, item);
+
+    // Most moves stay inside the same loose cell, in which case only the stored box changes
+    if (p_item->_cell != SPATIAL_INDEX_OVERSIZED) {
+        struct spatial_index_cell_key key;
+        spatial_index_find_cell(p_index, p_min, p_max, &key);
+
+        const struct spatial_index_cell* p_cell = darr_get(&p_index->_cells, p_item->_cell);
+
+        if (spatial_index_key_equals(&key, &p_cell->key)) {
+            for (size_t i = 0; i < 3; ++i) {
+                p_item->min[i] = p_min[i];
+                p_item->max[i] = p_max[i];
+            }
+            return;
+        }
+    }
+
+    spatial_index_unlink(p_index, item);
+
+    p_item = darr_get(&p_index->_items, item);
+    for (size_t i = 0; i < 3; ++i) {
+        p_item->min[i] = p_min[i];
+        p_item->max[i] = p_max[i];
+    }
+
+    spatial_index_link(p_index, item);
+}
+
+void spatial_index_remove(struct spatial_index* p_index, uint32_t item) {
+    spatial_index_unlink(p_index, item);
+    ((struct spatial_index_item*)darr_get(&p_index->_items, item))->_cell = SPATIAL_INDEX_NONE;
+    *(uint32_t*)darr_push(&p_index->_free_items) = item;
+}
+
+void spatial_index_query_aabb(const struct spatial_index* p_index, const float* p_min, const float* p_max, struct darr* p_results) {
+    struct spatial_index_query query = {
+        .shape = SPATIAL_INDEX_SHAPE_aabb,
+        .min = { p_min[0], p_min[1], p_min[2] },
+        .max = { p_max[0], p_max[1], p_max[2] }
+    };
+
+    spatial_index_query(p_index, &query, p_results);
+}
+
+void spatial_index_query_sphere(const struct spatial_index* p_index, const float* p_center, float radius, struct darr* p_results) {
+    struct spatial_index_query query = {
+        .shape = SPATIAL_INDEX_SHAPE_sphere,
+        .min = { p_center[0] - radius, p_center[1] - radius, p_center[2] - radius },
+        .max = { p_center[0] + radius, p_center[1] + radius, p_center[2] + radius },
+        .p_center = p_center,
+        .radius = radius
+    };
+
+    spatial_index_query(p_index, &query, p_results);
+}
+
+void spatial_index_query_frustum(const struct spatial_index* p_index, const float* p_planes, struct darr* p_results) {
+    struct spatial_index_query query = {
+        .shape = SPATIAL_INDEX_SHAPE_frustum,
+        .p_planes = p_planes
+    };
+
+    spatial_index_query(p_index, &query, p_results);
+}
+
+uint32_t spatial_index_hash(const struct spatial_index_cell_key* p_key) {
+    uint32_t hash = (uint32_t)p_key->coords[0] * 73856093u ^ (uint32_t)p_key->coords[1] * 19349663u ^ (uint32_t)p_key->coords[2] * 83492791u ^ p_key->level * 2654435761u;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+int spatial_index_key_equals(const struct spatial_index_cell_key* p_key0, const struct spatial_index_cell_key* p_key1) {
+    return p_key0->level == p_key1->level && p_key0->coords[0] == p_key1->coords[0] && p_key0->coords[1] == p_key1->coords[1] && p_key0->coords[2] == p_key1->coords[2];
+}
+
+uint32_t spatial_index_lookup(const struct spatial_index* p_index, const struct spatial_index_cell_key* p_key) {
+    if (p_index->_num_cell_slots == 0) {
+        return SPATIAL_INDEX_NONE;
+    }
+
+    const size_t mask = p_index->_num_cell_slots - 1;
+
+    for (size_t slot = spatial_index_hash(p_key) & mask;; slot = (slot + 1) & mask) {
+        const struct spatial_index_slot* p_slot = &p_index->_p_cell_slots[slot];
+
+        if (p_slot->cell == SPATIAL_INDEX_NONE || spatial_index_key_equals(&p_slot->key, p_key)) {
+            return p_slot->cell;
+        }
+    }
+}
+
+void spatial_index_add_slot(struct spatial_index* p_index, uint32_t cell) {
+    const size_t num_occupied = p_index->_cells._length - p_index->_free_cells._length;
+
+    // Rehash from the level lists, which already hold every occupied cell including the new one
+    if (num_occupied * 2 > p_index->_num_cell_slots) {
+        free(p_index->_p_cell_slots);
+        p_index->_num_cell_slots = p_index->_num_cell_slots ? p_index->_num_cell_slots * 2 : SPATIAL_INDEX_MIN_SLOTS;
+        p_index->_p_cell_slots = malloc(sizeof(struct spatial_index_slot) * p_index->_num_cell_slots);
+
+        for (size_t i = 0; i < p_index->_num_cell_slots; ++i) {
+            p_index->_p_cell_slots[i].cell = SPATIAL_INDEX_NONE;
+        }
+
+        for (size_t level = 0; level < SPATIAL_INDEX_LEVELS; ++level) {
+            for (size_t i = 0; i < p_index->_level_cells[level]._length; ++i) {
+                const uint32_t level_cell = *(uint32_t*)darr_get(&p_index->_level_cells[level], i);
+
+                if (level_cell != cell) {
+                    spatial_index_add_slot(p_index, level_cell);
+                }
+            }
+        }
+    }
+
+    const struct spatial_index_cell_key* p_key = &((const struct spatial_index_cell*)darr_get(&p_index->_cells, cell))->key;
+    const size_t mask = p_index->_num_cell_slots - 1;
+    size_t slot = spatial_index_hash(p_key) & mask;
+
+    while (p_index->_p_cell_slots[slot].cell != SPATIAL_INDEX_NONE) {
+        slot = (slot + 1) & mask;
+    }
+
+    p_index->_p_cell_slots[slot] = (struct spatial_index_slot) {
+        .key = *p_key,
+        .cell = cell
+    };
+}
+
+void spatial_index_remove_slot(struct spatial_index* p_index, uint32_t cell) {
+    const size_t mask = p_index->_num_cell_slots - 1;
+    size_t slot = spatial_index_hash(&((const struct spatial_index_cell*)darr_get(&p_index->_cells, cell))->key) & mask;
+
+    while (p_index->_p_cell_slots[slot].cell != cell) {
+        slot = (slot + 1) & mask;
+    }
+
+    // Later entries of the same probe run are shifted back into the hole, so lookups never need tombstones
+    for (size_t next = (slot + 1) & mask; p_index->_p_cell_slots[next].cell != SPATIAL_INDEX_NONE; next = (next + 1) & mask) {
+        const size_t home = spatial_index_hash(&p_index->_p_cell_slots[next].key) & mask;
+
+        // Only move it if its home slot doesn't lie cyclically in (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            p_index->_p_cell_slots[slot] = p_index->_p_cell_slots[next];
+            slot = next;
+        }
+    }
+
+    p_index->_p_cell_slots[slot].cell = SPATIAL_INDEX_NONE;
+}
+
+void spatial_index_find_cell(const struct spatial_index* p_index, const float* p_min, const float* p_max, struct spatial_index_cell_key* p_result) {
+    float extent = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        if (p_max[i] - p_min[i] > extent) {
+            extent = p_max[i] - p_min[i];
+        }
+    }
+
+    uint32_t level = 0;
+    float cell_size = p_index->_cell_size;
+
+    while (cell_size < extent && level < SPATIAL_INDEX_LEVELS) {
+        cell_size *= 2;
+        ++level;
+    }
+
+    *p_result = (struct spatial_index_cell_key) {
+        .level = level
+    };
+
+    if (level == SPATIAL_INDEX_LEVELS) {
+        return;
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+        p_result->coords[i] = spatial_index_coord((p_min[i] + p_max[i]) * 0.5f, cell_size);
+    }
+}
+
+void spatial_index_link(struct spatial_index* p_index, uint32_t item) {
+    struct spatial_index_item* p_item = darr_get(&p_index->_items, item);
+
+    struct spatial_index_cell_key key;
+    spatial_index_find_cell(p_index, p_item->min, p_item->max, &key);
+
+    if (key.level == SPATIAL_INDEX_LEVELS) {
+        p_item->_cell = SPATIAL_INDEX_OVERSIZED;
+        p_item->_prev = (uint32_t)p_index->_oversized_items._length; // position in the oversized list
+        *(uint32_t*)darr_push(&p_index->_oversized_items) = item;
+        return;
+    }
+
+    uint32_t cell = spatial_index_lookup(p_index, &key);
+
+    if (cell == SPATIAL_INDEX_NONE) {
+        if (p_index->_free_cells._length) {
+            cell = *(uint32_t*)darr_get(&p_index->_free_cells, p_index->_free_cells._length - 1);
+            darr_remove_back(&p_index->_free_cells);
+        } else {
+            cell = (uint32_t)p_index->_cells._length;
+            darr_push(&p_index->_cells);
+        }
+
+        struct darr* p_level_cells = &p_index->_level_cells[key.level];
+
+        *(struct spatial_index_cell*)darr_get(&p_index->_cells, cell) = (struct spatial_index_cell) {
+            .key = key,
+            .first_item = SPATIAL_INDEX_NONE,
+            .level_list_index = (uint32_t)p_level_cells->_length
+        };
+
+        *(uint32_t*)darr_push(p_level_cells) = cell;
+        spatial_index_add_slot(p_index, cell);
+    }
+
+    struct spatial_index_cell* p_cell = darr_get(&p_index->_cells, cell);
+
+    p_item->_cell = cell;
+    p_item->_prev = SPATIAL_INDEX_NONE;
+    p_item->_next = p_cell->first_item;
+
+    if (p_cell->first_item != SPATIAL_INDEX_NONE) {
+        ((struct spatial_index_item*)darr_get(&p_index->_items, p_cell->first_item))->_prev = item;
+    }
+
+    p_cell->first_item = item;
+}
+
+void spatial_index_unlink(struct spatial_index* p_index, uint32_t item) {
+    struct spatial_index_item* p_item = darr_get(&p_index->_items, item);
+
+    if (p_item->_cell == SPATIAL_INDEX_OVERSIZED) {
+        const uint32_t last = *(uint32_t*)darr_get(&p_index->_oversized_items, p_index->_oversized_items._length - 1);
+        ((struct spatial_index_item*)darr_get(&p_index->_items, last))->_prev = p_item->_prev;
+        darr_remove(&p_index->_oversized_items, p_item->_prev);
+        return;
+    }
+
+    struct spatial_index_cell* p_cell = darr_get(&p_index->_cells, p_item->_cell);
+
+    if (p_item->_prev != SPATIAL_INDEX_NONE) {
+        ((struct spatial_index_item*)darr_get(&p_index->_items, p_item->_prev))->_next = p_item->_next;
+    } else {
+        p_cell->first_item = p_item->_next;
+    }
+
+    if (p_item->_next != SPATIAL_INDEX_NONE) {
+        ((struct spatial_index_item*)darr_get(&p_index->_items, p_item->_next))->_prev = p_item->_prev;
+    }
+
+    if (p_cell->first_item != SPATIAL_INDEX_NONE) {
+        return;
+    }
+
+    // Empty cells are dropped so the level lists only ever hold occupied cells
+    struct darr* p_level_cells = &p_index->_level_cells[p_cell->key.level];
+    const uint32_t last = *(uint32_t*)darr_get(p_level_cells, p_level_cells->_length - 1);
+    ((struct spatial_index_cell*)darr_get(&p_index->_cells, last))->level_list_index = p_cell->level_list_index;
+    darr_remove(p_level_cells, p_cell->level_list_index);
+
+    spatial_index_remove_slot(p_index, p_item->_cell);
+    *(uint32_t*)darr_push(&p_index->_free_cells) = p_item->_cell;
+}
+
+void spatial_index_query(const struct spatial_index* p_index, const struct spatial_index_query* p_query, struct darr* p_results) {
+    for (uint32_t level = 0; level < SPATIAL_INDEX_LEVELS; ++level) {
+        const struct darr* p_level_cells = &p_index->_level_cells[level];
+
+        if (p_level_cells->_length == 0) {
+            continue;
+        }
+
+        const float cell_size = spatial_index_level_cell_size(p_index, level);
+
+        // Frustum queries have no bounds to pick cells by, so the level's whole loose cells are culled first, a batch
+        // at a time through the SIMD frustum test
+        if (p_query->shape == SPATIAL_INDEX_SHAPE_frustum) {
+            float cell_boxes[SPATIAL_INDEX_CELL_BATCH][6];
+            uint32_t visible_cells[SPATIAL_INDEX_CELL_BATCH];
+            const uint32_t* p_cells = p_level_cells->_p_buffer;
+
+            for (size_t first = 0; first < p_level_cells->_length; first += SPATIAL_INDEX_CELL_BATCH) {
+                const size_t num_cells = p_level_cells->_length - first < SPATIAL_INDEX_CELL_BATCH ? p_level_cells->_length - first : SPATIAL_INDEX_CELL_BATCH;
+
+                for (size_t i = 0; i < num_cells; ++i) {
+                    const int32_t* p_coords = ((const struct spatial_index_cell*)darr_get(&p_index->_cells, p_cells[first + i]))->key.coords;
+
+                    for (size_t j = 0; j < 3; ++j) {
+                        cell_boxes[i][j] = ((float)p_coords[j] - 0.5f) * cell_size;
+                        cell_boxes[i][j + 3] = ((float)p_coords[j] + 1.5f) * cell_size;
+                    }
+                }
+
+                const size_t num_visible = matrix_frustum_cull_aabbs(p_query->p_planes, cell_boxes, sizeof(cell_boxes[0]), num_cells, visible_cells);
+
+                for (size_t i = 0; i < num_visible; ++i) {
+                    spatial_index_query_cell(p_index, p_query, p_cells[first + visible_cells[i]], p_results);
+                }
+            }
+            continue;
+        }
+
+        // A box in cell c reaches at most half a cell past it, so only cells this close to the query can hold a hit
+        int32_t lo[3];
+        int32_t hi[3];
+        double num_cells = 1;
+
+        for (size_t i = 0; i < 3; ++i) {
+            lo[i] = spatial_index_coord(p_query->min[i] - cell_size * 1.5f, cell_size);
+            hi[i] = spatial_index_coord(p_query->max[i] + cell_size * 0.5f, cell_size);
+            num_cells *= (double)hi[i] - lo[i] + 1;
+        }
+
+        // Big queries are cheaper to answer by walking the occupied cells than by probing every cell they cover, with a
+        // probe costing a few times as much as a step of the walk
+        if (num_cells * 4 > (double)p_level_cells->_length) {
+            for (size_t i = 0; i < p_level_cells->_length; ++i) {
+                const uint32_t cell = *(uint32_t*)darr_get(p_level_cells, i);
+                const int32_t* p_coords = ((const struct spatial_index_cell*)darr_get(&p_index->_cells, cell))->key.coords;
+
+                if (p_coords[0] >= lo[0] && p_coords[0] <= hi[0] && p_coords[1] >= lo[1] && p_coords[1] <= hi[1] && p_coords[2] >= lo[2] && p_coords[2] <= hi[2]) {
+                    spatial_index_query_cell(p_index, p_query, cell, p_results);
+                }
+            }
+            continue;
+        }
+
+        struct spatial_index_cell_key key = { .level = level };
+
+        for (key.coords[2] = lo[2]; key.coords[2] <= hi[2]; ++key.coords[2]) {
+            for (key.coords[1] = lo[1]; key.coords[1] <= hi[1]; ++key.coords[1]) {
+                for (key.coords[0] = lo[0]; key.coords[0] <= hi[0]; ++key.coords[0]) {
+                    const uint32_t cell = spatial_index_lookup(p_index, &key);
+
+                    if (cell != SPATIAL_INDEX_NONE) {
+                        spatial_index_query_cell(p_index, p_query, cell, p_results);
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < p_index->_oversized_items._length; ++i) {
+        const struct spatial_index_item* p_item = darr_get(&p_index->_items, *(uint32_t*)darr_get(&p_index->_oversized_items, i));
+
+        if (spatial_index_test(p_query, p_item->min, p_item->max)) {
+            *(uint32_t*)darr_push(p_results) = p_item->value;
+        }
+    }
+}
+
+void spatial_index_query_cell(const struct spatial_index* p_index, const struct spatial_index_query* p_query, uint32_t cell, struct darr* p_results) {
+    const struct spatial_index_cell* p_cell = darr_get(&p_index->_cells, cell);
+
+    for (uint32_t item = p_cell->first_item; item != SPATIAL_INDEX_NONE;) {
+        const struct spatial_index_item* p_item = darr_get(&p_index->_items, item);
+
+        if (spatial_index_test(p_query, p_item->min, p_item->max)) {
+            *(uint32_t*)darr_push(p_results) = p_item->value;
+        }
+
+        item = p_item->_next;
+    }
+}
+
+int spatial_index_test(const struct spatial_index_query* p_query, const float* p_min, const float* p_max) {
+    switch (p_query->shape) {
+        case SPATIAL_INDEX_SHAPE_aabb: {
+            return p_min[0] <= p_query->max[0] && p_max[0] >= p_query->min[0]
+                && p_min[1] <= p_query->max[1] && p_max[1] >= p_query->min[1]
+                && p_min[2] <= p_query->max[2] && p_max[2] >= p_query->min[2];
+        }
+
+        case SPATIAL_INDEX_SHAPE_sphere: {
+            float distance_sq = 0;
+            for (size_t i = 0; i < 3; ++i) {
+                const float c = p_query->p_center[i];
+                const float d = c < p_min[i] ? p_min[i] - c : (c > p_max[i] ? c - p_max[i] : 0);
+                distance_sq += d * d;
+            }
+            return distance_sq <= p_query->radius * p_query->radius;
+        }
+
+        case SPATIAL_INDEX_SHAPE_frustum: {
+            // The box is outside if its corner furthest along any plane's normal is still behind that plane
+            for (size_t i = 0; i < 6; ++i) {
+                const float* p_plane = &p_query->p_planes[i * 4];
+                const float x = p_plane[0] >= 0 ? p_max[0] : p_min[0];
+                const float y = p_plane[1] >= 0 ? p_max[1] : p_min[1];
+                const float z = p_plane[2] >= 0 ? p_max[2] : p_min[2];
+
+                if (p_plane[0] * x + p_plane[1] * y + p_plane[2] * z + p_plane[3] < 0) {
+                    return 0;
+                }
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+float spatial_index_level_cell_size(const struct spatial_index* p_index, uint32_t level) {
+    return ldexpf(p_index->_cell_size, (int)level);
+}
+
+int32_t spatial_index_coord(float x, float cell_size) {
+    const float coord = floorf(x / cell_size);
+
+    if (!(coord > -SPATIAL_INDEX_COORD_MAX)) {
+        return -SPATIAL_INDEX_COORD_MAX;
+    }
+
+    if (coord > SPATIAL_INDEX_COORD_MAX) {
+        return SPATIAL_INDEX_COORD_MAX;
+    }
+
+    return (int32_t)coord;
+}
@@ -0,0 +1,51 @@
+#ifndef _H__SPATIAL_INDEX
+#define _H__SPATIAL_INDEX
+
+#include <stdint.h>
+
+#include "darr.h"
+
+#define SPATIAL_INDEX_NONE      UINT32_MAX
+#define SPATIAL_INDEX_OVERSIZED (SPATIAL_INDEX_NONE - 1)
+#define SPATIAL_INDEX_LEVELS    16
+
+struct spatial_index_slot;
+
+/* A hierarchical loose grid over axis-aligned boxes. Each box is filed under the cell containing its centre, on the
+ * finest level whose cells are at least as big as the box, so it never reaches more than half a cell outside that
+ * cell. Cells live in an open-addressed hash table, so the world is unbounded and inserting, moving and removing a box
+ * are O(1). Queries visit only the occupied cells near the query on each level. Boxes too big for the coarsest level
+ * are kept on a list that every query checks. */
+struct spatial_index {
+    float       _cell_size;                         // of the finest level; each level doubles it
+    struct darr _items;                             // struct spatial_index_item, indexed by item handle
+    struct darr _free_items;                        // uint32_t
+    struct darr _cells;                             // struct spatial_index_cell
+    struct darr _free_cells;                        // uint32_t
+    struct darr _level_cells[SPATIAL_INDEX_LEVELS]; // uint32_t indices of each level's occupied cells
+    struct darr _oversized_items;                   // uint32_t
+    struct spatial_index_slot* _p_cell_slots;       // cell keys and indices by key hash
+    size_t      _num_cell_slots;                    // a power of two, kept at least twice the occupied cells
+};
+
+struct spatial_index_item {
+    float    min[3];
+    float    max[3];
+    uint32_t value;
+    uint32_t _cell;    // SPATIAL_INDEX_OVERSIZED when oversized, SPATIAL_INDEX_NONE when free
+    uint32_t _prev;
+    uint32_t _next;
+};
+
+void     spatial_index_init(struct spatial_index* p_index, float cell_size);
+void     spatial_index_free(struct spatial_index* p_index);
+uint32_t spatial_index_insert(struct spatial_index* p_index, const float* p_min, const float* p_max, uint32_t value);
+void     spatial_index_update(struct spatial_index* p_index, uint32_t item, const float* p_min, const float* p_max);
+void     spatial_index_remove(struct spatial_index* p_index, uint32_t item);
+
+// Queries append the value of every box that touches the volume to p_results (a darr of uint32_t)
+void spatial_index_query_aabb(const struct spatial_index* p_index, const float* p_min, const float* p_max, struct darr* p_results);
+void spatial_index_query_sphere(const struct spatial_index* p_index, const float* p_center, float radius, struct darr* p_results);
+void spatial_index_query_frustum(const struct spatial_index* p_index, const float* p_planes, struct darr* p_results); // 6 planes from matrix_frustum_planes
+
+#endif
@@ -1,21 +1,24 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "gl_mesh.h"
 #include "mesh.h"
 #include "static_mesh.h"
+#include "vector.h"
 
 void static_mesh_free(struct static_mesh* p_static_mesh) {
-    free(p_static_mesh->p_gl_meshes);
-    static_mesh_unlod_device_meshes(p_static_mesh);
+    if (p_static_mesh->b_loaded_device_meshes) {
+        static_mesh_unlod_device_meshes(p_static_mesh);
+    }
     *p_static_mesh = (struct static_mesh){0};
 }
 
-void static_mesh_load_device_meshes(struct static_mesh* p_static_mesh) {
+void static_mesh_load_device_meshes(struct static_mesh* p_static_mesh, struct gl_geometry_pool* p_pool) {
     p_static_mesh->p_gl_meshes = malloc(sizeof(*p_static_mesh->p_gl_meshes) * p_static_mesh->num_primitives);
 
     for (size_t i = 0; i < p_static_mesh->num_primitives; ++i) {
         const struct mesh_primitive* p_primitive = &p_static_mesh->p_primitives[i];
-        gl_mesh_create(&p_static_mesh->p_gl_meshes[i], p_primitive);
+        gl_mesh_create_pooled(&p_static_mesh->p_gl_meshes[i], p_primitive, p_pool);
     }
 
     p_static_mesh->b_loaded_device_meshes = 1;
@@ -26,5 +29,22 @@ void static_mesh_unlod_device_meshes(struct static_mesh* p_static_mesh) {
         gl_mesh_destroy(&p_static_mesh->p_gl_meshes[i]);
     }
     free(p_static_mesh->p_gl_meshes);
+    p_static_mesh->p_gl_meshes = 0;
     p_static_mesh->b_loaded_device_meshes = 0;
-}
\ No newline at end of file
+}
+
+int static_mesh_compute_bounds(const struct static_mesh* p_static_mesh, float* p_min, float* p_max) {
+    if (p_static_mesh->num_primitives == 0) {
+        return 0;
+    }
+
+    memcpy(p_min, p_static_mesh->p_primitives[0].bounds_min, sizeof(float) * 3);
+    memcpy(p_max, p_static_mesh->p_primitives[0].bounds_max, sizeof(float) * 3);
+
+    for (size_t i = 1; i < p_static_mesh->num_primitives; ++i) {
+        vec3_min(p_min, p_static_mesh->p_primitives[i].bounds_min, p_min);
+        vec3_max(p_max, p_static_mesh->p_primitives[i].bounds_max, p_max);
+    }
+
+    return 1;
+}
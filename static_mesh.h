@@ -7,6 +7,7 @@
 
 #define ASSET_TYPE_STATIC_MESH 4
 
+struct gl_geometry_pool;
 struct gl_mesh;
 struct mesh_primitive;
 
@@ -19,7 +20,8 @@ struct static_mesh {
 };
 
 void static_mesh_free(struct static_mesh* p_static_mesh);
-void static_mesh_load_device_meshes(struct static_mesh* p_static_mesh);
+void static_mesh_load_device_meshes(struct static_mesh* p_static_mesh, struct gl_geometry_pool* p_pool);
 void static_mesh_unlod_device_meshes(struct static_mesh* p_static_mesh);
+int  static_mesh_compute_bounds(const struct static_mesh* p_static_mesh, float* p_min, float* p_max); // 0 if it has no primitives
 
 #endif
\ No newline at end of file
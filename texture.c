@@ -1,11 +1,34 @@
+#include "cooked_texture.h"
 #include "gl_texture.h"
+#include "gl_texture_upload_queue.h"
 #include "texture.h"
 
-void texture_load_device_texture(struct texture* p_texture) {
+void texture_load_device_texture(struct texture* p_texture, struct gl_texture_upload_queue* p_upload_queue) {
+    if (GET_ASSET_TYPE(p_texture->p_source_image->_asset._id) == ASSET_TYPE_COOKED_TEXTURE) {
+        const struct cooked_texture* p_cooked_texture = p_texture->p_source_image->_asset._p_data;
+
+        if (p_upload_queue) {
+            gl_texture_upload_queue_push_cooked(p_upload_queue, &p_texture->gl_texture, p_cooked_texture, &p_texture->sampler);
+        } else {
+            gl_texture_create_cooked(&p_texture->gl_texture, p_cooked_texture, &p_texture->sampler);
+        }
+
+        return;
+    }
+
     const struct image* p_image = p_texture->p_source_image->_asset._p_data;
-    gl_texture_create(&p_texture->gl_texture, p_image, &p_texture->sampler);
+
+    if (p_upload_queue) {
+        gl_texture_upload_queue_push(p_upload_queue, &p_texture->gl_texture, p_image, &p_texture->sampler);
+    } else {
+        gl_texture_create(&p_texture->gl_texture, p_image, &p_texture->sampler);
+    }
 }
 
-void texture_unload_device_texture(struct texture* p_texture) {
+void texture_unload_device_texture(struct texture* p_texture, struct gl_texture_upload_queue* p_upload_queue) {
+    if (p_upload_queue && !p_texture->gl_texture.b_is_ready) {
+        gl_texture_upload_queue_cancel(p_upload_queue, &p_texture->gl_texture);
+    }
+
     gl_texture_destroy(&p_texture->gl_texture);
 }
\ No newline at end of file
@@ -7,15 +7,17 @@
 
 #define ASSET_TYPE_TEXTURE 2
 
+struct gl_texture_upload_queue;
 struct image;
 
 struct texture {
-    asset_handle            p_source_image;
+    asset_handle            p_source_image; // an image, or a cooked texture
     struct texture_sampler  sampler;
     struct gl_texture       gl_texture;
 };
 
-void texture_load_device_texture(struct texture* p_texture);
-void texture_unload_device_texture(struct texture* p_texture);
+// Queues the texture's pixels on p_upload_queue, or uploads them right away if that's 0
+void texture_load_device_texture(struct texture* p_texture, struct gl_texture_upload_queue* p_upload_queue);
+void texture_unload_device_texture(struct texture* p_texture, struct gl_texture_upload_queue* p_upload_queue);
 
 #endif
\ No newline at end of file
@@ -1,9 +1,30 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "matrix.h"
+#include "parallel.h"
 #include "transform.h"
 #include "vector.h"
 
 #include "logging.h"
 
+static void     transform_compute_world(struct transform* p_transform);
+static uint32_t transform_depth(const struct transform* p_transform);
+static void     transform_hierarchy_compact(struct transform_hierarchy* p_hierarchy);
+static void     transform_hierarchy_sort(struct transform_hierarchy* p_hierarchy);
+static void     transform_hierarchy_update_range(struct transform** pp_transforms, size_t begin, size_t end);
+static void     transform_hierarchy_update_chunk(size_t index, void* p_user_data);
+
+// Levels smaller than this are updated on the calling thread; handing them to the pool costs more than it saves
+#define TRANSFORM_PARALLEL_MIN_LEVEL_SIZE 2048
+#define TRANSFORM_PARALLEL_CHUNK_SIZE     512
+
+struct transform_level_job {
+    struct transform** pp_transforms;
+    size_t             begin;
+    size_t             end;
+};
+
 void transform_make_identity(struct transform* p_transform) {
     *p_transform = (struct transform) {0};
     quaternion_identity(p_transform->rotation);
@@ -25,6 +46,14 @@ void transform_reset_local(struct transform* p_transform) {
 void transform_compute_world_trs_matrix(struct transform* p_transform) {    
     if (p_transform->p_local_transform) {
         transform_compute_world_trs_matrix(p_transform->p_local_transform);
+    }
+
+    transform_compute_world(p_transform);
+}
+
+// World values from the parent's current ones, without touching the parent
+void transform_compute_world(struct transform* p_transform) {
+    if (p_transform->p_local_transform) {
         vec3_add(p_transform->p_local_transform->world_position, p_transform->position, p_transform->world_position);
         quaternion_multiply(p_transform->p_local_transform->world_rotation, p_transform->rotation, p_transform->world_rotation);
         vec3_mul(p_transform->p_local_transform->world_scale, p_transform->scale, p_transform->world_scale);
@@ -34,12 +63,7 @@ void transform_compute_world_trs_matrix(struct transform* p_transform) {
         vec3_set(p_transform->scale, p_transform->world_scale);
     }
 
-    float temp[16];
-    matrix_make_scale(p_transform->world_scale[0], p_transform->world_scale[1], p_transform->world_scale[2], temp);
-    matrix_make_rotation_from_quaternion(p_transform->world_rotation, p_transform->world_trs_matrix);
-    matrix_multiply(p_transform->world_trs_matrix, temp, p_transform->world_trs_matrix);
-    matrix_make_translation(p_transform->world_position[0], p_transform->world_position[1], p_transform->world_position[2], temp);
-    matrix_multiply(temp, p_transform->world_trs_matrix, p_transform->world_trs_matrix);
+    matrix_make_trs(p_transform->world_position, p_transform->world_rotation, p_transform->world_scale, p_transform->world_trs_matrix);
 }
 
 void transform_copy(const struct transform* p_transform, struct transform* p_result) {
@@ -96,4 +120,195 @@ int transform_set_local_transform(struct transform* p_transform, struct transfor
     transform_set_world_scale(p_transform, p_transform->world_scale);
 
     return 1;
-}
\ No newline at end of file
+}
+
+uint32_t transform_depth(const struct transform* p_transform) {
+    uint32_t depth = 0;
+    while (p_transform->p_local_transform) {
+        p_transform = p_transform->p_local_transform;
+        ++depth;
+    }
+    return depth;
+}
+
+void transform_hierarchy_init(struct transform_hierarchy* p_hierarchy) {
+    *p_hierarchy = (struct transform_hierarchy){0};
+    darr_init(&p_hierarchy->_transforms, sizeof(struct transform*));
+    darr_init(&p_hierarchy->_level_offsets, sizeof(uint32_t));
+}
+
+void transform_hierarchy_free(struct transform_hierarchy* p_hierarchy) {
+    darr_free(&p_hierarchy->_transforms);
+    darr_free(&p_hierarchy->_level_offsets);
+}
+
+void transform_hierarchy_reserve(struct transform_hierarchy* p_hierarchy, size_t capacity) {
+    const size_t old_capacity = p_hierarchy->_transforms._capacity;
+    if (old_capacity < capacity) {
+        darr_set_capacity(&p_hierarchy->_transforms, capacity > old_capacity * 2 ? capacity : old_capacity * 2);
+    }
+}
+
+void transform_hierarchy_add(struct transform_hierarchy* p_hierarchy, struct transform* p_transform) {
+    p_transform->_hierarchy_index = (uint32_t)p_hierarchy->_transforms._length;
+    *(struct transform**)darr_push(&p_hierarchy->_transforms) = p_transform;
+    p_transform->_b_dirty = 1;
+
+    // Appended at the end it may be above its level's range or ahead of its parent
+    p_hierarchy->_b_needs_sort = 1;
+}
+
+void transform_hierarchy_remove(struct transform_hierarchy* p_hierarchy, struct transform* p_transform) {
+    const size_t index = p_transform->_hierarchy_index;
+    if (index >= p_hierarchy->_transforms._length || *(struct transform**)darr_get(&p_hierarchy->_transforms, index) != p_transform) {
+        cx_log(CX_LOG_ERROR, "transform", "Transform isn't part of this hierarchy\n");
+        return;
+    }
+
+    // Leave a hole so removal is O(1); the next update closes them all in one pass
+    *(struct transform**)darr_get(&p_hierarchy->_transforms, index) = 0;
+    ++p_hierarchy->_num_removed;
+}
+
+void transform_hierarchy_compact(struct transform_hierarchy* p_hierarchy) {
+    struct transform** pp_transforms = p_hierarchy->_transforms._p_buffer;
+    uint32_t* p_offsets = p_hierarchy->_level_offsets._p_buffer;
+    const size_t num_levels = p_hierarchy->_level_offsets._length ? p_hierarchy->_level_offsets._length - 1 : 0;
+    size_t read = 0;
+    size_t write = 0;
+
+    // Sliding everything down keeps the depth order, so each level offset just moves to where its range now starts.
+    // The last pass picks up anything added since the last sort, which sits after the sorted levels.
+    for (size_t level = 0; level <= num_levels; ++level) {
+        const size_t end = level < num_levels ? p_offsets[level + 1] : p_hierarchy->_transforms._length;
+
+        for (; read < end; ++read) {
+            if (pp_transforms[read]) {
+                pp_transforms[write] = pp_transforms[read];
+                pp_transforms[write]->_hierarchy_index = (uint32_t)write;
+                ++write;
+            }
+        }
+
+        if (level < num_levels) {
+            p_offsets[level + 1] = (uint32_t)write;
+        }
+    }
+
+    darr_set_length(&p_hierarchy->_transforms, write);
+    p_hierarchy->_num_removed = 0;
+}
+
+void transform_hierarchy_sort(struct transform_hierarchy* p_hierarchy) {
+    const size_t n = p_hierarchy->_transforms._length;
+    struct transform** pp_transforms = p_hierarchy->_transforms._p_buffer;
+
+    // Counting sort by depth, which is stable, so siblings keep their relative order between sorts
+    uint32_t* p_depths = malloc(sizeof(uint32_t) * (n ? n : 1));
+    uint32_t max_depth = 0;
+    for (size_t i = 0; i < n; ++i) {
+        p_depths[i] = transform_depth(pp_transforms[i]);
+        if (p_depths[i] > max_depth) {
+            max_depth = p_depths[i];
+        }
+    }
+
+    darr_set_length(&p_hierarchy->_level_offsets, n ? max_depth + 2 : 1);
+    uint32_t* p_offsets = p_hierarchy->_level_offsets._p_buffer;
+    memset(p_offsets, 0, sizeof(uint32_t) * p_hierarchy->_level_offsets._length);
+    for (size_t i = 0; i < n; ++i) {
+        ++p_offsets[p_depths[i] + 1];
+    }
+    for (size_t i = 1; i < p_hierarchy->_level_offsets._length; ++i) {
+        p_offsets[i] += p_offsets[i - 1];
+    }
+
+    struct transform** pp_sorted = malloc(sizeof(struct transform*) * (n ? n : 1));
+    uint32_t* p_cursors = malloc(sizeof(uint32_t) * (max_depth + 1));
+    memcpy(p_cursors, p_offsets, sizeof(uint32_t) * (max_depth + 1));
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t sorted_index = p_cursors[p_depths[i]]++;
+        pp_sorted[sorted_index] = pp_transforms[i];
+        pp_transforms[i]->_hierarchy_index = sorted_index;
+        if (pp_transforms[i]->_p_sorted_local_transform != pp_transforms[i]->p_local_transform) {
+            pp_transforms[i]->_p_sorted_local_transform = pp_transforms[i]->p_local_transform;
+            pp_transforms[i]->_b_dirty = 1;
+        }
+    }
+    memcpy(pp_transforms, pp_sorted, sizeof(struct transform*) * n);
+
+    free(p_cursors);
+    free(pp_sorted);
+    free(p_depths);
+
+    p_hierarchy->_b_needs_sort = 0;
+}
+
+void transform_hierarchy_update(struct transform_hierarchy* p_hierarchy) {
+    if (p_hierarchy->_num_removed) {
+        transform_hierarchy_compact(p_hierarchy);
+    }
+
+    struct transform** pp_transforms = p_hierarchy->_transforms._p_buffer;
+    const size_t n = p_hierarchy->_transforms._length;
+
+    if (n == 0) {
+        return;
+    }
+
+    // Parents are assigned directly on the transforms, so catch any that changed since the last sort
+    for (size_t i = 0; i < n && !p_hierarchy->_b_needs_sort; ++i) {
+        p_hierarchy->_b_needs_sort = pp_transforms[i]->p_local_transform != pp_transforms[i]->_p_sorted_local_transform;
+    }
+
+    if (p_hierarchy->_b_needs_sort) {
+        transform_hierarchy_sort(p_hierarchy);
+    }
+
+    /* Each level only reads the one above it, so a level's transforms are independent of each other. parallel_for
+     * returns once the whole level is done, which is the barrier before the next. */
+    const uint32_t* p_offsets = p_hierarchy->_level_offsets._p_buffer;
+    const size_t num_levels = p_hierarchy->_level_offsets._length - 1;
+    const int b_parallel = parallel_num_threads() > 1;
+
+    for (size_t level = 0; level < num_levels; ++level) {
+        const size_t begin = p_offsets[level];
+        const size_t end = p_offsets[level + 1];
+
+        if (!b_parallel || end - begin < TRANSFORM_PARALLEL_MIN_LEVEL_SIZE) {
+            transform_hierarchy_update_range(pp_transforms, begin, end);
+            continue;
+        }
+
+        struct transform_level_job job = { pp_transforms, begin, end };
+        parallel_for((end - begin + TRANSFORM_PARALLEL_CHUNK_SIZE - 1) / TRANSFORM_PARALLEL_CHUNK_SIZE, transform_hierarchy_update_chunk, &job);
+    }
+}
+
+void transform_hierarchy_update_chunk(size_t index, void* p_user_data) {
+    const struct transform_level_job* p_job = p_user_data;
+    const size_t begin = p_job->begin + index * TRANSFORM_PARALLEL_CHUNK_SIZE;
+    const size_t end = begin + TRANSFORM_PARALLEL_CHUNK_SIZE < p_job->end ? begin + TRANSFORM_PARALLEL_CHUNK_SIZE : p_job->end;
+    transform_hierarchy_update_range(p_job->pp_transforms, begin, end);
+}
+
+void transform_hierarchy_update_range(struct transform** pp_transforms, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        struct transform* p_transform = pp_transforms[i];
+
+        float local[10];
+        vec3_set(p_transform->position, &local[0]);
+        vec_set(4, p_transform->rotation, &local[3]);
+        vec3_set(p_transform->scale, &local[7]);
+
+        p_transform->_b_changed = p_transform->_b_dirty
+            || memcmp(local, p_transform->_cached_local, sizeof(local)) != 0
+            || (p_transform->p_local_transform && p_transform->p_local_transform->_b_changed);
+
+        if (p_transform->_b_changed) {
+            memcpy(p_transform->_cached_local, local, sizeof(local));
+            p_transform->_b_dirty = 0;
+            transform_compute_world(p_transform);
+        }
+    }
+}
@@ -1,6 +1,10 @@
 #ifndef _H__TRANSFORM
 #define _H__TRANSFORM
 
+#include <stdint.h>
+
+#include "darr.h"
+
 struct transform {
     float             position[3];
     float             rotation[4];
@@ -10,6 +14,23 @@ struct transform {
     float             world_scale[3];
     float             world_trs_matrix[16];
     struct transform* p_local_transform;
+
+    // Bookkeeping for struct transform_hierarchy
+    float             _cached_local[10];          // position, rotation and scale as of the last update
+    struct transform* _p_sorted_local_transform;  // p_local_transform when the hierarchy was last sorted
+    uint32_t          _hierarchy_index;
+    int               _b_dirty;                   // recompute on the next update even if the local values match
+    int               _b_changed;                 // world values were recomputed by the latest update
+};
+
+/* The transforms of a scene, kept sorted by depth so that a single linear pass sees every parent before its children.
+ * Local values are compared against the last update's, so subtrees that haven't moved are skipped without callers
+ * having to flag anything. The order is rebuilt lazily when a transform's parent changes. */
+struct transform_hierarchy {
+    struct darr _transforms;     // struct transform*, in depth order
+    struct darr _level_offsets;  // uint32_t, index of the first transform at each depth, plus the total at the end
+    size_t      _num_removed;    // null entries left in _transforms by removal
+    int         _b_needs_sort;
 };
 
 void transform_make_identity(struct transform* p_transform);
@@ -21,4 +42,11 @@ void transform_set_world_rotation(struct transform* p_transform, const float* p_
 void transform_set_world_scale(struct transform* p_transform, const float* p_scale);
 int  transform_set_local_transform(struct transform* p_transform, struct transform* p_local_transform, int b_preserve_world_transform);
 
+void transform_hierarchy_init(struct transform_hierarchy* p_hierarchy);
+void transform_hierarchy_free(struct transform_hierarchy* p_hierarchy);
+void transform_hierarchy_reserve(struct transform_hierarchy* p_hierarchy, size_t capacity);
+void transform_hierarchy_add(struct transform_hierarchy* p_hierarchy, struct transform* p_transform);
+void transform_hierarchy_remove(struct transform_hierarchy* p_hierarchy, struct transform* p_transform);
+void transform_hierarchy_update(struct transform_hierarchy* p_hierarchy);
+
 #endif
\ No newline at end of file
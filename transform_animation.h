@@ -1,6 +1,7 @@
 #ifndef _H__TRANSFORM_ANIMATION
 #define _H__TRANSFORM_ANIMATION
 
+#include <stddef.h>
 #include <stdint.h>
 
 enum transform_animation_interpolation_mode {
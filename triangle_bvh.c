@@ -0,0 +1,676 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logging.h"
+#include "mesh.h"
+#include "serialization.h"
+#include "static_mesh.h"
+#include "triangle_bvh.h"
+#include "vector.h"
+
+#define CX_LOG_CAT_BVH "bvh"
+
+#define TBVH_SAH_BINS     12
+#define TBVH_STACK_SIZE   64
+#define TBVH_QUANT_MAX    65535.0f
+
+struct tbvh_build_context {
+    struct triangle_bvh* p_bvh;
+    struct darr          nodes;
+    float*               p_tri_bounds;    // min, max per triangle
+    float*               p_tri_centroids;
+    uint32_t*            p_order;         // triangle indices, partitioned in place
+    float                quant_scale[3];
+};
+
+struct tbvh_bin {
+    float    min[3];
+    float    max[3];
+    uint32_t count;
+};
+
+static uint32_t tbvh_build_node(struct tbvh_build_context* p_ctx, uint32_t begin, uint32_t end, float* p_min, float* p_max);
+static uint32_t tbvh_find_split(const struct tbvh_build_context* p_ctx, uint32_t begin, uint32_t end, const float* p_min, const float* p_max);
+static uint32_t tbvh_make_leaf(uint32_t begin, uint32_t end);
+static void     tbvh_quantise(const struct triangle_bvh* p_bvh, const float* p_scale, const float* p_min, const float* p_max, uint16_t* p_qmin, uint16_t* p_qmax);
+static void     tbvh_dequantise(const struct triangle_bvh* p_bvh, const uint16_t* p_qmin, const uint16_t* p_qmax, float* p_min, float* p_max);
+static float    tbvh_surface_area(const float* p_min, const float* p_max);
+static void     tbvh_compute_quant_scale(const struct triangle_bvh* p_bvh, float* p_scale);
+static int      tbvh_ray_box(const float* p_origin, const float* p_inv_dir, const float* p_min, const float* p_max, float max_t, float* p_t);
+static int      tbvh_ray_triangle(const float* p_origin, const float* p_dir, const float* p_v0, const float* p_v1, const float* p_v2, float* p_t);
+
+int triangle_bvh_build(const struct static_mesh* p_static_mesh, struct triangle_bvh* p_result) {
+    *p_result = (struct triangle_bvh){0};
+
+    // Copy positions and indices of every triangle list, offsetting each primitive's indices past the ones before it
+
+    struct darr positions;
+    struct darr indices;
+    darr_init(&positions, sizeof(float) * 3);
+    darr_init(&indices, sizeof(uint32_t));
+
+    for (size_t i = 0; i < p_static_mesh->num_primitives; ++i) {
+        const struct mesh_primitive* p_primitive = &p_static_mesh->p_primitives[i];
+
+        if (p_primitive->draw_mode != MESH_PRIMITIVE_DRAW_MODE_triangles) {
+            cx_log_fmt(CX_LOG_WARNING, CX_LOG_CAT_BVH, "Skipping primitive %d: only triangle lists are supported\n", (int)i);
+            continue;
+        }
+
+        const struct vertex_attribute* p_position_attribute = 0;
+
+        for (size_t a = 0; a < p_primitive->num_attributes; ++a) {
+            if (p_primitive->p_attributes[a].index == 0) {
+                p_position_attribute = &p_primitive->p_attributes[a];
+                break;
+            }
+        }
+
+        const struct vertex_index_buffer* p_index_buffer = &p_primitive->index_buffer;
+        const size_t num_indices = (p_index_buffer->p_bytes ? p_index_buffer->count : p_primitive->vertex_count) / 3 * 3;
+
+        if (!p_position_attribute || num_indices == 0) {
+            continue;
+        }
+
+        const struct vertex_buffer* p_position_buffer = &p_primitive->p_vertex_buffers[p_position_attribute->vertex_buffer_index];
+        const uint32_t first_position = (uint32_t)positions._length;
+
+        darr_set_length(&positions, first_position + p_primitive->vertex_count);
+
+        for (size_t v = 0; v < p_primitive->vertex_count; ++v) {
+            const float* p_v = (float*)((char*)p_position_buffer->p_bytes + p_position_attribute->layout.offset + (p_position_attribute->layout.stride * v));
+            vec3_set(p_v, darr_get(&positions, first_position + v));
+        }
+
+        const size_t first_index = indices._length;
+
+        darr_set_length(&indices, first_index + num_indices);
+
+        for (size_t j = 0; j < num_indices; ++j) {
+            uint32_t index = (uint32_t)j;
+
+            if (p_index_buffer->p_bytes) {
+                switch (p_index_buffer->type) {
+                    case VERTEX_INDEX_TYPE_u8:  index = ((const uint8_t*)p_index_buffer->p_bytes)[j];  break;
+                    case VERTEX_INDEX_TYPE_u16: index = ((const uint16_t*)p_index_buffer->p_bytes)[j]; break;
+                    case VERTEX_INDEX_TYPE_u32: index = ((const uint32_t*)p_index_buffer->p_bytes)[j]; break;
+                }
+            }
+
+            *(uint32_t*)darr_get(&indices, first_index + j) = first_position + index;
+        }
+    }
+
+    if (indices._length == 0) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Cannot build triangle BVH: mesh has no triangles\n");
+        darr_free(&positions);
+        darr_free(&indices);
+        return 0;
+    }
+
+    if (indices._length / 3 > TRIANGLE_BVH_LEAF_FIRST_MASK) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Cannot build triangle BVH: too many triangles for the leaf encoding\n");
+        darr_free(&positions);
+        darr_free(&indices);
+        return 0;
+    }
+
+    p_result->num_positions = (uint32_t)positions._length;
+    p_result->p_positions = positions._p_buffer;
+
+    const uint32_t num_triangles = (uint32_t)(indices._length / 3);
+    uint32_t* p_indices = indices._p_buffer;
+
+    p_result->bounds_min[0] = p_result->bounds_min[1] = p_result->bounds_min[2] =  INFINITY;
+    p_result->bounds_max[0] = p_result->bounds_max[1] = p_result->bounds_max[2] = -INFINITY;
+
+    for (uint32_t i = 0; i < num_triangles * 3; ++i) {
+        for (int a = 0; a < 3; ++a) {
+            p_result->bounds_min[a] = fminf(p_result->bounds_min[a], p_result->p_positions[p_indices[i] * 3 + a]);
+            p_result->bounds_max[a] = fmaxf(p_result->bounds_max[a], p_result->p_positions[p_indices[i] * 3 + a]);
+        }
+    }
+
+    // Build
+
+    struct tbvh_build_context ctx = {
+        .p_bvh = p_result,
+        .p_tri_bounds = malloc(sizeof(float) * 6 * num_triangles),
+        .p_tri_centroids = malloc(sizeof(float) * 3 * num_triangles),
+        .p_order = malloc(sizeof(uint32_t) * num_triangles)
+    };
+    darr_init(&ctx.nodes, sizeof(struct triangle_bvh_node));
+    darr_set_capacity(&ctx.nodes, num_triangles);
+    tbvh_compute_quant_scale(p_result, ctx.quant_scale);
+
+    for (uint32_t t = 0; t < num_triangles; ++t) {
+        float* p_min = &ctx.p_tri_bounds[t * 6];
+        float* p_max = &ctx.p_tri_bounds[t * 6 + 3];
+        vec3_set(&p_result->p_positions[p_indices[t * 3] * 3], p_min);
+        vec3_set(p_min, p_max);
+
+        for (int v = 1; v < 3; ++v) {
+            const float* p_v = &p_result->p_positions[p_indices[t * 3 + v] * 3];
+            for (int a = 0; a < 3; ++a) {
+                p_min[a] = fminf(p_min[a], p_v[a]);
+                p_max[a] = fmaxf(p_max[a], p_v[a]);
+            }
+        }
+
+        vec3_add(p_min, p_max, &ctx.p_tri_centroids[t * 3]);
+        vec3_mul_s(&ctx.p_tri_centroids[t * 3], 0.5f, &ctx.p_tri_centroids[t * 3]);
+        ctx.p_order[t] = t;
+    }
+
+    float root_min[3];
+    float root_max[3];
+
+    if (num_triangles <= TRIANGLE_BVH_LEAF_MAX_TRIANGLES) {
+        // The root always has two child slots, so a tiny mesh gets a single leaf and an empty slot
+        struct triangle_bvh_node* p_root = darr_push(&ctx.nodes);
+        *p_root = (struct triangle_bvh_node) {
+            .children = { tbvh_make_leaf(0, num_triangles), TRIANGLE_BVH_EMPTY }
+        };
+        tbvh_quantise(p_result, ctx.quant_scale, p_result->bounds_min, p_result->bounds_max, p_root->child_min[0], p_root->child_max[0]);
+    } else {
+        tbvh_build_node(&ctx, 0, num_triangles, root_min, root_max);
+    }
+
+    // Store triangles in leaf order
+    p_result->num_triangles = num_triangles;
+    p_result->p_indices = malloc(sizeof(uint32_t) * 3 * num_triangles);
+    for (uint32_t t = 0; t < num_triangles; ++t) {
+        memcpy(&p_result->p_indices[t * 3], &p_indices[ctx.p_order[t] * 3], sizeof(uint32_t) * 3);
+    }
+
+    darr_shrink(&ctx.nodes);
+    p_result->p_nodes = ctx.nodes._p_buffer;
+    p_result->num_nodes = (uint32_t)ctx.nodes._length;
+
+    free(p_indices);
+    free(ctx.p_tri_bounds);
+    free(ctx.p_tri_centroids);
+    free(ctx.p_order);
+
+    cx_log_fmt(CX_LOG_TRACE, CX_LOG_CAT_BVH, "Triangle BVH built: %d triangles, %d nodes\n", p_result->num_triangles, p_result->num_nodes);
+
+    return 1;
+}
+
+asset_handle triangle_bvh_find_or_build(struct asset_package* p_package, asset_handle static_mesh_handle) {
+    // The BVH shares the source mesh's IDN, so it can be found again without an index
+    const asset_id id = ASSET_ID(ASSET_TYPE_TRIANGLE_BVH, GET_ASSET_IDN(static_mesh_handle->_asset._id));
+
+    asset_handle handle = asset_package_find_record(p_package, id);
+
+    if (handle) {
+        if (handle->_asset._p_data || asset_load(handle)) {
+            return handle;
+        }
+
+        cx_log_fmt(CX_LOG_INFO, CX_LOG_CAT_BVH, "Cached BVH of '%s' couldn't be loaded; rebuilding\n", static_mesh_handle->_asset.s_name);
+        asset_free(handle);
+    }
+
+    if (!static_mesh_handle->_asset._p_data && !asset_load(static_mesh_handle)) {
+        cx_log_fmt(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Cannot build a BVH for '%s': failed to load the static mesh\n", static_mesh_handle->_asset.s_name);
+        return 0;
+    }
+
+    struct triangle_bvh* p_bvh = calloc(1, sizeof(struct triangle_bvh));
+
+    if (!triangle_bvh_build(static_mesh_handle->_asset._p_data, p_bvh)) {
+        free(p_bvh);
+        return 0;
+    }
+
+    if (!handle) {
+        handle = asset_package_new_record_with_id(p_package, id);
+        snprintf(handle->_asset.s_name, ASSET_NAME_MAX_LEN, "%.*s bvh", ASSET_NAME_MAX_LEN - 5, static_mesh_handle->_asset.s_name);
+    }
+
+    handle->_asset._p_data = p_bvh;
+
+    return handle;
+}
+
+void triangle_bvh_get_triangle(const struct triangle_bvh* p_bvh, uint32_t triangle, float* p_v0, float* p_v1, float* p_v2) {
+    const uint32_t* p_tri = &p_bvh->p_indices[triangle * 3];
+    vec3_set(&p_bvh->p_positions[p_tri[0] * 3], p_v0);
+    vec3_set(&p_bvh->p_positions[p_tri[1] * 3], p_v1);
+    vec3_set(&p_bvh->p_positions[p_tri[2] * 3], p_v2);
+}
+
+void triangle_bvh_query_aabb(const struct triangle_bvh* p_bvh, const float* p_min, const float* p_max, struct darr* p_triangles) {
+    if (!p_bvh->num_nodes) {
+        return;
+    }
+
+    for (int a = 0; a < 3; ++a) {
+        if (p_min[a] > p_bvh->bounds_max[a] || p_max[a] < p_bvh->bounds_min[a]) {
+            return;
+        }
+    }
+
+    // Quantise the query box outward once and compare it against the nodes as integers
+    float scale[3];
+    tbvh_compute_quant_scale(p_bvh, scale);
+
+    uint16_t qmin[3];
+    uint16_t qmax[3];
+    tbvh_quantise(p_bvh, scale, p_min, p_max, qmin, qmax);
+
+    uint32_t stack[TBVH_STACK_SIZE];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size) {
+        const struct triangle_bvh_node* p_node = &p_bvh->p_nodes[stack[--stack_size]];
+
+        for (int c = 0; c < 2; ++c) {
+            const uint32_t child = p_node->children[c];
+
+            if (child == TRIANGLE_BVH_EMPTY
+                || qmin[0] > p_node->child_max[c][0] || qmax[0] < p_node->child_min[c][0]
+                || qmin[1] > p_node->child_max[c][1] || qmax[1] < p_node->child_min[c][1]
+                || qmin[2] > p_node->child_max[c][2] || qmax[2] < p_node->child_min[c][2]) {
+                continue;
+            }
+
+            if (child & TRIANGLE_BVH_LEAF) {
+                const uint32_t first = child & TRIANGLE_BVH_LEAF_FIRST_MASK;
+                const uint32_t count = ((child & ~TRIANGLE_BVH_LEAF) >> TRIANGLE_BVH_LEAF_SHIFT) + 1;
+                for (uint32_t t = first; t < first + count; ++t) {
+                    *(uint32_t*)darr_push(p_triangles) = t;
+                }
+            } else if (stack_size < TBVH_STACK_SIZE) {
+                stack[stack_size++] = child;
+            } else {
+                cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Triangle BVH query stack overflow\n");
+            }
+        }
+    }
+}
+
+int triangle_bvh_raycast(const struct triangle_bvh* p_bvh, const float* p_origin, const float* p_dir, float max_t, struct triangle_bvh_hit* p_hit) {
+    if (!p_bvh->num_nodes) {
+        return 0;
+    }
+
+    const float inv_dir[3] = { 1.0f / p_dir[0], 1.0f / p_dir[1], 1.0f / p_dir[2] };
+
+    float closest_t = max_t;
+    uint32_t closest_triangle = TRIANGLE_BVH_EMPTY;
+
+    uint32_t stack[TBVH_STACK_SIZE];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size) {
+        const struct triangle_bvh_node* p_node = &p_bvh->p_nodes[stack[--stack_size]];
+
+        float entry_t[2];
+        int b_hit[2];
+
+        for (int c = 0; c < 2; ++c) {
+            b_hit[c] = 0;
+
+            if (p_node->children[c] == TRIANGLE_BVH_EMPTY) {
+                continue;
+            }
+
+            float min[3];
+            float max[3];
+            tbvh_dequantise(p_bvh, p_node->child_min[c], p_node->child_max[c], min, max);
+            b_hit[c] = tbvh_ray_box(p_origin, inv_dir, min, max, closest_t, &entry_t[c]);
+        }
+
+        // Visit the nearer child first: push it last
+        const int first = (b_hit[0] && b_hit[1] && entry_t[1] < entry_t[0]) ? 1 : 0;
+
+        for (int i = 1; i >= 0; --i) {
+            const int c = i ? !first : first;
+
+            if (!b_hit[c]) {
+                continue;
+            }
+
+            const uint32_t child = p_node->children[c];
+
+            if (child & TRIANGLE_BVH_LEAF) {
+                const uint32_t leaf_first = child & TRIANGLE_BVH_LEAF_FIRST_MASK;
+                const uint32_t count = ((child & ~TRIANGLE_BVH_LEAF) >> TRIANGLE_BVH_LEAF_SHIFT) + 1;
+
+                for (uint32_t t = leaf_first; t < leaf_first + count; ++t) {
+                    float v[3][3];
+                    float hit_t;
+                    triangle_bvh_get_triangle(p_bvh, t, v[0], v[1], v[2]);
+
+                    if (tbvh_ray_triangle(p_origin, p_dir, v[0], v[1], v[2], &hit_t) && hit_t < closest_t) {
+                        closest_t = hit_t;
+                        closest_triangle = t;
+                    }
+                }
+            } else if (stack_size < TBVH_STACK_SIZE) {
+                stack[stack_size++] = child;
+            } else {
+                cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Triangle BVH raycast stack overflow\n");
+            }
+        }
+    }
+
+    if (closest_triangle == TRIANGLE_BVH_EMPTY) {
+        return 0;
+    }
+
+    float v[3][3];
+    float e[2][3];
+    triangle_bvh_get_triangle(p_bvh, closest_triangle, v[0], v[1], v[2]);
+    vec3_sub(v[1], v[0], e[0]);
+    vec3_sub(v[2], v[0], e[1]);
+
+    p_hit->t = closest_t;
+    p_hit->triangle = closest_triangle;
+    vec3_cross(e[0], e[1], p_hit->normal);
+
+    return 1;
+}
+
+int triangle_bvh_serialize(FILE* p_file, const void* p_triangle_bvh) {
+    const struct triangle_bvh* p_bvh = p_triangle_bvh;
+
+    serialize_bytes(p_file, p_bvh->bounds_min, sizeof(float) * 3);
+    serialize_bytes(p_file, p_bvh->bounds_max, sizeof(float) * 3);
+    serialize_uint32(p_file, p_bvh->num_positions);
+    serialize_uint32(p_file, p_bvh->num_triangles);
+    serialize_uint32(p_file, p_bvh->num_nodes);
+    serialize_bytes(p_file, p_bvh->p_positions, sizeof(float) * 3 * p_bvh->num_positions);
+    serialize_bytes(p_file, p_bvh->p_indices, sizeof(uint32_t) * 3 * p_bvh->num_triangles);
+    serialize_bytes(p_file, p_bvh->p_nodes, sizeof(struct triangle_bvh_node) * p_bvh->num_nodes);
+
+    return !ferror(p_file);
+}
+
+int triangle_bvh_deserialize(FILE* p_file, void* p_triangle_bvh) {
+    struct triangle_bvh* p_bvh = p_triangle_bvh;
+    *p_bvh = (struct triangle_bvh){0};
+
+    deserialize_bytes(p_file, p_bvh->bounds_min, sizeof(float) * 3);
+    deserialize_bytes(p_file, p_bvh->bounds_max, sizeof(float) * 3);
+    deserialize_uint32(p_file, &p_bvh->num_positions);
+    deserialize_uint32(p_file, &p_bvh->num_triangles);
+    deserialize_uint32(p_file, &p_bvh->num_nodes);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Failed to deserialize triangle BVH: unexpected end of file\n");
+        *p_bvh = (struct triangle_bvh){0};
+        return 0;
+    }
+
+    p_bvh->p_positions = malloc(sizeof(float) * 3 * p_bvh->num_positions);
+    p_bvh->p_indices = malloc(sizeof(uint32_t) * 3 * p_bvh->num_triangles);
+    p_bvh->p_nodes = malloc(sizeof(struct triangle_bvh_node) * p_bvh->num_nodes);
+
+    deserialize_bytes(p_file, p_bvh->p_positions, sizeof(float) * 3 * p_bvh->num_positions);
+    deserialize_bytes(p_file, p_bvh->p_indices, sizeof(uint32_t) * 3 * p_bvh->num_triangles);
+    deserialize_bytes(p_file, p_bvh->p_nodes, sizeof(struct triangle_bvh_node) * p_bvh->num_nodes);
+
+    if (ferror(p_file) || feof(p_file)) {
+        cx_log(CX_LOG_ERROR, CX_LOG_CAT_BVH, "Failed to deserialize triangle BVH: unexpected end of file\n");
+        triangle_bvh_free(p_bvh);
+        return 0;
+    }
+
+    return 1;
+}
+
+void triangle_bvh_free(void* p_triangle_bvh) {
+    struct triangle_bvh* p_bvh = p_triangle_bvh;
+    free(p_bvh->p_positions);
+    free(p_bvh->p_indices);
+    free(p_bvh->p_nodes);
+    *p_bvh = (struct triangle_bvh){0};
+}
+
+uint32_t tbvh_build_node(struct tbvh_build_context* p_ctx, uint32_t begin, uint32_t end, float* p_min, float* p_max) {
+    p_min[0] = p_min[1] = p_min[2] =  INFINITY;
+    p_max[0] = p_max[1] = p_max[2] = -INFINITY;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        const float* p_bounds = &p_ctx->p_tri_bounds[p_ctx->p_order[i] * 6];
+        for (int a = 0; a < 3; ++a) {
+            p_min[a] = fminf(p_min[a], p_bounds[a]);
+            p_max[a] = fmaxf(p_max[a], p_bounds[a + 3]);
+        }
+    }
+
+    if (end - begin <= TRIANGLE_BVH_LEAF_MAX_TRIANGLES) {
+        return tbvh_make_leaf(begin, end);
+    }
+
+    const uint32_t mid = tbvh_find_split(p_ctx, begin, end, p_min, p_max);
+
+    const uint32_t node_index = (uint32_t)p_ctx->nodes._length;
+    darr_push(&p_ctx->nodes);
+
+    float child_min[2][3];
+    float child_max[2][3];
+    const uint32_t left = tbvh_build_node(p_ctx, begin, mid, child_min[0], child_max[0]);
+    const uint32_t right = tbvh_build_node(p_ctx, mid, end, child_min[1], child_max[1]);
+
+    struct triangle_bvh_node* p_node = darr_get(&p_ctx->nodes, node_index);
+    p_node->children[0] = left;
+    p_node->children[1] = right;
+
+    for (int c = 0; c < 2; ++c) {
+        tbvh_quantise(p_ctx->p_bvh, p_ctx->quant_scale, child_min[c], child_max[c], p_node->child_min[c], p_node->child_max[c]);
+    }
+
+    return node_index;
+}
+
+uint32_t tbvh_find_split(const struct tbvh_build_context* p_ctx, uint32_t begin, uint32_t end, const float* p_min, const float* p_max) {
+    // Binned SAH over the triangle centroids, on every axis
+
+    float centroid_min[3] = {  INFINITY,  INFINITY,  INFINITY };
+    float centroid_max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+    for (uint32_t i = begin; i < end; ++i) {
+        const float* p_c = &p_ctx->p_tri_centroids[p_ctx->p_order[i] * 3];
+        for (int a = 0; a < 3; ++a) {
+            centroid_min[a] = fminf(centroid_min[a], p_c[a]);
+            centroid_max[a] = fmaxf(centroid_max[a], p_c[a]);
+        }
+    }
+
+    float best_cost = INFINITY;
+    int best_axis = -1;
+    int best_bin = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float extent = centroid_max[axis] - centroid_min[axis];
+
+        if (extent <= 0) {
+            continue;
+        }
+
+        struct tbvh_bin bins[TBVH_SAH_BINS];
+        for (int b = 0; b < TBVH_SAH_BINS; ++b) {
+            bins[b] = (struct tbvh_bin) {
+                .min = {  INFINITY,  INFINITY,  INFINITY },
+                .max = { -INFINITY, -INFINITY, -INFINITY }
+            };
+        }
+
+        const float bin_scale = TBVH_SAH_BINS / extent;
+
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t t = p_ctx->p_order[i];
+            int b = (int)((p_ctx->p_tri_centroids[t * 3 + axis] - centroid_min[axis]) * bin_scale);
+            b = b < TBVH_SAH_BINS ? b : TBVH_SAH_BINS - 1;
+
+            ++bins[b].count;
+            for (int a = 0; a < 3; ++a) {
+                bins[b].min[a] = fminf(bins[b].min[a], p_ctx->p_tri_bounds[t * 6 + a]);
+                bins[b].max[a] = fmaxf(bins[b].max[a], p_ctx->p_tri_bounds[t * 6 + 3 + a]);
+            }
+        }
+
+        // Sweep from the right to get the cost of everything after each split, then from the left
+        float right_area[TBVH_SAH_BINS];
+        uint32_t right_count[TBVH_SAH_BINS];
+        struct tbvh_bin acc = bins[TBVH_SAH_BINS - 1];
+
+        for (int b = TBVH_SAH_BINS - 1; b > 0; --b) {
+            if (b < TBVH_SAH_BINS - 1) {
+                acc.count += bins[b].count;
+                for (int a = 0; a < 3; ++a) {
+                    acc.min[a] = fminf(acc.min[a], bins[b].min[a]);
+                    acc.max[a] = fmaxf(acc.max[a], bins[b].max[a]);
+                }
+            }
+            right_area[b] = acc.count ? tbvh_surface_area(acc.min, acc.max) : 0;
+            right_count[b] = acc.count;
+        }
+
+        acc = bins[0];
+
+        for (int b = 1; b < TBVH_SAH_BINS; ++b) {
+            if (acc.count && right_count[b]) {
+                const float cost = tbvh_surface_area(acc.min, acc.max) * (float)acc.count + right_area[b] * (float)right_count[b];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = b;
+                }
+            }
+
+            acc.count += bins[b].count;
+            for (int a = 0; a < 3; ++a) {
+                acc.min[a] = fminf(acc.min[a], bins[b].min[a]);
+                acc.max[a] = fmaxf(acc.max[a], bins[b].max[a]);
+            }
+        }
+    }
+
+    // Every centroid coincides: split the range in half
+    if (best_axis < 0) {
+        return begin + (end - begin) / 2;
+    }
+
+    const float bin_scale = TBVH_SAH_BINS / (centroid_max[best_axis] - centroid_min[best_axis]);
+
+    uint32_t mid = begin;
+    for (uint32_t i = begin; i < end; ++i) {
+        const uint32_t t = p_ctx->p_order[i];
+        int b = (int)((p_ctx->p_tri_centroids[t * 3 + best_axis] - centroid_min[best_axis]) * bin_scale);
+        b = b < TBVH_SAH_BINS ? b : TBVH_SAH_BINS - 1;
+
+        if (b < best_bin) {
+            p_ctx->p_order[i] = p_ctx->p_order[mid];
+            p_ctx->p_order[mid] = t;
+            ++mid;
+        }
+    }
+
+    return mid;
+}
+
+uint32_t tbvh_make_leaf(uint32_t begin, uint32_t end) {
+    return TRIANGLE_BVH_LEAF | ((end - begin - 1) << TRIANGLE_BVH_LEAF_SHIFT) | begin;
+}
+
+void tbvh_compute_quant_scale(const struct triangle_bvh* p_bvh, float* p_scale) {
+    for (int a = 0; a < 3; ++a) {
+        const float extent = p_bvh->bounds_max[a] - p_bvh->bounds_min[a];
+        p_scale[a] = extent > 0 ? TBVH_QUANT_MAX / extent : 0;
+    }
+}
+
+void tbvh_quantise(const struct triangle_bvh* p_bvh, const float* p_scale, const float* p_min, const float* p_max, uint16_t* p_qmin, uint16_t* p_qmax) {
+    for (int a = 0; a < 3; ++a) {
+        const float qmin = floorf((p_min[a] - p_bvh->bounds_min[a]) * p_scale[a]);
+        const float qmax = ceilf((p_max[a] - p_bvh->bounds_min[a]) * p_scale[a]);
+        p_qmin[a] = (uint16_t)fmaxf(0, fminf(qmin, TBVH_QUANT_MAX));
+        p_qmax[a] = (uint16_t)fmaxf(0, fminf(qmax, TBVH_QUANT_MAX));
+    }
+}
+
+void tbvh_dequantise(const struct triangle_bvh* p_bvh, const uint16_t* p_qmin, const uint16_t* p_qmax, float* p_min, float* p_max) {
+    for (int a = 0; a < 3; ++a) {
+        const float step = (p_bvh->bounds_max[a] - p_bvh->bounds_min[a]) / TBVH_QUANT_MAX;
+        p_min[a] = p_bvh->bounds_min[a] + (float)p_qmin[a] * step;
+        p_max[a] = p_bvh->bounds_min[a] + (float)p_qmax[a] * step;
+    }
+}
+
+float tbvh_surface_area(const float* p_min, const float* p_max) {
+    const float dx = p_max[0] - p_min[0];
+    const float dy = p_max[1] - p_min[1];
+    const float dz = p_max[2] - p_min[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+int tbvh_ray_box(const float* p_origin, const float* p_inv_dir, const float* p_min, const float* p_max, float max_t, float* p_t) {
+    float t_near = 0;
+    float t_far = max_t;
+
+    for (int a = 0; a < 3; ++a) {
+        float t0 = (p_min[a] - p_origin[a]) * p_inv_dir[a];
+        float t1 = (p_max[a] - p_origin[a]) * p_inv_dir[a];
+
+        // 0 * inf for a ray lying in a slab's plane; treat it as inside that slab
+        if (isnan(t0)) t0 = -INFINITY;
+        if (isnan(t1)) t1 = INFINITY;
+
+        t_near = fmaxf(t_near, fminf(t0, t1));
+        t_far = fminf(t_far, fmaxf(t0, t1));
+    }
+
+    *p_t = t_near;
+
+    return t_near <= t_far;
+}
+
+int tbvh_ray_triangle(const float* p_origin, const float* p_dir, const float* p_v0, const float* p_v1, const float* p_v2, float* p_t) {
+    // Moller-Trumbore, double sided
+
+    float e1[3];
+    float e2[3];
+    float p[3];
+    float s[3];
+    float q[3];
+
+    vec3_sub(p_v1, p_v0, e1);
+    vec3_sub(p_v2, p_v0, e2);
+    vec3_cross(p_dir, e2, p);
+
+    const float det = vec3_dot(e1, p);
+
+    if (fabsf(det) < 1e-12f) {
+        return 0;
+    }
+
+    const float inv_det = 1.0f / det;
+
+    vec3_sub(p_origin, p_v0, s);
+    const float u = vec3_dot(s, p) * inv_det;
+
+    if (u < 0 || u > 1) {
+        return 0;
+    }
+
+    vec3_cross(s, e1, q);
+    const float v = vec3_dot(p_dir, q) * inv_det;
+
+    if (v < 0 || u + v > 1) {
+        return 0;
+    }
+
+    *p_t = vec3_dot(e2, q) * inv_det;
+
+    return *p_t >= 0;
+}
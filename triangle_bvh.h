@@ -0,0 +1,54 @@
+#ifndef _H__TRIANGLE_BVH
+#define _H__TRIANGLE_BVH
+
+#include <stdint.h>
+
+#include "asset.h"
+#include "darr.h"
+
+#define ASSET_TYPE_TRIANGLE_BVH 8
+
+#define TRIANGLE_BVH_LEAF_MAX_TRIANGLES 4
+
+// Child references: a node index, or a leaf holding a run of triangles, or nothing
+#define TRIANGLE_BVH_EMPTY      UINT32_MAX
+#define TRIANGLE_BVH_LEAF       0x80000000u
+#define TRIANGLE_BVH_LEAF_SHIFT 27
+#define TRIANGLE_BVH_LEAF_FIRST_MASK ((1u << TRIANGLE_BVH_LEAF_SHIFT) - 1)
+
+struct static_mesh;
+
+/* 32-byte node holding the bounds of both children, quantised to 16 bits relative to the tree's bounds. Both children
+ * are tested from one cache line before descending. Rounding is outward, so quantised bounds never shrink a child. */
+struct triangle_bvh_node {
+    uint16_t child_min[2][3];
+    uint16_t child_max[2][3];
+    uint32_t children[2];
+};
+
+struct triangle_bvh_hit {
+    float    t;
+    float    normal[3]; // unnormalised geometric normal of the hit triangle
+    uint32_t triangle;
+};
+
+/* Bounding volume hierarchy over a triangle mesh, built top-down with a binned surface area heuristic. Triangles are
+ * stored in leaf order as index triplets into p_positions, so a leaf's triangles are contiguous. Node 0 is the root. */
+ASSET_STRUCT(triangle_bvh) {
+    float                     bounds_min[3];
+    float                     bounds_max[3];
+    float*                    p_positions;
+    uint32_t                  num_positions;
+    uint32_t*                 p_indices;
+    uint32_t                  num_triangles;
+    struct triangle_bvh_node* p_nodes;
+    uint32_t                  num_nodes;
+};
+
+int          triangle_bvh_build(const struct static_mesh* p_static_mesh, struct triangle_bvh* p_result);
+asset_handle triangle_bvh_find_or_build(struct asset_package* p_package, asset_handle static_mesh_handle);
+void         triangle_bvh_get_triangle(const struct triangle_bvh* p_bvh, uint32_t triangle, float* p_v0, float* p_v1, float* p_v2);
+void         triangle_bvh_query_aabb(const struct triangle_bvh* p_bvh, const float* p_min, const float* p_max, struct darr* p_triangles);
+int          triangle_bvh_raycast(const struct triangle_bvh* p_bvh, const float* p_origin, const float* p_dir, float max_t, struct triangle_bvh_hit* p_hit);
+
+#endif
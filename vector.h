@@ -2,6 +2,7 @@
 #define _H__VECTOR
 
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "math_utils.h"